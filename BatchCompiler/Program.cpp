@@ -0,0 +1,171 @@
+#include "stdafx.h"
+#include "../Logic/BatchCompiler.h"
+#include "../Logic/BatchReportWriter.h"
+#include "../Logic/XFileSystem.h"
+#include "../Logic/StringLibrary.h"
+#include "../Logic/ScriptObjectLibrary.h"
+#include "../Logic/GameObjectLibrary.h"
+#include "../Logic/SyntaxLibrary.h"
+#include "../Logic/WorkerData.h"
+
+/// <summary>Application object, the logic library reads preferences through it</summary>
+CWinApp  theApp;
+
+/// <summary>Process exit codes</summary>
+enum ExitCode : int { ExitPassed = 0, ExitFailed = 1, ExitError = 2 };
+
+/// <summary>Command line arguments</summary>
+class Arguments
+{
+   // --------------------- CONSTRUCTION ----------------------
+public:
+   /// <summary>Parses the command line</summary>
+   /// <param name="argc">Number of arguments</param>
+   /// <param name="argv">Arguments, including the program name</param>
+   /// <exception cref="Logic::ArgumentException">Invalid or missing argument</exception>
+   Arguments(int argc, WCHAR* argv[]) : Language(GameLanguage::English), Threads(0), Version(GameVersion::TerranConflict), Verify(true)
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         GuiString arg(argv[i]);
+
+         // Switch: /name:value
+         if (arg.Left(1) == L"/" || arg.Left(1) == L"-")
+         {
+            auto colon = arg.find(L':');
+            GuiString name = GuiString(arg.substr(1, colon == wstring::npos ? wstring::npos : colon-1)).ToLower(),
+                      value = colon == wstring::npos ? L"" : arg.substr(colon+1);
+
+            if (name == L"game")
+               GameFolder = value;
+            else if (name == L"version")
+               Version = ParseVersion(value);
+            else if (name == L"language")
+               Language = (GameLanguage)_wtoi(value.c_str());
+            else if (name == L"threads")
+               Threads = _wtoi(value.c_str());
+            else if (name == L"report")
+               ReportPath = value;
+            else if (name == L"noverify")
+               Verify = false;
+            else
+               throw ArgumentException(HERE, L"argv", VString(L"Unrecognised switch '%s'", arg.c_str()));
+         }
+         // Folder: Scripts to compile
+         else if (ScriptFolder.Empty())
+            ScriptFolder = arg;
+         else
+            throw ArgumentException(HERE, L"argv", VString(L"Unexpected argument '%s'", arg.c_str()));
+      }
+
+      // Game data is required for command syntax
+      if (GameFolder.Empty())
+         throw ArgumentException(HERE, L"argv", L"Missing game folder");
+   }
+
+   // ------------------------ STATIC -------------------------
+public:
+   /// <summary>Prints the usage</summary>
+   static void  PrintUsage()
+   {
+      Console << Cons::Heading << L"Compiles and verifies every script in a folder, reporting throughput, timings and failures" << ENDL
+              << L"Usage: XStudio2.BatchCompiler [folder] /game:<folder> [/version:X3R|X3TC|X3AP] [/language:<id>] [/threads:<n>] [/report:<file>] [/noverify]" << ENDL
+              << L"  folder     Folder of scripts to compile, defaults to the scripts within the game" << ENDL
+              << L"  /game      Game folder, used to load command syntax and game data" << ENDL
+              << L"  /version   Game version, defaults to X3TC" << ENDL
+              << L"  /language  Game language ID, defaults to 44 (English)" << ENDL
+              << L"  /threads   Maximum number of scripts to compile concurrently, defaults to one per processor" << ENDL
+              << L"  /report    Path of XML report, containing the result and phase timings of each script" << ENDL
+              << L"  /noverify  Skip writing and re-reading each compiled script" << ENDL
+              << L"Exit code: 0 if every script compiled, 1 if any failed, 2 upon error" << ENDL;
+   }
+
+private:
+   /// <summary>Parses a game version acronym</summary>
+   /// <param name="v">X2, X3R, X3TC or X3AP</param>
+   /// <returns></returns>
+   /// <exception cref="Logic::ArgumentException">Unrecognised version</exception>
+   static GameVersion  ParseVersion(const GuiString& v)
+   {
+      if (v.ToUpper() == L"X2")
+         return GameVersion::Threat;
+      else if (v.ToUpper() == L"X3R")
+         return GameVersion::Reunion;
+      else if (v.ToUpper() == L"X3TC")
+         return GameVersion::TerranConflict;
+      else if (v.ToUpper() == L"X3AP")
+         return GameVersion::AlbionPrelude;
+
+      throw ArgumentException(HERE, L"version", VString(L"Unrecognised game version '%s'", v.c_str()));
+   }
+
+   // -------------------- REPRESENTATION ---------------------
+public:
+   Path          GameFolder,     // Game folder
+                 ReportPath,     // Report path, if any
+                 ScriptFolder;   // Scripts folder, if any
+   GameLanguage  Language;       // Game language
+   UINT          Threads;        // Maximum number of concurrent scripts
+   GameVersion   Version;        // Game version
+   bool          Verify;         // Whether to verify compiled scripts
+};
+
+
+/// <summary>Compiles every script in a folder and reports the results</summary>
+/// <param name="argc">Number of arguments</param>
+/// <param name="argv">Arguments</param>
+/// <returns>Exit code</returns>
+int wmain(int argc, WCHAR* argv[])
+{
+   // Init MFC/COM
+   if (!AfxWinInit(GetModuleHandle(nullptr), nullptr, GetCommandLine(), 0) || FAILED(CoInitialize(nullptr)))
+      return ExitError;
+
+   int result = ExitError;
+   try
+   {
+      Arguments     args(argc, argv);
+      WorkerData    data(Operation::NoFeedback);
+      XFileSystem   vfs;
+      BatchCompiler batch(args.Threads, args.Verify);
+
+      // Load game data
+      Console << Cons::Heading << L"Loading " << VersionString(args.Version) << L" game data from " << args.GameFolder << ENDL;
+      vfs.Enumerate(args.GameFolder, args.Version, &data);
+      StringLib.Enumerate(vfs, args.Language, &data);
+      ScriptObjectLib.Enumerate(&data);
+      GameObjectLib.Enumerate(vfs, &data);
+      SyntaxLib.Enumerate(&data);
+
+      // Add scripts from folder or game
+      UINT count = args.ScriptFolder.Empty() ? batch.AddFolder(vfs) : batch.AddFolder(args.ScriptFolder);
+      Console << Cons::Heading << VString(L"Compiling %d scripts", count) << ENDL;
+
+      // Compile + Print summary
+      result = batch.Run() ? ExitFailed : ExitPassed;
+      batch.Print();
+
+      // Write report
+      if (!args.ReportPath.Empty())
+      {
+         BatchReportWriter w(XFileInfo(args.ReportPath).OpenWrite());
+         w.WriteReport(batch);
+         w.Close();
+      }
+   }
+   catch (ArgumentException& e) {
+      Console << Cons::Error << e.Message << ENDL;
+      Arguments::PrintUsage();
+   }
+   catch (ExceptionBase& e) {
+      Console.Log(HERE, e, L"Unable to compile scripts");
+   }
+
+   // Cleanup
+   StringLib.Clear();
+   ScriptObjectLib.Clear();
+   GameObjectLib.Clear();
+   SyntaxLib.Clear();
+   CoUninitialize();
+   return result;
+}
@@ -21,6 +21,7 @@ NAMESPACE_BEGIN2(GUI,Preferences)
         CaseSensitiveVariables(nullptr), 
         CheckArgumentNames(nullptr), 
         CheckArgumentTypes(nullptr),
+        ResolveScriptCallsConcurrently(nullptr),
         UseDoIfSyntax(nullptr), 
         UseCppOperators(nullptr),
         UseMacroCommands(nullptr)
@@ -56,6 +57,7 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       PrefsLib.UseDoIfSyntax = UseDoIfSyntax->GetBool();
       PrefsLib.UseMacroCommands = UseMacroCommands->GetBool();
       PrefsLib.CaseSensitiveVariables = CaseSensitiveVariables->GetBool();
+      PrefsLib.ResolveScriptCallsConcurrently = ResolveScriptCallsConcurrently->GetBool();
    }
 
    /// <summary>Populates this page.</summary>
@@ -70,6 +72,7 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       group->AddSubItem(UseDoIfSyntax = new UseDoIfSyntaxProperty(*this));
       group->AddSubItem(UseMacroCommands = new UseMacroCommandsProperty(*this));
       group->AddSubItem(CaseSensitiveVariables = new CaseSensitiveVariablesProperty(*this));
+      group->AddSubItem(ResolveScriptCallsConcurrently = new ResolveScriptCallsConcurrentlyProperty(*this));
       Grid.AddProperty(group);
    }
    
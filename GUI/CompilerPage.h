@@ -169,6 +169,38 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       };
 
 
+      /// <summary>ResolveScriptCallsConcurrently property</summary>
+      class ResolveScriptCallsConcurrentlyProperty : public PropertyBase
+      {
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         /// <summary>Create 'ResolveScriptCallsConcurrently' property</summary>
+         /// <param name="page">Owner page.</param>
+         ResolveScriptCallsConcurrentlyProperty(PreferencesPage& page) 
+            : PropertyBase(page, L"Script Calls", L"", L"Choose whether to read the scripts called by a script concurrently or one at a time")
+         {
+            AddOption(L"Read concurrently", FALSE);
+            AddOption(L"Read one at a time", FALSE);
+            AllowEdit(FALSE);
+            // Set initial value
+            SetValue(GetOption(PrefsLib.ResolveScriptCallsConcurrently ? 0 : 1));
+         }
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         /// <summary>Gets value as bool.</summary>
+         /// <returns></returns>
+         bool GetBool() const
+         {
+            return GetString() == GetOption(0);
+         }
+
+         // ----------------------- MUTATORS ------------------------
+      
+         // -------------------- REPRESENTATION ---------------------
+      };
+
+
       /// <summary>UseDoIfSyntax property</summary>
       class UseDoIfSyntaxProperty : public PropertyBase
       {
@@ -258,6 +290,7 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       CaseSensitiveVariablesProperty*  CaseSensitiveVariables;
       CheckArgumentNamesProperty*      CheckArgumentNames;
       CheckArgumentTypesProperty*      CheckArgumentTypes;
+      ResolveScriptCallsConcurrentlyProperty*  ResolveScriptCallsConcurrently;
       UseDoIfSyntaxProperty*           UseDoIfSyntax;
       UseCppOperatorsProperty*         UseCppOperators;
       UseMacroCommandsProperty*        UseMacroCommands;
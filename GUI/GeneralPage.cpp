@@ -24,7 +24,10 @@ NAMESPACE_BEGIN2(GUI,Preferences)
         GameDataFolder(nullptr), 
         GameDataLanguage(nullptr),
         GameDataVersion(nullptr), 
-        SkipBrokenFiles(nullptr)
+        SkipBrokenFiles(nullptr),
+        MapCatalogFiles(nullptr),
+        UseGameDataSnapshot(nullptr),
+        UseSearchIndex(nullptr)
    {
    }
 
@@ -65,6 +68,9 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       // Game Data
       PrefsLib.GameDataFolder = GameDataFolder->GetFolder();
       PrefsLib.SkipBrokenFiles = SkipBrokenFiles->GetBool();
+      PrefsLib.MapCatalogFiles = MapCatalogFiles->GetBool();
+      PrefsLib.UseGameDataSnapshot = UseGameDataSnapshot->GetBool();
+      PrefsLib.UseSearchIndex = UseSearchIndex->GetBool();
       PrefsLib.GameDataLanguage = GameDataLanguage->GetLanguage();
       PrefsLib.GameDataVersion = GameDataVersion->GetVersion();
 
@@ -85,6 +91,9 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       group = new PropertyBase(*this, L"Game Data");
       group->AddSubItem(GameDataFolder = new GameDataFolderProperty(*this));
       group->AddSubItem(SkipBrokenFiles = new SkipBrokenFilesProperty(*this));
+      group->AddSubItem(MapCatalogFiles = new MapCatalogFilesProperty(*this));
+      group->AddSubItem(UseGameDataSnapshot = new UseGameDataSnapshotProperty(*this));
+      group->AddSubItem(UseSearchIndex = new UseSearchIndexProperty(*this));
       group->AddSubItem(GameDataLanguage = new GameLanguageProperty(*this));
       group->AddSubItem(GameDataVersion = new GameVersionProperty(*this));
       Grid.AddProperty(group);
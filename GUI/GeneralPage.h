@@ -120,6 +120,42 @@ NAMESPACE_BEGIN2(GUI,Preferences)
          }
       };
       
+      /// <summary>Map catalog files property</summary>
+      class MapCatalogFilesProperty : public BooleanProperty
+      {
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         /// <summary>Create 'map catalog files' property</summary>
+         /// <param name="page">Owner page.</param>
+         MapCatalogFilesProperty(PreferencesPage& page) 
+            : BooleanProperty(page, L"Map Catalogs", PrefsLib.MapCatalogFiles, L"Map catalog data files into memory when loading game data. Faster, but requires more address space")
+         {}
+      };
+      
+      /// <summary>Use game data snapshot property</summary>
+      class UseGameDataSnapshotProperty : public BooleanProperty
+      {
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         /// <summary>Create 'use game data snapshot' property</summary>
+         /// <param name="page">Owner page.</param>
+         UseGameDataSnapshotProperty(PreferencesPage& page) 
+            : BooleanProperty(page, L"Snapshot Game Data", PrefsLib.UseGameDataSnapshot, L"Restore strings, script objects and command syntax from a snapshot of the previous load when the game files are unchanged")
+         {}
+      };
+      
+      /// <summary>Use search index property</summary>
+      class UseSearchIndexProperty : public BooleanProperty
+      {
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         /// <summary>Create 'use search index' property</summary>
+         /// <param name="page">Owner page.</param>
+         UseSearchIndexProperty(PreferencesPage& page) 
+            : BooleanProperty(page, L"Index Scripts", PrefsLib.UseSearchIndex, L"Index the text of game scripts in the background once game data is loaded, so searches of the script folder skip scripts that cannot match")
+         {}
+      };
+      
       /// <summary>SkipBrokenFiles property</summary>
       class SkipBrokenFilesProperty : public PropertyBase
       {
@@ -206,6 +242,9 @@ NAMESPACE_BEGIN2(GUI,Preferences)
       GameVersionProperty*     GameDataVersion;
       LargeMenusProperty*      LargeMenus;
       LargeToolbarsProperty*   LargeToolbars;
+      MapCatalogFilesProperty* MapCatalogFiles;
+      UseGameDataSnapshotProperty* UseGameDataSnapshot;
+      UseSearchIndexProperty*  UseSearchIndex;
       TooltipFontProperty*     TooltipFont;
       ToolWindowFontProperty*  ToolWindowFont;
       
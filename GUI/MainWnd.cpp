@@ -8,6 +8,7 @@
 #include "../Testing/LogicTests.h"
 #include "PreferencesDialog.h"
 #include "ExportProjectDialog.h"
+#include "../Logic/SearchIndex.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -302,6 +303,10 @@ NAMESPACE_BEGIN2(GUI,Windows)
       // Clear relevant windows & menu items
       theApp.State = AppState::NoGameData;
 
+      // Stop indexing + discard index  [Reloaded once game data is loaded]
+      SearchIndexThread.Cancel();
+      SearchIndexLib.Clear();
+
       // Clear/Display output window
       ClearOutputPane(Operation::LoadGameData, true);
 
@@ -409,6 +414,12 @@ NAMESPACE_BEGIN2(GUI,Windows)
       // Save workspace
       SaveWorkspace();
 
+      // Stop indexing
+      SearchIndexThread.Cancel();
+
+      // Finish writing game data snapshot  [Reports progress to this window]
+      GameDataThread.WaitForSnapshot();
+
       // Close 
       __super::OnClose();
    }
@@ -571,6 +582,10 @@ NAMESPACE_BEGIN2(GUI,Windows)
       {
          // Change app state 
          theApp.State = AppState::GameDataPresent;
+
+         // Index game scripts in background
+         if (PrefsLib.UseSearchIndex)
+            SearchIndexThread.Start();
          
          // Parse command line 
 	      CCommandLineInfo cmdInfo;
@@ -12,6 +12,7 @@
 #include "ScriptObjectWnd.h"
 #include "ScriptView.h"
 #include "../Logic/GameDataWorker.h"
+#include "../Logic/SearchIndexWorker.h"
 #include "../Logic/Event.h"
 #include "ToolBarEx.h"
 #include "FindDialog.h"
@@ -182,6 +183,7 @@ NAMESPACE_BEGIN2(GUI,Windows)
       BackupWnd         m_wndBackups;
 
       GameDataWorker    GameDataThread;
+      SearchIndexWorker SearchIndexThread;
 
       FeedbackHandler        fnGameDataFeedback;
       CaretMovedHandler      fnCaretMoved;
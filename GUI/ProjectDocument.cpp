@@ -4,7 +4,7 @@
 #include "ScriptDocument.h"
 #include "MainWnd.h"
 #include "../Logic/FileIdentifier.h"
-#include "../Logic/BackupFileReader.h"
+#include "../Logic/BackupStore.h"
 #include "../Logic/ProjectFileReader.h"
 #include "../Logic/ProjectFileWriter.h"
 #include "../Logic/XFileInfo.h"
@@ -168,6 +168,7 @@ NAMESPACE_BEGIN2(GUI,Documents)
    /// <returns>True if commited, false if aborted</returns>
    /// <exception cref="Logic::ArgumentException">Document not part of project</exception>
    /// <exception cref="Logic::ComException">COM Error</exception>
+   /// <exception cref="Logic::FileFormatException">Invalid backup file format</exception>
    /// <exception cref="Logic::IOException">An I/O error occurred</exception>
    bool ProjectDocument::Commit(const ScriptDocument& doc, const wstring& title)
    {
@@ -196,12 +197,8 @@ NAMESPACE_BEGIN2(GUI,Documents)
          if (ch == '\v')
             ch = '\n';
 
-      // Load backup. Insert revision
-      auto backup = LoadBackupFile(doc);
-      backup.Revisions.Commit( ScriptRevision(title, doc.FullPath, content, doc.Script) );
-
-      // Overwrite backup file
-      backup.Write(GetBackupPath(doc));
+      // Append revision to backup file
+      BackupStore(GetBackupPath(doc)).Commit( ScriptRevision(title, doc.FullPath, content, doc.Script) );
 
       // Raise 'BACKUP CHANGED'
       RefreshRevisions(doc);
@@ -270,11 +267,8 @@ NAMESPACE_BEGIN2(GUI,Documents)
    /// <exception cref="Logic::IOException">An I/O error occurred</exception>
    BackupFile  ProjectDocument::LoadBackupFile(const ScriptDocument& doc) const
    {
-      // Open backup file
-      auto s = XFileInfo(GetBackupPath(doc)).OpenRead();
-
       // Read contents
-      return BackupFileReader(s).ReadFile();
+      return BackupStore(GetBackupPath(doc)).ReadFile();
    }
 
    /// <summary>Moves an item to a new folder</summary>
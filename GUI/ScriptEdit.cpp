@@ -37,6 +37,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
       ON_NOTIFY_REFLECT(EN_MSGFILTER, &ScriptEdit::OnInputMessage)
       ON_MESSAGE(UN_CHAR_NOTIFY, &ScriptEdit::OnCharNotify)
       ON_MESSAGE(UN_KEYDOWN_NOTIFY, &ScriptEdit::OnKeyDownNotify)
+      ON_MESSAGE(WM_COMPILE_COMPLETE, &ScriptEdit::OnCompileComplete)
    END_MESSAGE_MAP()
    
    // -------------------------------- CONSTRUCTION --------------------------------
@@ -78,7 +79,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
    bool  ScriptEdit::CanGotoLabel() const
    {
       // Require 'Goto' or 'Gosub'
-      auto cmd = ScriptParser::Identify(Document->Script, GetLineText(-1));
+      auto& cmd = *Identifier.Identify(Document->Script, GetLineText(-1)).Syntax;
       return cmd.Is(CMD_GOTO_LABEL) || cmd.Is(CMD_GOTO_SUB);
    }
    
@@ -87,7 +88,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
    bool  ScriptEdit::CanLookupOnline() const
    {
       // Require MSCI reference URL
-      auto cmd = ScriptParser::Identify(Document->Script, GetLineText(-1));
+      auto& cmd = *Identifier.Identify(Document->Script, GetLineText(-1)).Syntax;
       return !cmd.URL.empty();
    }
    
@@ -96,7 +97,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
    bool  ScriptEdit::CanOpenScript() const
    {
       // Require command contain 'script-call' syntax
-      auto cmd = ScriptParser::Identify(Document->Script, GetLineText(-1));
+      auto& cmd = *Identifier.Identify(Document->Script, GetLineText(-1)).Syntax;
       return cmd.IsScriptCall();
    }
    
@@ -117,7 +118,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
    bool  ScriptEdit::CanViewString() const
    {
       // Require command contain 'stringID/pageID' syntax
-      auto cmd = ScriptParser::Identify(Document->Script, GetLineText(-1));
+      auto& cmd = *Identifier.Identify(Document->Script, GetLineText(-1)).Syntax;
       return cmd.IsStringReference();
    }
 
@@ -451,6 +452,16 @@ NAMESPACE_BEGIN2(GUI,Controls)
       SetSel(offset+t.Start, offset+t.End);
       SetSelectionCharFormat(cf);
    }
+
+   /// <summary>Selects and formats a token lexed by a token buffer.</summary>
+   /// <param name="offset">The character index of the line</param>
+   /// <param name="t">The token</param>
+   /// <param name="cf">The formatting characteristics</param>
+   void  ScriptEdit::FormatToken(UINT offset, const LexToken& t, CharFormat& cf)
+   {
+      SetSel(offset+t.Start, offset+t.End);
+      SetSelectionCharFormat(cf);
+   }
    
    /// <summary>Freezes or unfreezes the window.</summary>
    /// <param name="freeze">True to freeze, false to restore</param>
@@ -510,28 +521,53 @@ NAMESPACE_BEGIN2(GUI,Controls)
    /// <summary>Refresh entire document.</summary>
    void ScriptEdit::OnArgumentChanged()
    {
+      // Discard compile using previous arguments, if any
+      BackgroundCompiler.Cancel();
+
       UpdateHighlighting(0, GetLineCount()-1);
    }
 
-   /// <summary>Compiles script to highlight errors</summary>
+   /// <summary>Compiles a snapshot of the script on the background compiler thread</summary>
    void ScriptEdit::OnBackgroundCompile()
    {
-      CWaitCursor c;
-
       // Stop compiler timer
       SetCompilerTimer(false);
-        
-      // Freeze window
-      SuspendUndo(true);
-      FreezeWindow(true);
 
       try 
       { 
          // Feedback
          Console << Cons::UserAction << "Background compiling " << Document->GetFullPath() << ENDL;
 
-         // Parse script 
-         ScriptParser parser(Document->Script, GetAllLines(), Document->Script.Game);
+         // Compile snapshot  [Supersedes compile in progress, if any]
+         BackgroundCompiler.Compile(this, Document->Script, GetAllLines());
+      }
+      catch (std::exception& e) 
+      { 
+         Console.Log(HERE, e); 
+      }
+   }
+
+   /// <summary>Highlights the errors of a completed background compile</summary>
+   /// <param name="wParam">Request ID</param>
+   /// <param name="lParam">Unused</param>
+   /// <returns></returns>
+   LRESULT ScriptEdit::OnCompileComplete(WPARAM wParam, LPARAM lParam)
+   {
+      // Superseded: Ignore
+      auto result = BackgroundCompiler.TakeResult();
+      if (!result)
+         return 0;
+
+      // Freeze window
+      SuspendUndo(true);
+      FreezeWindow(true);
+
+      try 
+      { 
+         // Update symbols
+         Document->Script.Labels = result->Labels;
+         Document->Script.ScriptCalls = result->ScriptCalls;
+         Document->Script.Variables = result->Variables;
          
          // Underlining Errors?
          if (PrefsLib.BackgroundCompiler)
@@ -548,7 +584,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
             cf.crTextColor = PrefsLib.ErrorHighlight;
 
             // Underline all errors
-            for (const auto& err : parser.Errors)
+            for (const auto& err : result->Errors)
             {
                FormatToken(LineIndex(err.Line-1), err, cf);
                Console << err << ENDL;
@@ -556,7 +592,8 @@ NAMESPACE_BEGIN2(GUI,Controls)
          }
 
          // Feedback
-         Console << L"Background compiler found: " << parser.Errors.size() << L" errors" << ENDL;
+         Console << L"Background compiler found: " << result->Errors.size() << L" errors (" << result->Reparsed << L" lines reparsed)" << ENDL;
+         Console << VString(L"Compiled in %.0fms, completed %.0fms after request, %.0fms after last keystroke", result->Duration, result->Latency, LastEdit.ElapsedMilliseconds) << ENDL;
 
          // Raise 'Compile Complete'
          CompileComplete.Raise();
@@ -569,6 +606,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
       // UnFreeze window
       FreezeWindow(false);
       SuspendUndo(false);
+      return 0;
    }
 
    /// <summary>Notifies the suggestion mediator of character input</summary>
@@ -820,9 +858,13 @@ NAMESPACE_BEGIN2(GUI,Controls)
    /// <summary>Performs syntax colouring on the current line</summary>
    void ScriptEdit::OnTextChange()
    {
-      // Set/Reset background compiler timer
+      // Set/Reset background compiler timer. Discard compile of previous text, if any
       if (!ReadOnly)
+      {
+         LastEdit.Restart();
+         BackgroundCompiler.Cancel();
          SetCompilerTimer(true);
+      }
 
       // Update current line
       UpdateHighlighting(-1, -1);
@@ -1035,13 +1077,14 @@ NAMESPACE_BEGIN2(GUI,Controls)
          {
             UINT offset = LineIndex(i);
 
-            // Lex current line
-            CommandLexer lex(GetLineText(i));
+            // Lex current line  [Tokens reference the line text]
+            wstring line = GetLineText(i);
+            HighlightTokens.Lex(line);
 
             // Format tokens
-            for (const auto& tok : lex.Tokens)
+            for (const auto& tok : HighlightTokens)
             {
-               cf.crTextColor = Highlights.GetColour(Document->Script, tok);
+               cf.crTextColor = Highlights.GetColour(Document->Script, HighlightTokens, tok);
                FormatToken(offset, tok, cf);
             }
          }
@@ -4,8 +4,11 @@
 #include "CustomTooltip.h"
 #include "ScriptDocument.h"
 #include "../Logic/ScriptParser.h"
+#include "../Logic/CommandIdentifier.h"
+#include "../Logic/CompilerWorker.h"
 #include "../Logic/DescriptionLibrary.h"
 #include "../Logic/SyntaxLibrary.h"
+#include "../Logic/TokenBuffer.h"
 
 /// <summary>User interface controls</summary>
 NAMESPACE_BEGIN2(GUI,Controls)
@@ -638,6 +641,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
       LineTextIterator send();
 
       void   FormatToken(UINT offset, const TokenBase& t, CharFormat& cf);
+      void   FormatToken(UINT offset, const LexToken& t, CharFormat& cf);
       void   FreezeWindow(bool freeze, bool invalidate = true) override;
       void   RefreshGutter();
       void   SetCompilerTimer(bool set);
@@ -652,6 +656,7 @@ NAMESPACE_BEGIN2(GUI,Controls)
       handler void OnBackgroundCompile();
       handler void OnCharInternal(UINT nChar, UINT nRepCnt, UINT nFlags);
       LRESULT      OnCharNotify(WPARAM wParam, LPARAM lParam);
+      LRESULT      OnCompileComplete(WPARAM wParam, LPARAM lParam);
       handler void OnCharNewLine();
       handler void OnCharTab(bool shift);
       afx_msg void OnHScroll(UINT nSBCode, UINT nPos, CScrollBar* bar) override;
@@ -671,8 +676,12 @@ NAMESPACE_BEGIN2(GUI,Controls)
       SimpleEvent     CompileComplete;       // Raised after background compile completed
 
    protected:
+      CompilerWorker     BackgroundCompiler;    // Compiles snapshots of the script on a worker thread
       ScriptDocument*    Document;              // Document pointer
+      mutable CommandIdentifier  Identifier;    // Identifies the command at the caret
+      Stopwatch          LastEdit;              // Time since the most recent text change
       EventHandler       fnArgumentChanged;     // Raised when a Script argument is modified/removed
+      TokenBuffer        HighlightTokens;       // Tokens of the line being highlighted, reused for each line
       SuggestionDirector Suggestions;           // Suggestions mediator
 };
    
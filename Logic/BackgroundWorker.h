@@ -87,6 +87,14 @@ namespace Logic
             return code == STILL_ACTIVE;
          }
 
+         /// <summary>Waits for the thread to exit.</summary>
+         /// <param name="ms">Timeout in milliseconds.</param>
+         /// <returns>True if the thread has exited or the handle is closed, false if the timeout elapsed</returns>
+         bool  Wait(DWORD ms = INFINITE) const
+         {
+            return Thread == nullptr || WaitForSingleObject(Thread, ms) == WAIT_OBJECT_0;
+         }
+
          // ----------------------- MUTATORS ------------------------
       public:
          /// <summary>Closes the thread handle.</summary>
@@ -1,7 +1,6 @@
 #include "stdafx.h"
 #include "BackupFile.h"
-#include "BackupFileWriter.h"
-#include "XFileInfo.h"
+#include "BackupStore.h"
 
 namespace Logic
 {
@@ -35,24 +34,12 @@ namespace Logic
          Revisions.Remove(index);
       }
       
-      /// <summary>Saves the backup file.</summary>
+      /// <summary>Saves the backup file, replacing any existing file.</summary>
       /// <param name="path">The path.</param>
-      /// <param name="f">The f.</param>
-      /// <exception cref="Logic::ComException">COM Error</exception>
-      /// <exception cref="Logic::GZipException">Unable to inititalise stream</exception>
       /// <exception cref="Logic::IOException">Unable to create file</exception>
       void  BackupFile::Write(const Path& path) const
       {
-         auto tmp = TempPath().RenameExtension(L".zip");
-
-         // Write to a temp file to prevent destroying all revisions if case of failure
-         BackupFileWriter w(XFileInfo(tmp).OpenWrite(L"revisions.xml"));
-         w.WriteFile(*this);
-         w.Close();
-
-         // Success: Copy file
-         if (!MoveFileEx(tmp.c_str(), path.c_str(), MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
-            throw IOException(HERE, L"Unable to overwrite backup file: " + SysErrorString());
+         BackupStore(path).Write(*this);
       }
 
       /// <summary>Find a revision by index</summary>
@@ -142,10 +142,8 @@ namespace Logic
 
          // ---------------------- ACCESSORS ------------------------			
       public:
-         /// <summary>Saves the backup file.</summary>
+         /// <summary>Saves the backup file, replacing any existing file.</summary>
          /// <param name="path">The path.</param>
-         /// <exception cref="Logic::ComException">COM Error</exception>
-         /// <exception cref="Logic::GZipException">Unable to inititalise stream</exception>
          /// <exception cref="Logic::IOException">Unable to create file</exception>
          void  Write(const Path& path) const;
 
@@ -0,0 +1,575 @@
+#include "stdafx.h"
+#include "BackupStore.h"
+#include "BackupFileReader.h"
+#include "XFileInfo.h"
+#include "MappedFile.h"
+#include "FileStream.h"
+#include "../DTL/dtl.hpp"
+#include "zlib.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      // -------------------------------- NESTED CLASSES ------------------------------
+
+      /// <summary>Reads values from a revision record</summary>
+      class BackupStore::Reader
+      {
+      public:
+         /// <summary>Creates a reader for a buffer</summary>
+         /// <param name="buf">The buffer</param>
+         /// <param name="length">Length of buffer, in bytes</param>
+         Reader(const BYTE* buf, DWORD length) : Buffer(buf), Length(length), Position(0)
+         {}
+
+         /// <summary>Reads a date</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of record</exception>
+         DATE  ReadDate()
+         {
+            DATE value;
+            Read(&value, sizeof(value));
+            return value;
+         }
+
+         /// <summary>Reads a 32-bit value</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of record</exception>
+         DWORD  ReadDWord()
+         {
+            DWORD value;
+            Read(&value, sizeof(value));
+            return value;
+         }
+
+         /// <summary>Reads a length-prefixed UTF-16 string</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of record</exception>
+         wstring  ReadString()
+         {
+            DWORD chars = ReadDWord();
+
+            // Ensure string lies within buffer
+            if (chars > (Length - Position) / sizeof(WCHAR))
+               throw FileFormatException(HERE, L"Unexpected end of backup revision");
+
+            wstring str(reinterpret_cast<const WCHAR*>(Buffer + Position), chars);
+            Position += chars * sizeof(WCHAR);
+            return str;
+         }
+
+      private:
+         /// <summary>Reads raw bytes</summary>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of record</exception>
+         void  Read(void* output, DWORD length)
+         {
+            if (length > Length - Position)
+               throw FileFormatException(HERE, L"Unexpected end of backup revision");
+
+            memcpy(output, Buffer + Position, length);
+            Position += length;
+         }
+
+         const BYTE*  Buffer;
+         const DWORD  Length;
+         DWORD        Position;
+      };
+
+      /// <summary>Writes values to a revision record</summary>
+      class BackupStore::Writer
+      {
+      public:
+         /// <summary>Writes a date</summary>
+         void  Write(const COleDateTime& value)
+         {
+            DATE dt = value;
+            Write(&dt, sizeof(dt));
+         }
+
+         /// <summary>Writes a 32-bit value</summary>
+         void  Write(DWORD value)
+         {
+            Write(&value, sizeof(value));
+         }
+
+         /// <summary>Writes a length-prefixed UTF-16 string</summary>
+         void  Write(const wstring& str)
+         {
+            Write((DWORD)str.length());
+            Write(str.c_str(), str.length() * sizeof(WCHAR));
+         }
+
+         /// <summary>Writes raw bytes</summary>
+         void  Write(const void* buf, DWORD length)
+         {
+            const BYTE* bytes = reinterpret_cast<const BYTE*>(buf);
+            Buffer.insert(Buffer.end(), bytes, bytes + length);
+         }
+
+         vector<BYTE>  Buffer;
+      };
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates a backup store for a file, which need not exist</summary>
+      /// <param name="path">Full path of backup file</param>
+      BackupStore::BackupStore(const Path& path) : FullPath(path)
+      {
+      }
+
+      BackupStore::~BackupStore()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Query whether a backup file uses the delta format, rather than the legacy XML format</summary>
+      /// <param name="path">Full path of backup file</param>
+      /// <returns>True if delta format, false if legacy format or missing</returns>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      bool  BackupStore::IsStore(const Path& path)
+      {
+         DWORD magic = 0;
+
+         // Missing: Neither format
+         if (!path.Exists())
+            return false;
+
+         // Compare signature
+         FileStream fs(path, FileMode::OpenExisting, FileAccess::Read);
+         return fs.Read(reinterpret_cast<BYTE*>(&magic), sizeof(magic)) == sizeof(magic) && magic == MAGIC;
+      }
+
+      /// <summary>Writes a revision record to the end of a file</summary>
+      /// <param name="fs">The file, positioned at the end of the previous record</param>
+      /// <param name="body">Record body</param>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  BackupStore::Append(FileStream& fs, const vector<BYTE>& body)
+      {
+         RecordHeader header;
+
+         // Generate header
+         header.Length = (DWORD)body.size();
+         header.Checksum = crc32(0, body.data(), body.size());
+
+         // Write header + body
+         fs.Write(reinterpret_cast<const BYTE*>(&header), sizeof(header));
+         fs.Write(body.data(), body.size());
+      }
+
+      /// <summary>Splits text into lines, retaining any carriage returns</summary>
+      /// <param name="text">The text</param>
+      /// <returns>Lines without their line feeds.  Text without any line feeds is a single line</returns>
+      BackupStore::LineArray  BackupStore::GetLines(const wstring& text)
+      {
+         LineArray lines;
+
+         // Split at line feeds
+         for (size_t start = 0, end; ; start = end + 1)
+         {
+            if ((end = text.find(L'\n', start)) == wstring::npos)
+            {
+               lines.push_back(text.substr(start));
+               return lines;
+            }
+            lines.push_back(text.substr(start, end - start));
+         }
+      }
+
+      /// <summary>Joins lines into text</summary>
+      /// <param name="lines">The lines</param>
+      /// <returns>Lines separated by line feeds</returns>
+      wstring  BackupStore::GetText(const LineArray& lines)
+      {
+         wstring text;
+
+         // Join with line feeds
+         for (UINT i = 0; i < lines.size(); ++i)
+         {
+            if (i > 0)
+               text += L'\n';
+            text += lines[i];
+         }
+         return text;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Appends a revision to the backup file, creating the file if necessary</summary>
+      /// <param name="r">The revision</param>
+      /// <remarks>Legacy backup files are converted to the delta format before the revision is appended</remarks>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  BackupStore::Commit(const ScriptRevision& r)
+      {
+         RecordArray  records;
+         BackupType   type;
+         DWORD        end;
+         vector<BYTE> body;
+
+         // Missing: Create file containing only this revision
+         if (!FullPath.Exists())
+         {
+            BackupFile file(BackupType::MSCI);
+            file.Revisions.Commit(r);
+            Write(file);
+            return;
+         }
+
+         // Legacy: Convert
+         if (!IsStore(FullPath))
+            Write(ReadFile());
+
+         // Encode revision  [Release mapping before writing]
+         {
+            MappedFile file(FullPath);
+            LineArray  previous;
+            ReadRecords(file, type, records, end);
+
+            // Reconstruct the most recent revision by replaying from its keyframe
+            UINT key = records.size();
+            while (key > 0 && records[--key].Type != RecordType::Keyframe)
+            {}
+
+            ScriptRevision unused;
+            for (UINT i = key; i < records.size(); ++i)
+               previous = ReadRevision(file, records[i], previous, unused);
+
+            // Store in full if first revision, or KEYFRAME_INTERVAL revisions have passed since the last keyframe
+            bool keyframe = records.empty() || records.size() - key >= KEYFRAME_INTERVAL;
+            body = WriteRevision(r, keyframe ? RecordType::Keyframe : RecordType::Delta, previous, GetLines(r.Content));
+         }
+
+         // Append record, discarding any partial record left by an interrupted commit
+         FileStream fs(FullPath, FileMode::OpenExisting, FileAccess::Write);
+         if (fs.GetLength() != end)
+            fs.SetLength(end);
+         fs.Seek(end, SeekOrigin::Begin);
+         Append(fs, body);
+         fs.Flush();
+         fs.Close();
+      }
+
+      /// <summary>Gets the number of revisions</summary>
+      /// <returns></returns>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      UINT  BackupStore::GetCount() const
+      {
+         RecordArray records;
+         BackupType  type;
+         DWORD       end;
+
+         // Legacy: Read entire file
+         if (!IsStore(FullPath))
+            return ReadFile().Revisions.Count;
+
+         MappedFile file(FullPath);
+         ReadRecords(file, type, records, end);
+         return records.size();
+      }
+
+      /// <summary>Reads a single revision, replaying deltas from the nearest keyframe</summary>
+      /// <param name="index">Zero-based index, where zero is the most recent revision</param>
+      /// <returns></returns>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
+      /// <exception cref="Logic::IndexOutOfRangeException">Index does not exist</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      ScriptRevision  BackupStore::Read(UINT index) const
+      {
+         RecordArray    records;
+         BackupType     type;
+         DWORD          end;
+         ScriptRevision r;
+         LineArray      lines;
+
+         // Legacy: Read entire file
+         if (!IsStore(FullPath))
+            return ReadFile()[index];
+
+         MappedFile file(FullPath);
+         ReadRecords(file, type, records, end);
+
+         // Validate index
+         if (index >= records.size())
+            throw IndexOutOfRangeException(HERE, index, records.size());
+
+         // Locate keyframe  [First record is always a keyframe]
+         UINT target = records.size() - 1 - index,
+              key = target;
+         while (records[key].Type != RecordType::Keyframe)
+            --key;
+
+         // Replay deltas
+         for (UINT i = key; i <= target; ++i)
+            lines = ReadRevision(file, records[i], lines, r);
+
+         return r;
+      }
+
+      /// <summary>Reads every revision</summary>
+      /// <returns>Backup file with the most recent revision first</returns>
+      /// <exception cref="Logic::ArgumentNullException">Invalid file format</exception>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
+      /// <exception cref="Logic::InvalidValueException">Invalid file format</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      BackupFile  BackupStore::ReadFile() const
+      {
+         RecordArray records;
+         BackupType  type;
+         DWORD       end;
+         LineArray   lines;
+
+         // Legacy: Read XML
+         if (!IsStore(FullPath))
+            return BackupFileReader(XFileInfo(FullPath).OpenRead()).ReadFile();
+
+         MappedFile file(FullPath);
+         ReadRecords(file, type, records, end);
+
+         // Replay every record in order
+         BackupFile backup(type);
+         for (auto& rec : records)
+         {
+            ScriptRevision r;
+            lines = ReadRevision(file, rec, lines, r);
+            backup.Revisions.Commit(move(r));
+         }
+
+         return backup;
+      }
+
+      /// <summary>Replaces the backup file with the revisions of another</summary>
+      /// <param name="f">The backup file</param>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  BackupStore::Write(const BackupFile& f)
+      {
+         vector<const ScriptRevision*> revisions;
+         FileHeader header;
+         LineArray  previous;
+         Path       temp = FullPath.RenameExtension(L".new");
+
+         try
+         {
+            // Order revisions oldest first
+            for (auto& r : f.Revisions)
+               revisions.push_back(&r);
+            reverse(revisions.begin(), revisions.end());
+
+            // Generate header
+            header.Magic = MAGIC;
+            header.Format = FORMAT;
+            header.Type = (DWORD)f.Type;
+
+            // Write to a temporary file to prevent destroying all revisions in case of failure
+            FileStream fs(temp, FileMode::CreateAlways, FileAccess::Write);
+            fs.Write(reinterpret_cast<const BYTE*>(&header), sizeof(header));
+            for (UINT i = 0; i < revisions.size(); ++i)
+            {
+               LineArray lines = GetLines(revisions[i]->Content);
+               Append(fs, WriteRevision(*revisions[i], i % KEYFRAME_INTERVAL == 0 ? RecordType::Keyframe : RecordType::Delta, previous, lines));
+               previous.swap(lines);
+            }
+            fs.Close();
+
+            // Success: Replace existing file
+            if (!MoveFileEx(temp.c_str(), FullPath.c_str(), MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+               throw IOException(HERE, L"Unable to overwrite backup file: " + SysErrorString());
+         }
+         catch (ExceptionBase&) {
+            DeleteFile(temp.c_str());
+            throw;
+         }
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Validates the file header and locates each revision record</summary>
+      /// <param name="file">The backup file</param>
+      /// <param name="type">On return, the backup type</param>
+      /// <param name="records">On return, the location of each complete record, oldest first</param>
+      /// <param name="end">On return, offset of the end of the last complete record</param>
+      /// <remarks>A trailing record that is truncated, or whose checksum does not match, is considered partial and excluded</remarks>
+      /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
+      void  BackupStore::ReadRecords(const MappedFile& file, BackupType& type, RecordArray& records, DWORD& end) const
+      {
+         // Validate header
+         if (file.Length < sizeof(FileHeader))
+            throw FileFormatException(HERE, L"Backup file is truncated");
+
+         const FileHeader* header = reinterpret_cast<const FileHeader*>(file.GetView(0, sizeof(FileHeader)));
+         if (header->Magic != MAGIC || header->Format != FORMAT)
+            throw FileFormatException(HERE, L"Unrecognised backup file format");
+         type = (BackupType)header->Type;
+
+         // Locate records, stopping at a partial record left by an interrupted commit
+         records.clear();
+         for (end = sizeof(FileHeader); file.Length - end >= sizeof(RecordHeader); )
+         {
+            const RecordHeader* rec = reinterpret_cast<const RecordHeader*>(file.GetView(end, sizeof(RecordHeader)));
+            DWORD offset = end + sizeof(RecordHeader);
+
+            if (rec->Length < sizeof(DWORD) || rec->Length > file.Length - offset)
+               break;
+
+            // Trailing record: Verify payload reached the disk  [Header may be written before the payload]
+            if (rec->Length == file.Length - offset && rec->Checksum != crc32(0, file.GetView(offset, rec->Length), rec->Length))
+               break;
+
+            records.push_back(Record(offset, rec->Length, *reinterpret_cast<const RecordType*>(file.GetView(offset, sizeof(DWORD)))));
+            end = offset + rec->Length;
+         }
+
+         // Ensure every revision can be reconstructed
+         if (!records.empty() && records.front().Type != RecordType::Keyframe)
+            throw FileFormatException(HERE, L"Backup file does not begin with a keyframe");
+      }
+
+      /// <summary>Decodes a revision record</summary>
+      /// <param name="file">The backup file</param>
+      /// <param name="rec">The record</param>
+      /// <param name="previous">Lines of the previous revision</param>
+      /// <param name="r">On return, the revision</param>
+      /// <returns>Lines of the revision</returns>
+      /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
+      BackupStore::LineArray  BackupStore::ReadRevision(const MappedFile& file, const Record& rec, const LineArray& previous, ScriptRevision& r) const
+      {
+         const BYTE* body = file.GetView(rec.Offset, rec.Length);
+         LineArray   lines;
+         UINT        pos = 0;
+
+         // Validate body
+         const RecordHeader* header = reinterpret_cast<const RecordHeader*>(file.GetView(rec.Offset - sizeof(RecordHeader), sizeof(RecordHeader)));
+         if (header->Checksum != crc32(0, body, rec.Length))
+            throw FileFormatException(HERE, L"Backup revision checksum mismatch");
+
+         // Properties
+         Reader rd(body, rec.Length);
+         rd.ReadDWord();      // Type  [Already located]
+         r.Title = rd.ReadString();
+         r.FullPath = rd.ReadString();
+         r.Date = COleDateTime(rd.ReadDate());
+         r.ScriptName = rd.ReadString();
+         r.Description = rd.ReadString();
+         r.Game = (GameVersion)rd.ReadDWord();
+         r.CommandID = rd.ReadDWord();
+         r.Version = rd.ReadDWord();
+
+         // Keyframe: Entire text
+         if (rec.Type == RecordType::Keyframe)
+            lines = GetLines(rd.ReadString());
+
+         // Delta: Apply each operation to the previous revision
+         else if (rec.Type == RecordType::Delta)
+         {
+            for (DWORD i = 0, count = rd.ReadDWord(); i < count; ++i)
+            {
+               DeltaOp op = (DeltaOp)rd.ReadDWord();
+               DWORD   length = rd.ReadDWord();
+
+               switch (op)
+               {
+               case DeltaOp::Copy:
+               case DeltaOp::Skip:
+                  if (length > previous.size() - pos)
+                     throw FileFormatException(HERE, L"Backup revision delta exceeds previous revision");
+
+                  if (op == DeltaOp::Copy)
+                     lines.insert(lines.end(), previous.begin() + pos, previous.begin() + pos + length);
+                  pos += length;
+                  break;
+
+               case DeltaOp::Insert:
+                  while (length-- > 0)
+                     lines.push_back(rd.ReadString());
+                  break;
+
+               default:
+                  throw FileFormatException(HERE, L"Unrecognised backup revision delta");
+               }
+            }
+
+            // Ensure entire previous revision was consumed
+            if (pos != previous.size())
+               throw FileFormatException(HERE, L"Backup revision delta is incomplete");
+         }
+         else
+            throw FileFormatException(HERE, L"Unrecognised backup revision type");
+
+         r.Content = GetText(lines);
+         return lines;
+      }
+
+      /// <summary>Encodes a revision record</summary>
+      /// <param name="r">The revision</param>
+      /// <param name="type">How to store the content</param>
+      /// <param name="previous">Lines of the previous revision, if delta</param>
+      /// <param name="lines">Lines of the revision, if delta</param>
+      /// <returns>Record body</returns>
+      vector<BYTE>  BackupStore::WriteRevision(const ScriptRevision& r, RecordType type, const LineArray& previous, const LineArray& lines) const
+      {
+         Writer w;
+
+         // Properties
+         w.Write((DWORD)type);
+         w.Write(r.Title);
+         w.Write(r.FullPath.ToString());
+         w.Write(r.Date);
+         w.Write(r.ScriptName);
+         w.Write(r.Description);
+         w.Write((DWORD)r.Game);
+         w.Write((DWORD)r.CommandID);
+         w.Write((DWORD)r.Version);
+
+         // Keyframe: Entire text
+         if (type == RecordType::Keyframe)
+            w.Write(r.Content);
+         else
+         {
+            vector<pair<DeltaOp,DWORD>> runs;
+            LineArray inserted;
+
+            // Diff lines against previous revision
+            dtl::Diff<wstring, LineArray> diff(previous, lines);
+            diff.compose();
+
+            // Coalesce edits into runs of the same operation
+            for (auto& e : diff.getSes().getSequence())
+            {
+               DeltaOp op = e.second.type == dtl::SES_ADD    ? DeltaOp::Insert
+                          : e.second.type == dtl::SES_DELETE ? DeltaOp::Skip
+                          :                                    DeltaOp::Copy;
+
+               if (runs.empty() || runs.back().first != op)
+                  runs.push_back(make_pair(op, (DWORD)0));
+               ++runs.back().second;
+
+               if (op == DeltaOp::Insert)
+                  inserted.push_back(e.first);
+            }
+
+            // Write runs, following insertions with their lines
+            auto line = inserted.begin();
+            w.Write((DWORD)runs.size());
+            for (auto& run : runs)
+            {
+               w.Write((DWORD)run.first);
+               w.Write(run.second);
+
+               for (DWORD i = 0; run.first == DeltaOp::Insert && i < run.second; ++i)
+                  w.Write(*line++);
+            }
+         }
+
+         return w.Buffer;
+      }
+
+   }
+}
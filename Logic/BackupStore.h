@@ -0,0 +1,118 @@
+#pragma once
+
+#include "BackupFile.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      class FileStream;
+      class MappedFile;
+
+      /// <summary>Backup file that stores each revision as a line-level delta against the previous revision</summary>
+      /// <remarks>Revisions are appended to the file without rewriting those before them.  Every KEYFRAME_INTERVAL'th revision
+      /// is stored in full, so any revision can be reconstructed by replaying at most KEYFRAME_INTERVAL-1 deltas.  Backup files
+      /// in the legacy XML format can be read, and are converted when a revision is committed</remarks>
+      class LogicExport BackupStore
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Defines how the content of a revision is stored</summary>
+         enum class RecordType : DWORD { Keyframe, Delta };
+
+         /// <summary>Delta operations, applied in order to the lines of the previous revision</summary>
+         enum class DeltaOp : DWORD
+         {
+            Copy,       // Copy lines of previous revision
+            Skip,       // Discard lines of previous revision
+            Insert      // Insert new lines
+         };
+
+         /// <summary>Backup file header</summary>
+         class FileHeader
+         {
+         public:
+            DWORD  Magic,      // Identifies backup stores
+                   Format,     // Store format version
+                   Type;       // Backup type
+         };
+
+         /// <summary>Revision record header</summary>
+         class RecordHeader
+         {
+         public:
+            DWORD  Length,     // Length of record body, in bytes
+                   Checksum;   // CRC32 of record body
+         };
+
+         /// <summary>Location of a revision record</summary>
+         class Record
+         {
+         public:
+            Record(DWORD offset, DWORD length, RecordType t) : Offset(offset), Length(length), Type(t)
+            {}
+
+            DWORD       Offset,    // Offset of record body
+                        Length;    // Length of record body, in bytes
+            RecordType  Type;      // How content is stored
+         };
+
+         /// <summary>Revision records, oldest first</summary>
+         typedef vector<Record>  RecordArray;
+
+         /// <summary>Lines of a revision, without line terminators</summary>
+         typedef vector<wstring>  LineArray;
+
+         class Reader;
+         class Writer;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         BackupStore(const Path& path);
+         virtual ~BackupStore();
+
+         NO_COPY(BackupStore);	// No copy semantics
+         NO_MOVE(BackupStore);	// No move semantics
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static const DWORD  MAGIC = 0x4B425358,   // 'XSBK'
+                             FORMAT = 1,
+                             KEYFRAME_INTERVAL = 16;
+
+         static bool  IsStore(const Path& path);
+
+      private:
+         static void       Append(FileStream& fs, const vector<BYTE>& body);
+         static LineArray  GetLines(const wstring& text);
+         static wstring    GetText(const LineArray& lines);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         UINT            GetCount() const;
+         ScriptRevision  Read(UINT index) const;
+         BackupFile      ReadFile() const;
+
+      private:
+         void         ReadRecords(const MappedFile& file, BackupType& type, RecordArray& records, DWORD& end) const;
+         LineArray    ReadRevision(const MappedFile& file, const Record& rec, const LineArray& previous, ScriptRevision& r) const;
+         vector<BYTE> WriteRevision(const ScriptRevision& r, RecordType type, const LineArray& previous, const LineArray& lines) const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         void  Commit(const ScriptRevision& r);
+         void  Write(const BackupFile& f);
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         const Path  FullPath;     // Full path of backup file
+      };
+
+   }
+}
+
+using namespace Logic::IO;
@@ -0,0 +1,300 @@
+#include "stdafx.h"
+#include "BatchCompiler.h"
+#include "ScriptParser.h"
+#include "ScriptFileReader.h"
+#include "ScriptFileWriter.h"
+#include "FileSearch.h"
+#include "ComThreadHelper.h"
+#include "WorkerPool.h"
+#include "Stopwatch.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         // -------------------------------- CONSTRUCTION --------------------------------
+
+         /// <summary>Creates a batch compiler</summary>
+         /// <param name="threads">Maximum number of scripts to compile concurrently. Zero to use one per processor, one to compile serially</param>
+         /// <param name="verify">Whether to verify each compiled script translates to the same text</param>
+         BatchCompiler::BatchCompiler(UINT threads, bool verify) : Elapsed(0), Threads(threads), Verify(verify)
+         {
+         }
+
+
+         BatchCompiler::~BatchCompiler()
+         {
+         }
+
+         /// <summary>Creates an empty histogram</summary>
+         BatchCompiler::Histogram::Histogram() : Maximum(0), Total(0)
+         {
+            for (UINT i = 0; i < BUCKETS; ++i)
+               Counts[i] = 0;
+         }
+
+         // ------------------------------- STATIC METHODS -------------------------------
+
+         /// <summary>Gets batch phase name</summary>
+         /// <param name="p">phase</param>
+         /// <returns></returns>
+         LogicExport const WCHAR* GetString(BatchPhase p)
+         {
+            static const WCHAR* str[] = {L"Read", L"Parse", L"Compile", L"Verify"};
+            return str[(UINT)p];
+         }
+
+         /// <summary>Gets the translated text of every command</summary>
+         /// <param name="script">script</param>
+         /// <returns></returns>
+         LineArray  BatchCompiler::GetAllLines(const ScriptFile& script)
+         {
+            LineArray lines;
+            for (auto& cmd : script.Commands.Input)
+               lines.push_back(cmd.Text);
+            return lines;
+         }
+
+         /// <summary>Gets the inclusive upper bound of a histogram bucket</summary>
+         /// <param name="bucket">Zero-based bucket index</param>
+         /// <returns>Upper bound in milliseconds, or zero for the last bucket, which is unbounded</returns>
+         double  BatchCompiler::Histogram::GetUpperBound(UINT bucket)
+         {
+            static const double bounds[BUCKETS] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 0 };
+            return bounds[bucket];
+         }
+
+         /// <summary>Creates a unique temporary file</summary>
+         /// <returns>Full path of the file</returns>
+         /// <exception cref="Logic::Win32Exception">Unable to create file</exception>
+         Path  BatchCompiler::GetTempFilePath()
+         {
+            WCHAR folder[MAX_PATH], file[MAX_PATH];
+
+            if (!GetTempPath(MAX_PATH, folder) || !GetTempFileName(folder, L"xsb", 0, file))
+               throw Win32Exception(HERE, L"Unable to create temporary file");
+
+            return file;
+         }
+
+         // ------------------------------- PUBLIC METHODS -------------------------------
+
+         /// <summary>Adds a duration to the histogram</summary>
+         /// <param name="ms">Duration in milliseconds</param>
+         void  BatchCompiler::Histogram::Add(double ms)
+         {
+            UINT b = 0;
+
+            // Find first bucket bounding the duration
+            while (b < BUCKETS-1 && ms > GetUpperBound(b))
+               ++b;
+
+            ++Counts[b];
+            Maximum = max(Maximum, ms);
+            Total += ms;
+         }
+
+         /// <summary>Adds a script to the batch</summary>
+         /// <param name="f">The script</param>
+         void  BatchCompiler::Add(const XFileInfo& f)
+         {
+            Input.push_back(f);
+         }
+
+         /// <summary>Adds every script within a folder to the batch</summary>
+         /// <param name="folder">Full path of folder, sub-folders are not searched</param>
+         /// <returns>Number of scripts added</returns>
+         UINT  BatchCompiler::AddFolder(const Path& folder)
+         {
+            UINT count = 0;
+
+            // Add PCK/XML files
+            for (FileSearch fs(folder + L"*.*"); fs.HasResult(); fs.Next())
+               if (!fs.IsDirectory() && (fs.FullPath.HasExtension(L".pck") || fs.FullPath.HasExtension(L".xml")))
+               {
+                  Add(XFileInfo(fs.FullPath));
+                  ++count;
+               }
+
+            return count;
+         }
+
+         /// <summary>Adds every script within the scripts folder of the game to the batch</summary>
+         /// <param name="vfs">The game file system, which must outlive the batch</param>
+         /// <returns>Number of scripts added</returns>
+         UINT  BatchCompiler::AddFolder(const XFileSystem& vfs)
+         {
+            UINT count = 0;
+
+            // Add PCK/XML files
+            for (auto& f : vfs.Browse(XFolder::Scripts))
+               if (f.FullPath.HasExtension(L".pck") || f.FullPath.HasExtension(L".xml"))
+               {
+                  Add(f);
+                  ++count;
+               }
+
+            return count;
+         }
+
+         /// <summary>Gets the number of scripts that failed to compile in the most recent run</summary>
+         /// <returns></returns>
+         UINT  BatchCompiler::GetFailures() const
+         {
+            return (UINT)count_if(Output.begin(), Output.end(), [](const Result& r) { return !r.Success; });
+         }
+
+         /// <summary>Gets the distribution of the duration of a phase in the most recent run</summary>
+         /// <param name="p">The phase</param>
+         /// <returns></returns>
+         BatchCompiler::Histogram  BatchCompiler::GetHistogram(BatchPhase p) const
+         {
+            Histogram h;
+
+            // Include only scripts that completed the phase
+            for (auto& r : Output)
+               if (r.Success || r.Phase > p)
+                  h.Add(r.Milliseconds[(UINT)p]);
+
+            return h;
+         }
+
+         /// <summary>Gets the number of scripts compiled per second in the most recent run</summary>
+         /// <returns></returns>
+         double  BatchCompiler::GetThroughput() const
+         {
+            return Output.size() * 1000.0 / max(Elapsed, 0.001);
+         }
+
+         /// <summary>Prints the failures, throughput and timing histograms of the most recent run to the console</summary>
+         void  BatchCompiler::Print() const
+         {
+            // Failures
+            for (auto& r : Output)
+               if (!r.Success)
+                  Console << Cons::Red << GetString(r.Phase) << L" failed: " << Cons::White << r.FullPath << L" : " << r.Error << ENDL;
+
+            // Throughput
+            Console << Cons::Heading << VString(L"Compiled %d scripts (%d failed) in %.0fms  %.1f scripts/sec", Output.size(), GetFailures(), Elapsed, GetThroughput()) << ENDL;
+
+            // Histogram of each phase
+            for (UINT p = 0; p < PHASES; ++p)
+            {
+               Histogram h = GetHistogram((BatchPhase)p);
+
+               Console << Cons::Yellow << VString(L"%-8s", GetString((BatchPhase)p)) << Cons::White << VString(L"total %.0fms  max %.1fms  ", h.Total, h.Maximum);
+               for (UINT b = 0; b < Histogram::BUCKETS; ++b)
+                  if (b < Histogram::BUCKETS-1)
+                     Console << VString(L" <=%.0f:%d", Histogram::GetUpperBound(b), h.Counts[b]);
+                  else
+                     Console << VString(L" >%.0f:%d", Histogram::GetUpperBound(b-1), h.Counts[b]);
+               Console << ENDL;
+            }
+         }
+
+         /// <summary>Compiles every script in the batch concurrently</summary>
+         /// <returns>Number of scripts that failed to compile</returns>
+         UINT  BatchCompiler::Run()
+         {
+            WorkerPool pool(Threads);
+            Stopwatch  sw;
+
+            // Prepare results
+            Output.clear();
+            Output.reserve(Input.size());
+            for (auto& f : Input)
+               Output.push_back(Result(f.FullPath));
+
+            // Compile each script on the pool
+            for (UINT i = 0; i < Input.size(); ++i)
+               pool.Add([this, i]
+               {
+                  Compile(Input[i], Output[i]);
+               });
+            pool.Run();
+
+            // Return failures
+            Elapsed = sw.ElapsedMilliseconds;
+            return GetFailures();
+         }
+
+         // ------------------------------ PROTECTED METHODS -----------------------------
+
+         // ------------------------------- PRIVATE METHODS ------------------------------
+
+         /// <summary>Compiles a script, recording the outcome and duration of each phase</summary>
+         /// <param name="f">The script</param>
+         /// <param name="r">On return, the result</param>
+         void  BatchCompiler::Compile(const XFileInfo& f, Result& r) const
+         {
+            Stopwatch sw;
+            Path      temp;
+
+            try
+            {
+               ComThreadHelper COM;
+
+               // Read: Read and translate script  [Scripts are already read concurrently, so resolve script-calls one at a time]
+               r.Phase = BatchPhase::Read;
+               ScriptFile script = ScriptFileReader(f.OpenRead(), false).ReadFile(f.FullPath, false);
+               LineArray  lines = GetAllLines(script);
+               r.Lines = lines.size();
+               r.Milliseconds[(UINT)BatchPhase::Read] = sw.ElapsedMilliseconds;
+
+               // Parse: Parse translated text
+               sw.Restart();
+               r.Phase = BatchPhase::Parse;
+               ScriptParser parser(script, lines, script.Game);
+               r.Milliseconds[(UINT)BatchPhase::Parse] = sw.ElapsedMilliseconds;
+
+               if (!parser.Successful)
+                  throw InvalidOperationException(HERE, VString(L"Line %d: %s", parser.Errors.front().Line, parser.Errors.front().Message.c_str()));
+
+               // Compile: Generate code
+               sw.Restart();
+               r.Phase = BatchPhase::Compile;
+               parser.Compile();
+               r.Milliseconds[(UINT)BatchPhase::Compile] = sw.ElapsedMilliseconds;
+
+               if (!parser.Successful)
+                  throw InvalidOperationException(HERE, VString(L"Line %d: %s", parser.Errors.front().Line, parser.Errors.front().Message.c_str()));
+
+               // Verify: Write compiled script, then ensure it translates to the same text
+               if (Verify)
+               {
+                  sw.Restart();
+                  r.Phase = BatchPhase::Verify;
+                  temp = GetTempFilePath();
+
+                  ScriptFileWriter w(XFileInfo(temp).OpenWrite());
+                  w.Write(script);
+                  w.Close();
+
+                  // Re-read using the original path, to resolve script-calls identically
+                  LineArray copy = GetAllLines(ScriptFileReader(XFileInfo(temp).OpenRead(), false).ReadFile(f.FullPath, false));
+                  r.Milliseconds[(UINT)BatchPhase::Verify] = sw.ElapsedMilliseconds;
+
+                  if (copy.size() != lines.size())
+                     throw InvalidOperationException(HERE, VString(L"Compiled script has %d lines instead of %d", copy.size(), lines.size()));
+
+                  auto diff = mismatch(lines.begin(), lines.end(), copy.begin());
+                  if (diff.first != lines.end())
+                     throw InvalidOperationException(HERE, VString(L"Line %d: Compiled as '%s' instead of '%s'", 1 + (diff.first - lines.begin()), diff.second->c_str(), diff.first->c_str()));
+               }
+
+               r.Success = true;
+            }
+            catch (ExceptionBase& e) {
+               r.Error = e.Message;
+            }
+
+            // Cleanup
+            if (!temp.Empty())
+               DeleteFile(temp.c_str());
+         }
+      }
+   }
+}
+
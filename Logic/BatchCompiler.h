@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ScriptFile.h"
+#include "XFileSystem.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         /// <summary>Phase of compiling a script</summary>
+         enum class BatchPhase : UINT { Read, Parse, Compile, Verify };
+
+         /// <summary>Get batch phase name</summary>
+         LogicExport const WCHAR* GetString(BatchPhase p);
+
+         /// <summary>Compiles and verifies a batch of scripts concurrently, measuring the duration of each phase</summary>
+         /// <remarks>Each script is read and translated, its text is parsed and compiled, then the compiled script is written to a
+         /// temporary file and read back to verify it translates to the same text.  Scripts are compiled concurrently, so the game
+         /// data libraries must be loaded beforehand and left unmodified until the batch has completed.
+         ///
+         /// Compiling requires MFC, COM and the syntax and game data of an installed game, so batches run on Windows only</remarks>
+         class LogicExport BatchCompiler
+         {
+            // ------------------------ TYPES --------------------------
+         public:
+            /// <summary>Number of phases</summary>
+            static const UINT  PHASES = 4;
+
+            /// <summary>Outcome of compiling a script</summary>
+            class Result
+            {
+            public:
+               Result(const Path& p) : FullPath(p), Lines(0), Phase(BatchPhase::Read), Success(false)
+               {
+                  for (UINT i = 0; i < PHASES; ++i)
+                     Milliseconds[i] = 0;
+               }
+
+               wstring     Error;                   // Error message, if failed
+               Path        FullPath;                // Full path of script
+               UINT        Lines;                   // Number of lines of script text
+               double      Milliseconds[PHASES];    // Duration of each phase
+               BatchPhase  Phase;                   // Last phase attempted
+               bool        Success;                 // Whether every phase succeeded
+            };
+
+            /// <summary>Results in the order scripts were added</summary>
+            typedef vector<Result>  ResultArray;
+
+            /// <summary>Distribution of the duration of a phase</summary>
+            class Histogram
+            {
+            public:
+               /// <summary>Number of buckets, the last of which is unbounded</summary>
+               static const UINT  BUCKETS = 11;
+
+               Histogram();
+
+               static double  GetUpperBound(UINT bucket);
+
+               void  Add(double ms);
+
+               UINT    Counts[BUCKETS];     // Number of durations within each bucket
+               double  Maximum,             // Longest duration
+                       Total;               // Sum of all durations
+            };
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            BatchCompiler(UINT threads = 0, bool verify = true);
+            virtual ~BatchCompiler();
+
+            NO_COPY(BatchCompiler);	// Uncopyable
+            NO_MOVE(BatchCompiler);	// Unmoveable
+
+            // ------------------------ STATIC -------------------------
+         private:
+            static LineArray  GetAllLines(const ScriptFile& script);
+            static Path       GetTempFilePath();
+
+            // --------------------- PROPERTIES ------------------------
+         public:
+            PROPERTY_GET(double,ElapsedMilliseconds,GetElapsedMilliseconds);
+            PROPERTY_GET(UINT,Failures,GetFailures);
+            PROPERTY_GET(const ResultArray&,Results,GetResults);
+            PROPERTY_GET(double,Throughput,GetThroughput);
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Gets the duration of the most recent run</summary>
+            double  GetElapsedMilliseconds() const   { return Elapsed; }
+
+            /// <summary>Gets the results of the most recent run</summary>
+            const ResultArray&  GetResults() const   { return Output; }
+
+            UINT       GetFailures() const;
+            Histogram  GetHistogram(BatchPhase p) const;
+            double     GetThroughput() const;
+            void       Print() const;
+
+         private:
+            void  Compile(const XFileInfo& f, Result& r) const;
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            void  Add(const XFileInfo& f);
+            UINT  AddFolder(const Path& folder);
+            UINT  AddFolder(const XFileSystem& vfs);
+            UINT  Run();
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            double             Elapsed;    // Duration of most recent run
+            vector<XFileInfo>  Input;      // Scripts to compile
+            ResultArray        Output;     // Results of most recent run
+            const UINT         Threads;    // Maximum number of scripts to compile concurrently
+            const bool         Verify;     // Whether to verify compiled scripts
+         };
+
+      }
+   }
+}
+
+using namespace Logic::Scripts::Compiler;
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "BatchReportWriter.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+   
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates a batch report writer for an output stream</summary>
+      /// <exception cref="Logic::ArgumentException">Stream is not writeable</exception>
+      /// <exception cref="Logic::ArgumentNullException">Stream is null</exception>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      BatchReportWriter::BatchReportWriter(StreamPtr out) : XmlWriter(out)
+      {
+      }
+
+
+      BatchReportWriter::~BatchReportWriter()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Closes and flushes the output stream</summary>
+      void  BatchReportWriter::Close()
+      {
+         __super::Close();
+      }
+
+      /// <summary>Writes the results of the most recent run of a batch</summary>
+      /// <param name="batch">The batch</param>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  BatchReportWriter::WriteReport(const BatchCompiler& batch)
+      {
+         // Header
+         WriteInstruction(L"version='1.0' encoding='UTF-8'");
+         WriteComment(L"Written by X-Studio II");
+
+         // <batch scripts="1200" failures="2" milliseconds="5231.4" throughput="229.4">
+         auto root = WriteRoot(L"batch");
+         WriteAttribute(root, L"scripts", (int)batch.Results.size());
+         WriteAttribute(root, L"failures", batch.Failures);
+         WriteAttribute(root, L"milliseconds", VString(L"%.1f", batch.ElapsedMilliseconds));
+         WriteAttribute(root, L"throughput", VString(L"%.1f", batch.Throughput));
+
+         // Histogram of each phase
+         auto phases = WriteElement(root, L"phases");
+         for (UINT p = 0; p < BatchCompiler::PHASES; ++p)
+            WritePhase(batch, (BatchPhase)p, phases);
+
+         // Result of each script
+         auto scripts = WriteElement(root, L"scripts");
+         for (auto& r : batch.Results)
+            WriteResult(r, scripts);
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+      
+      /// <summary>Writes the histogram of a phase</summary>
+      /// <param name="batch">The batch</param>
+      /// <param name="p">The phase</param>
+      /// <param name="parent">phases node.</param>
+      /// <exception cref="Logic::ArgumentNullException">Parent is nullptr</exception>
+      void  BatchReportWriter::WritePhase(const BatchCompiler& batch, BatchPhase p, XmlElementPtr& parent)
+      {
+         REQUIRED(parent);
+
+         auto h = batch.GetHistogram(p);
+
+         // <phase name="Parse" total="1520.3" maximum="48.1">
+         auto node = WriteElement(parent, L"phase");
+         WriteAttribute(node, L"name", GetString(p));
+         WriteAttribute(node, L"total", VString(L"%.1f", h.Total));
+         WriteAttribute(node, L"maximum", VString(L"%.1f", h.Maximum));
+
+         //  <bucket max="1" count="830"/>   [Last bucket is unbounded]
+         for (UINT b = 0; b < BatchCompiler::Histogram::BUCKETS; ++b)
+         {
+            auto bucket = WriteElement(node, L"bucket");
+            if (b < BatchCompiler::Histogram::BUCKETS-1)
+               WriteAttribute(bucket, L"max", VString(L"%.0f", BatchCompiler::Histogram::GetUpperBound(b)));
+            WriteAttribute(bucket, L"count", h.Counts[b]);
+         }
+      }
+
+      /// <summary>Writes the result of a script</summary>
+      /// <param name="r">Result.</param>
+      /// <param name="parent">scripts node.</param>
+      /// <exception cref="Logic::ArgumentNullException">Parent is nullptr</exception>
+      void  BatchReportWriter::WriteResult(const BatchCompiler::Result& r, XmlElementPtr& parent)
+      {
+         REQUIRED(parent);
+
+         // <script path="D:\X3 Albion Prelude\scripts\plugin.piracy.lib.logic.xml" lines="120" success="true" read="4.1" parse="1.2" compile="0.8" verify="4.6"/>
+         auto node = WriteElement(parent, L"script");
+         WriteAttribute(node, L"path", r.FullPath.c_str());
+         WriteAttribute(node, L"lines", r.Lines);
+         WriteAttribute(node, L"success", r.Success ? L"true" : L"false");
+         for (UINT p = 0; p < BatchCompiler::PHASES; ++p)
+            WriteAttribute(node, GuiString(GetString((BatchPhase)p)).ToLower(), VString(L"%.2f", r.Milliseconds[p]));
+
+         // Failed: <script ... phase="Parse">Line 12: Unrecognised command</script>
+         if (!r.Success)
+         {
+            WriteAttribute(node, L"phase", GetString(r.Phase));
+            WriteText(node, r.Error);
+         }
+      }
+
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+   
+   }
+}
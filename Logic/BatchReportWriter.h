@@ -0,0 +1,50 @@
+#pragma once
+
+
+#include "XmlWriter.h"
+#include "BatchCompiler.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+
+      /// <summary>Writer for the results of a batch compile, in a machine-readable form</summary>
+      /// <remarks>Timings vary between runs, so reports are not suitable for comparison against an expected report</remarks>
+      class LogicExport BatchReportWriter : protected XmlWriter
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         BatchReportWriter(StreamPtr out);
+         virtual ~BatchReportWriter();
+
+         NO_COPY(BatchReportWriter);	// No copy semantics
+         NO_MOVE(BatchReportWriter);	// No move semantics
+
+         // ------------------------ STATIC -------------------------
+
+         // --------------------- PROPERTIES ------------------------
+
+         // ---------------------- ACCESSORS ------------------------			
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         void  Close();
+         void  WriteReport(const BatchCompiler& batch);
+
+      protected:
+         void  WritePhase(const BatchCompiler& batch, BatchPhase p, XmlElementPtr& parent);
+         void  WriteResult(const BatchCompiler::Result& r, XmlElementPtr& parent);
+
+         // -------------------- REPRESENTATION ---------------------
+
+      private:
+      };
+
+   }
+}
+
+using namespace Logic::IO;
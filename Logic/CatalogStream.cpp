@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "CatalogStream.h"
+#include "XorCipher.h"
 
 namespace Logic
 {
@@ -92,11 +93,8 @@ namespace Logic
       /// <param name="streamPos">Stream position matching the first buffer element to be encoded</param>
       void  CatalogStream::Encode(byte* buffer, DWORD length, DWORD  streamPos)
       {
-         byte key = CalculateKey(streamPos);
-
          // Encode buffer
-         for (DWORD i = 0; i < length; i++)
-            buffer[i] ^= key++;
+         XorCipher::EncodeRolling(buffer, length, CalculateKey(streamPos));
       }
 
    }
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include "CommandIdentifier.h"
+#include "ScriptParser.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         // -------------------------------- CONSTRUCTION --------------------------------
+
+         CommandIdentifier::CommandIdentifier() : Lines(1), Scratch(L"")
+         {
+         }
+
+         CommandIdentifier::~CommandIdentifier()
+         {
+         }
+
+         // ------------------------------- STATIC METHODS -------------------------------
+
+         // ------------------------------- PUBLIC METHODS -------------------------------
+
+         /// <summary>Identifies the command from line of text.</summary>
+         /// <param name="script">script.</param>
+         /// <param name="line">line text.</param>
+         /// <returns>Command syntax and parameter positions if successful, otherwise 'Unknown' sentinel. Valid until the next call</returns>
+         const CommandIdentifier::Identification&  CommandIdentifier::Identify(const ScriptFile& script, const wstring& line)
+         {
+            // Reset  [Preserve capacity]
+            Result.Syntax = &CommandSyntax::Unrecognised;
+            Result.Parameters.clear();
+
+            try
+            {
+               auto node = Read(script, line);
+
+               // Extract syntax + parameter positions
+               Result.Syntax = &node->Syntax;
+               for (const ScriptParameter& p : node->Parameters)
+               {
+                  CHARRANGE span = {(LONG)p.Token.Start, (LONG)p.Token.End};
+                  Result.Parameters.push_back(span);
+               }
+            }
+            catch (ExceptionBase& e) {
+               Console.Log(HERE, e);
+            }
+
+            return Result;
+         }
+
+         /// <summary>Parses a single command from a line of text.</summary>
+         /// <param name="script">script.</param>
+         /// <param name="line">line text.</param>
+         /// <returns>Command if successful, otherwise 'unrecognised' sentinel</returns>
+         ScriptCommand  CommandIdentifier::Parse(const ScriptFile& script, const wstring& line)
+         {
+            try
+            {
+               auto node = Read(script, line);
+
+               // Generate command
+               if (!node->Is(CMD_EXPRESSION))
+                  return ScriptCommand(node->LineText, node->Syntax, node->Parameters, node->CmdComment);
+               else
+                  return ScriptCommand(node->LineText, node->Syntax, node->Parameters, node->Postfix, node->CmdComment);
+            }
+            catch (ExceptionBase& e) {
+               Console.Log(HERE, e);
+               return ScriptCommand::Unrecognised;
+            }
+         }
+
+         // ------------------------------ PROTECTED METHODS -----------------------------
+
+         /// <summary>Reads a single line of text, without verification</summary>
+         /// <param name="script">script.</param>
+         /// <param name="line">line text.</param>
+         /// <returns>Command node</returns>
+         /// <exception cref="Logic::AlgorithmException">Error in parsing algorithm</exception>
+         CommandNodePtr  CommandIdentifier::Read(const ScriptFile& script, const wstring& line)
+         {
+            // Copy line  [Preserve capacity]
+            Lines[0].assign(line);
+
+            // Release previous node  [Re-uses the arena, provided callers no longer hold it]
+            Tree.Clear();
+
+            // Read first line only
+            ScriptParser parser(Scratch, Lines, script.Game, Tree, Buffer);
+
+            // Sanity check
+            if (!parser.CurrentNode)
+               throw AlgorithmException(HERE, L"Unable to read command");
+
+            return parser.CurrentNode;
+         }
+
+         // ------------------------------- PRIVATE METHODS ------------------------------
+      }
+   }
+}
+
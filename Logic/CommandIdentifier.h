@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ScriptFile.h"
+#include "ScriptCommand.h"
+#include "CommandNode.h"
+#include "CommandTree.h"
+#include "TokenBuffer.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         /// <summary>Identifies the command on a single line of text, without copying or modifying the script</summary>
+         /// <remarks>The line is read but not verified, which is sufficient to determine the syntax and parameters of the command.
+         /// Identifiers re-use their token buffer and node arena between lines, so they should be retained by callers that identify lines frequently,
+         /// such as the editor upon each keystroke.  Identifiers are not thread-safe</remarks>
+         class LogicExport CommandIdentifier
+         {
+            // ------------------------ TYPES --------------------------
+         public:
+            /// <summary>Character ranges of each parameter</summary>
+            typedef vector<CHARRANGE>  SpanArray;
+
+            /// <summary>Syntax of a command and the position of its parameters</summary>
+            class Identification
+            {
+            public:
+               Identification() : Syntax(&CommandSyntax::Unrecognised)
+               {}
+
+               CommandSyntaxPtr  Syntax;        // Command syntax, or the 'unrecognised' sentinel
+               SpanArray         Parameters;    // Character ranges of each parameter, in the order they were read
+            };
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            CommandIdentifier();
+            virtual ~CommandIdentifier();
+
+            NO_COPY(CommandIdentifier);	// Uncopyable
+            NO_MOVE(CommandIdentifier);	// Unmoveable
+
+            // ------------------------ STATIC -------------------------
+
+            // --------------------- PROPERTIES ------------------------
+
+            // ---------------------- ACCESSORS ------------------------
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            const Identification&  Identify(const ScriptFile& script, const wstring& line);
+            ScriptCommand          Parse(const ScriptFile& script, const wstring& line);
+
+         protected:
+            CommandNodePtr  Read(const ScriptFile& script, const wstring& line);
+
+            // -------------------- REPRESENTATION ---------------------
+         protected:
+            LineArray       Lines;      // Line being identified
+            Identification  Result;     // Most recent identification
+            ScriptFile      Scratch;    // Empty script, bound to the parser but never modified
+            CommandTree     Tree;       // Allocates the node of each line, from an arena cleared between lines
+            TokenBuffer     Buffer;     // Token buffer of each line
+         };
+      }
+   }
+}
+
+using namespace Logic::Scripts::Compiler;
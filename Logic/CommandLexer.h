@@ -10,16 +10,18 @@ namespace Logic
    {
       namespace Compiler
       {
+         class TokenBuffer;
+
          /// <summary>Lexes MSCI Script command text into a stream of tokens</summary>
+         /// <remarks>Callers that lex many lines should supply one token buffer for every line, to avoid allocating a buffer per line</remarks>
          class LogicExport CommandLexer
          {
             // ------------------------ TYPES --------------------------
-         protected:
-            typedef wstring::const_iterator CharIterator;
 
             // --------------------- CONSTRUCTION ----------------------
          public:
             CommandLexer(const wstring& line, bool skipWhitespace = true);
+            CommandLexer(const wstring& line, TokenBuffer& buffer, bool skipWhitespace = true);
             virtual ~CommandLexer();
 
             NO_COPY_ASSIGN(CommandLexer);	// Immutable
@@ -27,13 +29,11 @@ namespace Logic
 
             // ------------------------ STATIC -------------------------
          protected:
-            void  Parse();
+            void  Parse(TokenBuffer& buffer);
 
             // --------------------- PROPERTIES ------------------------
          public:
             PROPERTY_GET(CHARRANGE,Extent,GetExtent);
-         protected:
-            PROPERTY_GET(bool,ValidPosition,IsValidPosition);
 
             // ---------------------- ACCESSORS ------------------------			
          public:
@@ -74,7 +74,7 @@ namespace Logic
             /// <returns></returns>
             CHARRANGE GetExtent() const
             {
-               CHARRANGE range = {0, LineEnd-LineStart};
+               CHARRANGE range = {0, (LONG)Input.length()};
 
                if (Tokens.size() > 0)
                {
@@ -121,39 +121,8 @@ namespace Logic
                return pos < Tokens.end();
             }
 
-         protected:
-            bool  IsValidPosition() const  { return Position < LineEnd; }
-            
-            bool  MatchChar(WCHAR ch) const;
-            bool  MatchChars(const WCHAR* str) const;
-            bool  MatchChars(const CharIterator pos, const WCHAR* str) const;
-
-            bool  MatchConstant() const;
-            bool  MatchDigit() const;
-            bool  MatchNumber() const;
-            bool  MatchOperator() const;
-            bool  MatchText() const;
-            bool  MatchVariable() const;
-            bool  MatchWhitespace() const;
-
-            ScriptToken  MakeToken(CharIterator start, TokenType t) const;
-
             // ----------------------- MUTATORS ------------------------
 
-         protected:
-            bool         ReadChar();
-
-            ScriptToken  ReadAmbiguous(CharIterator start);
-            ScriptToken  ReadConstant(CharIterator start);
-            ScriptToken  ReadComment(CharIterator start);
-            ScriptToken  ReadGameObject(CharIterator start);
-            ScriptToken  ReadNumber(CharIterator start);
-            ScriptToken  ReadOperator(CharIterator start);
-            ScriptToken  ReadString(CharIterator start);
-            ScriptToken  ReadText(CharIterator start);
-            ScriptToken  ReadVariable(CharIterator start);
-            ScriptToken  ReadWhitespace(CharIterator start);
-
             // -------------------- REPRESENTATION ---------------------
          public:
             const wstring       Input;             // Input text
@@ -161,9 +130,6 @@ namespace Logic
             const bool          SkipWhitespace;    // Whether skip whitespace option enabled
 
          protected:
-            const CharIterator  LineStart,         // Input start position
-                                LineEnd;           // Input end position
-            CharIterator        Position;          // Position
             TokenArray          Output;            // Tokens parsed so far
          };
       }
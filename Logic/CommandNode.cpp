@@ -15,15 +15,15 @@ namespace Logic
    {
       namespace Compiler
       {
-#ifdef VALIDATION
-         /// <summary>An invisible node that functions as a jump target with address 'script_length+1'</summary>
-         CommandNode  CommandNode::EndOfScript;
-#endif
          // -------------------------------- CONSTRUCTION --------------------------------
 
          /// <summary>Create root node</summary>
-         CommandNode::CommandNode()
-            : Syntax(CommandSyntax::Unrecognised), 
+         /// <param name="arena">Arena the node was allocated from, or nullptr if allocated from the heap</param>
+         CommandNode::CommandNode(NodeArena* arena)
+            : Children(arena),
+              Parameters(arena),
+              Postfix(arena),
+              Syntax(CommandSyntax::Unrecognised), 
               Condition(Conditional::NONE),
               Parent(nullptr), 
               JumpTarget(nullptr), 
@@ -36,9 +36,13 @@ namespace Logic
          /// <summary>Create node for a hidden jump command</summary>
          /// <param name="parent">parent node</param>
          /// <param name="target">target node</param>
+         /// <param name="arena">Arena the node was allocated from, or nullptr if allocated from the heap</param>
          /// <exception cref="Logic::ArgumentNullException">Parent or target is null</exception>
-         CommandNode::CommandNode(const CommandNode& parent, const CommandNode* target)
-            : Syntax(SyntaxLib.Find(CMD_HIDDEN_JUMP, GameVersion::Threat)),
+         CommandNode::CommandNode(const CommandNode& parent, const CommandNode* target, NodeArena* arena)
+            : Children(arena),
+              Parameters(arena),
+              Postfix(arena),
+              Syntax(SyntaxLib.Find(CMD_HIDDEN_JUMP, GameVersion::Threat)),
               Condition(Conditional::NONE),
               JumpTarget(target),
               Parent(const_cast<CommandNode*>(&parent)),
@@ -56,12 +60,14 @@ namespace Logic
          /// <summary>Create a replacement for a macro command. The line number/text from the macro are preserved</summary>
          /// <param name="macro">macro command - line number, parent, line text preserved</param>
          /// <param name="expanded">expanded command - syntax, parameters, condition preserved</param>
+         /// <param name="arena">Arena the node was allocated from, or nullptr if allocated from the heap</param>
          /// <exception cref="Logic::AlgorithmException">macro command not a macro</exception>
-         CommandNode::CommandNode(const CommandNode& macro, const CommandNode& expanded)
+         CommandNode::CommandNode(const CommandNode& macro, const CommandNode& expanded, NodeArena* arena)
             : Syntax(expanded.Syntax),
               Condition(expanded.Condition),
-              Parameters(expanded.Parameters),
-              Postfix(expanded.Postfix),
+              Children(arena),
+              Parameters(expanded.Parameters, arena),
+              Postfix(expanded.Postfix, arena),
               LineNumber(macro.LineNumber), 
               Extent(expanded.Extent), 
               LineText(expanded.LineText),
@@ -74,6 +80,25 @@ namespace Logic
                throw AlgorithmException(HERE, L"Cannot expand command from a non-macro");
          }
          
+         /// <summary>Create an unattached copy of a parsed line, at another line number</summary>
+         /// <param name="line">parsed line - syntax, parameters, condition, text preserved</param>
+         /// <param name="number">1-based line number</param>
+         /// <param name="arena">Arena the node was allocated from, or nullptr if allocated from the heap</param>
+         CommandNode::CommandNode(const CommandNode& line, UINT number, NodeArena* arena)
+            : Syntax(line.Syntax),
+              Condition(line.Condition),
+              Children(arena),
+              Parameters(line.Parameters, arena),
+              Postfix(line.Postfix, arena),
+              LineNumber(number), 
+              Extent(line.Extent), 
+              LineText(line.LineText),
+              Parent(nullptr), 
+              JumpTarget(nullptr), 
+              Index(EMPTY_JUMP),
+              CmdComment(line.CmdComment)
+         {}
+         
          /// <summary>Create node for a script command</summary>
          /// <param name="cnd">conditional.</param>
          /// <param name="syntax">command syntax.</param>
@@ -81,11 +106,14 @@ namespace Logic
          /// <param name="lex">lexer.</param>
          /// <param name="line">1-based line number</param>
          /// <param name="commented">Whether command comment</param>
+         /// <param name="arena">Arena the node was allocated from, or nullptr if allocated from the heap</param>
          CommandNode::CommandNode(Conditional cnd, CommandSyntaxRef syntax, ParameterArray& params, 
-                                  const CommandLexer& lex, UINT line, bool commented)
+                                  const CommandLexer& lex, UINT line, bool commented, NodeArena* arena)
             : Syntax(syntax),
               Condition(cnd),
-              Parameters(move(params)),
+              Children(arena),
+              Parameters(move(params), arena),
+              Postfix(arena),
               LineNumber(line), 
               Extent(lex.Extent), 
               LineText(lex.Input),
@@ -103,12 +131,14 @@ namespace Logic
          /// <param name="lex">lexer.</param>
          /// <param name="line">1-based line number</param>
          /// <param name="commented">Whether command comment</param>
+         /// <param name="arena">Arena the node was allocated from, or nullptr if allocated from the heap</param>
          CommandNode::CommandNode(Conditional cnd, CommandSyntaxRef syntax, ParameterArray& infix, ParameterArray& postfix, 
-                                  const CommandLexer& lex, UINT line, bool commented)
+                                  const CommandLexer& lex, UINT line, bool commented, NodeArena* arena)
             : Syntax(syntax),
               Condition(cnd),
-              Parameters(move(infix)),
-              Postfix(move(postfix)),
+              Children(arena),
+              Parameters(move(infix), arena),
+              Postfix(move(postfix), arena),
               LineNumber(line), 
               Extent(lex.Extent), 
               LineText(lex.Input),
@@ -240,9 +270,9 @@ namespace Logic
             // Find next Std command that isn't ELSE-IF
             return FindSibling(isConditionalEnd, L"conditional end-point");
 #else
-            // EOF: Return sentinel
+            // EOF: Root functions as the end-of-script jump target, with address 'script_length+1'
             if (IsRoot())
-               return &EndOfScript;
+               return const_cast<CommandNode*>(this);
 
             // Find next sibling node containing a standard command
             auto node = find_if(++Parent->FindChild(this), Parent->Children.cend(), isConditionalEnd);
@@ -413,6 +443,13 @@ namespace Logic
             return JumpTarget ? JumpTarget->Index : EMPTY_JUMP;
          }
 
+         /// <summary>Gets the arena the node was allocated from.</summary>
+         /// <returns>Arena, or nullptr if the node was allocated from the heap</returns>
+         NodeArena*  CommandNode::GetArena() const
+         {
+            return Children.get_allocator().GetArena();
+         }
+
          /// <summary>Gets the last executable child.</summary>
          /// <returns></returns>
          /// <exception cref="Logic::AlgorithmException">No executable children</exception>
@@ -458,7 +495,7 @@ namespace Logic
          /// <returns></returns>
          void  CommandNode::InsertJump(NodeIterator pos, const CommandNode* target)
          {
-            Children.insert(pos, new CommandNode(*this, target));
+            Children.insert(pos, Create(GetArena(), *this, target));
          }
          
          /// <summary>Query whether node is root</summary>
@@ -520,7 +557,7 @@ namespace Logic
             ParameterArray params(ScriptParameter(newSyntax.Parameters[0], lex.Tokens[1]));
 
             // Generate new command + perform in-place replacement
-            ReplaceChild(child, new CommandNode(Conditional::NONE, newSyntax, params, lex, child->LineNumber, false));
+            ReplaceChild(child, Create(GetArena(), Conditional::NONE, newSyntax, params, lex, child->LineNumber, false));
          }
          
          /// <summary>Append node as a child</summary>
@@ -562,7 +599,7 @@ namespace Logic
          /// <param name="newChild">new replacement child.</param>
          /// <exception cref="Logic::ArgumentNullException">child is null</exception>
          /// <exception cref="Logic::InvalidOperationException">Child node not found</exception>
-         void CommandNode::ReplaceChild(CommandNode* oldChild, CommandNode* newChild)
+         void CommandNode::ReplaceChild(CommandNode* oldChild, const CommandNodePtr& newChild)
          {
             REQUIRED(oldChild);
             REQUIRED(newChild);
@@ -572,7 +609,8 @@ namespace Logic
                if (c.get() == oldChild)
                {
                   newChild->Parent = this;
-                  return c.reset(newChild);
+                  c = newChild;
+                  return;
                }
 
             // Error: Not found
@@ -31,6 +31,8 @@ namespace Logic
             {}
             CommandNodePtr(CommandNode* node) : shared_ptr<CommandNode>(node)
             {}
+            CommandNodePtr(const shared_ptr<CommandNode>& node) : shared_ptr<CommandNode>(node)
+            {}
 
             // ---------------------- ACCESSORS ------------------------	
 
@@ -72,27 +74,38 @@ namespace Logic
 
             // --------------------- CONSTRUCTION ----------------------
          public:
-            CommandNode();
-            CommandNode(const CommandNode& macro, const CommandNode& expanded);
-            CommandNode(Conditional cnd, CommandSyntaxRef syntax, ParameterArray& params, const CommandLexer& lex, UINT line, bool commented);
-            CommandNode(Conditional cnd, CommandSyntaxRef syntax, ParameterArray& infix, ParameterArray& postfix, const CommandLexer& lex, UINT line, bool commented);
+            explicit CommandNode(NodeArena* arena = nullptr);
+            CommandNode(const CommandNode& parent, const CommandNode* target, NodeArena* arena = nullptr);
+            CommandNode(const CommandNode& macro, const CommandNode& expanded, NodeArena* arena = nullptr);
+            CommandNode(const CommandNode& line, UINT number, NodeArena* arena = nullptr);
+            CommandNode(Conditional cnd, CommandSyntaxRef syntax, ParameterArray& params, const CommandLexer& lex, UINT line, bool commented, NodeArena* arena = nullptr);
+            CommandNode(Conditional cnd, CommandSyntaxRef syntax, ParameterArray& infix, ParameterArray& postfix, const CommandLexer& lex, UINT line, bool commented, NodeArena* arena = nullptr);
             virtual ~CommandNode();
 
-         protected:
-            CommandNode(const CommandNode& parent, const CommandNode* target);
-
             // ------------------------ STATIC -------------------------
          public:
+            /// <summary>Creates a node, together with its children and parameters, from an arena or the heap</summary>
+            /// <param name="arena">Arena of the tree, or nullptr to allocate from the heap</param>
+            /// <param name="args">Node constructor arguments, excluding the arena</param>
+            /// <returns>New node, not yet attached to a tree</returns>
+            /// <exception cref="std::bad_alloc">Out of memory</exception>
+            template <typename... ARGS>
+            static CommandNodePtr  Create(NodeArena* arena, ARGS&&... args)
+            {
+               // Heap: Node + reference count allocated separately
+               if (!arena)
+                  return new CommandNode(std::forward<ARGS>(args)...);
+
+               // Arena: Node + reference count allocated together, node shares ownership of the arena
+               return allocate_shared<CommandNode>(ArenaAllocator<CommandNode>(arena->shared_from_this()), std::forward<ARGS>(args)..., arena);
+            }
+
             static NodeDelegate  isConditionalAlternate;
             static NodeDelegate  isConditionalEnd;
             static NodeDelegate  isExecutableCommand;
             static NodeDelegate  isStandardCommand;
             static NodeDelegate  isSkipIfCompatible;
-            
-#ifdef VALIDATION
-            /// <summary>An invisible node that functions as a jump target with address 'script_length+1'</summary>
-            static CommandNode  EndOfScript;
-#endif
+
             // --------------------- PROPERTIES ------------------------
          public:
             PROPERTY_GET(bool,Empty,IsEmpty);
@@ -115,6 +128,7 @@ namespace Logic
             CommandNode*  FindSibling(NodeDelegate d, const wchar* help) const;
             BranchLogic   GetBranchLogic() const;
             UINT          GetJumpAddress() const;
+            NodeArena*    GetArena() const;
             CommandNode*  GetLastExecutableChild() const;
             GuiString     GetLineCode() const;
             wstring       GetScriptCallName() const;
@@ -137,7 +151,7 @@ namespace Logic
             CommandNode&   operator-=(const CommandNodePtr& n);
          
          protected:
-            void           ReplaceChild(CommandNode* oldChild, CommandNode* newChild);
+            void           ReplaceChild(CommandNode* oldChild, const CommandNodePtr& newChild);
             
             // -------------------- REPRESENTATION ---------------------
          public:
@@ -1,4 +1,5 @@
 #pragma once
+#include "NodeArena.h"
 
 namespace Logic
 {
@@ -9,9 +10,17 @@ namespace Logic
          class CommandNodePtr;
 
          /// <summary>List of script commands nodes</summary>
-         class LogicExport CommandNodeList : public list<CommandNodePtr>
+         /// <remarks>The children of a node allocated from an arena are stored in the same arena, other lists use the heap</remarks>
+         class LogicExport CommandNodeList : public list<CommandNodePtr, NodeAllocator<CommandNodePtr>>
          {
             // --------------------- CONSTRUCTION ----------------------
+         public:
+            CommandNodeList()
+            {}
+            /// <summary>Creates a list that allocates from an arena</summary>
+            /// <param name="alloc">Allocator for the arena</param>
+            explicit CommandNodeList(const allocator_type& alloc) : list(alloc)
+            {}
 
             // ------------------------ STATIC -------------------------
 
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "CommandSyntax.h"
 #include "CommandLexer.h"
+#include "TokenBuffer.h"
 #include "CommandHash.h"
 #include "StringLibrary.h"
 #include <algorithm>
@@ -64,7 +65,8 @@ namespace Logic
            VArgCount(d.VArgCount),
            VArgument(d.VArgument),
            VArgParams(d.VArgParams),
-           Hash(GenerateHash(d.Syntax))
+           Hash(GenerateHash(d.Syntax)),
+           Template(GenerateTemplate(d.Syntax))
       {
       }
 
@@ -83,6 +85,30 @@ namespace Logic
          return CommandHash(lex.begin(), lex.end()).Hash;
       }
 
+      /// <summary>Generates the template used to translate commands read from file, by splitting the syntax at each '$n' marker</summary>
+      /// <param name="syntax">The syntax.</param>
+      /// <returns>Segments of verbatim syntax text and parameter markers.  Consecutive syntax text is combined into a single segment</returns>
+      CommandSyntax::SegmentArray  CommandSyntax::GenerateTemplate(const wstring& syntax)
+      {
+         TokenBuffer  lex;
+         SegmentArray segments;
+
+         for (const LexToken& tok : lex.Lex(syntax, false))
+         {
+            // Marker: Insert parameter  [Lexer identifies comment syntax as 'comment']
+            if (tok.Type == TokenType::Variable || tok.Type == TokenType::Comment)
+               segments.push_back(Segment((UINT)(syntax[tok.Start+1]-48)));
+
+            // Text: Extend preceeding text to the end of this token, if any
+            else if (!segments.empty() && !segments.back().IsParameter())
+               segments.back().Length = tok.End - segments.back().Start;
+            else
+               segments.push_back(Segment(tok.Start, tok.Length));
+         }
+
+         return segments;
+      }
+
       /// <summary>Get command group name</summary>
       LogicExport GuiString  GetString(CommandGroup g)
       {
@@ -68,6 +68,32 @@ namespace Logic
             VArgMethod       VArgParams;
          };
 
+         /// <summary>Segment of the text generated from the syntax, either verbatim syntax text or the text of a parameter</summary>
+         class Segment
+         {
+         public:
+            /// <summary>Creates a segment of verbatim syntax text</summary>
+            /// <param name="start">Zero-based character index of the text within the syntax</param>
+            /// <param name="length">Length of the text</param>
+            Segment(UINT start, UINT length) : Start(start), Length(length), Parameter(-1)
+            {}
+
+            /// <summary>Creates a segment for the text of a parameter</summary>
+            /// <param name="param">Physical index of the parameter</param>
+            explicit Segment(UINT param) : Start(0), Length(0), Parameter(param)
+            {}
+
+            /// <summary>Query whether segment is the text of a parameter</summary>
+            bool  IsParameter() const   { return Parameter != -1; }
+
+            UINT  Start,         // Syntax text: Zero-based character index within the syntax
+                  Length;        // Syntax text: Length in characters
+            int   Parameter;     // Parameter: Physical index, otherwise -1
+         };
+
+         /// <summary>Segments of the text generated from the syntax, in order</summary>
+         typedef vector<Segment>  SegmentArray;
+
          // --------------------- CONSTRUCTION ----------------------
       private:
          CommandSyntax();
@@ -85,7 +111,8 @@ namespace Logic
          
 
       private:
-         wstring  GenerateHash(const wstring& syntax);
+         wstring       GenerateHash(const wstring& syntax);
+         SegmentArray  GenerateTemplate(const wstring& syntax);
 
          // --------------------- PROPERTIES ------------------------
 		
@@ -162,6 +189,7 @@ namespace Logic
                                  URL;
          const VArgSyntax        VArgument;
          const VArgMethod        VArgParams;
+         const SegmentArray      Template;      // Text generated from the syntax, precompiled for translating commands read from file
       };
 
       /// <summary>Defines the display group of a script command</summary>
@@ -12,7 +12,8 @@ namespace Logic
          // -------------------------------- CONSTRUCTION --------------------------------
 
          CommandTree::CommandTree() 
-            : Root(new CommandNode()),
+            : Arena(new NodeArena()),
+              Root(CreateNode()),
               State(TreeState::Raw)
          {
          }
@@ -39,10 +40,29 @@ namespace Logic
          
          // ------------------------------- PUBLIC METHODS -------------------------------
          
+         /// <summary>Discards every node, re-using the arena if none of its nodes remain in use elsewhere</summary>
+         void  CommandTree::Clear()
+         {
+            // Release root + descendants
+            Root = nullptr;
+
+            // Re-use arena, unless nodes are still shared with other trees or callers
+            if (Arena.unique())
+               Arena->Reset();
+            else
+               Arena.reset(new NodeArena());
+
+            // Reset state
+            Root = CreateNode();
+            State = TreeState::Raw;
+         }
+
          /// <summary>Compiles the script.</summary>
          /// <param name="script">The script.</param>
+         /// <param name="errors">errors collection</param>
+         /// <param name="timings">Time spent in each pass is added to this collection. May be nullptr</param>
          /// <exception cref="Logic::AlgorithmException">Error in linking algorithm</exception>
-         void  CommandTree::Compile(ScriptFile& script, ErrorArray& errors)
+         void  CommandTree::Compile(ScriptFile& script, ErrorArray& errors, PassManager::TimingArray* timings)
          {
             UINT i = 0;
             CommandGenerator   generator(script, errors);
@@ -51,6 +71,7 @@ namespace Logic
             NodeIndexer        indexer(i);
             NodeLinker         linker(errors);
             VariableIdentifier variables(script, errors);
+            PassManager        passes;
 
             // Macros: Query whether macros are enabled
             if (PrefsLib.UseMacroCommands)
@@ -62,25 +83,28 @@ namespace Logic
                // Clear previous IDs
                script.Clear();
 
-               // Re-index variables to account for hidden iterator variables
-               Transform(variables);
-
-               // Re-identify constants
-               Transform(constants);
+               // Re-index variables to account for hidden iterator variables + Re-identify constants
+               passes.Add(L"Variables", variables);
+               passes.Add(L"Constants", constants);
+               passes.Run(*Root, nullptr, timings);
+               passes.Clear();
 #endif
             }
 
-            // Linking/Indexing
-            Transform(linker);
-            Transform(indexer);
+            // Linking/Indexing  [Linker inserts jumps, which must be indexed]
+            passes.Add(L"Linker", linker, PassManager::NameArray(), true);
+            passes.Add(L"Indexer", indexer, { L"Linker" });
+            passes.Run(*Root, nullptr, timings);
+            passes.Clear();
                
 #ifdef VALIDATION
-            // Set address of EOF
-            CommandNode::EndOfScript.Index = i;     
+            // Set address of EOF  [Root is the end-of-script jump target of this tree]
+            Root->Index = i;
 #endif
-            // Finalize linkage + generate commands
-            Transform(finalizer);
-            Transform(generator);
+            // Finalize linkage + generate commands  [Both require only the finalized linkage of the node being generated]
+            passes.Add(L"Finalizer", finalizer);
+            passes.Add(L"Generator", generator);
+            passes.Run(*Root, nullptr, timings);
             
             // Update state
             State = TreeState::Compiled;
@@ -140,23 +164,30 @@ namespace Logic
          /// <summary>Verifies the entire tree</summary>
          /// <param name="script">script</param>
          /// <param name="errors">errors collection</param>
-         void  CommandTree::Verify(ScriptFile& script, ErrorArray& errors) 
+         /// <param name="cancelled">Queried between passes, verification is abandoned if it returns true. May be empty</param>
+         /// <param name="timings">Time spent in each pass is added to this collection. May be nullptr</param>
+         void  CommandTree::Verify(ScriptFile& script, ErrorArray& errors, const CancelDelegate& cancelled, PassManager::TimingArray* timings) 
          {
             CommandGenerator    commands(script, errors);
             ConstantIdentifier  constants(script, errors);
             LogicVerifier       logic(errors);
             TerminationVerifier termination(errors);
             VariableIdentifier  variables(script, errors);
+            PassManager         passes;
 
             // Identify labels/variables/constants
-            Transform(variables);
-            Transform(constants);
+            passes.Add(L"Variables", variables);
+            passes.Add(L"Constants", constants);
 
-            // Verify commands+parameters
-            Transform(commands);
+            // Verify commands+parameters  [Requires every label/variable]
+            passes.Add(L"Commands", commands, { L"Variables", L"Constants" });
 
             // branching logic
-            Transform(logic);
+            passes.Add(L"Logic", logic);
+
+            // Cancelled: Abandon verification  [Tree remains unverified]
+            if (!passes.Run(*Root, cancelled, timings))
+               return;
 
             // Ensure script has std commands  [don't count break/continue]
             if (!any_of(begin(), end(), CommandNode::isStandardCommand))
@@ -164,7 +195,11 @@ namespace Logic
 
             // [VALID] Verify all control paths lead to RETURN
             else if (errors.empty()) 
-               Transform(termination);
+            {
+               passes.Clear();
+               passes.Add(L"Termination", termination);
+               passes.Run(*Root, nullptr, timings);
+            }
             
             // Update state
             State = TreeState::Verified;
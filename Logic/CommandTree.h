@@ -1,6 +1,8 @@
 #pragma once
 #include "TreeTraversal.h"
 #include "TreeVisitors.h"
+#include "PassManager.h"
+#include "NodeArena.h"
 
 namespace Logic
 {
@@ -211,6 +213,9 @@ namespace Logic
             /// <summary>Distinguishes tree state when printed to the console</summary>
             enum class TreeState { Raw, Verified, Compiled };
 
+            /// <summary>Queries whether an operation has been cancelled</summary>
+            typedef PassManager::CancelDelegate  CancelDelegate;
+
             // --------------------- CONSTRUCTION ----------------------
          public:
             CommandTree();
@@ -270,9 +275,20 @@ namespace Logic
 
             // ----------------------- MUTATORS ------------------------
          public:
-            void         Compile(ScriptFile& script, ErrorArray& errors);
+            /// <summary>Creates a node, together with its children and parameters, allocated from the arena of this tree</summary>
+            /// <param name="args">Node constructor arguments, excluding the arena</param>
+            /// <returns>New node, not yet attached to the tree</returns>
+            /// <exception cref="std::bad_alloc">Out of memory</exception>
+            template <typename... ARGS>
+            CommandNodePtr  CreateNode(ARGS&&... args)
+            {
+               return CommandNode::Create(Arena.get(), std::forward<ARGS>(args)...);
+            }
+
+            void         Clear();
+            void         Compile(ScriptFile& script, ErrorArray& errors, PassManager::TimingArray* timings = nullptr);
             void         Transform(CommandNode::Visitor& v);
-            void         Verify(ScriptFile& script, ErrorArray& errors);
+            void         Verify(ScriptFile& script, ErrorArray& errors, const CancelDelegate& cancelled = nullptr, PassManager::TimingArray* timings = nullptr);
 
             CommandTree& operator+=(const CommandNodePtr& r);
 
@@ -281,6 +297,7 @@ namespace Logic
             
             // -------------------- REPRESENTATION ---------------------
          protected:
+            NodeArenaPtr   Arena;   // Allocates the nodes of the tree
             CommandNodePtr Root;    // Root node of parse tree
             TreeState      State;   // processing state
          };
@@ -0,0 +1,186 @@
+#include "stdafx.h"
+#include "CompilerWorker.h"
+#include "ComThreadHelper.h"
+
+namespace Logic
+{
+   namespace Threads
+   {
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates a snapshot of a script</summary>
+      /// <param name="id">Request ID</param>
+      /// <param name="owner">Window notified upon completion</param>
+      /// <param name="script">Script</param>
+      /// <param name="lines">Script text</param>
+      CompilerWorker::CompileRequest::CompileRequest(UINT id, HWND owner, const ScriptFile& script, const LineArray& lines)
+         : ID(id), Lines(lines), Owner(owner), Script(script.FullPath)
+      {
+         // Copy properties + arguments  [Remaining symbols are regenerated by the parser]
+         Script.Name = script.Name;
+         Script.Description = script.Description;
+         Script.Version = script.Version;
+         Script.Game = script.Game;
+         Script.LiveData = script.LiveData;
+         Script.CommandID = script.CommandID;
+         Script.Variables = script.Variables;
+      }
+
+      /// <summary>Creates an idle worker. The thread is started upon the first request</summary>
+      /// <exception cref="Logic::Win32Exception">Unable to create event</exception>
+      CompilerWorker::CompilerWorker() : Available(false, false), Exiting(false), Latest(0), Thread(nullptr)
+      {
+      }
+
+      /// <summary>Abandons any compile in progress and waits for the thread to exit</summary>
+      CompilerWorker::~CompilerWorker()
+      {
+         if (Thread)
+         {
+            // Request exit  [Compile in progress is abandoned at the next pass]
+            Exiting = true;
+            Cancel();
+            SetEvent(Available);
+
+            // Wait for exit
+            WaitForSingleObject(Thread, INFINITE);
+            CloseHandle(Thread);
+         }
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Compiles each request until commanded to exit</summary>
+      /// <param name="worker">The worker</param>
+      /// <returns></returns>
+      DWORD WINAPI  CompilerWorker::ThreadMain(CompilerWorker* worker)
+      {
+         ComThreadHelper COM;
+
+         // Wait for request or exit
+         while (WaitForSingleObject(worker->Available, INFINITE) == WAIT_OBJECT_0 && !worker->Exiting)
+            worker->Execute();
+
+         return 0;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Discards any pending request and abandons any compile in progress</summary>
+      void  CompilerWorker::Cancel()
+      {
+         Lock.Enter();
+         Pending.reset();
+         Result.reset();
+         ++Latest;
+         Lock.Leave();
+      }
+
+      /// <summary>Compiles a snapshot of a script, superseding any compile in progress</summary>
+      /// <param name="owner">Window to receive WM_COMPILE_COMPLETE upon completion</param>
+      /// <param name="script">Script</param>
+      /// <param name="lines">Script text</param>
+      /// <returns>Request ID, passed as the WPARAM of WM_COMPILE_COMPLETE</returns>
+      /// <exception cref="Logic::ArgumentNullException">Owner window is nullptr</exception>
+      /// <exception cref="Logic::Win32Exception">Failed to start thread</exception>
+      UINT  CompilerWorker::Compile(CWnd* owner, const ScriptFile& script, const LineArray& lines)
+      {
+         REQUIRED(owner);
+
+         // Start thread upon first request
+         if (!Thread && !(Thread = CreateThread(nullptr, 0, (LPTHREAD_START_ROUTINE)ThreadMain, this, 0, nullptr)))
+            throw Win32Exception(HERE, L"Unable to start compiler thread");
+
+         // Snapshot script
+         CompileRequestPtr request(new CompileRequest(Latest+1, owner->GetSafeHwnd(), script, lines));
+         UINT id = request->ID;
+
+         // Supersede previous request
+         Lock.Enter();
+         Pending = move(request);
+         Result.reset();
+         Latest = id;
+         Lock.Leave();
+
+         // Wake thread
+         Available.Signal();
+         return id;
+      }
+
+      /// <summary>Takes the result of the most recent request</summary>
+      /// <returns>Result, or nullptr if not yet complete or superseded</returns>
+      CompilerWorker::CompileResultPtr  CompilerWorker::TakeResult()
+      {
+         CompileResultPtr r;
+
+         Lock.Enter();
+         r.swap(Result);
+         Lock.Leave();
+
+         // Superseded: Discard
+         return r && r->ID == Latest ? r : nullptr;
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Compiles the pending request, if any</summary>
+      void  CompilerWorker::Execute()
+      {
+         // Take pending request  [Retained until the next compile, as the session references it]
+         Lock.Enter();
+         if (Pending)
+            Current = move(Pending);
+         else
+            Current.reset();
+         Lock.Leave();
+
+         if (!Current)
+            return;
+
+         try
+         {
+            CompileRequest& r = *Current;
+            Stopwatch sw;
+
+            // Parse + verify. Abandon if superseded
+            auto& parser = Session.Parse(r.Script, r.Lines, r.Script.Game, [this,&r] { return IsCancelled(r.ID); });
+            if (IsCancelled(r.ID))
+               return;
+
+            // Copy errors + symbols
+            CompileResultPtr result(new CompileResult(r.ID));
+            result->Errors.swap(parser.Errors);
+            result->Labels = r.Script.Labels;
+            result->ScriptCalls = r.Script.ScriptCalls;
+            result->Variables = r.Script.Variables;
+            result->Reparsed = Session.Reparsed;
+            result->Duration = sw.ElapsedMilliseconds;
+            result->Latency = r.Timer.ElapsedMilliseconds;
+
+            // Publish unless superseded meanwhile
+            Lock.Enter();
+            bool publish = !IsCancelled(r.ID);
+            if (publish)
+               Result = result;
+            Lock.Leave();
+
+            // Notify owner
+            if (publish)
+               PostMessage(r.Owner, WM_COMPILE_COMPLETE, r.ID, NULL);
+         }
+         catch (ExceptionBase& e) {
+            Console.Log(HERE, e, L"Unable to compile script");
+         }
+      }
+
+      /// <summary>Query whether a request has been superseded or cancelled</summary>
+      /// <param name="id">Request ID</param>
+      /// <returns></returns>
+      bool  CompilerWorker::IsCancelled(UINT id) const
+      {
+         return Exiting || Latest != id;
+      }
+   }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "ParseSession.h"
+#include "ScriptFile.h"
+#include "CriticalSection.h"
+#include "SyncEvent.h"
+#include "Stopwatch.h"
+
+namespace Logic
+{
+   namespace Threads
+   {
+      /// <summary>Notifies a window that a background compile has completed</summary>
+      #define WM_COMPILE_COMPLETE   (WM_USER+3)
+
+
+      /// <summary>Compiles scripts on a worker thread, superseding any compile in progress when a newer one is requested</summary>
+      /// <remarks>Each request compiles a snapshot of the script text and arguments, so the document may be edited meanwhile.  Superseded
+      /// compiles are abandoned between verification passes.  Completion is posted to the requesting window, which collects the
+      /// errors and symbol tables using TakeResult</remarks>
+      class LogicExport CompilerWorker
+      {
+         // ------------------------ TYPES --------------------------
+      public:
+         /// <summary>Errors and symbols produced by a compile</summary>
+         class CompileResult
+         {
+         public:
+            CompileResult(UINT id) : ID(id), Duration(0), Latency(0), Reparsed(0)
+            {}
+
+            const UINT                        ID;            // Request ID
+            double                            Duration,      // Time spent compiling, in milliseconds
+                                              Latency;       // Time from request to completion, in milliseconds
+            UINT                              Reparsed;      // Number of lines read
+            ErrorArray                        Errors;        // Compilation errors
+            ScriptFile::LabelCollection       Labels;        // Labels
+            ScriptFile::ScriptCallCollection  ScriptCalls;   // Scripts called
+            ScriptFile::VariableCollection    Variables;     // Arguments and variables
+         };
+
+         /// <summary>Shared pointer to a compile result</summary>
+         typedef shared_ptr<CompileResult>  CompileResultPtr;
+
+      private:
+         /// <summary>Snapshot of a script to compile</summary>
+         class CompileRequest
+         {
+         public:
+            CompileRequest(UINT id, HWND owner, const ScriptFile& script, const LineArray& lines);
+
+            const UINT       ID;         // Request ID
+            const LineArray  Lines;      // Script text
+            const HWND       Owner;      // Window notified upon completion
+            ScriptFile       Script;     // Script properties and arguments
+            Stopwatch        Timer;      // Time since request
+         };
+
+         /// <summary>Unique pointer to a compile request</summary>
+         typedef unique_ptr<CompileRequest>  CompileRequestPtr;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         CompilerWorker();
+         virtual ~CompilerWorker();
+
+         NO_COPY(CompilerWorker);	// Uncopyable
+		   NO_MOVE(CompilerWorker);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static DWORD WINAPI  ThreadMain(CompilerWorker* worker);
+
+         // --------------------- PROPERTIES ------------------------
+
+         // ---------------------- ACCESSORS ------------------------
+      private:
+         bool  IsCancelled(UINT id) const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         void              Cancel();
+         UINT              Compile(CWnd* owner, const ScriptFile& script, const LineArray& lines);
+         CompileResultPtr  TakeResult();
+
+      private:
+         void  Execute();
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         SyncEvent          Available;     // Signalled when a request is pending or the thread should exit
+         CompileRequestPtr  Current;       // Request being compiled  [Worker thread only]
+         volatile bool      Exiting;       // Whether the thread should exit
+         volatile UINT      Latest;        // ID of the most recent request
+         CriticalSection    Lock;          // Guards pending request and result
+         CompileRequestPtr  Pending;       // Most recent request, if not yet started
+         CompileResultPtr   Result;        // Most recent result, if not yet taken
+         ParseSession       Session;       // Caches lines between compiles  [Worker thread only]
+         HANDLE             Thread;        // Worker thread, created upon the first request
+      };
+
+   }
+}
+
+using namespace Logic::Threads;
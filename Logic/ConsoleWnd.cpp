@@ -40,6 +40,9 @@ namespace Logic
             Visible = false;
 #endif
          }
+         // Existing console: Write to the console of the command-line tool
+         else
+            Handle = GetStdHandle(STD_OUTPUT_HANDLE);
       }
 
       /// <summary>Frees the console.</summary>
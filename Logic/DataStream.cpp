@@ -2,7 +2,7 @@
 #include "DataStream.h"
 #include "FileStream.h"
 #include "XCatalog.h"
-#include <cassert>
+#include "XorCipher.h"
 
 //using namespace Logic::FileSystem;
 
@@ -14,38 +14,56 @@ namespace Logic
 
       /// <summary>Creates a data stream from a file descriptor</summary>
       /// <param name="f">The file to open</param>
+      /// <exception cref="Logic::ArgumentException">File exceeds the length of the mapped data file</exception>
       /// <exception cref="Logic::FileNotFoundException">Data file not found</exception>
       /// <exception cref="Logic::IOException">An I/O error occurred</exception>
       DataStream::DataStream(const XFileInfo&  f)
-         : StreamDecorator( StreamPtr(new FileStream(f.DataFile, FileMode::OpenExisting, FileAccess::Read)) ),
-           File(f)
+         : Mapping(f.Catalog->GetDataView()), View(nullptr), Offset(f.Offset), Length(f.Length), Position(0)
       {
-         // Seek to logical beginning of file
-         StreamDecorator::Seek(File.Offset, SeekOrigin::Begin);
-         assert(StreamDecorator::GetPosition() == File.Offset);
+         // Mapped: Lookup logical file within view
+         if (Mapping)
+            View = Mapping->GetView(Offset, Length);
+         else
+         {
+            // Streamed: Open data file + seek to logical beginning of file
+            Source = StreamPtr(new FileStream(f.DataFile, FileMode::OpenExisting, FileAccess::Read));
+            Source->Seek(Offset, SeekOrigin::Begin);
+         }
       }
 
       /// <summary>Closes the stream without throwing</summary>
       DataStream::~DataStream()
       {
-         StreamDecorator::SafeClose();
+         SafeClose();
       }
 
       // ------------------------------- PUBLIC METHODS -------------------------------
 
+      /// <summary>Closes the stream.</summary>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  DataStream::Close()
+      {
+         if (Source)
+            Source->Close();
+      }
+
+      /// <summary>Does nothing</summary>
+      void  DataStream::Flush()
+      {
+      }
+
       /// <summary>Gets the length of the logical file</summary>
       /// <returns></returns>
       DWORD DataStream::GetLength()
       {
-         return File.Length;
+         return Length;
       }
 
       /// <summary>Gets the current position within the logical file</summary>
       /// <returns></returns>
-      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
       DWORD DataStream::GetPosition() const
       {
-         return StreamDecorator::GetPosition() - File.Offset;
+         return Position;
       }
 
       /// <summary>Reads/decodes from the stream into the specified buffer.</summary>
@@ -53,43 +71,63 @@ namespace Logic
       /// <param name="length">The length of the buffer</param>
       /// <returns>Number of bytes read</returns>
       /// <exception cref="Logic::ArgumentNullException">Buffer is null</exception>
-      /// <exception cref="Logic::NotSupportedException">Stream is not readable</exception>
       /// <exception cref="Logic::IOException">An I/O error occurred</exception>
       DWORD  DataStream::Read(BYTE* buffer, DWORD length)
       {
          REQUIRED(buffer);
 
          // Ensure we don't exceed logical EOF
-         if (GetPosition() + length > GetLength())
-            length = GetLength() - GetPosition();
+         if (Position >= Length)
+            return 0;
+         else if (length > Length - Position)
+            length = Length - Position;
+
+         DWORD bytesRead = 0;
+
+         // Mapped: Copy directly from view
+         if (View)
+            memcpy(buffer, View + Position, bytesRead = length);
+         else
+            // Streamed: Read from data file
+            bytesRead = Source->Read(buffer, length);
 
-         // Read + Decode buffer
-         DWORD bytesRead = StreamDecorator::Read(buffer, length);
+         // Decode buffer + advance
          Encode(buffer, bytesRead);
+         Position += bytesRead;
          return bytesRead;
       }
 
-      /// <summary>Not supported</summary>
+      /// <summary>Closes the stream without throwing.</summary>
+      void  DataStream::SafeClose()
+      {
+         if (Source)
+            Source->SafeClose();
+      }
+
+      /// <summary>Seeks within the logical file</summary>
       /// <param name="offset">The offset.</param>
       /// <param name="mode">The mode.</param>
-      /// <exception cref="Logic::NotSupportedException">Stream is not seekable</exception>
       /// <exception cref="Logic::IOException">An I/O error occurred</exception>
       void  DataStream::Seek(LONG  offset, SeekOrigin  mode)
       {
          switch (mode)
          {
-         case SeekOrigin::Begin:    
-            StreamDecorator::Seek((LONG)File.Offset + offset, SeekOrigin::Begin);      
-            break;
+         case SeekOrigin::Begin:    Position = offset;                      break;
+         case SeekOrigin::Current:  Position = (LONG)Position + offset;     break;
+         case SeekOrigin::End:      Position = (LONG)Length + offset;       break;
+         }
 
-         case SeekOrigin::Current:  
-            StreamDecorator::Seek(offset, mode);                                       
-            break;
+         // Streamed: Seek data file
+         if (Source)
+            Source->Seek((LONG)(Offset + Position), SeekOrigin::Begin);
+      }
 
-         case SeekOrigin::End:      
-            StreamDecorator::Seek((LONG)File.Offset + (LONG)File.Length + offset, SeekOrigin::Begin);      
-            break;
-         }
+      /// <summary>Not supported</summary>
+      /// <param name="length">The length.</param>
+      /// <exception cref="Logic::NotSupportedException">Always</exception>
+      void  DataStream::SetLength(DWORD  length)
+      {
+         throw NotSupportedException(HERE, L"Catalog based files are read-only");
       }
 
       /// <summary>Writes/encodes the specified buffer to the stream</summary>
@@ -100,14 +138,6 @@ namespace Logic
       DWORD  DataStream::Write(const BYTE* buffer, DWORD length)
       {
          throw NotImplementedException(HERE, L"writing .dat files");
-
-         //// Copy buffer so we can encode it
-         //ByteArrayPtr copy(new BYTE[length]);
-         //memcpy(copy.get(), buffer, length);
-
-         //// Encode + Write
-         //Encode(copy.get(), length);
-         //return StreamDecorator::Write(copy.get(), length);
       }
 
       // ------------------------------ PROTECTED METHODS -----------------------------
@@ -123,10 +153,9 @@ namespace Logic
          REQUIRED(buffer);
 
          // Encode buffer
-         for (DWORD i = 0; i < length; i++)
-            buffer[i] ^= DATAFILE_ENCRYPT_KEY;
+         XorCipher::Encode(buffer, length, DATAFILE_ENCRYPT_KEY);
       }
 
       // -------------------------------- NESTED CLASSES ------------------------------
    }
-}
\ No newline at end of file
+}
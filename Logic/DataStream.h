@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Stream.h"
+#include "MappedFile.h"
 #include "XFileInfo.h"
 
 namespace Logic
@@ -9,10 +10,12 @@ namespace Logic
    {
 
       /// <summary>Provides stream access to the contents of catalog data files</summary>
-      class LogicExport DataStream : public StreamDecorator
+      /// <remarks>When the catalog has been mapped into memory the stream is a cursor over the mapped view,
+      /// otherwise it opens its own stream on the data file</remarks>
+      class LogicExport DataStream : public Stream
       {
       const byte  DATAFILE_ENCRYPT_KEY = 0x33;
-         
+
          // --------------------- CONSTRUCTION ----------------------
 
       public:
@@ -25,16 +28,27 @@ namespace Logic
          NO_COPY(DataStream);
 
          // --------------------- PROPERTIES ------------------------
-			
+
 			// ---------------------- ACCESSORS ------------------------
 
+         bool   CanRead() const   { return true;  }
+         bool   CanSeek() const   { return true;  }
+         bool   CanWrite() const  { return false; }
+
          DWORD  GetLength();
          DWORD  GetPosition() const;
 
+         /// <summary>Query whether stream reads from a mapped view</summary>
+         bool   IsMapped() const  { return View != nullptr; }
+
 			// ----------------------- MUTATORS ------------------------
 
+         void   Close();
+         void   Flush();
+         void   SafeClose();
          DWORD  Read(BYTE* buffer, DWORD length);
          void   Seek(LONG  offset, SeekOrigin  mode);
+         void   SetLength(DWORD  length);
          DWORD  Write(const BYTE* buffer, DWORD length);
 
       private:
@@ -42,7 +56,12 @@ namespace Logic
 
          // -------------------- REPRESENTATION ---------------------
 
-         const XFileInfo&  File;
+         StreamPtr     Source;       // Streamed: Data file stream
+         MappedFilePtr Mapping;      // Mapped: Keeps the mapped data file alive while stream is open
+         const BYTE*   View;         // Mapped: First byte of logical file within mapped data file
+         const DWORD   Offset,       // Offset of logical file within data file
+                       Length;       // Length of logical file
+         DWORD         Position;     // Position within logical file
       };
 
    }
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "EncryptedX2Stream.h"
+#include "XorCipher.h"
 
 namespace Logic
 {
@@ -111,8 +112,7 @@ namespace Logic
       void  EncryptedX2Stream::Encode(byte* buffer, DWORD length)
       {
          // Encode buffer
-         for (DWORD i = 0; i < length; i++)
-            buffer[i] ^= DECRYPT_KEY;
+         XorCipher::Encode(buffer, length, DECRYPT_KEY);
       }
 
    }
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "EncryptedX3Stream.h"
+#include "XorCipher.h"
 
 namespace Logic
 {
@@ -145,8 +146,7 @@ namespace Logic
       void  EncryptedX3Stream::Encode(byte* buffer, DWORD length)
       {
          // Encode buffer
-         for (DWORD i = 0; i < length; i++)
-            buffer[i] ^= DECRYPT_KEY;
+         XorCipher::Encode(buffer, length, DECRYPT_KEY);
       }
 
    }
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "FileWatcherWorker.h"
 #include "ComThreadHelper.h"
+#include "ScriptCallCache.h"
+#include "SearchIndex.h"
 #include <strsafe.h>
 
 namespace Logic
@@ -243,6 +245,13 @@ namespace Logic
                // Watch for changes
                for (auto& c : fw.Watch(data->AbortEvent))
                {
+                  // Discard cached script-call properties and indexed text of any modified file
+                  if (c.Action == FileWatcher::ChangeType::Modified)
+                  {
+                     ScriptCallLib.Invalidate(c.FullPath);
+                     SearchIndexLib.Invalidate(c.FullPath);
+                  }
+
                   // Notify owner window if file was modified
                   if (c.Action == FileWatcher::ChangeType::Modified && c.FullPath == path)
                   {
@@ -0,0 +1,501 @@
+#include "stdafx.h"
+#include "GameDataSnapshot.h"
+#include "MappedFile.h"
+#include "FileStream.h"
+#include "StringLibrary.h"
+#include "ScriptObjectLibrary.h"
+#include "SyntaxLibrary.h"
+#include "zlib.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      // -------------------------------- NESTED CLASSES ------------------------------
+
+      /// <summary>Reads values from a snapshot body</summary>
+      class GameDataSnapshot::Reader
+      {
+      public:
+         /// <summary>Creates a reader for a buffer</summary>
+         /// <param name="buf">The buffer</param>
+         /// <param name="length">Length of buffer, in bytes</param>
+         Reader(const BYTE* buf, DWORD length) : Buffer(buf), Length(length), Position(0)
+         {}
+
+         /// <summary>Reads a 32-bit value</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of snapshot</exception>
+         DWORD  ReadDWord()
+         {
+            DWORD value;
+            Read(&value, sizeof(value));
+            return value;
+         }
+
+         /// <summary>Reads a length-prefixed UTF-16 string</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of snapshot</exception>
+         wstring  ReadString()
+         {
+            DWORD chars = ReadDWord();
+
+            // Ensure string lies within buffer
+            if (chars > (Length - Position) / sizeof(WCHAR))
+               throw FileFormatException(HERE, L"Unexpected end of snapshot");
+
+            wstring str(reinterpret_cast<const WCHAR*>(Buffer + Position), chars);
+            Position += chars * sizeof(WCHAR);
+            return str;
+         }
+
+      private:
+         /// <summary>Reads raw bytes</summary>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of snapshot</exception>
+         void  Read(void* output, DWORD length)
+         {
+            if (length > Length - Position)
+               throw FileFormatException(HERE, L"Unexpected end of snapshot");
+
+            memcpy(output, Buffer + Position, length);
+            Position += length;
+         }
+
+         const BYTE*  Buffer;
+         const DWORD  Length;
+         DWORD        Position;
+      };
+
+      /// <summary>Writes values to a snapshot body</summary>
+      class GameDataSnapshot::Writer
+      {
+      public:
+         /// <summary>Writes a 32-bit value</summary>
+         void  Write(DWORD value)
+         {
+            Write(&value, sizeof(value));
+         }
+
+         /// <summary>Writes a length-prefixed UTF-16 string</summary>
+         void  Write(const wstring& str)
+         {
+            Write((DWORD)str.length());
+            Write(str.c_str(), str.length() * sizeof(WCHAR));
+         }
+
+         /// <summary>Writes raw bytes</summary>
+         void  Write(const void* buf, DWORD length)
+         {
+            const BYTE* bytes = reinterpret_cast<const BYTE*>(buf);
+            Buffer.insert(Buffer.end(), bytes, bytes + length);
+         }
+
+         vector<BYTE>  Buffer;
+      };
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates a snapshot stored at the specified path</summary>
+      /// <param name="path">Full path of snapshot file</param>
+      GameDataSnapshot::GameDataSnapshot(Path path) : FullPath(path)
+      {
+      }
+
+      GameDataSnapshot::~GameDataSnapshot()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Calculates the key identifying the source files and settings of the game data</summary>
+      /// <param name="vfs">Enumerated file system</param>
+      /// <param name="lang">Game data language</param>
+      /// <returns>Key that changes whenever the language files, syntax files, game version or language change</returns>
+      DWORD64  GameDataSnapshot::GetKey(const XFileSystem& vfs, GameLanguage lang)
+      {
+         DWORD64 key = 14695981039346656037ULL;
+         DWORD   settings[3] = { FORMAT, (DWORD)vfs.GetVersion(), (DWORD)lang };
+
+         // Settings
+         Combine(key, settings, sizeof(settings));
+
+         // Language files: Include location within data file, and the data file itself
+         for (const XFileInfo& f : vfs.Browse(XFolder::Language))
+         {
+            Combine(key, f.FullPath);
+            if (f.Source == FileSource::Catalog)
+            {
+               DWORD position[2] = { f.Offset, f.Length };
+               Combine(key, position, sizeof(position));
+               Combine(key, f.DataFile);
+            }
+         }
+
+         // Syntax files
+         Combine(key, AppPath(L"Data\\Commands.xml"));
+         Combine(key, AppPath(L"Data\\Command Syntax.txt"));
+         return key;
+      }
+
+      /// <summary>Combines a buffer into a key, using FNV-1a</summary>
+      /// <param name="key">The key</param>
+      /// <param name="buf">The buffer</param>
+      /// <param name="length">Length of buffer, in bytes</param>
+      void  GameDataSnapshot::Combine(DWORD64& key, const void* buf, DWORD length)
+      {
+         const BYTE* bytes = reinterpret_cast<const BYTE*>(buf);
+
+         for (DWORD i = 0; i < length; ++i)
+            key = (key ^ bytes[i]) * 1099511628211ULL;
+      }
+
+      /// <summary>Combines the path, size and modification time of a file into a key</summary>
+      /// <param name="key">The key</param>
+      /// <param name="file">Full path of file, need not exist</param>
+      void  GameDataSnapshot::Combine(DWORD64& key, const Path& file)
+      {
+         WIN32_FILE_ATTRIBUTE_DATA attr;
+
+         // Path
+         Combine(key, file.c_str(), file.Length * sizeof(WCHAR));
+
+         // Size/Modification time  (if present)
+         if (GetFileAttributesEx(file.c_str(), GetFileExInfoStandard, &attr))
+         {
+            DWORD stats[4] = { attr.nFileSizeLow, attr.nFileSizeHigh, attr.ftLastWriteTime.dwLowDateTime, attr.ftLastWriteTime.dwHighDateTime };
+            Combine(key, stats, sizeof(stats));
+         }
+      }
+
+      /// <summary>Reads the script objects into the script object library</summary>
+      /// <param name="r">Reader</param>
+      /// <exception cref="Logic::FileFormatException">Unexpected end of snapshot</exception>
+      void  GameDataSnapshot::ReadObjects(Reader& r)
+      {
+         // Lookup collection, then ID collection  [Names are already mangled]
+         for (int pass = 0; pass < 2; ++pass)
+            for (DWORD count = r.ReadDWord(); count > 0; --count)
+            {
+               UINT              id = r.ReadDWord();
+               ScriptObjectGroup group = (ScriptObjectGroup)r.ReadDWord();
+               GuiString         text = r.ReadString();
+               GameVersion       ver = (GameVersion)r.ReadDWord();
+
+               if (pass == 0)
+                  ScriptObjectLib.Lookup.Add(ScriptObject(id, group, text, ver));
+               else
+                  ScriptObjectLib.Objects.Add(ScriptObject(id, group, text, ver));
+            }
+      }
+
+      /// <summary>Reads the language files into the string library</summary>
+      /// <param name="r">Reader</param>
+      /// <exception cref="Logic::FileFormatException">Unexpected end of snapshot</exception>
+      void  GameDataSnapshot::ReadStrings(Reader& r)
+      {
+         for (DWORD files = r.ReadDWord(); files > 0; --files)
+         {
+            UINT         fileID = r.ReadDWord();
+            GameLanguage lang = (GameLanguage)r.ReadDWord();
+            LanguageFile file(r.ReadString());
+
+            file.ID = fileID;
+            file.Language = lang;
+
+            // Pages
+            for (DWORD pages = r.ReadDWord(); pages > 0; --pages)
+            {
+               UINT    pageID = r.ReadDWord();
+               wstring title = r.ReadString(),
+                       desc = r.ReadString();
+               LanguagePage page(pageID, title, desc, r.ReadDWord() != 0);
+
+               // Strings
+               for (DWORD strings = r.ReadDWord(); strings > 0; --strings)
+               {
+                  UINT    id = r.ReadDWord();
+                  wstring text = r.ReadString();
+                  LanguageString str(id, pageID, text, (GameVersion)r.ReadDWord());
+                  str.TagType = (ColourTag)r.ReadDWord();
+                  page.Add(str);
+               }
+
+               file.Pages.insert(LanguageFile::PageCollection::value_type(pageID, move(page)));
+            }
+
+            StringLib.Files.insert(move(file));
+         }
+
+         // Merge strings
+         StringLib.UpdateLookup();
+      }
+
+      /// <summary>Reads the command syntax into the syntax library</summary>
+      /// <param name="r">Reader</param>
+      /// <exception cref="Logic::FileFormatException">Unexpected end of snapshot</exception>
+      void  GameDataSnapshot::ReadSyntax(Reader& r)
+      {
+         SyntaxFile file(L"Game data snapshot", VString(L"v%d", FORMAT));
+
+         // Groups
+         for (DWORD groups = r.ReadDWord(); groups > 0; --groups)
+         {
+            CommandGroup g = (CommandGroup)r.ReadDWord();
+            file.Groups.Add(VString(L"%d", g), g);
+         }
+
+         // Commands
+         for (DWORD commands = r.ReadDWord(); commands > 0; --commands)
+         {
+            CommandSyntax::Declaration d;
+            d.Group = (CommandGroup)r.ReadDWord();
+            d.Type = (CommandType)r.ReadDWord();
+            d.Versions = r.ReadDWord();
+            d.ID = r.ReadDWord();
+            d.VArgCount = r.ReadDWord();
+            d.URL = r.ReadString();
+            d.Syntax = r.ReadString();
+            d.Execution = (ExecutionType)r.ReadDWord();
+            d.VArgument = (VArgSyntax)r.ReadDWord();
+            d.VArgParams = (VArgMethod)r.ReadDWord();
+
+            // Parameters
+            for (DWORD params = r.ReadDWord(); params > 0; --params)
+            {
+               ParameterType  type = (ParameterType)r.ReadDWord();
+               UINT           physical = r.ReadDWord(),
+                              display = r.ReadDWord(),
+                              ordinal = r.ReadDWord();
+               ParameterSyntax::Declaration p(type, physical, display, ordinal, (ParameterUsage)r.ReadDWord());
+               d.Params.push_back(ParameterSyntax(p));
+            }
+
+            file.Commands.Add(CommandSyntax(d));
+         }
+
+         // Populate library + syntax tree
+         SyntaxLib.Add(file);
+      }
+
+      /// <summary>Writes the contents of the script object library</summary>
+      /// <param name="w">Writer</param>
+      void  GameDataSnapshot::WriteObjects(Writer& w)
+      {
+         auto write = [&w](const ScriptObject& obj)
+         {
+            w.Write(obj.ID);
+            w.Write((DWORD)obj.Group);
+            w.Write(obj.Text);
+            w.Write((DWORD)obj.Version);
+         };
+
+         // Lookup collection
+         w.Write(ScriptObjectLib.Lookup.size());
+         for (auto& pair : ScriptObjectLib.Lookup)
+            write(pair.second);
+
+         // ID collection
+         w.Write(ScriptObjectLib.Objects.size());
+         for (auto& pair : ScriptObjectLib.Objects)
+            write(pair.second);
+      }
+
+      /// <summary>Writes the contents of the string library</summary>
+      /// <param name="w">Writer</param>
+      void  GameDataSnapshot::WriteStrings(Writer& w)
+      {
+         w.Write(StringLib.Files.size());
+         for (const LanguageFile& f : StringLib.Files)
+         {
+            w.Write(f.ID);
+            w.Write((DWORD)f.Language);
+            w.Write(f.FullPath.ToString());
+
+            // Pages
+            w.Write(f.Pages.size());
+            for (auto& pair : f.Pages)
+            {
+               const LanguagePage& page = pair.second;
+               w.Write(page.ID);
+               w.Write(page.Title);
+               w.Write(page.Description);
+               w.Write(page.Voiced ? 1UL : 0UL);
+
+               // Strings
+               w.Write(page.Strings.size());
+               for (auto& str : page.Strings)
+               {
+                  w.Write(str.second.ID);
+                  w.Write(str.second.Text);
+                  w.Write((DWORD)str.second.Version);
+                  w.Write((DWORD)str.second.TagType);
+               }
+            }
+         }
+      }
+
+      /// <summary>Writes the contents of the syntax library</summary>
+      /// <param name="w">Writer</param>
+      void  GameDataSnapshot::WriteSyntax(Writer& w)
+      {
+         // Groups
+         w.Write(SyntaxLib.Groups.size());
+         for (CommandGroup g : SyntaxLib.Groups)
+            w.Write((DWORD)g);
+
+         // Commands
+         w.Write(SyntaxLib.Commands.size());
+         for (auto& pair : SyntaxLib.Commands)
+         {
+            const CommandSyntax& s = pair.second;
+            w.Write((DWORD)s.Group);
+            w.Write((DWORD)s.Type);
+            w.Write(s.Versions);
+            w.Write(s.ID);
+            w.Write(s.VArgCount);
+            w.Write(s.URL);
+            w.Write(s.Text);
+            w.Write((DWORD)s.Execution);
+            w.Write((DWORD)s.VArgument);
+            w.Write((DWORD)s.VArgParams);
+
+            // Parameters
+            w.Write(s.Parameters.size());
+            for (const ParameterSyntax& p : s.Parameters)
+            {
+               w.Write((DWORD)p.Type);
+               w.Write(p.PhysicalIndex);
+               w.Write(p.DisplayIndex);
+               w.Write(p.Ordinal);
+               w.Write((DWORD)p.Usage);
+            }
+         }
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Loads the string, script object and syntax libraries from the snapshot, if it is valid</summary>
+      /// <param name="key">Key of current source files</param>
+      /// <param name="data">Background worker data</param>
+      /// <returns>True if loaded, false if the snapshot is missing, stale or corrupt.  Libraries are left empty on failure</returns>
+      /// <exception cref="Logic::ArgumentNullException">Worker data is null</exception>
+      bool  GameDataSnapshot::Load(DWORD64 key, WorkerData* data)
+      {
+         REQUIRED(data);
+
+         // Missing: Skip
+         if (!FullPath.Exists())
+            return false;
+
+         // Feedback
+         data->SendFeedback(Cons::Heading, ProgressType::Operation, 1, L"Loading game data snapshot");
+         Console << L"Reading game data snapshot: " << FullPath << L"...";
+
+         try
+         {
+            MappedFile file(FullPath);
+
+            // Validate header
+            if (file.Length < sizeof(Header))
+               throw FileFormatException(HERE, L"Snapshot is truncated");
+
+            const Header* header = reinterpret_cast<const Header*>(file.GetView(0, sizeof(Header)));
+            if (header->Magic != MAGIC || header->Format != FORMAT)
+               throw FileFormatException(HERE, L"Unrecognised snapshot format");
+
+            // Stale: Regenerate
+            if (header->Key != key)
+            {
+               data->SendFeedback(ProgressType::Info, 2, L"Game data has changed, snapshot will be regenerated");
+               Console << Cons::Yellow << L"Stale" << ENDL;
+               return false;
+            }
+
+            // Validate body
+            if (header->Length != file.Length - sizeof(Header))
+               throw FileFormatException(HERE, L"Snapshot is truncated");
+
+            const BYTE* body = file.GetView(sizeof(Header), header->Length);
+            if (header->Checksum != crc32(0, body, header->Length))
+               throw FileFormatException(HERE, L"Snapshot checksum mismatch");
+
+            // Populate libraries
+            Reader r(body, header->Length);
+            ReadStrings(r);
+            ReadObjects(r);
+            ReadSyntax(r);
+
+            // Feedback
+            data->SendFeedback(ProgressType::Info, 2, VString(L"Loaded %d language files, %d script objects and %d commands from snapshot",
+                                                              StringLib.Files.size(), ScriptObjectLib.Lookup.size(), SyntaxLib.Commands.size()));
+            Console << Cons::Success << ENDL;
+            return true;
+         }
+         catch (ExceptionBase& e) {
+            // Corrupt: Discard partial contents
+            StringLib.Clear();
+            ScriptObjectLib.Clear();
+            SyntaxLib.Clear();
+
+            data->SendFeedback(ProgressType::Warning, 2, GuiString(L"Unable to load snapshot: ") + e.Message);
+            Console << Cons::Failure << e.Message << ENDL;
+            return false;
+         }
+      }
+
+      /// <summary>Saves the contents of the string, script object and syntax libraries</summary>
+      /// <param name="key">Key of source files</param>
+      /// <param name="data">Background worker data</param>
+      /// <exception cref="Logic::ArgumentNullException">Worker data is null</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  GameDataSnapshot::Save(DWORD64 key, WorkerData* data) const
+      {
+         REQUIRED(data);
+
+         Writer  w;
+         Header  header;
+         Path    temp = FullPath.RenameExtension(L".new");
+
+         // Feedback
+         data->SendFeedback(ProgressType::Info, 2, L"Generating game data snapshot");
+         Console << L"Writing game data snapshot: " << FullPath << L"...";
+
+         try
+         {
+            // Generate body
+            WriteStrings(w);
+            WriteObjects(w);
+            WriteSyntax(w);
+
+            // Generate header
+            header.Magic = MAGIC;
+            header.Format = FORMAT;
+            header.Key = key;
+            header.Length = w.Buffer.size();
+            header.Checksum = crc32(0, w.Buffer.data(), w.Buffer.size());
+
+            // Write to temporary file, then replace existing snapshot
+            FileStream fs(temp, FileMode::CreateAlways, FileAccess::Write);
+            fs.Write(reinterpret_cast<const BYTE*>(&header), sizeof(header));
+            fs.Write(w.Buffer.data(), w.Buffer.size());
+            fs.Close();
+
+            if (!MoveFileEx(temp.c_str(), FullPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+               throw IOException(HERE, SysErrorString());
+
+            // Feedback
+            Console << Cons::Success << ENDL;
+         }
+         catch (ExceptionBase& e) {
+            Console << Cons::Failure << e.Message << ENDL;
+            DeleteFile(temp.c_str());
+            throw;
+         }
+      }
+
+		// ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+   }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "XFileSystem.h"
+#include "BackgroundWorker.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+
+      /// <summary>Versioned, checksummed binary snapshot of the parsed game data</summary>
+      /// <remarks>Stores the language strings, script objects and command syntax so they can be restored without parsing
+      /// the language and syntax files.  Snapshots are keyed on the files they were generated from and the game data settings</remarks>
+      class LogicExport GameDataSnapshot
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Snapshot file header</summary>
+         class Header
+         {
+         public:
+            DWORD    Magic,      // Identifies snapshot files
+                     Format;     // Snapshot format version
+            DWORD64  Key;        // Key of source files
+            DWORD    Length,     // Length of body, in bytes
+                     Checksum;   // CRC32 of body
+         };
+
+         class Reader;
+         class Writer;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         GameDataSnapshot(Path path);
+         virtual ~GameDataSnapshot();
+
+         NO_COPY(GameDataSnapshot);	// Uncopyable
+		   NO_MOVE(GameDataSnapshot);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static const DWORD  MAGIC = 0x44475358,   // 'XSGD'
+                             FORMAT = 1;
+
+         static DWORD64  GetKey(const XFileSystem& vfs, GameLanguage lang);
+
+      private:
+         static void  Combine(DWORD64& key, const void* buf, DWORD length);
+         static void  Combine(DWORD64& key, const Path& file);
+
+         static void  ReadObjects(Reader& r);
+         static void  ReadStrings(Reader& r);
+         static void  ReadSyntax(Reader& r);
+         static void  WriteObjects(Writer& w);
+         static void  WriteStrings(Writer& w);
+         static void  WriteSyntax(Writer& w);
+
+         // --------------------- PROPERTIES ------------------------
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         void  Save(DWORD64 key, WorkerData* data) const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         bool  Load(DWORD64 key, WorkerData* data);
+
+         // -------------------- REPRESENTATION ---------------------
+      public:
+         const Path  FullPath;
+      };
+
+   }
+}
+
+using namespace Logic::IO;
@@ -11,6 +11,10 @@
 #include "GameObjectLibrary.h"
 #include "DescriptionLibrary.h"
 #include "PreferencesLibrary.h"
+#include "GameDataSnapshot.h"
+#include "WorkerPool.h"
+#include "ComThreadHelper.h"
+#include "Stopwatch.h"
 
 namespace Logic
 {
@@ -23,8 +27,10 @@ namespace Logic
       {
       }
 
+      /// <summary>Waits for the snapshot to be written, if any</summary>
       GameDataWorker::~GameDataWorker()
       {
+         WaitForSnapshot();
       }
 
       // ------------------------------- STATIC METHODS -------------------------------
@@ -46,6 +52,38 @@ namespace Logic
          SyntaxLib.Clear();
       }
 
+      /// <summary>Wraps a loading stage so it initializes COM on its thread and reports its duration</summary>
+      /// <param name="data">arguments.</param>
+      /// <param name="name">stage name.</param>
+      /// <param name="stage">stage.</param>
+      /// <returns></returns>
+      WorkerPool::Task  GameDataWorker::Stage(GameDataWorkerData* data, const wstring& name, WorkerPool::Task stage)
+      {
+         return [=] 
+         {
+            ComThreadHelper COM;
+            Stopwatch       sw;
+
+            stage();
+            data->SendFeedback(ProgressType::Info, 1, VString(L"%s completed in %.0fms", name.c_str(), sw.ElapsedMilliseconds));
+         };
+      }
+
+      /// <summary>Regenerates the game data snapshot from the loaded libraries</summary>
+      /// <param name="data">arguments.</param>
+      /// <returns></returns>
+      DWORD WINAPI GameDataWorker::SnapshotMain(GameDataWorkerData* data)
+      {
+         try 
+         {
+            GameDataSnapshot(AppPath(L"GameData.snapshot")).Save(data->SnapshotKey, data);
+         }
+         catch (ExceptionBase& e) {
+            data->SendFeedback(ProgressType::Warning, 2, GuiString(L"Unable to save game data snapshot: ") + e.Message);
+         }
+         return 0;
+      }
+
       /// <summary>Loads game data</summary>
       /// <param name="data">arguments.</param>
       /// <returns></returns>
@@ -53,7 +91,12 @@ namespace Logic
       {
          try
          {
-            XFileSystem vfs;
+            XFileSystem vfs(data->Backend);
+            GameDataSnapshot snapshot(AppPath(L"GameData.snapshot"));
+            WorkerPool  pool;
+            Stopwatch   sw;
+            DWORD64     key = 0;
+            bool        restored = false;
             HRESULT  hr;
 
             // Init COM
@@ -64,24 +107,65 @@ namespace Logic
             Console << Cons::UserAction << L"Loading " << VersionString(data->Version) << L" game data from " << data->GameFolder << ENDL;
             data->SendFeedback(ProgressType::Operation, 0, VString(L"Loading %s game data from '%s'", VersionString(data->Version).c_str(), data->GameFolder.c_str()));
 
-            // Build VFS. 
-            vfs.Enumerate(data->GameFolder, data->Version, data);
+            // Build VFS.  Snapshot: Restore strings, script objects and syntax if game files are unchanged
+            UINT files = pool.Add(Stage(data, L"File system", [&] 
+            {
+               vfs.Enumerate(data->GameFolder, data->Version, data);
 
-            // language files
-            StringLib.Enumerate(vfs, data->Language, data);
+               key = GameDataSnapshot::GetKey(vfs, data->Language);
+               restored = data->UseSnapshot && snapshot.Load(key, data);
+            }));
 
-            // script/game objects
-            ScriptObjectLib.Enumerate(data);
-            GameObjectLib.Enumerate(vfs, data);
+            // language files
+            UINT strings = pool.Add(Stage(data, L"Language files", [&] 
+            {
+               if (!restored)
+                  StringLib.Enumerate(vfs, data->Language, data);
+            }), { files });
+
+            // script/game objects  [Both resolve names from the string library]
+            pool.Add(Stage(data, L"Script objects", [&] 
+            {
+               if (!restored)
+                  ScriptObjectLib.Enumerate(data);
+            }), { strings });
+
+            pool.Add(Stage(data, L"Game objects", [&] 
+            {
+               GameObjectLib.Enumerate(vfs, data);
+            }), { strings });
 
             // Descriptions
-            DescriptionLib.Enumerate(data);
-
-            // legacy syntax file
-            SyntaxLib.Enumerate(data);
+            pool.Add(Stage(data, L"Descriptions", [&] 
+            {
+               DescriptionLib.Enumerate(data);
+            }));
+
+            // legacy syntax file  [Independent, unless it may be restored from the snapshot]
+            pool.Add(Stage(data, L"Command syntax", [&] 
+            {
+               if (!restored)
+                  SyntaxLib.Enumerate(data);
+            }), data->UseSnapshot ? vector<UINT>(1, files) : vector<UINT>());
+
+            // Execute stages concurrently, in dependency order
+            pool.Run();
+
+            // Snapshot: Regenerate if missing or stale, at low priority once loading is reported complete
+            //  [Created before reporting, so a subsequent reload always waits for it]
+            if (data->UseSnapshot && !restored)
+            {
+               data->SnapshotKey = key;
+               if (data->SnapshotThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)SnapshotMain, (void*)data, CREATE_SUSPENDED, NULL))
+                  SetThreadPriority(data->SnapshotThread, THREAD_PRIORITY_LOWEST);
+               else
+                  data->SendFeedback(ProgressType::Warning, 2, GuiString(L"Unable to save game data snapshot: ") + SysErrorString());
+            }
 
             // Cleanup
-            data->SendFeedback(Cons::UserAction, ProgressType::Succcess, 0, VString(L"Loaded %s game data successfully", VersionString(data->Version).c_str()));
+            data->SendFeedback(Cons::UserAction, ProgressType::Succcess, 0, VString(L"Loaded %s game data successfully in %.0fms", VersionString(data->Version).c_str(), sw.ElapsedMilliseconds));
+            if (data->SnapshotThread)
+               ResumeThread(data->SnapshotThread);
             CoUninitialize();
             return 0;
          }
@@ -1,6 +1,8 @@
 #pragma once
 #include "BackgroundWorker.h"
 #include "PreferencesLibrary.h"
+#include "XCatalog.h"
+#include "WorkerPool.h"
 
 namespace Logic
 {
@@ -16,7 +18,7 @@ namespace Logic
          class LogicExport GameDataWorkerData : public WorkerData
          {
          public:
-            GameDataWorkerData() : WorkerData(Operation::LoadGameData), Version(GameVersion::Threat), Language(GameLanguage::English)
+            GameDataWorkerData() : WorkerData(Operation::LoadGameData), Version(GameVersion::Threat), Language(GameLanguage::English), Backend(CatalogBackend::Streamed), UseSnapshot(true), SnapshotThread(nullptr), SnapshotKey(0)
             {}
 
             /// <summary>Resets data + update values from preferences.</summary>
@@ -26,6 +28,8 @@ namespace Logic
                GameFolder = PrefsLib.GameDataFolder;
                Version = PrefsLib.GameDataVersion;
                Language = PrefsLib.GameDataLanguage;
+               Backend = PrefsLib.MapCatalogFiles ? CatalogBackend::Mapped : CatalogBackend::Streamed;
+               UseSnapshot = PrefsLib.UseGameDataSnapshot;
 
                // Reset 'aborted' flag
                __super::Reset();
@@ -35,6 +39,10 @@ namespace Logic
             Path         GameFolder;
             GameVersion  Version;
             GameLanguage Language;
+            CatalogBackend Backend;
+            bool         UseSnapshot;
+            HANDLE       SnapshotThread;   // Thread regenerating the snapshot, if any
+            DWORD64      SnapshotKey;      // Key of the snapshot being regenerated
          };
 	  
          // --------------------- CONSTRUCTION ----------------------
@@ -45,6 +53,8 @@ namespace Logic
          // ------------------------ STATIC -------------------------
       protected:
          static void         Clear();
+         static WorkerPool::Task  Stage(GameDataWorkerData* data, const wstring& name, WorkerPool::Task stage);
+         static DWORD WINAPI SnapshotMain(GameDataWorkerData* data);
          static DWORD WINAPI ThreadMain(GameDataWorkerData* data);
 
          // --------------------- PROPERTIES ------------------------
@@ -61,6 +71,9 @@ namespace Logic
             if (IsRunning())
                throw InvalidOperationException(HERE, L"Thread already running");
 
+            // Finish writing previous snapshot before its game data is cleared
+            WaitForSnapshot();
+
             // Clear previous (if any)
             Clear();
 
@@ -71,6 +84,17 @@ namespace Logic
             __super::Start(&Data);
          }
 
+         /// <summary>Waits for the game data snapshot to be regenerated, if it is being written in the background.</summary>
+         void  WaitForSnapshot()
+         {
+            if (Data.SnapshotThread)
+            {
+               WaitForSingleObject(Data.SnapshotThread, INFINITE);
+               CloseHandle(Data.SnapshotThread);
+               Data.SnapshotThread = nullptr;
+            }
+         }
+
          // -------------------- REPRESENTATION ---------------------
       protected:
 	      GameDataWorkerData  Data;
@@ -99,7 +99,7 @@ namespace Logic
          data->SendFeedback(Cons::Heading, ProgressType::Operation, 1, L"Enumerating type definition files");
 
          // Enumerate type files
-         for (XFileInfo& f : vfs.Browse(XFolder::Types))
+         for (const XFileInfo& f : vfs.Browse(XFolder::Types))
          {
             try
             {
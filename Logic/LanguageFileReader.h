@@ -45,7 +45,7 @@ namespace Logic
 
          // ------------------------ STATIC -------------------------
 
-      private:
+      public:
          static UINT    ParsePageID(const wstring&  pageid, GameVersion&  v);
 
          // --------------------- PROPERTIES ------------------------
@@ -0,0 +1,521 @@
+#include "stdafx.h"
+#include "LanguageStreamReader.h"
+#include "LanguageFileReader.h"
+#include "FileStream.h"
+#include <algorithm>
+
+namespace Logic
+{
+   namespace IO
+   {
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates a streaming reader from an input stream</summary>
+      /// <param name="in">The input stream</param>
+      /// <exception cref="Logic::ArgumentException">Stream is not readable</exception>
+      /// <exception cref="Logic::ArgumentNullException">Stream is null</exception>
+      LanguageStreamReader::LanguageStreamReader(StreamPtr in) : Position(nullptr), End(nullptr), Input(in)
+      {
+         REQUIRED(in);
+
+         // Ensure stream has read access
+         if (!Input->CanRead())
+            throw ArgumentException(HERE, L"in", GuiString(ERR_NO_READ_ACCESS));
+      }
+
+      /// <summary>Closes the input stream</summary>
+      LanguageStreamReader::~LanguageStreamReader()
+      {
+         Input->SafeClose();
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Queries whether a character may appear within an element or attribute name</summary>
+      /// <param name="ch">The character</param>
+      /// <returns></returns>
+      bool  LanguageStreamReader::IsNameChar(WCHAR ch)
+      {
+         return iswalnum(ch) || ch == '_' || ch == ':' || ch == '-' || ch == '.' || ch >= 0x80;
+      }
+
+      /// <summary>Queries whether a character is xml whitespace</summary>
+      /// <param name="ch">The character</param>
+      /// <returns></returns>
+      bool  LanguageStreamReader::IsWhitespace(WCHAR ch)
+      {
+         return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+      }
+
+      /// <summary>Reads the value of an attribute</summary>
+      /// <param name="tag">The tag containing the attribute</param>
+      /// <param name="name">The attribute name</param>
+      /// <returns>Attribute value</returns>
+      /// <exception cref="Logic::FileFormatException">Attribute is missing</exception>
+      wstring  LanguageStreamReader::ReadAttribute(const Token& tag, const WCHAR* name)
+      {
+         const wstring* value = tag.Find(name);
+
+         // Ensure present : "Missing '%s' attribute on '<%s>' element"
+         if (value == nullptr)
+            throw FileFormatException(HERE, VString(ERR_XML_MISSING_ATTRIBUTE, name, tag.Name.c_str()));
+
+         return *value;
+      }
+
+		// ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Reads the entire language file</summary>
+      /// <param name="path">Full path</param>
+      /// <returns>New language file</returns>
+      /// <exception cref="Logic::FileFormatException">Corrupt XML / Missing elements / missing attributes</exception>
+      /// <exception cref="Logic::InvalidOperationException">File already read</exception>
+      /// <exception cref="Logic::InvalidValueException">Invalid languageID or pageID</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      LanguageFile  LanguageStreamReader::ReadFile(Path path)
+      {
+         LanguageFile file(path);
+         Token        tag;
+
+         // Ensure we haven't already read
+         if (Buffer != nullptr)
+            throw InvalidOperationException(HERE, L"File has already been read");
+
+         // Sanity check
+         if (!Input->GetLength())
+            throw FileFormatException(HERE, L"The file is empty");
+
+         // Convert ASCII/UTF8/UTF16 file into wchar array
+         DWORD length = Input->GetLength();
+         Buffer = FileStream::ConvertFileBuffer(Input, length);
+         Position = Buffer.get();
+         End = Position + length;
+
+         // Find root element
+         while (ReadToken(tag) && tag.Type == TokenType::Text)
+         {}
+
+         // Ensure present: "Missing '%s' element"
+         if (tag.Type != TokenType::OpeningTag && tag.Type != TokenType::EmptyTag)
+            throw FileFormatException(HERE, VString(ERR_XML_MISSING_ELEMENT, L"language"));
+
+         // Verify tag: "Unexpected '<%s>' element while searching for '<%s>' element"
+         if (tag.Name != L"language")
+            throw FileFormatException(HERE, VString(ERR_XML_UNEXPECTED_ELEMENT, tag.Name.c_str(), L"language"));
+
+         // Read fileID + language tag
+         file.ID = LanguageFilenameReader(path.FileName).FileID;
+         file.Language = LanguageFilenameReader::ParseLanguageID(ReadAttribute(tag, L"id"));
+
+         // Read pages
+         if (tag.Type == TokenType::OpeningTag)
+         {
+            Token t;
+            while (ReadToken(t) && t.Type != TokenType::ClosingTag)
+               if (t.Type != TokenType::Text)
+                  file.Pages.Add( ReadPage(t) );
+
+            // Ensure closed
+            if (t.Type != TokenType::ClosingTag || t.Name != L"language")
+               ThrowParseError(L"Missing '</language>' end tag", Position);
+         }
+
+         return file;
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Reads an entity reference, appending the character it represents</summary>
+      /// <param name="output">String to append to</param>
+      /// <exception cref="Logic::FileFormatException">Malformed or undefined entity</exception>
+      void  LanguageStreamReader::ReadEntity(wstring& output)
+      {
+         const WCHAR *start = Position,
+                     *limit = min(End, Position + 12),
+                     *end = find(Position, limit, L';');
+
+         // Ensure terminated
+         if (end == limit)
+            ThrowParseError(L"Unterminated entity reference", start);
+
+         wstring name(start + 1, end);
+         Position = end + 1;
+
+         // Character reference
+         if (!name.empty() && name[0] == '#')
+         {
+            bool  hex = name.length() > 1 && name[1] == 'x';
+            WCHAR* last = nullptr;
+            UINT  code = wcstoul(name.c_str() + (hex ? 2 : 1), &last, hex ? 16 : 10);
+
+            // Validate
+            if (*last || code == 0 || code > 0x10FFFF || name.length() < (hex ? 3U : 2U))
+               ThrowParseError(L"Invalid character reference", start);
+
+            // Encode as UTF-16
+            if (code < 0x10000)
+               output += (WCHAR)code;
+            else
+            {
+               output += (WCHAR)(0xD800 + ((code - 0x10000) >> 10));
+               output += (WCHAR)(0xDC00 + ((code - 0x10000) & 0x3FF));
+            }
+         }
+         // Predefined entities
+         else if (name == L"lt")
+            output += L'<';
+         else if (name == L"gt")
+            output += L'>';
+         else if (name == L"amp")
+            output += L'&';
+         else if (name == L"quot")
+            output += L'"';
+         else if (name == L"apos")
+            output += L'\'';
+         else
+            ThrowParseError(L"Undefined entity", start);
+      }
+
+      /// <summary>Reads an element or attribute name</summary>
+      /// <returns></returns>
+      /// <exception cref="Logic::FileFormatException">Name is missing</exception>
+      wstring  LanguageStreamReader::ReadName()
+      {
+         const WCHAR* start = Position;
+
+         while (Position < End && IsNameChar(*Position))
+            ++Position;
+
+         // Ensure present
+         if (Position == start)
+            ThrowParseError(L"Expected an element or attribute name", start);
+
+         return wstring(start, Position);
+      }
+
+      /// <summary>Reads a page tag and all it's string tags</summary>
+      /// <param name="tag">Page tag</param>
+      /// <returns>New language page</returns>
+      /// <exception cref="Logic::FileFormatException">Corrupt XML / Missing elements / missing attributes</exception>
+      /// <exception cref="Logic::InvalidValueException">Invalid page ID</exception>
+      LanguagePage  LanguageStreamReader::ReadPage(const Token& tag)
+      {
+         GameVersion ver;
+
+         // Verify page tag
+         if (tag.Name != L"page")
+            throw FileFormatException(HERE, VString(ERR_XML_UNEXPECTED_ELEMENT, tag.Name.c_str(), L"page"));
+
+         // Read properties
+         const wstring *title = tag.Find(L"title"),
+                       *desc = tag.Find(L"descr"),
+                       *voice = tag.Find(L"voice");
+
+         // Create page (also normalise PageID)
+         UINT id = LanguageFileReader::ParsePageID(ReadAttribute(tag, L"id"), ver);
+         LanguagePage page(id, title ? *title : L"", desc ? *desc : L"", voice && *voice == L"yes");
+
+         // Read strings
+         if (tag.Type == TokenType::OpeningTag)
+         {
+            Token t;
+            while (ReadToken(t) && t.Type != TokenType::ClosingTag)
+               if (t.Type != TokenType::Text)
+               {
+                  LanguageString str = ReadString(t, page, ver);
+                  page.Strings.Add(str);
+               }
+
+            // Ensure closed
+            if (t.Type != TokenType::ClosingTag || t.Name != L"page")
+               ThrowParseError(L"Missing '</page>' end tag", Position);
+         }
+
+         // Return page
+         return page;
+      }
+
+      /// <summary>Reads a string tag</summary>
+      /// <param name="tag">String 't' tag</param>
+      /// <param name="page">Containing page</param>
+      /// <param name="v">Version of page</param>
+      /// <returns>New language string</returns>
+      /// <exception cref="Logic::FileFormatException">Corrupt XML / Missing element or attributes</exception>
+      LanguageString  LanguageStreamReader::ReadString(const Token& tag, const LanguagePage& page, GameVersion v)
+      {
+         wstring txt;
+
+         // Verify string tag
+         if (tag.Name != L"t")
+            throw FileFormatException(HERE, VString(ERR_XML_UNEXPECTED_ELEMENT, tag.Name.c_str(), L"t"));
+
+         UINT id = _wtoi(ReadAttribute(tag, L"id").c_str());
+
+         // Concatenate text of all descendants
+         if (tag.Type == TokenType::OpeningTag)
+         {
+            vector<wstring> open(1, tag.Name);
+            Token t;
+
+            while (!open.empty())
+            {
+               if (!ReadToken(t))
+                  ThrowParseError(L"Missing '</t>' end tag", Position);
+
+               switch (t.Type)
+               {
+               case TokenType::Text:        txt += t.Text;              break;
+               case TokenType::OpeningTag:  open.push_back(t.Name);     break;
+               case TokenType::ClosingTag:
+                  if (t.Name != open.back())
+                     ThrowParseError(L"End tag does not match start tag", Position);
+                  open.pop_back();
+                  break;
+               default:
+                  break;
+               }
+            }
+         }
+
+         // Trim leading/trailing whitespace, as the DOM does when whitespace is not preserved
+         auto first = find_if_not(txt.begin(), txt.end(), IsWhitespace);
+         auto last = find_if_not(txt.rbegin(), wstring::reverse_iterator(first), IsWhitespace).base();
+         txt = wstring(first, last);
+
+         // Convert octal addition entities
+         for (auto pos = txt.find(L"\\053"); pos != wstring::npos; pos = txt.find(L"\\053", pos))
+            txt.replace(pos, 4, L"+");
+
+         // Read ID+text
+         return LanguageString(id, page.ID, txt, v);
+      }
+
+      /// <summary>Reads the name and attributes of an opening or empty element tag</summary>
+      /// <param name="t">On return, the tag</param>
+      /// <exception cref="Logic::FileFormatException">Malformed tag</exception>
+      void  LanguageStreamReader::ReadTag(Token& t)
+      {
+         // Name
+         ++Position;
+         t.Name = ReadName();
+         t.Attributes.clear();
+
+         for (;;)
+         {
+            SkipWhitespace();
+
+            if (Position >= End)
+               ThrowParseError(L"Unterminated element tag", Position);
+
+            // Opening tag
+            if (*Position == '>')
+            {
+               t.Type = TokenType::OpeningTag;
+               ++Position;
+               return;
+            }
+            // Empty tag
+            else if (*Position == '/' && Position + 1 < End && Position[1] == '>')
+            {
+               t.Type = TokenType::EmptyTag;
+               Position += 2;
+               return;
+            }
+
+            // Attribute: Name
+            Attribute a;
+            a.first = ReadName();
+            SkipWhitespace();
+
+            if (Position >= End || *Position != '=')
+               ThrowParseError(L"Missing '=' following attribute name", Position);
+            ++Position;
+            SkipWhitespace();
+
+            // Attribute: Value
+            if (Position >= End || (*Position != '"' && *Position != '\''))
+               ThrowParseError(L"Missing quote around attribute value", Position);
+
+            for (WCHAR quote = *Position++; Position < End && *Position != quote; )
+            {
+               if (*Position == '&')
+                  ReadEntity(a.second);
+               else if (*Position == '<')
+                  ThrowParseError(L"Attribute values cannot contain '<'", Position);
+               // Normalise whitespace  [CRLF becomes a single space]
+               else if (IsWhitespace(*Position))
+               {
+                  if (*Position++ == '\r' && Position < End && *Position == '\n')
+                     ++Position;
+                  a.second += L' ';
+               }
+               else
+                  a.second += *Position++;
+            }
+
+            if (Position++ >= End)
+               ThrowParseError(L"Unterminated attribute value", Position);
+
+            t.Attributes.push_back(a);
+         }
+      }
+
+      /// <summary>Reads the next element tag or run of character data, skipping comments, processing instructions and declarations</summary>
+      /// <param name="t">On return, the token</param>
+      /// <returns>False if end of file reached</returns>
+      /// <exception cref="Logic::FileFormatException">Malformed XML</exception>
+      bool  LanguageStreamReader::ReadToken(Token& t)
+      {
+         static const WCHAR cdata[] = L"<![CDATA[";
+
+         while (Position < End)
+         {
+            t.Text.clear();
+
+            // Character data
+            if (*Position != '<')
+            {
+               t.Type = TokenType::Text;
+
+               while (Position < End && *Position != '<')
+               {
+                  // Append run of literal characters
+                  const WCHAR* run = Position;
+                  while (Position < End && *Position != '<' && *Position != '&' && *Position != '\r')
+                     ++Position;
+                  t.Text.append(run, Position);
+
+                  // Entity
+                  if (Position < End && *Position == '&')
+                     ReadEntity(t.Text);
+
+                  // Normalise line breaks
+                  else if (Position < End && *Position == '\r')
+                  {
+                     if (++Position < End && *Position == '\n')
+                        ++Position;
+                     t.Text += L'\n';
+                  }
+               }
+               return true;
+            }
+
+            // Closing tag
+            if (Position + 1 < End && Position[1] == '/')
+            {
+               Position += 2;
+               t.Type = TokenType::ClosingTag;
+               t.Name = ReadName();
+               SkipWhitespace();
+
+               if (Position >= End || *Position++ != '>')
+                  ThrowParseError(L"Malformed end tag", Position);
+               return true;
+            }
+
+            // Comment / Processing instruction: Skip
+            if (Position + 3 < End && wcsncmp(Position, L"<!--", 4) == 0)
+               SkipPast(L"-->");
+
+            else if (Position + 1 < End && Position[1] == '?')
+               SkipPast(L"?>");
+
+            // CDATA: Append verbatim
+            else if (End - Position >= 9 && wcsncmp(Position, cdata, 9) == 0)
+            {
+               const WCHAR* start = Position + 9;
+               SkipPast(L"]]>");
+
+               t.Type = TokenType::Text;
+               for (const WCHAR* ch = start; ch < Position - 3; ++ch)
+                  if (*ch != '\r')
+                     t.Text += *ch;
+                  else if (ch + 1 == Position - 3 || ch[1] != '\n')
+                     t.Text += L'\n';
+               return true;
+            }
+
+            // Declaration: Skip, including any internal subset
+            else if (Position + 1 < End && Position[1] == '!')
+            {
+               int depth = 0;
+               for (++Position; Position < End && (depth > 0 || *Position != '>'); ++Position)
+                  depth += (*Position == '[' ? 1 : *Position == ']' ? -1 : 0);
+
+               if (Position++ >= End)
+                  ThrowParseError(L"Unterminated declaration", Position);
+            }
+
+            // Element tag
+            else
+            {
+               ReadTag(t);
+               return true;
+            }
+         }
+
+         // EOF
+         t.Type = TokenType::EndOfFile;
+         return false;
+      }
+
+      /// <summary>Advances the position past the next occurrence of a terminator</summary>
+      /// <param name="terminator">The terminator</param>
+      /// <exception cref="Logic::FileFormatException">Terminator not found</exception>
+      void  LanguageStreamReader::SkipPast(const WCHAR* terminator)
+      {
+         const WCHAR* end = terminator + wcslen(terminator),
+                    * pos = search(Position, End, terminator, end);
+
+         // Ensure found
+         if (pos == End)
+            ThrowParseError(VString(L"Missing '%s'", terminator).c_str(), Position);
+
+         Position = pos + (end - terminator);
+      }
+
+      /// <summary>Advances the position past any whitespace</summary>
+      void  LanguageStreamReader::SkipWhitespace()
+      {
+         while (Position < End && IsWhitespace(*Position))
+            ++Position;
+      }
+
+      /// <summary>Throws a parse error at a position within the buffer</summary>
+      /// <param name="reason">Reason</param>
+      /// <param name="pos">Position of error</param>
+      /// <exception cref="Logic::FileFormatException">Always thrown</exception>
+      void  LanguageStreamReader::ThrowParseError(const WCHAR* reason, const WCHAR* pos) const
+      {
+         const WCHAR* line = Buffer.get();
+         int          number = 1;
+
+         // Calculate line number + character position
+         for (const WCHAR* ch = Buffer.get(); ch < pos && ch < End; ++ch)
+            if (*ch == '\n')
+            {
+               line = ch + 1;
+               ++number;
+            }
+
+         // "%s (line %d, char %d)"
+         throw FileFormatException(HERE, VString(ERR_XML_PARSE_FAILED, reason, number, (int)(pos - line) + 1));
+      }
+
+		// -------------------------------- NESTED CLASSES ------------------------------
+
+      /// <summary>Finds the value of an attribute</summary>
+      /// <param name="name">The attribute name</param>
+      /// <returns>Attribute value, or nullptr if not present</returns>
+      const wstring*  LanguageStreamReader::Token::Find(const WCHAR* name) const
+      {
+         for (const Attribute& a : Attributes)
+            if (a.first == name)
+               return &a.second;
+
+         return nullptr;
+      }
+   }
+}
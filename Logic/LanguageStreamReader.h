@@ -0,0 +1,84 @@
+#pragma once
+
+#include "LanguageFile.h"
+#include "Stream.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+
+      /// <summary>Reads strings and pages of an X3 language xml file without building a document</summary>
+      /// <remarks>Pull-based tokenizer for the language/page/t schema that reads directly from the decoded file buffer,
+      /// producing the same pages and strings as the DOM based LanguageFileReader without COM</remarks>
+      class LogicExport LanguageStreamReader
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Markup token types</summary>
+         enum class TokenType { Text, OpeningTag, ClosingTag, EmptyTag, EndOfFile };
+
+         /// <summary>Name/value pair of an attribute</summary>
+         typedef pair<wstring,wstring>  Attribute;
+
+         /// <summary>Markup token</summary>
+         class Token
+         {
+         public:
+            Token() : Type(TokenType::EndOfFile)
+            {}
+
+            const wstring*  Find(const WCHAR* name) const;
+
+            TokenType          Type;
+            wstring            Name,          // Element name, if any
+                               Text;          // Decoded character data, if any
+            vector<Attribute>  Attributes;    // Attributes, if any
+         };
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         LanguageStreamReader(StreamPtr in);
+         virtual ~LanguageStreamReader();
+
+         NO_COPY(LanguageStreamReader);	// Uncopyable
+		   NO_MOVE(LanguageStreamReader);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static bool     IsNameChar(WCHAR ch);
+         static bool     IsWhitespace(WCHAR ch);
+         static wstring  ReadAttribute(const Token& tag, const WCHAR* name);
+
+         // --------------------- PROPERTIES ------------------------
+
+			// ---------------------- ACCESSORS ------------------------
+      private:
+         void  ThrowParseError(const WCHAR* reason, const WCHAR* pos) const;
+
+			// ----------------------- MUTATORS ------------------------
+      public:
+         LanguageFile   ReadFile(Path path);
+
+      private:
+         void           ReadEntity(wstring& output);
+         wstring        ReadName();
+         LanguagePage   ReadPage(const Token& tag);
+         LanguageString ReadString(const Token& tag, const LanguagePage& page, GameVersion v);
+         void           ReadTag(Token& t);
+         bool           ReadToken(Token& t);
+         void           SkipPast(const WCHAR* terminator);
+         void           SkipWhitespace();
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         CharArrayPtr   Buffer;        // Decoded file
+         const WCHAR   *Position,      // Current position
+                       *End;           // End of buffer
+         StreamPtr      Input;
+      };
+
+   }
+}
+
+using namespace Logic::IO;
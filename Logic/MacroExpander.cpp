@@ -69,8 +69,8 @@ namespace Logic
          /// <returns></returns>
          CommandNodePtr  MacroExpander::ExpandCommand(CommandNode* n, const wstring& txt, GameVersion v)
          {
-            // Generate new node
-            return new CommandNode(*n, *ScriptParser::Generate(txt, v));
+            // Generate new node from the arena of the tree
+            return CommandNode::Create(n->GetArena(), *n, *ScriptParser::Generate(txt, v));
          }
          
          
@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Maps the entire contents of a file into memory for reading</summary>
+      /// <param name="path">The full path.</param>
+      /// <exception cref="Logic::DirectoryNotFoundException">Folder not found</exception>
+      /// <exception cref="Logic::FileNotFoundException">File not found</exception>
+      /// <exception cref="Logic::IOException">Unable to open or map file, or file is 4GB or larger</exception>
+      MappedFile::MappedFile(Path path)
+         : FullPath(path), File(INVALID_HANDLE_VALUE), Mapping(nullptr), View(nullptr), Size(0)
+      {
+         // Open file
+         File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+
+         // Specialise certain errors
+         if (File == INVALID_HANDLE_VALUE)
+            switch (GetLastError())
+            {
+            case ERROR_FILE_NOT_FOUND: throw FileNotFoundException(HERE, path);
+            case ERROR_PATH_NOT_FOUND: throw DirectoryNotFoundException(HERE, path.Folder);
+            default: throw IOException(HERE, SysErrorString());
+            }
+
+         try
+         {
+            LARGE_INTEGER size = {0LL};
+
+            // Lookup file size
+            if (!GetFileSizeEx(File, &size))
+               throw IOException(HERE, SysErrorString());
+
+            // Reject files whose length exceeds the 32-bit offsets of the view  (Catalogs fallback to streamed access)
+            if (size.HighPart != 0)
+               throw IOException(HERE, VString(L"Cannot map '%s' : file exceeds 4GB", path.c_str()));
+            Size = size.LowPart;
+
+            // Empty: Nothing to map
+            if (Size == 0)
+               return;
+
+            // Map entire file
+            if ((Mapping = CreateFileMapping(File, NULL, PAGE_READONLY, 0, 0, NULL)) == nullptr)
+               throw IOException(HERE, SysErrorString());
+
+            if ((View = reinterpret_cast<const BYTE*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0))) == nullptr)
+               throw IOException(HERE, SysErrorString());
+         }
+         catch (ExceptionBase&) {
+            SafeClose();
+            throw;
+         }
+      }
+
+      /// <summary>Unmaps the file without throwing</summary>
+      MappedFile::~MappedFile()
+      {
+         SafeClose();
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Gets a pointer to a range of bytes within the file</summary>
+      /// <param name="offset">Offset of first byte</param>
+      /// <param name="length">Length of range</param>
+      /// <returns>Pointer to first byte of range</returns>
+      /// <exception cref="Logic::ArgumentException">Range exceeds the length of the file</exception>
+      const BYTE*  MappedFile::GetView(DWORD offset, DWORD length) const
+      {
+         // Validate range
+         if (offset > Size || length > Size - offset)
+            throw ArgumentException(HERE, L"length", VString(L"Range %d+%d exceeds length of '%s'", offset, length, FullPath.c_str()));
+
+         return View + offset;
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Unmaps the view and closes the file without throwing.</summary>
+      void  MappedFile::SafeClose()
+      {
+         if (View)
+            UnmapViewOfFile(View);
+         if (Mapping)
+            CloseHandle(Mapping);
+         if (File != INVALID_HANDLE_VALUE)
+            CloseHandle(File);
+
+         View = nullptr;
+         Mapping = nullptr;
+         File = INVALID_HANDLE_VALUE;
+      }
+
+      // -------------------------------- NESTED CLASSES ------------------------------
+   }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FileStream.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+
+      /// <summary>Provides read-only access to the entire contents of a file mapped into memory</summary>
+      /// <remarks>The file is locked for writing/deleting during the lifetime of this object</remarks>
+      class LogicExport MappedFile
+      {
+         // --------------------- CONSTRUCTION ----------------------
+
+      public:
+         MappedFile(Path path);
+         ~MappedFile();
+
+         // Prevent copying/moving
+         NO_MOVE(MappedFile);
+         NO_COPY(MappedFile);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(DWORD,Length,GetLength);
+
+			// ---------------------- ACCESSORS ------------------------
+      public:
+         const BYTE*  GetView(DWORD offset, DWORD length) const;
+
+         /// <summary>Gets the length of the file</summary>
+         DWORD        GetLength() const   { return Size; }
+
+			// ----------------------- MUTATORS ------------------------
+      private:
+         void  SafeClose();
+
+         // -------------------- REPRESENTATION ---------------------
+      public:
+         const Path  FullPath;
+
+      private:
+         HANDLE      File,
+                     Mapping;
+         const BYTE* View;
+         DWORD       Size;
+      };
+
+      /// <summary>Shared pointer to a mapped file</summary>
+      typedef shared_ptr<MappedFile>  MappedFilePtr;
+   }
+}
+
+using namespace Logic::IO;
@@ -2,6 +2,7 @@
 //
 #include <regex>
 #include "StringResolver.h"      // RegEx Exception
+#include "SearchPattern.h"
 
 namespace Logic
 {
@@ -37,7 +38,8 @@ namespace Logic
               MatchCase(regEx ? matchCase : false), 
               MatchWord(regEx ? matchWord : false),
               UseRegEx(regEx),
-              RegEx(GetSafeRegEx(regEx ? search : L""))
+              RegEx(GetSafeRegEx(regEx ? search : L"", MatchCase)),
+              Pattern(search, regEx, MatchCase, MatchWord)
          {
          }
 
@@ -48,12 +50,13 @@ namespace Logic
       private:
          /// <summary>Creates a regular expression.</summary>
          /// <param name="txt">expression</param>
+         /// <param name="matchCase">Whether case sensitive</param>
          /// <returns></returns>
          /// <exception cref="Logic::Language::RegularExpressionException">Error in expression</exception>
-         wregex  GetSafeRegEx(const wstring& txt)
+         wregex  GetSafeRegEx(const wstring& txt, bool matchCase)
          {
             try {
-               return txt.length() ? wregex(txt) : wregex();
+               return txt.length() ? wregex(txt, matchCase ? regex_constants::ECMAScript : regex_constants::ECMAScript | regex_constants::icase) : wregex();
             }
             catch (regex_error& e) {
                throw RegularExpressionException(HERE, e);
@@ -225,7 +228,8 @@ namespace Logic
          const bool         MatchCase,     // Match case 
                             MatchWord,     // Match whole word
                             UseRegEx;      // Search and replacement terms are regular expressions
-         const wregex       RegEx;         // Search RegEx, if 'UseRegEx'
+         const wregex       RegEx;         // Search RegEx, if 'UseRegEx'.  Used to format replacements
+         const SearchPattern Pattern;      // Compiled search term/expression
 
 
       private:
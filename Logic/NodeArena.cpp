@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "NodeArena.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         // -------------------------------- CONSTRUCTION --------------------------------
+
+         NodeArena::NodeArena() : Allocations(0), End(nullptr), Position(nullptr), Size(0), Used(0)
+         {
+         }
+
+         NodeArena::~NodeArena()
+         {
+         }
+
+         // ------------------------------- STATIC METHODS -------------------------------
+
+         // ------------------------------- PUBLIC METHODS -------------------------------
+
+         /// <summary>Allocates memory, aligned for any type</summary>
+         /// <param name="bytes">Number of bytes</param>
+         /// <returns></returns>
+         /// <exception cref="std::bad_alloc">Out of memory</exception>
+         void*  NodeArena::Allocate(UINT bytes)
+         {
+            // Round up to preserve alignment
+            bytes = (bytes + MEMORY_ALLOCATION_ALIGNMENT-1) & ~(MEMORY_ALLOCATION_ALIGNMENT-1);
+
+            // Insufficient space: Allocate new block, double the size of the last  [Oversized allocations receive a dedicated block]
+            if ((UINT)(End - Position) < bytes)
+            {
+               UINT size = max(bytes, Blocks.size() < 4 ? FIRST_BLOCK << Blocks.size() : MAX_BLOCK);
+               Blocks.push_back(BlockPtr(new BYTE[size]));
+               Position = Blocks.back().get();
+               End = Position + size;
+               Size += size;
+            }
+
+            // Bump position
+            void* p = Position;
+            Position += bytes;
+            Used += bytes;
+            ++Allocations;
+            return p;
+         }
+
+         /// <summary>Releases every allocation, retaining the most recent block for re-use</summary>
+         /// <remarks>Nothing allocated from the arena may remain in use</remarks>
+         void  NodeArena::Reset()
+         {
+            // Retain final block  [Largest, unless dedicated to an oversized allocation]
+            if (!Blocks.empty())
+            {
+               Blocks.erase(Blocks.begin(), Blocks.end()-1);
+               Position = Blocks.back().get();
+               Size = End - Position;
+            }
+
+            Allocations = Used = 0;
+         }
+
+         // ------------------------------ PROTECTED METHODS -----------------------------
+
+         // ------------------------------- PRIVATE METHODS ------------------------------
+      }
+   }
+}
+
@@ -0,0 +1,228 @@
+#pragma once
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         /// <summary>Allocates memory for the nodes of a command tree, and their children and parameters, from large contiguous blocks</summary>
+         /// <remarks>Memory is never released individually, the blocks are released together when the arena is destroyed.  Arenas
+         /// are shared by the nodes allocated from them, so nodes may safely outlive the tree that created them</remarks>
+         class NodeArena : public enable_shared_from_this<NodeArena>
+         {
+            // ------------------------ TYPES --------------------------
+         private:
+            /// <summary>Block of memory</summary>
+            typedef unique_ptr<BYTE[]>  BlockPtr;
+
+            /// <summary>Blocks of memory</summary>
+            typedef vector<BlockPtr>  BlockArray;
+
+            /// <summary>Size of the first block, and maximum size of subsequent blocks, in bytes.  Blocks double in size so
+            /// that single line parses remain cheap</summary>
+            static const UINT  FIRST_BLOCK = 4*1024,
+                               MAX_BLOCK = 64*1024;
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            NodeArena();
+            virtual ~NodeArena();
+
+            NO_COPY(NodeArena);	// Uncopyable
+            NO_MOVE(NodeArena);	// Unmoveable
+
+            // ------------------------ STATIC -------------------------
+
+            // --------------------- PROPERTIES ------------------------
+         public:
+            PROPERTY_GET(UINT,Allocated,GetAllocated);
+            PROPERTY_GET(UINT,Count,GetCount);
+            PROPERTY_GET(UINT,Reserved,GetReserved);
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Gets the number of bytes allocated</summary>
+            UINT  GetAllocated() const   { return Used; }
+
+            /// <summary>Gets the number of allocations</summary>
+            UINT  GetCount() const       { return Allocations; }
+
+            /// <summary>Gets the number of bytes reserved by all blocks</summary>
+            UINT  GetReserved() const    { return Size; }
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            void*  Allocate(UINT bytes);
+            void   Reset();
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            UINT        Allocations;   // Number of allocations
+            BlockArray  Blocks;        // Blocks, the last of which is current
+            BYTE*       End;           // End of current block
+            BYTE*       Position;      // Next free byte of current block
+            UINT        Size,          // Bytes reserved by all blocks
+                        Used;          // Bytes allocated
+         };
+
+         /// <summary>Shared pointer to a node arena</summary>
+         typedef shared_ptr<NodeArena>  NodeArenaPtr;
+
+
+         /// <summary>Standard allocator that allocates from a node arena, used to allocate nodes and their reference counts together</summary>
+         template <typename T>
+         class ArenaAllocator
+         {
+            template <typename U> friend class ArenaAllocator;
+
+            // ------------------------ TYPES --------------------------
+         public:
+            typedef T         value_type;
+            typedef T*        pointer;
+            typedef const T*  const_pointer;
+            typedef T&        reference;
+            typedef const T&  const_reference;
+            typedef size_t    size_type;
+            typedef ptrdiff_t difference_type;
+
+            /// <summary>Allocator of another type</summary>
+            template <typename U>
+            struct rebind
+            {
+               typedef ArenaAllocator<U>  other;
+            };
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            /// <summary>Creates an allocator for an arena</summary>
+            /// <param name="arena">The arena</param>
+            ArenaAllocator(const NodeArenaPtr& arena) : Arena(arena)
+            {}
+
+            /// <summary>Creates an allocator sharing the arena of an allocator of another type</summary>
+            /// <param name="r">Another allocator</param>
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U>& r) : Arena(r.Arena)
+            {}
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Query whether two allocators share an arena</summary>
+            template <typename U>
+            bool operator==(const ArenaAllocator<U>& r) const   { return Arena == r.Arena; }
+
+            /// <summary>Query whether two allocators use different arenas</summary>
+            template <typename U>
+            bool operator!=(const ArenaAllocator<U>& r) const   { return Arena != r.Arena; }
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            /// <summary>Allocates storage for objects</summary>
+            /// <param name="n">Number of objects</param>
+            /// <returns></returns>
+            T*  allocate(size_t n)
+            {
+               return reinterpret_cast<T*>(Arena->Allocate(n * sizeof(T)));
+            }
+
+            /// <summary>Does nothing, storage is released with the arena</summary>
+            void  deallocate(T* p, size_t n)
+            {}
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            NodeArenaPtr  Arena;    // Arena, shared by each allocation
+         };
+
+
+         /// <summary>Standard allocator for the child and parameter containers of a node, which allocates from the arena of the 
+         /// node, or from the heap if the node has no arena</summary>
+         /// <remarks>The arena is not shared, as the containers of a node never outlive it.  Copies of a container are allocated from
+         /// the heap so they may outlive the node, whereas moving or swapping a container transfers its storage and arena</remarks>
+         template <typename T>
+         class NodeAllocator
+         {
+            template <typename U> friend class NodeAllocator;
+
+            // ------------------------ TYPES --------------------------
+         public:
+            typedef T         value_type;
+            typedef T*        pointer;
+            typedef const T*  const_pointer;
+            typedef T&        reference;
+            typedef const T&  const_reference;
+            typedef size_t    size_type;
+            typedef ptrdiff_t difference_type;
+
+            typedef std::true_type  propagate_on_container_move_assignment;
+            typedef std::true_type  propagate_on_container_swap;
+
+            /// <summary>Allocator of another type</summary>
+            template <typename U>
+            struct rebind
+            {
+               typedef NodeAllocator<U>  other;
+            };
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            /// <summary>Creates an allocator that allocates from the heap</summary>
+            NodeAllocator() : Arena(nullptr)
+            {}
+
+            /// <summary>Creates an allocator for the arena of a node</summary>
+            /// <param name="arena">The arena, or nullptr to allocate from the heap</param>
+            NodeAllocator(NodeArena* arena) : Arena(arena)
+            {}
+
+            /// <summary>Creates an allocator sharing the arena of an allocator of another type</summary>
+            /// <param name="r">Another allocator</param>
+            template <typename U>
+            NodeAllocator(const NodeAllocator<U>& r) : Arena(r.Arena)
+            {}
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Gets the arena, if any</summary>
+            /// <returns>Arena, or nullptr if allocating from the heap</returns>
+            NodeArena*  GetArena() const   { return Arena; }
+
+            /// <summary>Gets the allocator used by copies of a container, which allocates from the heap</summary>
+            NodeAllocator  select_on_container_copy_construction() const   { return NodeAllocator(); }
+
+            /// <summary>Query whether two allocators share an arena, or both allocate from the heap</summary>
+            template <typename U>
+            bool operator==(const NodeAllocator<U>& r) const   { return Arena == r.Arena; }
+
+            /// <summary>Query whether two allocators use different storage</summary>
+            template <typename U>
+            bool operator!=(const NodeAllocator<U>& r) const   { return Arena != r.Arena; }
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            /// <summary>Allocates storage for objects</summary>
+            /// <param name="n">Number of objects</param>
+            /// <returns></returns>
+            /// <exception cref="std::bad_alloc">Out of memory</exception>
+            T*  allocate(size_t n)
+            {
+               return reinterpret_cast<T*>(Arena ? Arena->Allocate(n * sizeof(T)) : ::operator new(n * sizeof(T)));
+            }
+
+            /// <summary>Releases storage allocated from the heap.  Storage allocated from an arena is released with the arena</summary>
+            void  deallocate(T* p, size_t n)
+            {
+               if (!Arena)
+                  ::operator delete(p);
+            }
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            NodeArena*  Arena;    // Arena of the node, or nullptr for the heap
+         };
+      }
+   }
+}
+
+using namespace Logic::Scripts::Compiler;
@@ -1,5 +1,5 @@
 #pragma once
-
+#include "NodeArena.h"
 
 namespace Logic
 {
@@ -8,11 +8,21 @@ namespace Logic
       class ScriptParameter;
 
       /// <summary>Vector of script parameters</summary>
-      class LogicExport ParameterArray : public vector<ScriptParameter> 
+      /// <remarks>The parameters of a node allocated from an arena are stored in the same arena, other arrays use the heap</remarks>
+      class LogicExport ParameterArray : public vector<ScriptParameter, NodeAllocator<ScriptParameter>> 
       {
       public:
          ParameterArray()
          {}
+         /// <summary>Create empty array that allocates from an arena</summary>
+         explicit ParameterArray(const allocator_type& alloc) : vector(alloc)
+         {}
+         /// <summary>Create copy that allocates from an arena</summary>
+         ParameterArray(const ParameterArray& r, const allocator_type& alloc) : vector(r, alloc)
+         {}
+         /// <summary>Move parameters into an array that allocates from an arena</summary>
+         ParameterArray(ParameterArray&& r, const allocator_type& alloc) : vector(move(r), alloc)
+         {}
          /// <summary>Create from single parameter</summary>
          ParameterArray(const ScriptParameter& p)
          {
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "ParseSession.h"
+#include "SyntaxLibrary.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         // -------------------------------- CONSTRUCTION --------------------------------
+
+         ParseSession::ParseSession() : Generation(0), ReadCount(0), Syntax(SyntaxLib.Generation), Version(GameVersion::Threat)
+         {
+         }
+
+         ParseSession::~ParseSession()
+         {
+         }
+
+         // ------------------------------- STATIC METHODS -------------------------------
+
+         // ------------------------------- PUBLIC METHODS -------------------------------
+
+         /// <summary>Discards all cached lines and the most recent parse</summary>
+         void  ParseSession::Clear()
+         {
+            Parser.reset();
+            Cache.clear();
+            Lines.clear();
+            ReadCount = 0;
+         }
+
+         /// <summary>Parses the entire script, reading only lines whose text has changed since the previous parse</summary>
+         /// <param name="script">Script</param>
+         /// <param name="lines">The lines to parse</param>
+         /// <param name="v">The game version</param>
+         /// <param name="cancelled">Queried between verification passes, verification is abandoned if it returns true. May be empty</param>
+         /// <returns>Parser, valid until the next parse</returns>
+         /// <exception cref="Logic::ArgumentException">Line array is empty</exception>
+         /// <exception cref="Logic::AlgorithmException">Error in parsing algorithm</exception>
+         ScriptParser&  ParseSession::Parse(ScriptFile& script, const LineArray& lines, GameVersion v, const CommandTree::CancelDelegate& cancelled)
+         {
+            // Release previous parse before the script is cleared
+            Parser.reset();
+
+            // Version/Syntax changed: Discard lines identified against previous version, or whose syntax has been reloaded
+            if (v != Version || SyntaxLib.Generation != Syntax)
+               Cache.clear();
+
+            // Prepare
+            Cancelled = cancelled;
+            Lines = lines;
+            Syntax = SyntaxLib.Generation;
+            Version = v;
+            ReadCount = 0;
+            ++Generation;
+
+            // Parse script
+            Parser.reset(new ScriptParser(script, Lines, v, this));
+
+            // Discard lines no longer present
+            for (auto it = Cache.begin(); it != Cache.end(); )
+               if (it->second.Generation != Generation)
+                  it = Cache.erase(it);
+               else
+                  ++it;
+
+            return *Parser;
+         }
+
+         // ------------------------------ PROTECTED METHODS -----------------------------
+
+         // ------------------------------- PRIVATE METHODS ------------------------------
+
+         /// <summary>Finds the node of a previously read line with identical text</summary>
+         /// <param name="line">The line text</param>
+         /// <param name="number">1-based line number</param>
+         /// <param name="errors">Errors of the line are appended to this collection</param>
+         /// <returns>Cached node if line is present, otherwise nullptr. Must be copied before use, as tree nodes are modified by verification</returns>
+         const CommandNode*  ParseSession::Find(const wstring& line, UINT number, ErrorArray& errors)
+         {
+            auto pos = Cache.find(line);
+
+            // Not found: Line must be read
+            if (pos == Cache.end())
+               return nullptr;
+
+            // Retain for next parse
+            ParsedLine& parsed = pos->second;
+            parsed.Generation = Generation;
+
+            // Re-number errors
+            for (const ErrorToken& e : parsed.Errors)
+               errors += ErrorToken(e.Message, number, e.Text, e.Start, e.End);
+
+            return parsed.Node.get();
+         }
+
+         /// <summary>Stores the node and errors of a line that has been read</summary>
+         /// <param name="line">The line text</param>
+         /// <param name="node">The node, before it is added to the tree</param>
+         /// <param name="firstError">First error of the line</param>
+         /// <param name="lastError">Position following the last error of the line</param>
+         void  ParseSession::Store(const wstring& line, const CommandNodePtr& node, ErrorArray::const_iterator firstError, ErrorArray::const_iterator lastError)
+         {
+            ParsedLine& parsed = Cache[line];
+
+            // Copy node + errors
+            parsed.Node = new CommandNode(*node, node->LineNumber);
+            parsed.Generation = Generation;
+            for (auto e = firstError; e != lastError; ++e)
+               parsed.Errors += *e;
+
+            ++ReadCount;
+         }
+      }
+   }
+}
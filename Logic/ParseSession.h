@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ScriptParser.h"
+#include <unordered_map>
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+
+         /// <summary>Repeatedly parses the changing text of a script, re-using the results of unchanged lines</summary>
+         /// <remarks>The lexing, identification and parameter matching of each line is cached by line text, so only lines whose
+         /// text has changed since the previous parse are read.  Cached lines reference command syntax, so they are discarded whenever 
+         /// the syntax library is reloaded.
+         ///
+         /// Only reading is incremental: the parse tree is still structured and verified in full.  Verification regenerates script-wide 
+         /// state (labels, variable IDs and usage, script-call arguments, command output) that is cleared before each parse, and node 
+         /// line numbers are immutable, so branches following an inserted or deleted line cannot be re-used</remarks>
+         class LogicExport ParseSession
+         {
+            friend class ScriptParser;
+
+            // ------------------------ TYPES --------------------------
+         private:
+            /// <summary>Result of reading a single line</summary>
+            class ParsedLine
+            {
+            public:
+               ParsedLine() : Generation(0)
+               {}
+
+               CommandNodePtr  Node;          // Unattached copy of the node
+               ErrorArray      Errors;        // Errors of the line
+               UINT            Generation;    // Generation in which the line was last used
+            };
+
+            /// <summary>Parsed lines keyed by line text</summary>
+            typedef unordered_map<wstring,ParsedLine>  LineCache;
+
+            /// <summary>Unique pointer to a script parser</summary>
+            typedef unique_ptr<ScriptParser>  ScriptParserPtr;
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            ParseSession();
+            virtual ~ParseSession();
+
+            NO_COPY(ParseSession);	// Uncopyable
+            NO_MOVE(ParseSession);	// Unmoveable
+
+            // ------------------------ STATIC -------------------------
+
+            // --------------------- PROPERTIES ------------------------
+         public:
+            PROPERTY_GET(UINT,Count,GetCount);
+            PROPERTY_GET(UINT,Reparsed,GetReparsed);
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Gets the number of cached lines</summary>
+            UINT  GetCount() const      { return Cache.size(); }
+
+            /// <summary>Gets the number of lines read by the most recent parse</summary>
+            UINT  GetReparsed() const   { return ReadCount; }
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            void           Clear();
+            ScriptParser&  Parse(ScriptFile& script, const LineArray& lines, GameVersion v, const CommandTree::CancelDelegate& cancelled = nullptr);
+
+         private:
+            const CommandNode*  Find(const wstring& line, UINT number, ErrorArray& errors);
+            void                Store(const wstring& line, const CommandNodePtr& node, ErrorArray::const_iterator firstError, ErrorArray::const_iterator lastError);
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            LineCache                    Cache;         // Lines read by the most recent parse
+            CommandTree::CancelDelegate  Cancelled;     // Queried between verification passes of the current parse
+            UINT                         Generation;    // Number of parses performed
+            LineArray                    Lines;         // Text of the most recent parse
+            ScriptParserPtr              Parser;        // Most recent parse
+            UINT                         ReadCount;     // Number of lines read by the most recent parse
+            UINT                         Syntax;        // Syntax library generation of cached lines
+            GameVersion                  Version;       // Game version of cached lines
+         };
+      }
+   }
+}
+
+using namespace Logic::Scripts::Compiler;
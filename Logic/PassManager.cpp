@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "PassManager.h"
+#include "Stopwatch.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         // -------------------------------- CONSTRUCTION --------------------------------
+
+         PassManager::PassManager()
+         {
+         }
+
+         PassManager::~PassManager()
+         {
+         }
+
+         // ------------------------------- STATIC METHODS -------------------------------
+
+         /// <summary>Adds time to the timing of a pass, creating it if necessary</summary>
+         /// <param name="timings">Timings</param>
+         /// <param name="name">Pass name</param>
+         /// <param name="ms">Time in milliseconds</param>
+         void  PassManager::AddTiming(TimingArray& timings, const wstring& name, double ms)
+         {
+            auto pos = find_if(timings.begin(), timings.end(), [&name](const Timing& t) { return t.Name == name; });
+
+            // New: Append
+            if (pos == timings.end())
+               pos = timings.insert(timings.end(), Timing(name));
+
+            pos->Milliseconds += ms;
+         }
+
+         // ------------------------------- PUBLIC METHODS -------------------------------
+
+         /// <summary>Appends a pass</summary>
+         /// <param name="name">Pass name</param>
+         /// <param name="v">Visitor, which must remain valid until the passes are executed</param>
+         /// <param name="dependencies">Previously added passes that must visit the entire tree before this pass begins. Passes whose results
+         /// are only required for the node being visited, or nodes preceeding it, need not be listed</param>
+         /// <param name="restructures">Whether the visitor adds children to the nodes it visits</param>
+         /// <exception cref="Logic::ArgumentException">Dependency has not been added</exception>
+         void  PassManager::Add(const wstring& name, CommandNode::Visitor& v, const NameArray& dependencies, bool restructures)
+         {
+            // Ensure dependencies precede pass
+            for (const wstring& dep : dependencies)
+               if (none_of(Passes.begin(), Passes.end(), [&dep](const Pass& p) { return p.Name == dep; }))
+                  throw ArgumentException(HERE, L"dependencies", VString(L"Pass '%s' depends upon unknown pass '%s'", name.c_str(), dep.c_str()));
+
+            Passes.push_back(Pass(name, v, dependencies, restructures));
+         }
+
+         /// <summary>Removes all passes</summary>
+         void  PassManager::Clear()
+         {
+            Passes.clear();
+         }
+
+         /// <summary>Gets the number of traversals required to execute all passes</summary>
+         /// <returns></returns>
+         UINT  PassManager::GetTraversals() const
+         {
+            UINT count = 0;
+
+            for (auto pos = Passes.begin(); pos != Passes.end(); pos = FindTraversalEnd(pos))
+               ++count;
+
+            return count;
+         }
+
+         /// <summary>Executes all passes upon the tree, in order</summary>
+         /// <param name="root">Root of the tree</param>
+         /// <param name="cancelled">Queried between traversals, execution is abandoned if it returns true. May be empty</param>
+         /// <param name="timings">Time spent in each pass is added to this collection. May be nullptr</param>
+         /// <returns>True if all passes were executed, false if cancelled</returns>
+         /// <exception cref="Logic::AlgorithmException">Error in a pass</exception>
+         bool  PassManager::Run(CommandNode& root, const CancelDelegate& cancelled, TimingArray* timings)
+         {
+            Flatten(root, timings);
+
+            for (PassIterator first = Passes.begin(); first != Passes.end(); )
+            {
+               // Cancelled: Abandon remaining passes
+               if (first != Passes.begin() && cancelled && cancelled())
+                  return false;
+
+               // Execute consecutive compatible passes upon each node
+               auto last = FindTraversalEnd(first);
+               Traverse(first, last, timings);
+
+               // Restructured: Re-flatten tree for remaining passes
+               if (last != Passes.end() && any_of(first, last, [](const Pass& p) { return p.Restructures; }))
+                  Flatten(root, timings);
+
+               first = last;
+            }
+
+            return true;
+         }
+
+         // ------------------------------ PROTECTED METHODS -----------------------------
+
+         // ------------------------------- PRIVATE METHODS ------------------------------
+
+         /// <summary>Query whether a pass depends upon any pass within a range</summary>
+         /// <param name="p">Pass</param>
+         /// <param name="first">First pass</param>
+         /// <param name="last">Position following the last pass</param>
+         /// <returns></returns>
+         bool  PassManager::DependsUpon(const Pass& p, PassIterator first, PassIterator last) const
+         {
+            for (const wstring& dep : p.Dependencies)
+               if (any_of(first, last, [&dep](const Pass& q) { return q.Name == dep; }))
+                  return true;
+
+            return false;
+         }
+
+         /// <summary>Finds the last pass that can be executed within the same traversal as another</summary>
+         /// <param name="first">First pass of traversal</param>
+         /// <returns>Position following the last pass of the traversal</returns>
+         PassManager::PassIterator  PassManager::FindTraversalEnd(PassIterator first) const
+         {
+            auto last = first;
+            bool restructures = false;
+
+            // Fuse passes until one requires the results of another for the entire tree, or the tree is restructured
+            do
+               restructures |= (last++)->Restructures;
+            while (last != Passes.end() && !restructures && !DependsUpon(*last, first, last));
+
+            return last;
+         }
+
+         /// <summary>Flattens the tree into an array of nodes in pre-order</summary>
+         /// <param name="root">Root of the tree</param>
+         /// <param name="timings">Time spent is added to this collection. May be nullptr</param>
+         void  PassManager::Flatten(CommandNode& root, TimingArray* timings)
+         {
+            Stopwatch sw;
+
+            // Prepare  [Preserve capacity]
+            Nodes.clear();
+            Stack.clear();
+            Stack.push_back(&root);
+
+            // Visit nodes depth-first  [Push children in reverse order]
+            while (!Stack.empty())
+            {
+               CommandNode* n = Stack.back();
+               Stack.pop_back();
+               Nodes.push_back(n);
+
+               for (auto c = n->Children.rbegin(); c != n->Children.rend(); ++c)
+                  Stack.push_back(c->get());
+            }
+
+            if (timings)
+               AddTiming(*timings, L"Flatten", sw.ElapsedMilliseconds);
+         }
+
+         /// <summary>Executes a range of passes upon each node in turn</summary>
+         /// <param name="first">First pass</param>
+         /// <param name="last">Position following the last pass</param>
+         /// <param name="timings">Time spent in each pass is added to this collection. May be nullptr</param>
+         void  PassManager::Traverse(PassIterator first, PassIterator last, TimingArray* timings)
+         {
+            // Execute passes upon each node
+            if (!timings)
+            {
+               for (CommandNode* n : Nodes)
+                  for (auto p = first; p != last; ++p)
+                     n->Accept(*p->Handler);
+               return;
+            }
+
+            LARGE_INTEGER start, finish, frequency;
+            QueryPerformanceFrequency(&frequency);
+
+            // Timed: Measure each visitor separately
+            Ticks.assign(last - first, 0);
+            for (CommandNode* n : Nodes)
+            {
+               QueryPerformanceCounter(&start);
+               for (auto p = first; p != last; ++p)
+               {
+                  n->Accept(*p->Handler);
+
+                  QueryPerformanceCounter(&finish);
+                  Ticks[p - first] += finish.QuadPart - start.QuadPart;
+                  start = finish;
+               }
+            }
+
+            // Add pass timings
+            for (auto p = first; p != last; ++p)
+               AddTiming(*timings, p->Name, Ticks[p - first] * 1000.0 / frequency.QuadPart);
+         }
+      }
+   }
+}
+
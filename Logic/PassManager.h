@@ -0,0 +1,107 @@
+#pragma once
+#include "CommandNode.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         /// <summary>Executes a sequence of visitors upon a command tree, fusing compatible visitors into a single traversal</summary>
+         /// <remarks>The tree is flattened into a pre-order array of nodes, and consecutive passes are executed upon each node in turn
+         /// using a single traversal of the array.  A pass begins a new traversal if it depends upon the results of a pass in the current
+         /// traversal for the entire tree, or if a pass in the current traversal restructures the tree.  Passes are never re-ordered</remarks>
+         class PassManager
+         {
+            // ------------------------ TYPES --------------------------
+         public:
+            /// <summary>Queries whether an operation has been cancelled</summary>
+            typedef function<bool ()>  CancelDelegate;
+
+            /// <summary>Pass names</summary>
+            typedef vector<wstring>  NameArray;
+
+            /// <summary>Time spent executing a pass, accumulated over one or more runs</summary>
+            class Timing
+            {
+            public:
+               Timing(const wstring& name) : Name(name), Milliseconds(0)
+               {}
+
+               wstring  Name;           // Pass name
+               double   Milliseconds;   // Time spent executing the pass
+            };
+
+            /// <summary>Pass timings in order of execution</summary>
+            typedef vector<Timing>  TimingArray;
+
+         private:
+            /// <summary>Visitor and the passes it depends upon</summary>
+            class Pass
+            {
+            public:
+               Pass(const wstring& name, CommandNode::Visitor& v, const NameArray& deps, bool restructures)
+                  : Name(name), Handler(&v), Dependencies(deps), Restructures(restructures)
+               {}
+
+               wstring                Name;            // Pass name
+               CommandNode::Visitor*  Handler;         // Visitor
+               NameArray              Dependencies;    // Passes that must have visited the entire tree beforehand
+               bool                   Restructures;    // Whether the visitor adds children to the nodes it visits
+            };
+
+            typedef vector<Pass>                PassArray;
+            typedef PassArray::const_iterator   PassIterator;
+            typedef vector<CommandNode*>        NodeArray;
+            typedef vector<LONGLONG>            TickArray;
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            PassManager();
+            virtual ~PassManager();
+
+            NO_COPY(PassManager);	// Uncopyable
+            NO_MOVE(PassManager);	// Unmoveable
+
+            // ------------------------ STATIC -------------------------
+         private:
+            static void  AddTiming(TimingArray& timings, const wstring& name, double ms);
+
+            // --------------------- PROPERTIES ------------------------
+         public:
+            PROPERTY_GET(UINT,Count,GetCount);
+            PROPERTY_GET(UINT,Traversals,GetTraversals);
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Gets the number of passes</summary>
+            UINT  GetCount() const   { return Passes.size(); }
+
+            UINT  GetTraversals() const;
+
+         private:
+            bool          DependsUpon(const Pass& p, PassIterator first, PassIterator last) const;
+            PassIterator  FindTraversalEnd(PassIterator first) const;
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            void  Add(const wstring& name, CommandNode::Visitor& v, const NameArray& dependencies = NameArray(), bool restructures = false);
+            void  Clear();
+            bool  Run(CommandNode& root, const CancelDelegate& cancelled = nullptr, TimingArray* timings = nullptr);
+
+         private:
+            void  Flatten(CommandNode& root, TimingArray* timings);
+            void  Traverse(PassIterator first, PassIterator last, TimingArray* timings);
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            NodeArray  Nodes;     // Pre-order nodes of the tree
+            PassArray  Passes;    // Passes in order of execution
+            NodeArray  Stack;     // Nodes awaiting flattening
+            TickArray  Ticks;     // Time spent in each pass of the current traversal
+         };
+      }
+   }
+}
+
+using namespace Logic::Scripts::Compiler;
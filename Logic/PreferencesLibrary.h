@@ -217,11 +217,17 @@ namespace Logic
       /// <summary>Enable translation and expansion of macro commands</summary>
       PREFERENCE_PROPERTY(bool,Bool,UseMacroCommands,true);
 
+      /// <summary>Read the scripts targetted by script-calls concurrently</summary>
+      PREFERENCE_PROPERTY(bool,Bool,ResolveScriptCallsConcurrently,true);
+
 
       // Find Dialog
       /// <summary>Show options in the find dialog</summary>
       PREFERENCE_PROPERTY(bool,Bool,ShowFindOptions,true);
 
+      /// <summary>Skip scripts that cannot match a search, using an index of script text built in the background</summary>
+      PREFERENCE_PROPERTY(bool,Bool,UseSearchIndex,true);
+
       /// <summary>Find dialog search terms</summary>
       PREFERENCE_PROPERTY_LIST(wstring,StringList,SearchTerms);
 
@@ -244,6 +250,12 @@ namespace Logic
       /// <summary>Continue loading game data if a language file fails to load</summary>
       PREFERENCE_PROPERTY(bool,Bool,SkipBrokenFiles,true);
 
+      /// <summary>Map catalog data files into memory instead of opening a stream per file</summary>
+      PREFERENCE_PROPERTY(bool,Bool,MapCatalogFiles,false);
+
+      /// <summary>Restore game data from a snapshot of the previous load, when the game files are unchanged</summary>
+      PREFERENCE_PROPERTY(bool,Bool,UseGameDataSnapshot,true);
+
       /// <summary>Game data folder</summary>
       PREFERENCE_PROPERTY_EX(Path,LPCWSTR,String,GameDataFolder,L"");
 
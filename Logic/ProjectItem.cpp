@@ -208,12 +208,12 @@ namespace Logic
       /// <param name="folder">Project folder.</param>
       void  ProjectItem::SetBackupPath(Path folder)
       {
-         // Set default path (Filename.zip)
-         auto path = folder + (FullPath.FileName + L".zip");
+         // Set default path (Filename.bak)
+         auto path = folder + (FullPath.FileName + L".bak");
             
          // [EXISTS] Append numbers until unique
          for (int i = 2; path.Exists(); ++i)
-            path = folder + VString(L"%s%d.zip", FullPath.FileName.c_str(), i);
+            path = folder + VString(L"%s%d.bak", FullPath.FileName.c_str(), i);
 
          // Set filename
          BackupName = path.FileName;
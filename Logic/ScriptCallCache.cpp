@@ -0,0 +1,191 @@
+#include "stdafx.h"
+#include "ScriptCallCache.h"
+#include "ScriptFileReader.h"
+#include "XFileInfo.h"
+#include "ComThreadHelper.h"
+#include "WorkerPool.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      ScriptCallCache  ScriptCallCache::Instance;
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      ScriptCallCache::ScriptCallCache() : Hits(0), Misses(0)
+      {
+      }
+
+
+      ScriptCallCache::~ScriptCallCache()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Gets the size and modification time of a file</summary>
+      /// <param name="path">Full path</param>
+      /// <param name="stamp">On return, the stamp of the file</param>
+      /// <returns>True if the file exists, otherwise false</returns>
+      bool  ScriptCallCache::GetStamp(const Path& path, FileStamp& stamp)
+      {
+         WIN32_FILE_ATTRIBUTE_DATA attr;
+
+         if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attr))
+            return false;
+
+         stamp.Modified = (DWORD64)attr.ftLastWriteTime.dwHighDateTime << 32 | attr.ftLastWriteTime.dwLowDateTime;
+         stamp.Size = (DWORD64)attr.nFileSizeHigh << 32 | attr.nFileSizeLow;
+         return true;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Discards all entries, the counters are retained</summary>
+      void  ScriptCallCache::Clear()
+      {
+         Lock.Enter();
+         Entries.clear();
+         Lock.Leave();
+      }
+
+      /// <summary>Gets the number of scripts cached</summary>
+      /// <returns></returns>
+      UINT  ScriptCallCache::GetCount() const
+      {
+         Lock.Enter();
+         UINT count = Entries.size();
+         Lock.Leave();
+
+         return count;
+      }
+
+      /// <summary>Gets the number of reads satisfied by the cache</summary>
+      /// <returns></returns>
+      UINT  ScriptCallCache::GetHits() const
+      {
+         Lock.Enter();
+         UINT hits = Hits;
+         Lock.Leave();
+
+         return hits;
+      }
+
+      /// <summary>Gets the proportion of reads satisfied by the cache</summary>
+      /// <returns>Value between 0 and 1, or zero if nothing has been read</returns>
+      double  ScriptCallCache::GetHitRate() const
+      {
+         Lock.Enter();
+         UINT total = Hits + Misses;
+         double rate = total ? (double)Hits / total : 0;
+         Lock.Leave();
+
+         return rate;
+      }
+
+      /// <summary>Gets the number of reads from disc</summary>
+      /// <returns></returns>
+      UINT  ScriptCallCache::GetMisses() const
+      {
+         Lock.Enter();
+         UINT misses = Misses;
+         Lock.Leave();
+
+         return misses;
+      }
+
+      /// <summary>Discards the entry for a file, if any</summary>
+      /// <param name="path">Full path of a file, need not be a script</param>
+      void  ScriptCallCache::Invalidate(const Path& path)
+      {
+         Lock.Enter();
+         Entries.erase(path);
+         Lock.Leave();
+      }
+
+      /// <summary>Reads the properties of a script, from the cache if the file is unchanged</summary>
+      /// <param name="path">Full path of script</param>
+      /// <returns>ScriptFile containing properties only</returns>
+      /// <exception cref="Logic::FileNotFoundException">File not found</exception>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::FileFormatException">Corrupt XML / Missing elements / missing attributes</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      ScriptFile  ScriptCallCache::Read(const Path& path)
+      {
+         FileStamp stamp;
+
+         // Missing: Discard stale entry
+         if (!GetStamp(path, stamp))
+         {
+            Invalidate(path);
+            throw FileNotFoundException(HERE, path);
+         }
+
+         // Lookup entry.  Hit: Return a copy
+         Lock.Enter();
+         auto pos = Entries.find(path);
+         if (pos != Entries.end() && pos->second.Stamp == stamp)
+         {
+            ScriptFile props(pos->second.Properties);
+            ++Hits;
+            Lock.Leave();
+            return props;
+         }
+         ++Misses;
+         Lock.Leave();
+
+         // Miss: Read properties without holding the lock
+         ScriptFile props = ScriptFileReader(XFileInfo(path).OpenRead()).ReadFile(path, true);
+
+         // Store/Replace entry
+         Lock.Enter();
+         Entries.erase(path);
+         Entries.insert(EntryMap::value_type(path, Entry(stamp, props)));
+         Lock.Leave();
+
+         return props;
+      }
+
+      /// <summary>Reads the properties of several scripts into the cache concurrently</summary>
+      /// <param name="folder">Folder of the calling script</param>
+      /// <param name="scripts">Names of target scripts WITHOUT extension</param>
+      /// <param name="threads">Maximum number of scripts to read concurrently. Zero to use one per processor</param>
+      /// <remarks>Scripts that cannot be found or read are skipped, they are reported when subsequently read</remarks>
+      void  ScriptCallCache::Resolve(const Path& folder, const set<wstring>& scripts, UINT threads)
+      {
+         WorkerPool pool(threads);
+
+         // Read each script on the pool  [Hits are cheap, so cached scripts are not filtered beforehand]
+         for (const wstring& name : scripts)
+            pool.Add([this, &folder, &name]
+            {
+               try
+               {
+                  ComThreadHelper COM;
+                  ScriptCallPath  path(folder, name);
+
+                  if (path.Exists())
+                     Read(path);
+               }
+               catch (ExceptionBase&) {
+               }
+            });
+
+         pool.Run();
+      }
+
+      /// <summary>Resets the hit and miss counters</summary>
+      void  ScriptCallCache::ResetCounters()
+      {
+         Lock.Enter();
+         Hits = Misses = 0;
+         Lock.Leave();
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+   }
+}
+
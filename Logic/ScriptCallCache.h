@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ScriptFile.h"
+#include "CriticalSection.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      /// <summary>Process-wide cache of the properties of scripts targetted by script-calls</summary>
+      /// <remarks>Entries are keyed by the resolved path of the target script, and are discarded once the size or modification
+      /// time of the file changes.  The cache is thread-safe; concurrent misses upon the same script may each read the file, in
+      /// which case the last to finish is retained</remarks>
+      class LogicExport ScriptCallCache
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Size and modification time of a file</summary>
+         class FileStamp
+         {
+         public:
+            FileStamp() : Modified(0), Size(0)
+            {}
+
+            bool operator==(const FileStamp& r) const  { return Modified == r.Modified && Size == r.Size; }
+
+            DWORD64  Modified,    // Last write time
+                     Size;        // Size in bytes
+         };
+
+         /// <summary>Properties of a script, and the stamp of the file they were read from</summary>
+         class Entry
+         {
+         public:
+            Entry(const FileStamp& s, const ScriptFile& f) : Stamp(s), Properties(f)
+            {}
+
+            FileStamp   Stamp;         // Stamp of file when read
+            ScriptFile  Properties;    // Script properties
+         };
+
+         /// <summary>Entries keyed by full path  [Case insensitive]</summary>
+         typedef map<Path, Entry>  EntryMap;
+
+         // --------------------- CONSTRUCTION ----------------------
+      private:
+         ScriptCallCache();
+      public:
+         virtual ~ScriptCallCache();
+
+         NO_COPY(ScriptCallCache);	// Uncopyable
+         NO_MOVE(ScriptCallCache);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static bool  GetStamp(const Path& path, FileStamp& stamp);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+         PROPERTY_GET(UINT,Hits,GetHits);
+         PROPERTY_GET(double,HitRate,GetHitRate);
+         PROPERTY_GET(UINT,Misses,GetMisses);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         UINT    GetCount() const;
+         UINT    GetHits() const;
+         double  GetHitRate() const;
+         UINT    GetMisses() const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         void        Clear();
+         void        Invalidate(const Path& path);
+         ScriptFile  Read(const Path& path);
+         void        Resolve(const Path& folder, const set<wstring>& scripts, UINT threads = 0);
+         void        ResetCounters();
+
+         // -------------------- REPRESENTATION ---------------------
+      public:
+         static ScriptCallCache  Instance;
+
+      private:
+         mutable CriticalSection  Lock;       // Guards all members below
+         EntryMap                 Entries;    // Script properties keyed by path
+         UINT                     Hits,       // Number of reads satisfied by the cache
+                                  Misses;     // Number of reads from disc
+      };
+
+      // The script-call cache singleton
+      #define ScriptCallLib  ScriptCallCache::Instance
+   }
+}
+
+using namespace Logic::IO;
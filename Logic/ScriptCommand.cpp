@@ -628,24 +628,25 @@ namespace Logic
       {
          try
          {
-            CommandLexer lex(Syntax.Text, false);
-            bool         Param = false;
+            UINT length = Text.length();
 
             // Translate parameters
             for (ScriptParameter& p : Parameters)
                p.Translate(f);
 
-            // Insert/Replace syntax '$n' markers with parameter text
-            for (const ScriptToken& tok : lex.Tokens)
+            // Measure syntax text + parameter text
+            for (const auto& seg : Syntax.Template)
+               length += seg.IsParameter() ? Parameters[seg.Parameter].Text.length() : seg.Length;
+            Text.reserve(length);
+
+            // Replace syntax '$n' markers with parameter text
+            for (const auto& seg : Syntax.Template)
             {
                // Marker: Insert parameter text
-               if (tok.Type == TokenType::Variable || tok.Type == TokenType::Comment)  // Lexer identifies comment syntax as 'comment'
-               {
-                  int i = (tok.Text[1]-48);
-                  Text.append( Parameters[i].Text );
-               }
+               if (seg.IsParameter())
+                  Text.append( Parameters[seg.Parameter].Text );
                else // Text: Insert verbatim
-                  Text.append(tok.Text);
+                  Text.append(Syntax.Text, seg.Start, seg.Length);
             }
             // Trim leading spaces
             Text = Text.TrimLeft(L" ");
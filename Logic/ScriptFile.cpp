@@ -66,34 +66,12 @@ namespace Logic
       /// <returns>True if found, false otherwise</returns>
       bool  ScriptFile::FindNext(UINT start, MatchData& m)
       {
-         int pos = GuiString::npos, len = 0;
+         UINT pos = 0, len = 0;
 
-         // Validate position 
-         if (start >= OfflineBuffer.length())
-            m.Clear();
-         
-         // RegEx: Find + determine match length
-         else if (m.UseRegEx)
-         {
-            wsmatch matches;
-
-            // Search remainder of text
-            if (regex_search(OfflineBuffer.cbegin()+start, OfflineBuffer.cend(), matches, m.RegEx))  //, regex_constants::match_default))
-            {
-               pos = matches[0].first - OfflineBuffer.cbegin();
-               len = matches[0].length();
-            }
-         }
-         // Basic: Linear search
-         else
-         {
-            pos = OfflineBuffer.Find(m.SearchTerm, start, m.MatchCase);
-            len = m.SearchTerm.length();
-         }
-         
-         // Found: Set location, length, line number, line text
-         if (pos != GuiString::npos)
+         // Search remainder of text using compiled term/expression
+         if (start < OfflineBuffer.length() && m.Pattern.Find(OfflineBuffer, start, pos, len))
          {
+            // Found: Set location, length, line number, line text
             int line = count_if(OfflineBuffer.begin(), OfflineBuffer.begin()+pos, [](wchar ch) {return ch=='\n';} );
             m.SetMatch(pos, len, line+1, Commands.Input[line].Text);
          }
@@ -6,6 +6,7 @@
 #include "XFileSystem.h"
 #include "PreferencesLibrary.h"
 #include "SyntaxLibrary.h"
+#include "ScriptCallCache.h"
 
 namespace Logic
 {
@@ -15,10 +16,12 @@ namespace Logic
 
       /// <summary>Creates an MSCI script reader from an input stream</summary>
       /// <param name="src">The input stream</param>
+      /// <param name="concurrent">Whether script-calls may be resolved concurrently, if enabled in the preferences.  Callers 
+      /// that already read scripts concurrently should pass false, so that each script does not create its own worker pool</param>
       /// <exception cref="Logic::ArgumentException">Stream is not readable</exception>
       /// <exception cref="Logic::ArgumentNullException">Stream is null</exception>
       /// <exception cref="Logic::ComException">COM Error</exception>
-      ScriptFileReader::ScriptFileReader(StreamPtr in) : ScriptValueReader(in)
+      ScriptFileReader::ScriptFileReader(StreamPtr in, bool concurrent) : ScriptValueReader(in), Concurrent(concurrent)
       {
       }
 
@@ -75,8 +78,8 @@ namespace Logic
             if (!path.Exists())
                throw FileNotFoundException(HERE, folder+script);
 
-            // Read script
-            ScriptFile sf = ScriptFileReader(XFileInfo(path).OpenRead()).ReadFile(path, true);
+            // Read script  [Shared between all callers]
+            ScriptFile sf = ScriptCallLib.Read(path);
 
             // Feedback
             if (!silent)
@@ -125,7 +128,7 @@ namespace Logic
 
             // Commands
             if (!justProperties)
-               ReadCommands(file, GetChild(CodeArray, 6, L"standard commands branch"), GetChild(CodeArray, 8, L"auxiliary commands branch"), rawTranslate);
+               ReadCommands(file, GetChild(CodeArray, 6, L"standard commands branch"), GetChild(CodeArray, 8, L"auxiliary commands branch"), rawTranslate, false, true);
 
             // Command ID
             file.CommandID = ReadValue(CodeArray, 9, L"script command ID");
@@ -138,6 +141,45 @@ namespace Logic
          }
       }
 
+      /// <summary>Reads only the properties and command text necessary to search or compare a script</summary>
+      /// <param name="path">Full file path</param>
+      /// <param name="macros">Whether to translate command sequences into macros, if enabled in the preferences</param>
+      /// <returns>New script file containing the name, variables, labels, translated commands and script text</returns>
+      /// <remarks>Unlike ReadFile, variable usage is not identified and macros are only translated upon request.  Script-calls are resolved
+      /// through the script-call cache, one at a time, so that arguments are named as in the opened document</remarks>
+      /// <exception cref="Logic::ArgumentNullException">Missing node</exception>
+      /// <exception cref="Logic::ComException">COM Error</exception>
+      /// <exception cref="Logic::FileFormatException">Corrupt XML / Missing elements / missing attributes</exception>
+      /// <exception cref="Logic::InvalidValueException">Invalid script command</exception>
+      /// <exception cref="Logic::InvalidOperationException">Invalid goto/gosub command</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      ScriptFile ScriptFileReader::ReadText(Path path, bool macros /*= false*/)
+      {
+         try
+         {
+            ScriptFile file(path);
+
+            // Read file
+            LoadDocument();
+
+            // Read name/version
+            file.Name = ReadString(CodeArray, 0, L"script name");
+            file.Game = EngineVersionConverter::ToGame(ReadInt(CodeArray, 1, L"script engine version"));
+
+            // Variables: Required for variable names
+            ReadVariables(file, GetChild(CodeArray, 5, L"variables branch"), GetChild(CodeArray, 7, L"codearray arguments branch")); 
+
+            // Commands
+            ReadCommands(file, GetChild(CodeArray, 6, L"standard commands branch"), GetChild(CodeArray, 8, L"auxiliary commands branch"), false, true, macros);
+
+            // Return file
+            return file;
+         }
+         catch (_com_error& ex) {
+            throw ComException(HERE, ex);
+         }
+      }
+
 		// ------------------------------ PROTECTED METHODS -----------------------------
 
 		// ------------------------------- PRIVATE METHODS ------------------------------
@@ -183,12 +225,14 @@ namespace Logic
       /// <param name="stdBranch">The standard commands branch.</param>
       /// <param name="auxBranch">The auxiliary commands branch.</param>
       /// <param name="rawTranslate">Whether to preserve script exactly - retain JMP commands and skip macro insertion</param>
+      /// <param name="textOnly">Whether to translate command text only - skip identifying variables and resolve script-calls silently, one at a time</param>
+      /// <param name="macros">Whether to translate command sequences into macros, if enabled in the preferences</param>
       /// <exception cref="Logic::ArgumentNullException">Missing node</exception>
       /// <exception cref="Logic::FileFormatException">Invalid file format</exception>
       /// <exception cref="Logic::InvalidOperationException">Invalid goto/gosub command</exception>
       /// <exception cref="Logic::InvalidValueException">Invalid goto/gosub command</exception>
       /// <exception cref="Logic::ComException">COM Error</exception>
-      void  ScriptFileReader::ReadCommands(ScriptFile&  script, XmlNodePtr& stdBranch, XmlNodePtr& auxBranch, bool rawTranslate)
+      void  ScriptFileReader::ReadCommands(ScriptFile&  script, XmlNodePtr& stdBranch, XmlNodePtr& auxBranch, bool rawTranslate, bool textOnly, bool macros)
       {
          CommandArray  std;
          CommandList   aux; 
@@ -221,6 +265,10 @@ namespace Logic
             script.Commands.AddInput(c);
 
 
+         // Resolve script-calls concurrently, they are then read from the script-call cache below
+         if (!textOnly && Concurrent && PrefsLib.ResolveScriptCallsConcurrently)
+            ResolveScriptCalls(script);
+
          // Translate all commands/parameters
          UINT line = 1;
          for (ScriptCommand& cmd : script.Commands.Input)
@@ -241,7 +289,7 @@ namespace Logic
             else if (cmd.Is(CMD_DEFINE_LABEL))
                script.Labels.Add(cmd.GetLabelName(), line);
 
-            // SCRIPT-CALL: Load script properties
+            // SCRIPT-CALL: Load script properties, required to name arguments
             else if (cmd.Syntax.IsScriptCall())
             {
                try 
@@ -251,7 +299,7 @@ namespace Logic
 
                   // Read unless previously read
                   if (!name.empty() && !script.ScriptCalls.Contains(name))
-                     script.ScriptCalls.Add(name, ReadExternalScript(script.FullPath.Folder, name, false));
+                     script.ScriptCalls.Add(name, ReadExternalScript(script.FullPath.Folder, name, textOnly));
                }
                catch (ExceptionBase&) {
                   //if (e.ErrorID != ERROR_FILE_NOT_FOUND)
@@ -263,18 +311,24 @@ namespace Logic
             cmd.Translate(script);
 
             // Distinguish constants from variables
-            for (auto& p : cmd.Parameters)
-               p.Identify(script);
+            if (!textOnly)
+               for (auto& p : cmd.Parameters)
+                  p.Identify(script);
 
             // Advance
             ++line;
          }
 
          // Macros: convert certain command sequences into macros
-         if (PrefsLib.UseMacroCommands)
+         if (macros && PrefsLib.UseMacroCommands)
             TranslateMacros(script);
 
-         // Generate offline buffer
+         // Generate offline buffer  [Measure first to avoid reallocation]
+         UINT length = 0;
+         for (const ScriptCommand& cmd : script.Commands.Input)
+            length += cmd.Text.length() + 1;
+         script.OfflineBuffer.reserve(script.OfflineBuffer.length() + length);
+
          for (ScriptCommand& cmd : script.Commands.Input)
          {
             script.OfflineBuffer += cmd.Text;
@@ -529,5 +583,28 @@ namespace Logic
          }
       }
 
+      /// <summary>Reads the properties of every script called by a script into the script-call cache concurrently</summary>
+      /// <param name="script">The script.</param>
+      void  ScriptFileReader::ResolveScriptCalls(const ScriptFile& script)
+      {
+         set<wstring> names;
+
+         // Collect distinct target scripts  [Calls via variables cannot be resolved]
+         for (const ScriptCommand& cmd : script.Commands.Input)
+            if (cmd.Syntax.IsScriptCall())
+               try 
+               {
+                  wstring name = cmd.GetScriptCallName();
+                  if (!name.empty() && !script.ScriptCalls.Contains(name))
+                     names.insert(name);
+               }
+               catch (ExceptionBase&) {
+               }
+
+         // Read concurrently, unless there is only one
+         if (names.size() > 1)
+            ScriptCallLib.Resolve(script.FullPath.Folder, names);
+      }
+
    }
 }
\ No newline at end of file
@@ -169,7 +169,7 @@ namespace Logic
 
          // --------------------- CONSTRUCTION ----------------------
       public:
-         ScriptFileReader(StreamPtr in);
+         ScriptFileReader(StreamPtr in, bool concurrent = true);
          virtual ~ScriptFileReader();
 
          // ------------------------ STATIC -------------------------
@@ -190,16 +190,18 @@ namespace Logic
 		   // ----------------------- MUTATORS ------------------------
       public:
          ScriptFile  ReadFile(Path path, bool justProperties, bool rawTranslate = false);
+         ScriptFile  ReadText(Path path, bool macros = false);
 
       protected:
          ReaderPtr GetCommandReader(ScriptFile& script, CommandType type, XmlNodePtr& cmdBranch);
-         void      ReadCommands(ScriptFile&  script, XmlNodePtr& stdBranch, XmlNodePtr& auxBranch, bool rawTranslate);
+         void      ReadCommands(ScriptFile&  script, XmlNodePtr& stdBranch, XmlNodePtr& auxBranch, bool rawTranslate, bool textOnly, bool macros);
          void      ReadVariables(ScriptFile&  script, XmlNodePtr& varBranch, XmlNodePtr& argBranch);
+         void      ResolveScriptCalls(const ScriptFile& script);
          void      TranslateMacros(ScriptFile& script);
 
 		   // -------------------- REPRESENTATION ---------------------
       protected:
-
+         const bool  Concurrent;    // Whether script-calls may be resolved concurrently
       };
 
       
@@ -20,6 +20,16 @@ namespace Logic
       {
       }
 
+      /// <summary>Creates a script object from a known group</summary>
+      /// <param name="id">string ID</param>
+      /// <param name="grp">object group</param>
+      /// <param name="txt">resolved text</param>
+      /// <param name="ver">game version</param>
+      ScriptObject::ScriptObject(UINT id, ScriptObjectGroup grp, const GuiString& txt, GameVersion ver) 
+            : ID(id), Group(grp), Text(txt), Version(ver)
+      {
+      }
+
       /// <summary>Copy move ctor</summary>
       /// <param name="r">The source</param>
       ScriptObject::ScriptObject(ScriptObject&& r)
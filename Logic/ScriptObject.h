@@ -59,6 +59,7 @@ namespace Logic
          // --------------------- CONSTRUCTION ----------------------
       public:
          ScriptObject(UINT id, KnownPage page, const GuiString& txt, GameVersion ver);
+         ScriptObject(UINT id, ScriptObjectGroup grp, const GuiString& txt, GameVersion ver);
          ScriptObject(ScriptObject&& r);
          ~ScriptObject();
 
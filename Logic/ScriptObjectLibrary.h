@@ -9,6 +9,11 @@
 
 namespace Logic
 {
+   namespace IO
+   {
+      class GameDataSnapshot;
+   }
+
    namespace Scripts
    {
       
@@ -16,6 +21,8 @@ namespace Logic
       /// <summary>Provides access to script objects</summary>
       class LogicExport ScriptObjectLibrary
       {
+         friend class IO::GameDataSnapshot;
+
 		   // ------------------------ TYPES --------------------------
       private:
          /// <summary>Defines a {KnownPage,ID} pair</summary>
@@ -1,11 +1,13 @@
 #include "stdafx.h"
 #include "ScriptParser.h"
+#include "CommandIdentifier.h"
 #include "ExpressionParser.h"
 #include "GameObjectLibrary.h"
 #include "ScriptObjectLibrary.h"
 #include "SyntaxLibrary.h"
 #include "CommandHash.h"
 #include "ScriptFile.h"
+#include "ParseSession.h"
 
 /// <summary>Prints the parse tree post-verification and post-compilation</summary>
 //#define DEBUG_PRINT
@@ -22,22 +24,44 @@ namespace Logic
          /// <param name="file">Script</param>
          /// <param name="lines">The lines to parse</param>
          /// <param name="v">The game version</param>
+         /// <param name="session">Session caching previously read lines, or nullptr to read every line</param>
          /// <exception cref="Logic::ArgumentException">Line array is empty</exception>
          /// <exception cref="Logic::AlgorithmException">Error in parsing algorithm</exception>
-         ScriptParser::ScriptParser(ScriptFile& file, const LineArray& lines, GameVersion  v) 
-            : Input(lines), Version(v), Script(file)
+         ScriptParser::ScriptParser(ScriptFile& file, const LineArray& lines, GameVersion  v, ParseSession* session) 
+            : Input(lines), Version(v), Script(file), Session(session), Buffer(LocalBuffer)
          {
             if (lines.size() == 0)
                throw ArgumentException(HERE, L"lines", L"Line count cannot be zero");
 
+            CurrentLine = Input.begin();
+
             // Clear script
             Script.Clear();
 
             // Parse input
-            CurrentLine = Input.begin();
             ParseRoot();
          }
 
+         /// <summary>Creates a parser for identifying the first line only, without modifying the script</summary>
+         /// <param name="file">Script</param>
+         /// <param name="lines">The lines to parse</param>
+         /// <param name="v">The game version</param>
+         /// <param name="tree">Tree whose arena allocates the node, retained by the caller between lines</param>
+         /// <param name="buffer">Token buffer, retained by the caller between lines</param>
+         /// <remarks>The node is available as CurrentNode</remarks>
+         /// <exception cref="Logic::ArgumentException">Line array is empty</exception>
+         /// <exception cref="Logic::AlgorithmException">Error in parsing algorithm</exception>
+         ScriptParser::ScriptParser(ScriptFile& file, const LineArray& lines, GameVersion  v, const CommandTree& tree, TokenBuffer& buffer) 
+            : Input(lines), Version(v), Script(file), Tree(tree), Session(nullptr), Buffer(buffer)
+         {
+            if (lines.size() == 0)
+               throw ArgumentException(HERE, L"lines", L"Line count cannot be zero");
+
+            // Read first line only
+            CurrentLine = Input.begin();
+            CurrentNode = ReadLine();
+         }
+
          ScriptParser::~ScriptParser()
          {
          }
@@ -65,52 +89,19 @@ namespace Logic
          /// <param name="script">script.</param>
          /// <param name="line">line text.</param>
          /// <returns>Command syntax if successful, otherwise 'Unknown' sentinel</returns>
-         CommandSyntaxRef  ScriptParser::Identify(ScriptFile script, const wstring& line)
+         /// <remarks>Callers identifying lines repeatedly should retain a CommandIdentifier, which re-uses its buffers</remarks>
+         CommandSyntaxRef  ScriptParser::Identify(const ScriptFile& script, const wstring& line)
          {
-            try
-            {
-               ScriptParser parser(script, {line}, script.Game);
-
-               // Sanity check
-               if (parser.Empty)
-                  throw AlgorithmException(HERE, L"Parse tree has no children");
-
-               // Retrieve syntax of single node
-               return parser.FirstCommand->Syntax;
-            }
-            catch (ExceptionBase& e) {
-               Console.Log(HERE, e);
-               return CommandSyntax::Unrecognised;
-            }
+            return *CommandIdentifier().Identify(script, line).Syntax;
          }
 
          /// <summary>Parses a single command from a line of text.</summary>
          /// <param name="script">script.</param>
          /// <param name="line">line text.</param>
          /// <returns>Command if successful, otherwise 'unrecognised' sentinel</returns>
-         ScriptCommand  ScriptParser::Parse(ScriptFile script, const wstring& line)
+         ScriptCommand  ScriptParser::Parse(const ScriptFile& script, const wstring& line)
          {
-            try
-            {
-               ScriptParser parser(script, {line}, script.Game);
-
-               // Sanity check
-               if (parser.Empty)
-                  throw AlgorithmException(HERE, L"Parse tree has no children");
-
-               // Retrieve node
-               auto node = parser.FirstCommand;
-
-               // Generate command
-               if (!node->Is(CMD_EXPRESSION))
-                  return ScriptCommand(node->LineText, node->Syntax, node->Parameters, node->CmdComment);
-               else
-                  return ScriptCommand(node->LineText, node->Syntax, node->Parameters, node->Postfix, node->CmdComment);
-            }
-            catch (ExceptionBase& e) {
-               Console.Log(HERE, e);
-               return ScriptCommand::Unrecognised;
-            }
+            return CommandIdentifier().Parse(script, line);
          }
 
          
@@ -278,7 +269,7 @@ namespace Logic
             }
             
             // Verify tree
-            Tree.Verify(Script, Errors);
+            Tree.Verify(Script, Errors, Session ? Session->Cancelled : CommandTree::CancelDelegate());
 
 #ifdef DEBUG_PRINT
             Print();
@@ -644,10 +635,10 @@ namespace Logic
 
             // NOP: No processing required
             if (lex.count() == 0)
-               return new CommandNode(Conditional::NONE, SyntaxLib.Find(CMD_NOP, Version), params, lex, LineNumber, false);
+               return Tree.CreateNode(Conditional::NONE, SyntaxLib.Find(CMD_NOP, Version), params, lex, LineNumber, false);
 
             // Re-lex line without the '*' operator
-            CommentLexer lex2(lex.Input);
+            CommentLexer lex2(lex.Input, Buffer);
 
             // Commented Command:
             if (MatchCommand(lex2) && (node = ReadCommand(lex2, true)))
@@ -664,7 +655,7 @@ namespace Logic
             params += ScriptParameter(syntax.Parameters[0], lex.count()==2 ? lex.Tokens[1] : ScriptToken(TokenType::Comment, 1,1, L""));
 
             // Return comment
-            return new CommandNode(Conditional::NONE, syntax, params, lex, LineNumber, false);
+            return Tree.CreateNode(Conditional::NONE, syntax, params, lex, LineNumber, false);
          }
 
          /// <summary>Reads an entire non-expression command</summary>
@@ -786,7 +777,7 @@ namespace Logic
             }
 
             // Return new command / commented-command
-            return new CommandNode(condition, syntax, params, lex, LineNumber, comment);
+            return Tree.CreateNode(condition, syntax, params, lex, LineNumber, comment);
          }
 
          /// <summary>Reads an entire expression command</summary>
@@ -851,7 +842,7 @@ namespace Logic
             }
 
             // Return new expression / commented-expression
-            return new CommandNode(condition, syntax, params, postfix, lex, LineNumber, comment);
+            return Tree.CreateNode(condition, syntax, params, postfix, lex, LineNumber, comment);
          }
          
          
@@ -875,13 +866,23 @@ namespace Logic
          /// <exception cref="Logic::AlgorithmException">Error in parsing algorithm</exception>
          CommandNodePtr ScriptParser::ReadLine()
          {
+            CommandNodePtr node;
+
             // EOF: Return
             if (CurrentLine == Input.end())
                return nullptr;
 
+            // Cached: Re-use node + errors of identical line text
+            const CommandNode* cached = (Session ? Session->Find(*CurrentLine, LineNumber, Errors) : nullptr);
+            if (cached)
+            {
+               node = Tree.CreateNode(*cached, LineNumber);
+               return (++CurrentLine, node);
+            }
+
             // Lex current line
-            CommandLexer   lex(*CurrentLine);
-            CommandNodePtr node;
+            CommandLexer   lex(*CurrentLine, Buffer);
+            UINT           errors = Errors.size();
             
             // NOP/Comment/CmdComment:
             if (MatchComment(lex))
@@ -899,9 +900,14 @@ namespace Logic
             {
                // UNRECOGNISED: Generate empty node
                Errors += MakeError(L"Unable to parse command", lex);
-               node = new CommandNode(Conditional::NONE, CommandSyntax::Unrecognised, ParameterArray(), lex, LineNumber, false);
+               ParameterArray none;
+               node = Tree.CreateNode(Conditional::NONE, CommandSyntax::Unrecognised, none, lex, LineNumber, false);
             }
 
+            // Session: Cache node + errors
+            if (Session)
+               Session->Store(*CurrentLine, node, Errors.begin() + errors, Errors.end());
+
             // Consume line + return node
             ++CurrentLine;
             return node;
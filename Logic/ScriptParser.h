@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CommandTree.h"
+#include "TokenBuffer.h"
 #include <algorithm>
 
 namespace Testing
@@ -14,11 +15,14 @@ namespace Logic
    {
       namespace Compiler
       {
+         class CommandIdentifier;
+         class ParseSession;
          
          /// <summary>Generates a parse tree from MSCI scripts</summary>
          class LogicExport ScriptParser
          {
             friend class ::Testing::LogicTests;
+            friend class CommandIdentifier;
 
             // ------------------------ TYPES --------------------------
          protected:
@@ -28,7 +32,8 @@ namespace Logic
             public:
                /// <summary>Lexes a command comment as a command</summary>
                /// <param name="input">Line of command text</param>
-               CommentLexer(const wstring& input) : CommandLexer(StripComment(input), true)
+               /// <param name="buffer">Token buffer shared with other lexers</param>
+               CommentLexer(const wstring& input, TokenBuffer& buffer) : CommandLexer(StripComment(input), buffer, true)
                {}
 
             private:
@@ -43,7 +48,10 @@ namespace Logic
 
             // --------------------- CONSTRUCTION ----------------------
          public:
-            ScriptParser(ScriptFile& file, const LineArray& lines, GameVersion  v);
+            ScriptParser(ScriptFile& file, const LineArray& lines, GameVersion  v, ParseSession* session = nullptr);
+         protected:
+            ScriptParser(ScriptFile& file, const LineArray& lines, GameVersion  v, const CommandTree& tree, TokenBuffer& buffer);
+         public:
             virtual ~ScriptParser();
 
             NO_COPY(ScriptParser);	// Cannot copy semantics
@@ -51,8 +59,8 @@ namespace Logic
 
             // ------------------------ STATIC -------------------------
          public:
-            static CommandSyntaxRef  Identify(ScriptFile script, const wstring& line);
-            static ScriptCommand     Parse(ScriptFile script, const wstring& line);
+            static CommandSyntaxRef  Identify(const ScriptFile& script, const wstring& line);
+            static ScriptCommand     Parse(const ScriptFile& script, const wstring& line);
             static CommandNodePtr    Generate(const wstring& line, GameVersion v);
 
             // --------------------- PROPERTIES ------------------------
@@ -120,6 +128,9 @@ namespace Logic
             LineIterator    CurrentLine;     // Line being parsed
             CommandNodePtr  CurrentNode;     // Most recently parsed node
             ErrorArray      CommentErrors;   // Separate error queue used for trying to parse command comments
+            ParseSession*   Session;         // Session caching previously read lines, if any
+            TokenBuffer     LocalBuffer;     // Token buffer, unless provided by the caller
+            TokenBuffer&    Buffer;          // Token buffer shared by the lexer of every line
          };
       }
    }
@@ -148,6 +148,40 @@ namespace Logic
             const wstring    Text;
          };
 
+         /// <summary>Token produced by the allocation-free lexer, identifying a range of characters within the lexed text</summary>
+         /// <remarks>Unlike ScriptToken this is trivially copyable and owns no text, so arrays of tokens can be reused without allocation</remarks>
+         class LexToken
+         {
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            LexToken(TokenType t, UINT s, UINT e) : Type(t), Start(s), End(e)
+            {}
+
+            // --------------------- PROPERTIES ------------------------
+         public:
+            PROPERTY_GET(UINT,Length,GetLength);
+
+            // ---------------------- ACCESSORS ------------------------			
+         public:
+            /// <summary>Determines whether token contains a character position</summary>
+            /// <param name="pos">Zero based char index.</param>
+            /// <returns></returns>
+            bool  Contains(UINT pos) const { return pos >= Start && pos < End; }
+
+            /// <summary>Gets the length in characters</summary>
+            /// <returns></returns>
+            UINT  GetLength() const { return End - Start; }
+
+            // -------------------- REPRESENTATION ---------------------
+         public:
+            TokenType  Type;
+            UINT       Start, 
+                       End;
+         };
+
+         /// <summary>Vector of allocation-free tokens</summary>
+         typedef vector<LexToken>  LexTokenArray;
+
          /// <summary>Write script token to the console</summary>
          LogicExport ConsoleWnd& operator<<(ConsoleWnd& c, const ScriptToken& tok);
 
@@ -0,0 +1,689 @@
+#include "stdafx.h"
+#include "SearchIndex.h"
+#include "ScriptFileReader.h"
+#include "XFileInfo.h"
+#include "MappedFile.h"
+#include "FileStream.h"
+#include "ComThreadHelper.h"
+#include "WorkerPool.h"
+#include "WorkerData.h"
+#include "PreferencesLibrary.h"
+#include "zlib.h"
+
+namespace Logic
+{
+   namespace IO
+   {
+      // -------------------------------- NESTED CLASSES ------------------------------
+
+      /// <summary>Reads values from an index body</summary>
+      class SearchIndex::Reader
+      {
+      public:
+         /// <summary>Creates a reader for a buffer</summary>
+         /// <param name="buf">The buffer</param>
+         /// <param name="length">Length of buffer, in bytes</param>
+         Reader(const BYTE* buf, DWORD length) : Buffer(buf), Length(length), Position(0)
+         {}
+
+         /// <summary>Reads a 32-bit value</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of index</exception>
+         DWORD  ReadDWord()
+         {
+            DWORD value;
+            Read(&value, sizeof(value));
+            return value;
+         }
+
+         /// <summary>Reads a 64-bit value</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of index</exception>
+         DWORD64  ReadQWord()
+         {
+            DWORD64 value;
+            Read(&value, sizeof(value));
+            return value;
+         }
+
+         /// <summary>Reads a length-prefixed UTF-16 string</summary>
+         /// <returns></returns>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of index</exception>
+         wstring  ReadString()
+         {
+            DWORD chars = ReadDWord();
+
+            // Ensure string lies within buffer
+            if (chars > (Length - Position) / sizeof(WCHAR))
+               throw FileFormatException(HERE, L"Unexpected end of search index");
+
+            wstring str(reinterpret_cast<const WCHAR*>(Buffer + Position), chars);
+            Position += chars * sizeof(WCHAR);
+            return str;
+         }
+
+      private:
+         /// <summary>Reads raw bytes</summary>
+         /// <exception cref="Logic::FileFormatException">Unexpected end of index</exception>
+         void  Read(void* output, DWORD length)
+         {
+            if (length > Length - Position)
+               throw FileFormatException(HERE, L"Unexpected end of search index");
+
+            memcpy(output, Buffer + Position, length);
+            Position += length;
+         }
+
+         const BYTE*  Buffer;
+         const DWORD  Length;
+         DWORD        Position;
+      };
+
+      /// <summary>Writes values to an index body</summary>
+      class SearchIndex::Writer
+      {
+      public:
+         /// <summary>Writes a 32-bit value</summary>
+         void  Write(DWORD value)
+         {
+            Write(&value, sizeof(value));
+         }
+
+         /// <summary>Writes a 64-bit value</summary>
+         void  Write(DWORD64 value)
+         {
+            Write(&value, sizeof(value));
+         }
+
+         /// <summary>Writes a length-prefixed UTF-16 string</summary>
+         void  Write(const wstring& str)
+         {
+            Write((DWORD)str.length());
+            Write(str.c_str(), str.length() * sizeof(WCHAR));
+         }
+
+         /// <summary>Writes raw bytes</summary>
+         void  Write(const void* buf, DWORD length)
+         {
+            const BYTE* bytes = reinterpret_cast<const BYTE*>(buf);
+            Buffer.insert(Buffer.end(), bytes, bytes + length);
+         }
+
+         vector<BYTE>  Buffer;
+      };
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      SearchIndex  SearchIndex::Instance;
+
+      SearchIndex::SearchIndex() : Removed(0)
+      {
+      }
+
+      SearchIndex::~SearchIndex()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Calculates the key identifying the settings that affect the translated text of scripts</summary>
+      /// <returns>Key that changes whenever the game folder, version, language or translation preferences change</returns>
+      DWORD64  SearchIndex::GetKey()
+      {
+         DWORD64 key = 14695981039346656037ULL;
+         DWORD   settings[5] = { FORMAT, (DWORD)PrefsLib.GameDataVersion, (DWORD)PrefsLib.GameDataLanguage,
+                                 PrefsLib.UseMacroCommands ? 1UL : 0UL, PrefsLib.UseCppOperators ? 1UL : 0UL };
+         Path    folder = PrefsLib.GameDataFolder;
+
+         // Combine settings and game folder using FNV-1a
+         const BYTE* bytes = reinterpret_cast<const BYTE*>(settings);
+         for (DWORD i = 0; i < sizeof(settings); ++i)
+            key = (key ^ bytes[i]) * 1099511628211ULL;
+
+         bytes = reinterpret_cast<const BYTE*>(folder.c_str());
+         for (DWORD i = 0; i < folder.Length * sizeof(WCHAR); ++i)
+            key = (key ^ bytes[i]) * 1099511628211ULL;
+
+         return key;
+      }
+
+      /// <summary>Gets the text that every match of a search must contain</summary>
+      /// <param name="m">The search</param>
+      /// <returns>Search term, the literal prefix of a regular expression, or empty string if none can be determined</returns>
+      wstring  SearchIndex::GetLiteral(const MatchData& m)
+      {
+         const wstring& expr = m.SearchTerm;
+         wstring literal;
+
+         // Text: Entire term
+         if (!m.UseRegEx)
+            return expr;
+
+         // Alternation: No single literal is required
+         if (expr.find(L'|') != wstring::npos)
+            return L"";
+
+         // RegEx: Extract literal characters preceding the first metacharacter
+         for (UINT i = 0; i < expr.length(); ++i)
+         {
+            wchar ch = expr[i];
+
+            // Anchor: Skip
+            if (i == 0 && ch == '^')
+               continue;
+
+            // Escape: Punctuation is literal, classes/assertions/back-references end the prefix
+            if (ch == '\\')
+            {
+               if (i+1 < expr.length() && !iswalnum(expr[i+1]))
+                  ch = expr[++i];
+               else
+                  break;
+            }
+            else if (wcschr(L".[](){}*+?^$", ch))
+               break;
+
+            // Optional: Character followed by '*', '?' or '{' may not be present
+            if (i+1 < expr.length() && wcschr(L"*?{", expr[i+1]))
+               break;
+
+            literal.push_back(ch);
+
+            // Repeated: Character followed by '+' is present, but ends the prefix
+            if (i+1 < expr.length() && expr[i+1] == '+')
+               break;
+         }
+
+         return literal;
+      }
+
+      /// <summary>Gets the size and modification time of a file</summary>
+      /// <param name="path">Full path</param>
+      /// <param name="stamp">On return, the stamp of the file</param>
+      /// <returns>True if the file exists, otherwise false</returns>
+      bool  SearchIndex::GetStamp(const Path& path, FileStamp& stamp)
+      {
+         WIN32_FILE_ATTRIBUTE_DATA attr;
+
+         if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attr))
+            return false;
+
+         stamp.Modified = (DWORD64)attr.ftLastWriteTime.dwHighDateTime << 32 | attr.ftLastWriteTime.dwLowDateTime;
+         stamp.Size = (DWORD64)attr.nFileSizeHigh << 32 | attr.nFileSizeLow;
+         return true;
+      }
+
+      /// <summary>Gets the distinct trigrams of text, folding ASCII letters to lower case</summary>
+      /// <param name="text">The text</param>
+      /// <param name="query">Whether text is a search term.  Searches fold non-ASCII characters too, so trigrams containing them are omitted</param>
+      /// <returns>Distinct trigrams in ascending order</returns>
+      SearchIndex::TrigramArray  SearchIndex::GetTrigrams(const wstring& text, bool query)
+      {
+         TrigramArray trigrams;
+         Trigram      t = 0;
+         UINT         ascii = 0;   // Number of consecutive ASCII characters
+
+         if (text.length() < 3)
+            return trigrams;
+
+         trigrams.reserve(text.length());
+         for (UINT i = 0; i < text.length(); ++i)
+         {
+            wchar ch = text[i];
+
+            // Fold case
+            if (ch >= 'A' && ch <= 'Z')
+               ch += 'a' - 'A';
+            ascii = (ch < 0x80 ? ascii + 1 : 0);
+
+            // Shift character into trigram
+            t = ((t << 16) | ch) & 0xFFFFFFFFFFFFULL;
+            if (i >= 2 && (!query || ascii >= 3))
+               trigrams.push_back(t);
+         }
+
+         // Remove duplicates
+         sort(trigrams.begin(), trigrams.end());
+         trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+         return trigrams;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Indexes the text of a script</summary>
+      /// <param name="path">Full path of script</param>
+      /// <param name="text">Text of script, translated by ScriptFileReader::ReadText with macros</param>
+      /// <remarks>The stamp of the file is read immediately, so the text must reflect its current contents</remarks>
+      void  SearchIndex::Add(const Path& path, const wstring& text)
+      {
+         FileStamp stamp;
+
+         if (GetStamp(path, stamp))
+            Insert(path, stamp, GetTrigrams(text, false));
+      }
+
+      /// <summary>Discards all documents</summary>
+      void  SearchIndex::Clear()
+      {
+         Lock.Enter();
+         Documents.clear();
+         Lookup.clear();
+         Postings.clear();
+         Removed = 0;
+         Lock.Leave();
+      }
+
+      /// <summary>Removes files that cannot match a search</summary>
+      /// <param name="files">Full paths of files to search. On return, files that cannot match are removed</param>
+      /// <param name="m">The search</param>
+      /// <returns>Number of files removed</returns>
+      /// <remarks>Files are only removed if they are indexed, unchanged since, and lack a trigram of the search literal</remarks>
+      UINT  SearchIndex::Filter(list<Path>& files, const MatchData& m) const
+      {
+         TrigramArray query = GetTrigrams(GetLiteral(m), true);
+         UINT         skipped = 0;
+
+         // Short/Unknown literal: Any file may match
+         if (query.empty())
+            return 0;
+
+         vector<pair<list<Path>::iterator,FileStamp>> excluded;
+
+         // Find indexed files that are not candidates, and the stamp of each when indexed
+         Lock.Enter();
+         PostingList candidates = FindCandidates(query);
+
+         for (auto f = files.begin(); f != files.end(); ++f)
+         {
+            auto doc = Lookup.find(*f);
+
+            if (doc != Lookup.end() && !binary_search(candidates.begin(), candidates.end(), doc->second))
+               excluded.push_back(make_pair(f, Documents[doc->second].Stamp));
+         }
+         Lock.Leave();
+
+         // Remove those unchanged since  [Stamps are read outside the lock, as they require disk access]
+         for (auto& e : excluded)
+         {
+            FileStamp stamp;
+
+            if (GetStamp(*e.first, stamp) && e.second == stamp)
+            {
+               files.erase(e.first);
+               ++skipped;
+            }
+         }
+
+         return skipped;
+      }
+
+      /// <summary>Gets the number of scripts indexed</summary>
+      /// <returns></returns>
+      UINT  SearchIndex::GetCount() const
+      {
+         Lock.Enter();
+         UINT count = Lookup.size();
+         Lock.Leave();
+
+         return count;
+      }
+
+      /// <summary>Gets the number of distinct trigrams</summary>
+      /// <returns></returns>
+      UINT  SearchIndex::GetTrigramCount() const
+      {
+         Lock.Enter();
+         UINT count = Postings.size();
+         Lock.Leave();
+
+         return count;
+      }
+
+      /// <summary>Discards the document for a file, if any</summary>
+      /// <param name="path">Full path of a file, need not be a script</param>
+      void  SearchIndex::Invalidate(const Path& path)
+      {
+         Lock.Enter();
+         Remove(path);
+         Lock.Leave();
+      }
+
+      /// <summary>Replaces the contents of the index with an index file</summary>
+      /// <param name="path">Full path of index file</param>
+      /// <returns>True if loaded, false if the file is missing, stale or corrupt.  The index is left empty on failure</returns>
+      bool  SearchIndex::Load(const Path& path)
+      {
+         DocumentArray docs;
+         DocumentMap   lookup;
+         PostingMap    postings;
+
+         // Missing: Skip
+         Clear();
+         if (!path.Exists())
+            return false;
+
+         Console << L"Reading search index: " << path << L"...";
+         try
+         {
+            MappedFile file(path);
+
+            // Validate header
+            if (file.Length < sizeof(Header))
+               throw FileFormatException(HERE, L"Search index is truncated");
+
+            const Header* header = reinterpret_cast<const Header*>(file.GetView(0, sizeof(Header)));
+            if (header->Magic != MAGIC || header->Format != FORMAT)
+               throw FileFormatException(HERE, L"Unrecognised search index format");
+
+            // Stale: Rebuild
+            if (header->Key != GetKey())
+            {
+               Console << Cons::Yellow << L"Stale" << ENDL;
+               return false;
+            }
+
+            // Validate body
+            if (header->Length != file.Length - sizeof(Header))
+               throw FileFormatException(HERE, L"Search index is truncated");
+
+            const BYTE* body = file.GetView(sizeof(Header), header->Length);
+            if (header->Checksum != crc32(0, body, header->Length))
+               throw FileFormatException(HERE, L"Search index checksum mismatch");
+
+            // Documents: Path, stamp
+            Reader r(body, header->Length);
+            for (DWORD i = 0, count = r.ReadDWord(); i < count; ++i)
+            {
+               Path      p = r.ReadString();
+               FileStamp s;
+               s.Modified = r.ReadQWord();
+               s.Size = r.ReadQWord();
+
+               lookup[p] = docs.size();
+               docs.push_back(Document(p, s));
+            }
+
+            // Postings: Trigram, document IDs
+            for (DWORD i = 0, count = r.ReadDWord(); i < count; ++i)
+            {
+               PostingList& list = postings[r.ReadQWord()];
+               list.resize(r.ReadDWord());
+
+               for (UINT& id : list)
+                  if ((id = r.ReadDWord()) >= docs.size())
+                     throw FileFormatException(HERE, L"Search index contains an invalid document ID");
+            }
+
+            // Replace contents
+            Lock.Enter();
+            Documents.swap(docs);
+            Lookup.swap(lookup);
+            Postings.swap(postings);
+            Removed = 0;
+            Lock.Leave();
+
+            Console << Cons::Success << ENDL;
+            return true;
+         }
+         catch (ExceptionBase& e) {
+            Console << Cons::Failure << e.Message << ENDL;
+            return false;
+         }
+      }
+
+      /// <summary>Writes the index to a file</summary>
+      /// <param name="path">Full path of index file</param>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      void  SearchIndex::Save(const Path& path) const
+      {
+         Writer  w;
+         Header  header;
+         Path    temp = path.RenameExtension(L".new");
+
+         Console << L"Writing search index: " << path << L"...";
+         try
+         {
+            Lock.Enter();
+            vector<UINT> ids(Documents.size(), UINT_MAX);
+
+            // Documents: Write live documents, numbering them consecutively
+            w.Write((DWORD)Lookup.size());
+            for (UINT i = 0, live = 0; i < Documents.size(); ++i)
+               if (!Documents[i].FullPath.Empty())
+               {
+                  ids[i] = live++;
+                  w.Write(Documents[i].FullPath.ToString());
+                  w.Write(Documents[i].Stamp.Modified);
+                  w.Write(Documents[i].Stamp.Size);
+               }
+
+            // Postings: Write live document IDs, omitting trigrams without any
+            vector<UINT> list;
+            DWORD        count = 0;
+            size_t       countPos = w.Buffer.size();
+            w.Write(count);
+            for (auto& p : Postings)
+            {
+               list.clear();
+               for (UINT id : p.second)
+                  if (ids[id] != UINT_MAX)
+                     list.push_back(ids[id]);
+
+               if (!list.empty())
+               {
+                  w.Write(p.first);
+                  w.Write((DWORD)list.size());
+                  w.Write(list.data(), list.size() * sizeof(UINT));
+                  ++count;
+               }
+            }
+            memcpy(&w.Buffer[countPos], &count, sizeof(count));
+            Lock.Leave();
+
+            // Generate header
+            header.Magic = MAGIC;
+            header.Format = FORMAT;
+            header.Key = GetKey();
+            header.Length = (DWORD)w.Buffer.size();
+            header.Checksum = crc32(0, w.Buffer.data(), w.Buffer.size());
+
+            // Write to temporary file, then replace existing index
+            FileStream fs(temp, FileMode::CreateAlways, FileAccess::Write);
+            fs.Write(reinterpret_cast<const BYTE*>(&header), sizeof(header));
+            fs.Write(w.Buffer.data(), w.Buffer.size());
+            fs.Close();
+
+            if (!MoveFileEx(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+               throw IOException(HERE, SysErrorString());
+
+            Console << Cons::Success << ENDL;
+         }
+         catch (ExceptionBase& e) {
+            Console << Cons::Failure << e.Message << ENDL;
+            DeleteFile(temp.c_str());
+            throw;
+         }
+      }
+
+      /// <summary>Indexes scripts that are new or have changed since they were indexed</summary>
+      /// <param name="files">Full paths of scripts</param>
+      /// <param name="threads">Maximum number of scripts to read concurrently. Zero to use one per processor</param>
+      /// <param name="data">Worker data used to abort indexing, may be null</param>
+      /// <returns>Number of scripts indexed</returns>
+      /// <remarks>Game data must be loaded.  Missing scripts are removed, unreadable scripts are skipped and remain unindexed</remarks>
+      UINT  SearchIndex::Update(const list<Path>& files, UINT threads, const WorkerData* data)
+      {
+         vector<pair<bool,FileStamp>> stamps(files.size());  // Whether script exists, and its stamp
+         list<Path>    stale;
+         volatile LONG count = 0;
+
+         // Stamp each script without holding the lock, so searches are not blocked by the I/O
+         auto s = stamps.begin();
+         for (const Path& f : files)
+         {
+            s->first = GetStamp(f, s->second);
+            ++s;
+         }
+
+         // Identify new, changed and missing scripts
+         Lock.Enter();
+         s = stamps.begin();
+         for (const Path& f : files)
+         {
+            auto doc = Lookup.find(f);
+
+            if (!s->first)
+               Remove(f);
+            else if (doc == Lookup.end() || !(Documents[doc->second].Stamp == s->second))
+               stale.push_back(f);
+            ++s;
+         }
+         Lock.Leave();
+
+         // Read and index each script on the pool
+         WorkerPool pool(threads);
+         for (const Path& f : stale)
+            pool.Add([this, &f, &count, data]
+            {
+               FileStamp stamp;
+
+               // Aborted: Skip remainder
+               if (data && data->IsAborted())
+                  return;
+
+               try
+               {
+                  ComThreadHelper COM;
+
+                  // Stamp before reading, so changes made while reading are detected later
+                  if (GetStamp(f, stamp))
+                  {
+                     auto script = ScriptFileReader(XFileInfo(f).OpenRead()).ReadText(f, true);
+                     Insert(f, stamp, GetTrigrams(script.GetAllText(), false));
+                     InterlockedIncrement(&count);
+                  }
+               }
+               catch (ExceptionBase&) {
+               }
+            });
+
+         pool.Run();
+         return count;
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Removes documents that have been removed from the posting lists, then numbers documents consecutively</summary>
+      /// <remarks>Lock must be held by the caller</remarks>
+      void  SearchIndex::Compact()
+      {
+         vector<UINT>  ids(Documents.size(), UINT_MAX);
+         DocumentArray live;
+
+         // Renumber live documents  [Preserves order, so posting lists remain sorted]
+         for (UINT i = 0; i < Documents.size(); ++i)
+            if (!Documents[i].FullPath.Empty())
+            {
+               ids[i] = live.size();
+               live.push_back(Documents[i]);
+            }
+
+         // Update posting lists, discarding empty lists
+         for (auto p = Postings.begin(); p != Postings.end(); )
+         {
+            UINT n = 0;
+            for (UINT id : p->second)
+               if (ids[id] != UINT_MAX)
+                  p->second[n++] = ids[id];
+            p->second.resize(n);
+
+            if (p->second.empty())
+               p = Postings.erase(p);
+            else
+               ++p;
+         }
+
+         // Update lookup
+         for (auto& doc : Lookup)
+            doc.second = ids[doc.second];
+
+         Documents.swap(live);
+         Removed = 0;
+      }
+
+      /// <summary>Finds the documents that contain every trigram of a search</summary>
+      /// <param name="query">Trigrams of search literal</param>
+      /// <returns>Document IDs in ascending order, including removed documents</returns>
+      /// <remarks>Lock must be held by the caller</remarks>
+      SearchIndex::PostingList  SearchIndex::FindCandidates(const TrigramArray& query) const
+      {
+         vector<const PostingList*> lists;
+
+         // Lookup posting lists. Missing: No document matches
+         for (Trigram t : query)
+         {
+            auto pos = Postings.find(t);
+            if (pos == Postings.end())
+               return PostingList();
+            lists.push_back(&pos->second);
+         }
+
+         // Intersect lists, starting with the shortest
+         sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+
+         PostingList candidates(*lists.front()), next;
+         for (UINT i = 1; i < lists.size() && !candidates.empty(); ++i)
+         {
+            next.clear();
+            set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), back_inserter(next));
+            candidates.swap(next);
+         }
+
+         return candidates;
+      }
+
+      /// <summary>Adds or replaces the document for a file</summary>
+      /// <param name="path">Full path</param>
+      /// <param name="stamp">Stamp of file when read</param>
+      /// <param name="trigrams">Distinct trigrams of file text</param>
+      void  SearchIndex::Insert(const Path& path, const FileStamp& stamp, const TrigramArray& trigrams)
+      {
+         Lock.Enter();
+
+         // Replace previous document, if any
+         Remove(path);
+
+         // Append document  [IDs ascend, so posting lists remain sorted]
+         UINT id = Documents.size();
+         Documents.push_back(Document(path, stamp));
+         Lookup[path] = id;
+
+         for (Trigram t : trigrams)
+            Postings[t].push_back(id);
+
+         // Compact once most documents have been removed
+         if (Removed > Lookup.size())
+            Compact();
+
+         Lock.Leave();
+      }
+
+      /// <summary>Removes the document for a file, if any</summary>
+      /// <param name="path">Full path</param>
+      /// <remarks>Lock must be held by the caller.  Posting lists are updated when compacted</remarks>
+      void  SearchIndex::Remove(const Path& path)
+      {
+         auto doc = Lookup.find(path);
+
+         if (doc != Lookup.end())
+         {
+            Documents[doc->second].FullPath = Path();
+            Lookup.erase(doc);
+            ++Removed;
+         }
+      }
+   }
+}
+
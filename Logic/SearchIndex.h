@@ -0,0 +1,146 @@
+#pragma once
+
+#include "MatchData.h"
+#include "CriticalSection.h"
+#include <unordered_map>
+
+namespace Logic
+{
+   namespace Threads
+   {
+      class WorkerData;
+   }
+
+   namespace IO
+   {
+      /// <summary>Persistent trigram index of the translated text of scripts, used to skip scripts that cannot match a search</summary>
+      /// <remarks>Text is folded to lower case and every distinct sequence of three characters is recorded against the scripts
+      /// containing it.  Entries are discarded once the size or modification time of the script changes, so scripts that are
+      /// missing or stale are always searched.  The index is thread-safe</remarks>
+      class LogicExport SearchIndex
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Three characters packed into 48 bits</summary>
+         typedef DWORD64  Trigram;
+
+         /// <summary>Distinct trigrams in ascending order</summary>
+         typedef vector<Trigram>  TrigramArray;
+
+         /// <summary>IDs of the documents containing a trigram, in ascending order</summary>
+         typedef vector<UINT>  PostingList;
+
+         /// <summary>Posting lists keyed by trigram</summary>
+         typedef unordered_map<Trigram, PostingList>  PostingMap;
+
+         /// <summary>Size and modification time of a file</summary>
+         class FileStamp
+         {
+         public:
+            FileStamp() : Modified(0), Size(0)
+            {}
+
+            bool operator==(const FileStamp& r) const  { return Modified == r.Modified && Size == r.Size; }
+
+            DWORD64  Modified,    // Last write time
+                     Size;        // Size in bytes
+         };
+
+         /// <summary>Indexed script</summary>
+         class Document
+         {
+         public:
+            Document(const Path& p, const FileStamp& s) : FullPath(p), Stamp(s)
+            {}
+
+            Path       FullPath;   // Full path, empty if removed
+            FileStamp  Stamp;      // Stamp of file when indexed
+         };
+
+         /// <summary>Documents keyed by ID</summary>
+         typedef vector<Document>  DocumentArray;
+
+         /// <summary>IDs of live documents keyed by full path  [Case insensitive]</summary>
+         typedef map<Path, UINT>  DocumentMap;
+
+         /// <summary>Index file header</summary>
+         class Header
+         {
+         public:
+            DWORD    Magic,      // Identifies index files
+                     Format;     // Index format version
+            DWORD64  Key;        // Key of settings affecting script text
+            DWORD    Length,     // Length of body, in bytes
+                     Checksum;   // CRC32 of body
+         };
+
+         class Reader;
+         class Writer;
+
+         // --------------------- CONSTRUCTION ----------------------
+      private:
+         SearchIndex();
+      public:
+         virtual ~SearchIndex();
+
+         NO_COPY(SearchIndex);	// Uncopyable
+         NO_MOVE(SearchIndex);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static const DWORD  MAGIC = 0x49535358,   // 'XSSI'
+                             FORMAT = 2;
+
+         static DWORD64  GetKey();
+         static wstring  GetLiteral(const MatchData& m);
+
+      private:
+         static bool          GetStamp(const Path& path, FileStamp& stamp);
+         static TrigramArray  GetTrigrams(const wstring& text, bool query);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+         PROPERTY_GET(UINT,Trigrams,GetTrigramCount);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         UINT  Filter(list<Path>& files, const MatchData& m) const;
+         UINT  GetCount() const;
+         UINT  GetTrigramCount() const;
+         void  Save(const Path& path) const;
+
+      private:
+         PostingList  FindCandidates(const TrigramArray& query) const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         void  Add(const Path& path, const wstring& text);
+         void  Clear();
+         void  Invalidate(const Path& path);
+         bool  Load(const Path& path);
+         UINT  Update(const list<Path>& files, UINT threads = 0, const WorkerData* data = nullptr);
+
+      private:
+         void  Compact();
+         void  Insert(const Path& path, const FileStamp& stamp, const TrigramArray& trigrams);
+         void  Remove(const Path& path);
+
+         // -------------------- REPRESENTATION ---------------------
+      public:
+         static SearchIndex  Instance;
+
+      private:
+         mutable CriticalSection  Lock;         // Guards all members below
+         DocumentArray            Documents;    // Documents keyed by ID
+         DocumentMap              Lookup;       // IDs of live documents keyed by path
+         PostingMap               Postings;     // Posting lists keyed by trigram
+         UINT                     Removed;      // Number of removed documents
+      };
+
+      // The search index singleton
+      #define SearchIndexLib  SearchIndex::Instance
+   }
+}
+
+using namespace Logic::IO;
@@ -0,0 +1,94 @@
+// SearchIndexWorker.cpp : implementation file
+//
+
+#include "stdafx.h"
+#include "SearchIndexWorker.h"
+#include "SearchIndex.h"
+#include "XFileSystem.h"
+#include "WorkerPool.h"
+#include "Stopwatch.h"
+
+namespace Logic
+{
+   namespace Threads
+   {
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      SearchIndexWorker::SearchIndexWorker() : BackgroundWorker((ThreadProc)ThreadMain)
+      {
+      }
+
+      SearchIndexWorker::~SearchIndexWorker()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Gets the full path of the search index file</summary>
+      /// <returns></returns>
+      Path  SearchIndexWorker::GetIndexPath()
+      {
+         return AppPath(L"SearchIndex.dat");
+      }
+
+      /// <summary>Indexes the scripts of the game that are new or have changed, then saves the index</summary>
+      /// <param name="data">arguments.</param>
+      /// <returns></returns>
+      DWORD WINAPI SearchIndexWorker::ThreadMain(SearchIndexWorkerData* data)
+      {
+         try
+         {
+            XFileSystem vfs;
+            list<Path>  files;
+            Stopwatch   sw;
+            HRESULT  hr;
+
+            // Init COM
+            if (FAILED(hr=CoInitialize(NULL)))
+               throw ComException(HERE, hr);
+
+            // Restore index saved by previous session
+            if (SearchIndexLib.Count == 0)
+               SearchIndexLib.Load(GetIndexPath());
+
+            // Enumerate XML/PCK scripts
+            vfs.Enumerate(data->GameFolder, data->Version);
+            for (auto& f : vfs.Browse(XFolder::Scripts))
+               if (f.FullPath.HasExtension(L".pck") || f.FullPath.HasExtension(L".xml"))
+                  files.push_back(f.FullPath);
+
+            // Index new/changed scripts  [Use half the processors, leaving the remainder to the user]
+            UINT count = SearchIndexLib.Update(files, max(1U, WorkerPool::GetProcessorCount() / 2), data);
+
+            // Save if changed
+            if (count && !data->IsAborted())
+            {
+               Console << Cons::Heading << VString(L"Indexed %d of %d scripts in %.0fms", count, files.size(), sw.ElapsedMilliseconds) << ENDL;
+               SearchIndexLib.Save(GetIndexPath());
+            }
+
+            // Cleanup
+            CoUninitialize();
+            return 0;
+         }
+         catch (ExceptionBase& e)
+         {
+            // Feedback
+            Console.Log(HERE, e, L"Unable to update search index");
+
+            // Cleanup
+            CoUninitialize();
+            return 0;
+         }
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+
+   }
+}
+
@@ -0,0 +1,96 @@
+#pragma once
+#include "BackgroundWorker.h"
+#include "PreferencesLibrary.h"
+
+namespace Logic
+{
+   namespace Threads
+   {
+
+      /// <summary>Worker thread for updating the search index in the background</summary>
+      class LogicExport SearchIndexWorker : public BackgroundWorker
+      {
+         // ------------------------ TYPES --------------------------
+      protected:
+         /// <summary>Data for search index worker thread</summary>
+         class LogicExport SearchIndexWorkerData : public WorkerData
+         {
+         public:
+            SearchIndexWorkerData() : WorkerData(Operation::NoFeedback), Version(GameVersion::Threat)
+            {}
+
+            /// <summary>Resets data + update values from preferences.</summary>
+            virtual void  Reset()
+            {
+               // Update values
+               GameFolder = PrefsLib.GameDataFolder;
+               Version = PrefsLib.GameDataVersion;
+
+               // Reset 'aborted' flag
+               __super::Reset();
+            }
+
+         public:
+            Path         GameFolder;
+            GameVersion  Version;
+         };
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+	      SearchIndexWorker();
+	      virtual ~SearchIndexWorker();
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static Path  GetIndexPath();
+
+      protected:
+         static DWORD WINAPI ThreadMain(SearchIndexWorkerData* data);
+
+         // --------------------- PROPERTIES ------------------------
+
+         // ---------------------- ACCESSORS ------------------------
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         /// <summary>Aborts indexing and waits for the thread to exit.</summary>
+         void  Cancel()
+         {
+            // Abort + Wait
+            Data.Abort();
+            Wait();
+
+            // Close handle
+            Close();
+         }
+
+         /// <summary>Indexes the scripts of the game that are new or have changed, using the current game data preferences.</summary>
+         /// <exception cref="Logic::InvalidOperationException">Thread already running</exception>
+         /// <exception cref="Logic::Win32Exception">Failed to start Thread</exception>
+         void  Start()
+         {
+            if (IsRunning())
+               throw InvalidOperationException(HERE, L"Thread already running");
+
+            // Close previous (if any)
+            Close();
+
+            // Update Game folder/version
+            Data.Reset();
+
+            // Start thread
+            __super::Start(&Data);
+         }
+
+         // -------------------- REPRESENTATION ---------------------
+      protected:
+	      SearchIndexWorkerData  Data;
+      };
+
+
+   }
+}
+
+using namespace Logic::Threads;
+
+
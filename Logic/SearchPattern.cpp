@@ -0,0 +1,1046 @@
+#include "stdafx.h"
+#include "SearchPattern.h"
+#include "StringResolver.h"      // RegEx exception
+#include "XorCipher.h"           // Instruction set detection
+#include <intrin.h>
+#include <emmintrin.h>
+
+namespace Logic
+{
+   namespace Utils
+   {
+      // -------------------------------- NESTED CLASSES ------------------------------
+
+      /// <summary>Compiles a regular expression into an automaton program</summary>
+      /// <remarks>Supports the subset of ECMAScript that an automaton can represent: characters, escapes, '.', classes,
+      /// anchors, word boundaries, groups, alternation and greedy/lazy quantifiers</remarks>
+      class SearchPattern::Compiler
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Syntax tree node types</summary>
+         enum class NodeType { Empty, Char, Any, Class, Assert, Concat, Alternate, Repeat };
+
+         /// <summary>Syntax tree node</summary>
+         class Node
+         {
+         public:
+            Node(NodeType t) : Type(t), Char(0), Index(0), Min(0), Max(0), Greedy(true)
+            {}
+
+            NodeType      Type;       // Node type
+            wchar         Char;       // Char: Character
+            UINT          Index,      // Class: Class index.  Assert: Assertion
+                          Min,        // Repeat: Minimum repetitions
+                          Max;        // Repeat: Maximum repetitions, or UNBOUNDED
+            bool          Greedy;     // Repeat: Whether to prefer more repetitions
+            vector<UINT>  Children;   // Concat/Alternate/Repeat: Child nodes
+         };
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         /// <summary>Creates a compiler</summary>
+         /// <param name="expr">The expression</param>
+         /// <param name="matchCase">Whether case sensitive</param>
+         /// <param name="matchWord">Whether matches must be whole words</param>
+         /// <param name="code">Program to generate</param>
+         /// <param name="classes">Character classes to generate</param>
+         Compiler(const wstring& expr, bool matchCase, bool matchWord, Program& code, vector<CharClass>& classes)
+            : Expression(expr), MatchCase(matchCase), MatchWord(matchWord), Code(code), Classes(classes), Position(0), Depth(0)
+         {}
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static const UINT  MAX_DEPTH = 256,             // Maximum nesting of groups
+                            MAX_INSTRUCTIONS = 32768,    // Maximum program length
+                            MAX_REPEAT = 1000,           // Maximum bounded repetition
+                            UNBOUNDED = UINT_MAX;        // Unbounded repetition
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         /// <summary>Compiles the expression</summary>
+         /// <param name="literal">On return, the characters matched if the expression contains no metacharacters, otherwise empty</param>
+         /// <remarks>No program is generated if the expression contains no metacharacters</remarks>
+         /// <exception cref="Logic::NotSupportedException">Expression requires back-references or look-ahead, or is too large</exception>
+         void  Compile(wstring& literal)
+         {
+            UINT root = ParseAlternation();
+
+            // Ensure all input consumed
+            if (Position < Expression.length())
+               throw NotSupportedException(HERE, L"Unbalanced parentheses");
+
+            // Literal: Search for characters
+            literal.clear();
+            if (IsLiteral(root, literal))
+               return;
+
+            // Automaton: [Word start] expression [Word end] match
+            literal.clear();
+            if (MatchWord)
+               EmitAssert(Assertion::WordStart);
+            Emit(root);
+            if (MatchWord)
+               EmitAssert(Assertion::WordEnd);
+            Push(Instruction(OpCode::Match));
+         }
+
+      private:
+         /// <summary>Determines whether the next character is a specific character, and consumes it if so</summary>
+         bool  Accept(wchar ch)
+         {
+            if (Position >= Expression.length() || Expression[Position] != ch)
+               return false;
+
+            ++Position;
+            return true;
+         }
+
+         /// <summary>Appends a node to the syntax tree</summary>
+         /// <returns>Node index</returns>
+         UINT  Add(const Node& n)
+         {
+            Nodes.push_back(n);
+            return Nodes.size()-1;
+         }
+
+         /// <summary>Appends a node representing a single class</summary>
+         /// <returns>Node index</returns>
+         UINT  AddClass(const CharClass& c)
+         {
+            Node n(NodeType::Class);
+            n.Index = Classes.size();
+            Classes.push_back(c);
+            return Add(n);
+         }
+
+         /// <summary>Consumes and decodes the character following a backslash</summary>
+         /// <param name="ch">Escaped character</param>
+         /// <returns></returns>
+         /// <exception cref="Logic::NotSupportedException">Back-reference or malformed escape</exception>
+         wchar  DecodeEscape(wchar ch)
+         {
+            switch (ch)
+            {
+            case 'n':  return '\n';
+            case 'r':  return '\r';
+            case 't':  return '\t';
+            case 'f':  return '\f';
+            case 'v':  return '\v';
+            case '0':  return '\0';
+            case 'x':  return ReadHex(2);
+            case 'u':  return ReadHex(4);
+
+            // Control: \cA .. \cZ
+            case 'c':
+               if (Position < Expression.length() && iswalpha(Expression[Position]))
+                  return Expression[Position++] % 32;
+               throw NotSupportedException(HERE, L"Malformed control escape");
+            }
+
+            // Back-reference
+            if (ch >= '1' && ch <= '9')
+               throw NotSupportedException(HERE, L"Back-references are not supported");
+
+            // Identity escape
+            return ch;
+         }
+
+         /// <summary>Appends an assertion</summary>
+         void  EmitAssert(Assertion a)
+         {
+            Instruction in(OpCode::Assert);
+            in.Condition = a;
+            Push(in);
+         }
+
+         /// <summary>Generates the program for a node</summary>
+         /// <param name="node">Node index</param>
+         /// <exception cref="Logic::NotSupportedException">Program too large</exception>
+         void  Emit(UINT node)
+         {
+            const Node& n = Nodes[node];
+
+            switch (n.Type)
+            {
+            case NodeType::Empty:
+               break;
+
+            // Char: Fold if case insensitive
+            case NodeType::Char:
+               {
+                  Instruction in(OpCode::Char);
+                  in.Char = MatchCase ? n.Char : Fold(n.Char);
+                  Push(in);
+               }
+               break;
+
+            case NodeType::Any:
+               Push(Instruction(OpCode::Any));
+               break;
+
+            case NodeType::Class:
+               Push(Instruction(OpCode::Class, n.Index));
+               break;
+
+            case NodeType::Assert:
+               EmitAssert((Assertion)n.Index);
+               break;
+
+            case NodeType::Concat:
+               for (UINT child : n.Children)
+                  Emit(child);
+               break;
+
+            // Alternate: Split to each alternative in order of preference, then jump to the end
+            case NodeType::Alternate:
+               {
+                  vector<UINT> jumps;
+
+                  for (UINT i = 0; i < n.Children.size(); ++i)
+                  {
+                     bool last = (i+1 == n.Children.size());
+                     UINT split = Code.size();
+
+                     if (!last)
+                        Push(Instruction(OpCode::Split, split+1));
+                     Emit(n.Children[i]);
+                     if (!last)
+                     {
+                        jumps.push_back(Code.size());
+                        Push(Instruction(OpCode::Jump));
+                        Code[split].Alternate = Code.size();
+                     }
+                  }
+
+                  for (UINT j : jumps)
+                     Code[j].Target = Code.size();
+               }
+               break;
+
+            // Repeat: Required copies, then a loop or optional copies
+            case NodeType::Repeat:
+               {
+                  for (UINT i = 0; i < n.Min; ++i)
+                     Emit(n.Children[0]);
+
+                  if (n.Max == UNBOUNDED)
+                  {
+                     UINT loop = Code.size();
+                     Push(Instruction(OpCode::Split));
+                     Emit(n.Children[0]);
+                     Push(Instruction(OpCode::Jump, loop));
+                     SetSplit(loop, Code.size(), n.Greedy);
+                  }
+                  else
+                  {
+                     vector<UINT> splits;
+                     for (UINT i = n.Min; i < n.Max; ++i)
+                     {
+                        splits.push_back(Code.size());
+                        Push(Instruction(OpCode::Split));
+                        Emit(n.Children[0]);
+                     }
+
+                     for (UINT s : splits)
+                        SetSplit(s, Code.size(), n.Greedy);
+                  }
+               }
+               break;
+            }
+         }
+
+         /// <summary>Determines whether a node matches only a fixed sequence of characters</summary>
+         /// <param name="node">Node index</param>
+         /// <param name="literal">On return, the sequence is appended</param>
+         /// <returns></returns>
+         bool  IsLiteral(UINT node, wstring& literal) const
+         {
+            const Node& n = Nodes[node];
+
+            switch (n.Type)
+            {
+            case NodeType::Empty:
+               return true;
+
+            case NodeType::Char:
+               literal.push_back(n.Char);
+               return true;
+
+            case NodeType::Concat:
+               for (UINT child : n.Children)
+                  if (!IsLiteral(child, literal))
+                     return false;
+               return true;
+            }
+
+            return false;
+         }
+
+         /// <summary>Parses alternatives separated by '|'</summary>
+         /// <returns>Node index</returns>
+         /// <exception cref="Logic::NotSupportedException">Unsupported expression</exception>
+         UINT  ParseAlternation()
+         {
+            if (++Depth > MAX_DEPTH)
+               throw NotSupportedException(HERE, L"Expression is nested too deeply");
+
+            UINT first = ParseSequence();
+
+            // Alternatives: Gather all
+            if (Accept('|'))
+            {
+               UINT alt = Add(Node(NodeType::Alternate));
+               Nodes[alt].Children.push_back(first);
+               do
+               {
+                  UINT next = ParseSequence();
+                  Nodes[alt].Children.push_back(next);
+               }
+               while (Accept('|'));
+               first = alt;
+            }
+
+            --Depth;
+            return first;
+         }
+
+         /// <summary>Parses a single character, class, assertion or group</summary>
+         /// <returns>Node index</returns>
+         /// <exception cref="Logic::NotSupportedException">Unsupported expression</exception>
+         UINT  ParseAtom()
+         {
+            Node  n(NodeType::Char);
+            wchar ch = Expression[Position++];
+
+            switch (ch)
+            {
+            case '.':
+               return Add(Node(NodeType::Any));
+
+            case '^':
+            case '$':
+               n.Type = NodeType::Assert;
+               n.Index = (UINT)(ch == '^' ? Assertion::LineStart : Assertion::LineEnd);
+               return Add(n);
+
+            case '[':
+               return ParseClass();
+
+            case '\\':
+               return ParseEscape();
+
+            // Group: Capturing or non-capturing '(?:'
+            case '(':
+               {
+                  if (Accept('?') && !Accept(':'))
+                     throw NotSupportedException(HERE, L"Look-ahead assertions are not supported");
+
+                  UINT inner = ParseAlternation();
+                  if (!Accept(')'))
+                     throw NotSupportedException(HERE, L"Unbalanced parentheses");
+                  return inner;
+               }
+
+            // Quantifier without operand
+            case '*':
+            case '+':
+            case '?':
+               throw NotSupportedException(HERE, L"Quantifier does not follow an expression");
+            }
+
+            // Literal
+            n.Char = ch;
+            return Add(n);
+         }
+
+         /// <summary>Parses a character class, following the opening '['</summary>
+         /// <returns>Node index</returns>
+         /// <exception cref="Logic::NotSupportedException">Unsupported expression</exception>
+         UINT  ParseClass()
+         {
+            CharClass c;
+            c.Negated = Accept('^');
+
+            while (!Accept(']'))
+            {
+               wchar lo, hi;
+
+               // Lower bound or class escape
+               if (!ReadClassChar(c, lo))
+                  continue;
+
+               // Range: Exclude trailing '-'
+               hi = lo;
+               if (Position+1 < Expression.length() && Expression[Position] == '-' && Expression[Position+1] != ']')
+               {
+                  ++Position;
+                  if (!ReadClassChar(c, hi) || hi < lo)
+                     throw NotSupportedException(HERE, L"Malformed class range");
+               }
+
+               c.Ranges.push_back(make_pair(lo, hi));
+            }
+
+            return AddClass(c);
+         }
+
+         /// <summary>Parses an escape sequence, following the backslash</summary>
+         /// <returns>Node index</returns>
+         /// <exception cref="Logic::NotSupportedException">Unsupported expression</exception>
+         UINT  ParseEscape()
+         {
+            CharClass c;
+            Node      n(NodeType::Assert);
+
+            if (Position >= Expression.length())
+               throw NotSupportedException(HERE, L"Trailing backslash");
+
+            switch (wchar ch = Expression[Position++])
+            {
+            // Word boundaries
+            case 'b':  n.Index = (UINT)Assertion::WordBoundary;     return Add(n);
+            case 'B':  n.Index = (UINT)Assertion::NotWordBoundary;  return Add(n);
+
+            // Class escapes
+            case 'd':  c.Digit = true;      return AddClass(c);
+            case 'D':  c.NonDigit = true;   return AddClass(c);
+            case 's':  c.Space = true;      return AddClass(c);
+            case 'S':  c.NonSpace = true;   return AddClass(c);
+            case 'w':  c.Word = true;       return AddClass(c);
+            case 'W':  c.NonWord = true;    return AddClass(c);
+
+            // Character escapes
+            default:
+               n.Type = NodeType::Char;
+               n.Char = DecodeEscape(ch);
+               return Add(n);
+            }
+         }
+
+         /// <summary>Parses a quantifier, if any</summary>
+         /// <param name="min">On return, minimum repetitions</param>
+         /// <param name="max">On return, maximum repetitions or UNBOUNDED</param>
+         /// <returns>True if a quantifier was consumed.  Malformed braces are not consumed, and are later parsed as characters</returns>
+         /// <exception cref="Logic::NotSupportedException">Repetition too large</exception>
+         bool  ParseQuantifier(UINT& min, UINT& max)
+         {
+            if (Accept('*'))
+               min = 0, max = UNBOUNDED;
+            else if (Accept('+'))
+               min = 1, max = UNBOUNDED;
+            else if (Accept('?'))
+               min = 0, max = 1;
+            else if (Position < Expression.length() && Expression[Position] == '{')
+            {
+               UINT start = Position++;
+
+               // Parse {n}, {n,} or {n,m}
+               bool valid = ReadNumber(min);
+               max = min;
+               if (valid && Accept(','))
+                  max = ReadNumber(max) ? max : UNBOUNDED;
+
+               // Malformed: Restore position
+               if (!valid || !Accept('}'))
+               {
+                  Position = start;
+                  return false;
+               }
+
+               if (min > MAX_REPEAT || (max != UNBOUNDED && (max > MAX_REPEAT || max < min)))
+                  throw NotSupportedException(HERE, L"Repetition count is too large");
+            }
+            else
+               return false;
+
+            return true;
+         }
+
+         /// <summary>Parses a sequence of quantified atoms</summary>
+         /// <returns>Node index</returns>
+         /// <exception cref="Logic::NotSupportedException">Unsupported expression</exception>
+         UINT  ParseSequence()
+         {
+            UINT seq = Add(Node(NodeType::Concat));
+
+            while (Position < Expression.length() && Expression[Position] != '|' && Expression[Position] != ')')
+            {
+               UINT term = ParseTerm();
+               Nodes[seq].Children.push_back(term);
+            }
+
+            // Single term: Omit sequence
+            return Nodes[seq].Children.size() == 1 ? Nodes[seq].Children[0] : seq;
+         }
+
+         /// <summary>Parses an atom and its quantifier, if any</summary>
+         /// <returns>Node index</returns>
+         /// <exception cref="Logic::NotSupportedException">Unsupported expression</exception>
+         UINT  ParseTerm()
+         {
+            UINT atom = ParseAtom(), min, max;
+
+            if (!ParseQuantifier(min, max))
+               return atom;
+
+            Node rep(NodeType::Repeat);
+            rep.Min = min;
+            rep.Max = max;
+            rep.Greedy = !Accept('?');
+            rep.Children.push_back(atom);
+            return Add(rep);
+         }
+
+         /// <summary>Appends an instruction</summary>
+         /// <exception cref="Logic::NotSupportedException">Program too large</exception>
+         void  Push(const Instruction& in)
+         {
+            if (Code.size() >= MAX_INSTRUCTIONS)
+               throw NotSupportedException(HERE, L"Expression is too large");
+
+            Code.push_back(in);
+         }
+
+         /// <summary>Reads a character within a class, adding class escapes such as \d to the class</summary>
+         /// <param name="c">The class</param>
+         /// <param name="ch">On return, the character</param>
+         /// <returns>True if a character was read, false if a class escape was added</returns>
+         /// <exception cref="Logic::NotSupportedException">Unterminated class</exception>
+         bool  ReadClassChar(CharClass& c, wchar& ch)
+         {
+            if (Position >= Expression.length())
+               throw NotSupportedException(HERE, L"Unterminated class");
+
+            // Literal
+            if ((ch = Expression[Position++]) != '\\')
+               return true;
+
+            if (Position >= Expression.length())
+               throw NotSupportedException(HERE, L"Unterminated class");
+
+            switch (ch = Expression[Position++])
+            {
+            // Class escape: Add to class
+            case 'd':  c.Digit = true;     return false;
+            case 'D':  c.NonDigit = true;  return false;
+            case 's':  c.Space = true;     return false;
+            case 'S':  c.NonSpace = true;  return false;
+            case 'w':  c.Word = true;      return false;
+            case 'W':  c.NonWord = true;   return false;
+
+            // Backspace
+            case 'b':  ch = '\b';          return true;
+            }
+
+            ch = DecodeEscape(ch);
+            return true;
+         }
+
+         /// <summary>Reads a fixed number of hexadecimal digits</summary>
+         /// <exception cref="Logic::NotSupportedException">Malformed escape</exception>
+         wchar  ReadHex(UINT digits)
+         {
+            UINT value = 0;
+
+            for (UINT i = 0; i < digits; ++i, ++Position)
+               if (Position >= Expression.length() || !iswxdigit(Expression[Position]))
+                  throw NotSupportedException(HERE, L"Malformed hexadecimal escape");
+               else
+                  value = value * 16 + (iswdigit(Expression[Position]) ? Expression[Position] - '0' : (towlower(Expression[Position]) - 'a' + 10));
+
+            return (wchar)value;
+         }
+
+         /// <summary>Reads a decimal number, if any</summary>
+         /// <returns>True if at least one digit was read</returns>
+         bool  ReadNumber(UINT& value)
+         {
+            UINT start = Position;
+
+            // Saturate beyond maximum repetition
+            for (value = 0; Position < Expression.length() && iswdigit(Expression[Position]); ++Position)
+               value = (value > MAX_REPEAT ? value : value * 10 + (Expression[Position] - '0'));
+
+            return Position > start;
+         }
+
+         /// <summary>Sets the branches of a split preceding a repeated expression</summary>
+         /// <param name="split">Index of split</param>
+         /// <param name="exit">Instruction following repetition</param>
+         /// <param name="greedy">Whether to prefer repeating</param>
+         void  SetSplit(UINT split, UINT exit, bool greedy)
+         {
+            Code[split].Target    = greedy ? split+1 : exit;
+            Code[split].Alternate = greedy ? exit : split+1;
+         }
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         const wstring&      Expression;   // Expression being compiled
+         const bool          MatchCase,    // Whether case sensitive
+                             MatchWord;    // Whether matches must be whole words
+         Program&            Code;         // Generated program
+         vector<CharClass>&  Classes;      // Generated classes
+         vector<Node>        Nodes;        // Syntax tree
+         UINT                Position,     // Parse position
+                             Depth;        // Group nesting
+      };
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates an empty pattern, which matches nothing</summary>
+      SearchPattern::SearchPattern() : Type(PatternEngine::Literal), MatchCase(false), MatchWord(false), Anchored(false)
+      {
+      }
+
+      /// <summary>Compiles a search term or regular expression</summary>
+      /// <param name="pattern">Search term or ECMAScript regular expression</param>
+      /// <param name="regEx">Whether pattern is a regular expression</param>
+      /// <param name="matchCase">Whether case sensitive</param>
+      /// <param name="matchWord">Whether matches must be whole words</param>
+      /// <exception cref="Logic::Language::RegularExpressionException">Error in expression</exception>
+      SearchPattern::SearchPattern(const wstring& pattern, bool regEx, bool matchCase, bool matchWord)
+         : Type(PatternEngine::Literal), MatchCase(matchCase), MatchWord(matchWord), Anchored(false)
+      {
+         // Text: Search for term
+         if (!regEx)
+            Literal = pattern;
+         else
+         {
+            try
+            {
+               // RegEx: Generate automaton, unless expression contains no metacharacters
+               Compiler(pattern, matchCase, matchWord, Code, Classes).Compile(Literal);
+
+               if (!Code.empty())
+                  Type = PatternEngine::Automaton;
+            }
+            catch (NotSupportedException&)
+            {
+               // Unsupported/Malformed: Use library
+               Code.clear();
+               Classes.clear();
+               Literal.clear();
+               Type = PatternEngine::Library;
+
+               try {
+                  auto flags = (matchCase ? regex_constants::ECMAScript : regex_constants::ECMAScript | regex_constants::icase);
+
+                  // Validate expression before translating it
+                  RegEx = wregex(pattern, flags);
+                  RegEx = wregex(TranslateExpression(pattern, matchWord, Anchored), flags);
+               }
+               catch (regex_error& e) {
+                  throw RegularExpressionException(HERE, e);
+               }
+            }
+         }
+
+         // Case insensitive: Fold term
+         if (!MatchCase)
+            transform(Literal.begin(), Literal.end(), Literal.begin(), Fold);
+      }
+
+      SearchPattern::~SearchPattern()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Folds a character to lower case</summary>
+      /// <param name="ch">The character</param>
+      /// <returns></returns>
+      wchar  SearchPattern::Fold(wchar ch)
+      {
+         if (ch < 0x80)
+            return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+
+         return towlower(ch);
+      }
+
+      /// <summary>Determines whether a character terminates a line</summary>
+      /// <param name="ch">The character</param>
+      /// <returns></returns>
+      bool  SearchPattern::IsLineTerminator(wchar ch)
+      {
+         return ch == '\n' || ch == '\r' || ch == 0x2028 || ch == 0x2029;
+      }
+
+      /// <summary>Determines whether a character is part of a word</summary>
+      /// <param name="ch">The character</param>
+      /// <returns>True if alpha-numeric or underscore</returns>
+      bool  SearchPattern::IsWordChar(wchar ch)
+      {
+         if (ch < 0x80)
+            return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+
+         return iswalnum(ch) != 0;
+      }
+
+      /// <summary>Translates an expression for std::wregex, so that '$' matches at the end of each line, and whole-word matches end at a word boundary</summary>
+      /// <param name="expr">The expression</param>
+      /// <param name="matchWord">Whether matches must be whole words</param>
+      /// <param name="anchored">On return, whether the expression contains '^'</param>
+      /// <returns></returns>
+      wstring  SearchPattern::TranslateExpression(const wstring& expr, bool matchWord, bool& anchored)
+      {
+         wstring out;
+         bool    inClass = false;
+
+         anchored = false;
+         for (UINT i = 0; i < expr.length(); ++i)
+         {
+            wchar ch = expr[i];
+
+            // Escape: Copy verbatim
+            if (ch == '\\' && i+1 < expr.length())
+            {
+               out.push_back(ch);
+               out.push_back(expr[++i]);
+               continue;
+            }
+
+            // '$': Match before any line terminator
+            if (inClass)
+               inClass = (ch != ']');
+            else if (ch == '[')
+               inClass = true;
+            else if (ch == '^')
+               anchored = true;
+            else if (ch == '$')
+            {
+               out += L"(?=[\r\n\x2028\x2029]|$)";
+               continue;
+            }
+
+            out.push_back(ch);
+         }
+
+         // Whole words: Reject matches followed by a word character, so the matcher backtracks to a less preferred match
+         return matchWord ? L"(?:" + out + L")(?!\\w)" : out;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Determines whether a character is a member of the class</summary>
+      /// <param name="ch">The character</param>
+      /// <param name="matchCase">Whether case sensitive</param>
+      /// <returns></returns>
+      bool  SearchPattern::CharClass::Contains(wchar ch, bool matchCase) const
+      {
+         bool member = Includes(ch) || (!matchCase && (Includes(Fold(ch)) || Includes((wchar)towupper(ch))));
+
+         return member != Negated;
+      }
+
+      /// <summary>Finds the next match</summary>
+      /// <param name="text">Text to search</param>
+      /// <param name="start">Position to search from</param>
+      /// <param name="pos">On return, position of match</param>
+      /// <param name="length">On return, length of match</param>
+      /// <returns>True if found, otherwise false</returns>
+      bool  SearchPattern::Find(const wstring& text, UINT start, UINT& pos, UINT& length) const
+      {
+         switch (Type)
+         {
+         // Literal: Scan for term, skipping partial words  [Equivalent to the leftmost whole-word match, having a single length]
+         case PatternEngine::Literal:
+            if (Literal.empty())
+               return false;
+
+            for (UINT from = start; FindLiteral(text, from, pos); from = pos+1)
+               if (!MatchWord || IsWholeWord(text, pos, Literal.length()))
+               {
+                  length = Literal.length();
+                  return true;
+               }
+            return false;
+
+         case PatternEngine::Automaton:
+            return FindAutomaton(text, start, pos, length);
+
+         default:
+            return FindLibrary(text, start, pos, length);
+         }
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+      // ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Adds a thread to a list, following jumps, splits and assertions in order of preference</summary>
+      /// <param name="list">Thread list</param>
+      /// <param name="visited">Position at which each instruction was last added to a list</param>
+      /// <param name="stack">Working stack, must be empty</param>
+      /// <param name="pc">Instruction</param>
+      /// <param name="start">Start position of thread</param>
+      /// <param name="text">Text being searched</param>
+      /// <param name="position">Current position</param>
+      void  SearchPattern::AddThread(ThreadList& list, vector<UINT>& visited, vector<UINT>& stack, UINT pc, UINT start, const wstring& text, UINT position) const
+      {
+         stack.push_back(pc);
+
+         while (!stack.empty())
+         {
+            pc = stack.back();
+            stack.pop_back();
+
+            // Skip instructions already reached at this position by a preferred thread
+            if (visited[pc] == position)
+               continue;
+            visited[pc] = position;
+
+            const Instruction& in = Code[pc];
+            switch (in.Op)
+            {
+            case OpCode::Jump:
+               stack.push_back(in.Target);
+               break;
+
+            // Split: Explore preferred branch first
+            case OpCode::Split:
+               stack.push_back(in.Alternate);
+               stack.push_back(in.Target);
+               break;
+
+            case OpCode::Assert:
+               if (IsAsserted(in.Condition, text, position))
+                  stack.push_back(pc+1);
+               break;
+
+            // Char/Any/Class/Match: Wait for next character
+            default:
+               list.push_back(Thread(pc, start));
+               break;
+            }
+         }
+      }
+
+      /// <summary>Finds the next match by simulating the automaton</summary>
+      /// <param name="text">Text to search</param>
+      /// <param name="start">Position to search from</param>
+      /// <param name="pos">On return, position of match</param>
+      /// <param name="length">On return, length of match</param>
+      /// <returns>True if found, otherwise false</returns>
+      /// <remarks>Threads are kept in order of preference, so the match found is the one a backtracking matcher would find</remarks>
+      bool  SearchPattern::FindAutomaton(const wstring& text, UINT start, UINT& pos, UINT& length) const
+      {
+         ThreadList   current, next;
+         vector<UINT> visited(Code.size(), UINT_MAX), stack;
+         bool         matched = false;
+
+         current.reserve(Code.size());
+         next.reserve(Code.size());
+
+         for (UINT i = start; i <= text.length(); ++i)
+         {
+            // Start a thread at each position until matched  [Least preferred]
+            if (!matched)
+               AddThread(current, visited, stack, 0, i, text, i);
+            else if (current.empty())
+               break;
+
+            // Advance each thread by one character
+            for (UINT t = 0; t < current.size(); ++t)
+            {
+               const Instruction& in = Code[current[t].PC];
+               bool consume = false;
+
+               switch (in.Op)
+               {
+               // Match: Discard less preferred threads
+               case OpCode::Match:
+                  pos = current[t].Start;
+                  length = i - pos;
+                  matched = true;
+                  t = current.size();
+                  continue;
+
+               case OpCode::Char:
+                  consume = i < text.length() && (MatchCase ? text[i] : Fold(text[i])) == in.Char;
+                  break;
+
+               case OpCode::Any:
+                  consume = i < text.length() && !IsLineTerminator(text[i]);
+                  break;
+
+               case OpCode::Class:
+                  consume = i < text.length() && Classes[in.Target].Contains(text[i], MatchCase);
+                  break;
+               }
+
+               if (consume)
+                  AddThread(next, visited, stack, current[t].PC+1, current[t].Start, text, i+1);
+            }
+
+            current.swap(next);
+            next.clear();
+         }
+
+         return matched;
+      }
+
+      /// <summary>Finds the next match using std::wregex</summary>
+      /// <param name="text">Text to search</param>
+      /// <param name="start">Position to search from</param>
+      /// <param name="pos">On return, position of match</param>
+      /// <param name="length">On return, length of match</param>
+      /// <returns>True if found, otherwise false</returns>
+      /// <remarks>std::wregex matches '^' only where the search begins, so expressions containing '^' are matched at each position in turn</remarks>
+      bool  SearchPattern::FindLibrary(const wstring& text, UINT start, UINT& pos, UINT& length) const
+      {
+         wsmatch matches;
+
+         for (UINT from = start; from <= text.length(); from = pos+1)
+         {
+            if (Anchored)
+            {
+               // Anchored: Match at this position only, beginning the search here if it starts a line
+               pos = from;
+               auto flags = regex_constants::match_continuous | (IsAsserted(Assertion::LineStart, text, pos) ? regex_constants::match_default 
+                                                                                                                : regex_constants::match_prev_avail | regex_constants::match_not_bol);
+               if (MatchWord && !IsAsserted(Assertion::WordStart, text, pos))
+                  continue;
+               if (!regex_search(text.cbegin()+pos, text.cend(), matches, RegEx, flags))
+                  continue;
+            }
+            else
+            {
+               auto flags = (from > 0 ? regex_constants::match_prev_avail : regex_constants::match_default);
+
+               if (!regex_search(text.cbegin()+from, text.cend(), matches, RegEx, flags))
+                  return false;
+
+               // Skip matches beginning within a word  [Word end is enforced by the expression]
+               pos = matches[0].first - text.cbegin();
+               if (MatchWord && !IsAsserted(Assertion::WordStart, text, pos))
+                  continue;
+            }
+
+            length = matches[0].length();
+            return true;
+         }
+
+         return false;
+      }
+
+      /// <summary>Finds the next occurrence of the literal, ignoring word boundaries</summary>
+      /// <param name="text">Text to search</param>
+      /// <param name="start">Position to search from</param>
+      /// <param name="pos">On return, position of literal</param>
+      /// <returns>True if found, otherwise false</returns>
+      /// <remarks>Candidates are located by comparing eight characters at a time with both cases of the first character</remarks>
+      bool  SearchPattern::FindLiteral(const wstring& text, UINT start, UINT& pos) const
+      {
+         const wchar* txt = text.c_str();
+         const UINT   len = text.length(),
+                      n = Literal.length();
+
+         // Ensure space for literal
+         if (n > len || start > len - n)
+            return false;
+
+         const UINT  last = len - n;    // Last candidate position
+         const wchar first = Literal[0],
+                     other = MatchCase ? first : (wchar)towupper(first);
+         UINT i = start;
+
+         // SSE2: Compare 8 candidates per step
+         if (XorCipher::Available != XorCipher::InstructionSet::Scalar)
+         {
+            const __m128i a = _mm_set1_epi16((short)first),
+                          b = _mm_set1_epi16((short)other);
+
+            for (; i + 8 <= last + 1; i += 8)
+            {
+               __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(txt + i));
+               DWORD   mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(chunk, a), _mm_cmpeq_epi16(chunk, b))),
+                       bit;
+
+               // Verify each candidate, two mask bits per character
+               while (_BitScanForward(&bit, mask))
+               {
+                  if (IsLiteralAt(txt + i + bit/2))
+                  {
+                     pos = i + bit/2;
+                     return true;
+                  }
+                  mask &= ~(3UL << bit);
+               }
+            }
+         }
+
+         // Scalar: Compare remaining candidates
+         for (; i <= last; ++i)
+            if ((txt[i] == first || txt[i] == other) && IsLiteralAt(txt + i))
+            {
+               pos = i;
+               return true;
+            }
+
+         return false;
+      }
+
+      /// <summary>Determines whether an assertion holds at a position</summary>
+      /// <param name="a">The assertion</param>
+      /// <param name="text">Text being searched</param>
+      /// <param name="position">The position</param>
+      /// <returns></returns>
+      bool  SearchPattern::IsAsserted(Assertion a, const wstring& text, UINT position) const
+      {
+         bool before = position > 0 && IsWordChar(text[position-1]),
+              after = position < text.length() && IsWordChar(text[position]);
+
+         switch (a)
+         {
+         case Assertion::LineStart:        return position == 0 || IsLineTerminator(text[position-1]);
+         case Assertion::LineEnd:          return position == text.length() || IsLineTerminator(text[position]);
+         case Assertion::WordBoundary:     return before != after;
+         case Assertion::NotWordBoundary:  return before == after;
+         case Assertion::WordStart:        return !before;
+         case Assertion::WordEnd:          return !after;
+         }
+
+         return false;
+      }
+
+      /// <summary>Determines whether the character is included by the ranges or class escapes, ignoring negation</summary>
+      /// <param name="ch">The character</param>
+      /// <returns></returns>
+      bool  SearchPattern::CharClass::Includes(wchar ch) const
+      {
+         for (auto& r : Ranges)
+            if (ch >= r.first && ch <= r.second)
+               return true;
+
+         return (Digit && iswdigit(ch)) || (NonDigit && !iswdigit(ch))
+             || (Space && iswspace(ch)) || (NonSpace && !iswspace(ch))
+             || (Word && IsWordChar(ch)) || (NonWord && !IsWordChar(ch));
+      }
+
+      /// <summary>Determines whether the literal occurs at a position</summary>
+      /// <param name="text">Position within text, followed by at least as many characters as the literal</param>
+      /// <returns></returns>
+      bool  SearchPattern::IsLiteralAt(const wchar* text) const
+      {
+         for (UINT i = 0; i < Literal.length(); ++i)
+            if ((MatchCase ? text[i] : Fold(text[i])) != Literal[i])
+               return false;
+
+         return true;
+      }
+
+      /// <summary>Determines whether a match is a whole word</summary>
+      /// <param name="text">Text being searched</param>
+      /// <param name="pos">Position of match</param>
+      /// <param name="length">Length of match</param>
+      /// <returns>True if the match is neither preceded nor followed by a word character</returns>
+      bool  SearchPattern::IsWholeWord(const wstring& text, UINT pos, UINT length) const
+      {
+         return (pos == 0 || !IsWordChar(text[pos-1]))
+             && (pos+length >= text.length() || !IsWordChar(text[pos+length]));
+      }
+   }
+}
+
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <regex>
+
+namespace Logic
+{
+   namespace Utils
+   {
+      /// <summary>Search term or regular expression compiled for repeated searches of script text</summary>
+      /// <remarks>Terms, and expressions without metacharacters, are found by a vectorised scan for their first character.
+      /// Other expressions are compiled into an automaton that is simulated one character at a time, tracking every viable
+      /// thread at once, so a search runs in time proportional to the length of the text.  Expressions that require back-references
+      /// or look-ahead cannot be represented by an automaton and are matched using std::wregex instead.
+      /// 
+      /// Every engine finds the same match: '^' and '$' match at the start and end of each line, and whole-word matches are the
+      /// leftmost, most preferred match that begins and ends at a word boundary, eg. 'a|ab' matches all of 'ab'.  std::wregex
+      /// cannot match '^' following a line break consumed by the same match</remarks>
+      class LogicExport SearchPattern
+      {
+         // ------------------------ TYPES --------------------------
+      public:
+         /// <summary>Defines how a pattern is matched</summary>
+         enum class PatternEngine { Literal, Automaton, Library };
+
+      private:
+         /// <summary>Automaton instructions</summary>
+         enum class OpCode : BYTE
+         {
+            Char,       // Consume a character equal to 'Char'
+            Any,        // Consume any character except a line terminator
+            Class,      // Consume a character within the set 'Target'
+            Assert,     // Assert 'Condition' holds at current position
+            Jump,       // Continue at 'Target'
+            Split,      // Continue at 'Target', then at 'Alternate' with lower priority
+            Match       // Match found
+         };
+
+         /// <summary>Zero-width assertions</summary>
+         enum class Assertion : BYTE { LineStart, LineEnd, WordBoundary, NotWordBoundary, WordStart, WordEnd };
+
+         /// <summary>Character class, eg. [a-z\d]</summary>
+         class CharClass
+         {
+         public:
+            CharClass() : Negated(false), Digit(false), NonDigit(false), Space(false), NonSpace(false), Word(false), NonWord(false)
+            {}
+
+            bool  Contains(wchar ch, bool matchCase) const;
+
+            vector<pair<wchar,wchar>>  Ranges;     // Inclusive character ranges
+            bool  Negated,                         // Whether class is negated
+                  Digit, NonDigit,                 // Whether class includes \d, \D
+                  Space, NonSpace,                 // Whether class includes \s, \S
+                  Word, NonWord;                   // Whether class includes \w, \W
+
+         private:
+            bool  Includes(wchar ch) const;
+         };
+
+         /// <summary>Automaton instruction</summary>
+         class Instruction
+         {
+         public:
+            Instruction(OpCode op, UINT target = 0, UINT alt = 0) : Op(op), Char(0), Condition(Assertion::LineStart), Target(target), Alternate(alt)
+            {}
+
+            OpCode     Op;          // Operation
+            wchar      Char;        // Char: Character, folded if case insensitive
+            Assertion  Condition;   // Assert: Assertion
+            UINT       Target,      // Class: Class index. Jump/Split: Preferred instruction
+                       Alternate;   // Split: Alternative instruction
+         };
+
+         /// <summary>Thread of the automaton</summary>
+         class Thread
+         {
+         public:
+            Thread(UINT pc, UINT start) : PC(pc), Start(start)
+            {}
+
+            UINT  PC,       // Instruction
+                  Start;    // Position of first character matched
+         };
+
+         /// <summary>Automaton program</summary>
+         typedef vector<Instruction>  Program;
+
+         /// <summary>Automaton threads, in descending order of priority</summary>
+         typedef vector<Thread>  ThreadList;
+
+         class Compiler;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         SearchPattern();
+         SearchPattern(const wstring& pattern, bool regEx, bool matchCase, bool matchWord);
+         virtual ~SearchPattern();
+
+         DEFAULT_COPY(SearchPattern);	// Default copy semantics
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static wchar  Fold(wchar ch);
+         static bool   IsWordChar(wchar ch);
+
+      private:
+         static bool     IsLineTerminator(wchar ch);
+         static wstring  TranslateExpression(const wstring& expr, bool matchWord, bool& anchored);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(PatternEngine,Engine,GetEngine);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         /// <summary>Gets how the pattern is matched</summary>
+         PatternEngine  GetEngine() const   { return Type; }
+
+         bool  Find(const wstring& text, UINT start, UINT& pos, UINT& length) const;
+
+      private:
+         bool  FindAutomaton(const wstring& text, UINT start, UINT& pos, UINT& length) const;
+         bool  FindLibrary(const wstring& text, UINT start, UINT& pos, UINT& length) const;
+         bool  FindLiteral(const wstring& text, UINT start, UINT& pos) const;
+         void  AddThread(ThreadList& list, vector<UINT>& visited, vector<UINT>& stack, UINT pc, UINT start, const wstring& text, UINT position) const;
+         bool  IsAsserted(Assertion a, const wstring& text, UINT position) const;
+         bool  IsLiteralAt(const wchar* text) const;
+         bool  IsWholeWord(const wstring& text, UINT pos, UINT length) const;
+
+         // ----------------------- MUTATORS ------------------------
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         PatternEngine      Type;          // How pattern is matched
+         bool               MatchCase,     // Whether case sensitive
+                            MatchWord;     // Whether matches must be whole words
+         wstring            Literal;       // Literal: Search term, folded if case insensitive
+         Program            Code;          // Automaton: Instructions
+         vector<CharClass>  Classes;       // Automaton: Character classes
+         wregex             RegEx;         // Library: Expression
+         bool               Anchored;      // Library: Whether expression contains '^'
+      };
+
+   }
+}
+
+using namespace Logic::Utils;
@@ -4,6 +4,9 @@
 #include "XFileInfo.h"
 #include "ScriptFileReader.h"
 #include "PreferencesLibrary.h"
+#include "ComThreadHelper.h"
+#include "WorkerPool.h"
+#include "SearchIndex.h"
 
 namespace Logic
 {
@@ -74,11 +77,52 @@ namespace Logic
          data->Initialized = true;
       }
 
+      /// <summary>Searches the remaining files on the calling thread, reading them concurrently</summary>
+      /// <param name="data">The data.</param>
+      /// <param name="threads">Maximum number of files to search concurrently. Zero to use one per processor</param>
+      /// <returns>Find/Replace: True if a match was found, files following the match remain.  FindAll/ReplaceAll: False</returns>
+      /// <exception cref="Logic::ArgumentNullException">data is null</exception>
+      /// <exception cref="Logic::InvalidOperationException">Target not project or script folder</exception>
+      bool  SearchWorker::Search(SearchWorkerData* data, UINT threads)
+      {
+         REQUIRED(data);
+
+         // FirstCall: Assemble list of files to search
+         if (!data->Initialized)
+         {
+            data->Match.Clear();
+            BuildFileList(data);
+
+            // Index: Skip indexed scripts lacking the search literal
+            if (PrefsLib.UseSearchIndex)
+               if (UINT skipped = SearchIndexLib.Filter(data->Files, data->Match))
+                  Console << "Search index excluded " << skipped << " files" << ENDL;
+         }
+
+         // Feedback
+         Console << Cons::Heading << "Searching remaining " << data->Files.size() << " files..." << ENDL;
+
+         switch (data->Command)
+         {
+         // Find/Replace: Return match for display
+         case SearchCommand::Find:
+         case SearchCommand::Replace:
+            return FindNext(data, threads);
+
+         // FindAll/ReplaceAll: Feedback [+Replace]
+         default:
+            FindAll(data, threads);
+            return false;
+         }
+      }
+
       /// <summary>Finds either the next matching file, or all matches in all files.</summary>
       /// <param name="data">The data.</param>
       /// <returns></returns>
       DWORD WINAPI  SearchWorker::ThreadMain(SearchWorkerData* data)
       {
+         bool matched = false;
+
          try
          {
             HRESULT  hr;
@@ -87,71 +131,8 @@ namespace Logic
             if (FAILED(hr=CoInitialize(NULL)))
                throw ComException(HERE, hr);
 
-            // FirstCall: Assemble list of files to search
-            if (!data->Initialized)
-            {
-               data->Match.Clear();
-               BuildFileList(data);
-            }
-
-            // Feedback
-            Console << Cons::Heading << "Searching remaining " << data->Files.size() << " files..." << ENDL;
-
-            // Search thru remaining files for a match
-            while (!data->Files.empty() && !data->IsAborted())
-            {
-               // Get next file
-               Path CurrentFile = data->Files.front();
-               data->Files.pop_front();
-
-               try
-               {
-                  // Feedback
-                  Console << L"Searching script: " << CurrentFile << ENDL;
-
-                  // Read script
-                  XFileInfo f(CurrentFile);
-                  ScriptFile script = ScriptFileReader(f.OpenRead()).ReadFile(CurrentFile, false);
-             
-                  // Search contents
-                  data->Match.SetPath(CurrentFile);
-                  switch (data->Command)
-                  {
-                  // Find/Replace: Return match for display
-                  case SearchCommand::Find:
-                  case SearchCommand::Replace:
-                     // Search from beginning of file
-                     if (script.FindNext(0, data->Match))
-                     {
-                        data->Match.ClearLocation();   // Clear location because document co-ordinates are different
-                        return 0;
-                     }
-                     break;
-
-                  // FindAll/ReplaceAll: Feedback [+Replace]
-                  case SearchCommand::FindAll:
-                  case SearchCommand::ReplaceAll:
-                     // Search thru all matches
-                     for (UINT start = 0; script.FindNext(start, data->Match); start = data->Match.End)
-                     {
-                        // Replace match
-                        if (data->Command == SearchCommand::ReplaceAll)
-                           script.Replace(data->Match);
-
-                        // Feedback
-                        data->FeedbackMatch();
-                     }
-                     break;
-                  }
-               }
-               catch (ExceptionBase& e)
-               {
-                  // Error: Feedback
-                  VString msg(L"Cannot read '%s' : %s", CurrentFile.c_str(), e.Message.c_str());
-                  data->FeedbackError(msg);
-                  Console.Log(HERE, e, msg);
-               }
-            }
+            // Search remaining files
+            matched = Search(data);
          }
          catch (ExceptionBase& e) {
             // Feedback
@@ -161,7 +142,8 @@ namespace Logic
          }
 
          // Complete: No more matches
-         data->Match.Clear();
+         if (!matched)
+            data->Match.Clear();
          CoUninitialize();
          return 0;
       }
@@ -171,7 +153,175 @@ namespace Logic
       // ------------------------------ PROTECTED METHODS -----------------------------
 
       // ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Searches all remaining files concurrently, feeding back matches in the order of the files</summary>
+      /// <param name="data">The data.</param>
+      /// <param name="threads">Maximum number of files to search concurrently. Zero to use one per processor</param>
+      void  SearchWorker::FindAll(SearchWorkerData* data, UINT threads)
+      {
+         const MatchData     query(data->Match);
+         const SearchCommand cmd = data->Command;
+         FileResultArray     results;
+         CriticalSection     lock;
+         UINT                next = 0;
+
+         // Consume all remaining files
+         results.reserve(data->Files.size());
+         for (auto& f : data->Files)
+            results.push_back(FileResult(f));
+         data->Files.clear();
+
+         // Search each file on the pool
+         WorkerPool pool(threads);
+         for (UINT i = 0; i < results.size(); ++i)
+            pool.Add([&, i]
+            {
+               // Search file, unless cancelled
+               if (!data->IsAborted())
+                  SearchFile(query, cmd, results[i]);
+
+               // Feedback every consecutive completed file, so matches stream in order
+               lock.Enter();
+               results[i].Complete = true;
+               for (; next < results.size() && results[next].Complete; ++next)
+               {
+                  if (!data->IsAborted())
+                     ReportResult(data, results[next]);
+                  results[next].Matches.clear();
+               }
+               lock.Leave();
+            });
+
+         pool.Run();
+      }
+
+      /// <summary>Searches the remaining files concurrently, a batch at a time, for the first match</summary>
+      /// <param name="data">The data.</param>
+      /// <param name="threads">Maximum number of files to search concurrently. Zero to use one per processor</param>
+      /// <returns>True if found, in which case files following the matching file remain to be searched</returns>
+      bool  SearchWorker::FindNext(SearchWorkerData* data, UINT threads)
+      {
+         const MatchData     query(data->Match);
+         const SearchCommand cmd = data->Command;
+
+         while (!data->Files.empty() && !data->IsAborted())
+         {
+            WorkerPool      pool(threads);
+            FileResultArray results;
+
+            // Take a batch of one file per thread
+            while (results.size() < pool.Threads && !data->Files.empty())
+            {
+               results.push_back(FileResult(data->Files.front()));
+               data->Files.pop_front();
+            }
+
+            // Search batch concurrently
+            for (auto& r : results)
+               pool.Add([&]
+               {
+                  if (!data->IsAborted())
+                     SearchFile(query, cmd, r);
+               });
+            pool.Run();
+
+            // Report files in order, stopping at the first match
+            for (UINT i = 0; i < results.size() && !data->IsAborted(); ++i)
+            {
+               auto& r = results[i];
+
+               // No match: Feedback errors
+               if (r.Matches.empty())
+               {
+                  ReportResult(data, r);
+                  continue;
+               }
+
+               // Match: Return first match in file
+               Console << L"Searching script: " << r.FullPath << ENDL;
+               data->Match.SetPath(r.FullPath);
+               data->Match.SetMatch(r.Matches.front().Start, r.Matches.front().Length, r.Matches.front().LineNumber, r.Matches.front().LineText);
+               data->Match.ClearLocation();   // Clear location because document co-ordinates are different
+
+               // Return unreported files to the list, to be searched by the next call
+               for (UINT j = results.size()-1; j > i; --j)
+                  data->Files.push_front(results[j].FullPath);
+               return true;
+            }
+         }
+
+         // No more matches
+         return false;
+      }
+
+      /// <summary>Feeds back the errors and matches of a searched file.</summary>
+      /// <param name="data">The data.</param>
+      /// <param name="r">The result.</param>
+      void  SearchWorker::ReportResult(SearchWorkerData* data, const FileResult& r)
+      {
+         // Feedback
+         Console << L"Searching script: " << r.FullPath << ENDL;
+
+         // Error: Feedback
+         if (!r.Error.empty())
+            data->FeedbackError(r.Error);
+
+         // Feedback each match
+         for (auto& m : r.Matches)
+         {
+            data->Match.SetPath(r.FullPath);
+            data->Match.SetMatch(m.Start, m.Length, m.LineNumber, m.LineText);
+            data->FeedbackMatch();
+         }
+      }
+
+      /// <summary>Reads a script and searches its contents.  Called concurrently from the worker pool.</summary>
+      /// <param name="query">The search term and options.</param>
+      /// <param name="cmd">Find/Replace: Find the first match only.  FindAll/ReplaceAll: Find [and replace] all matches</param>
+      /// <param name="r">The file to search. On return, the matches or the error</param>
+      void  SearchWorker::SearchFile(const MatchData& query, SearchCommand cmd, FileResult& r)
+      {
+         try
+         {
+            ComThreadHelper COM;
+            MatchData       m(query);
+
+            // Read script text
+            XFileInfo f(r.FullPath);
+            ScriptFile script = ScriptFileReader(f.OpenRead()).ReadText(r.FullPath, true);
+             
+            // Search contents
+            switch (cmd)
+            {
+            // Find/Replace: Search from beginning of file
+            case SearchCommand::Find:
+            case SearchCommand::Replace:
+               if (script.FindNext(0, m))
+                  r.Matches.push_back(FileMatch(m));
+               break;
+
+            // FindAll/ReplaceAll: Search thru all matches
+            case SearchCommand::FindAll:
+            case SearchCommand::ReplaceAll:
+               // Advance beyond empty matches, eg. 'a*'
+               for (UINT start = 0; script.FindNext(start, m); start = (m.Length ? m.End : m.End+1))
+               {
+                  // Replace match
+                  if (cmd == SearchCommand::ReplaceAll)
+                     script.Replace(m);
+
+                  r.Matches.push_back(FileMatch(m));
+               }
+               break;
+            }
+         }
+         catch (ExceptionBase& e)
+         {
+            // Error: Log now, feedback once reported
+            r.Error = VString(L"Cannot read '%s' : %s", r.FullPath.c_str(), e.Message.c_str());
+            Console.Log(HERE, e, r.Error);
+         }
+      }
    
    }
 }
-
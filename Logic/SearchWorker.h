@@ -40,6 +40,7 @@ namespace Logic
               Project(proj),
               Target(targ), 
               Match(search), 
+              Matches(0),
               Initialized(false),
               Command(SearchCommand::Find)
          {
@@ -48,6 +49,22 @@ namespace Logic
                REQUIRED(proj);
          }
 
+         /// <summary>Initializes a new instance of the <see cref="SearchWorkerData"/> class for an explicit set of files.</summary>
+         /// <param name="op">operation.</param>
+         /// <param name="files">Full paths of the scripts to search, in order.</param>
+         /// <param name="search">search term.</param>
+         SearchWorkerData(Threads::Operation op, const list<Path>& files, const MatchData& search)
+            : WorkerData(op), 
+              Project(nullptr),
+              Target(search.Target), 
+              Match(search), 
+              Matches(0),
+              Initialized(true),
+              Files(files),
+              Command(SearchCommand::Find)
+         {
+         }
+
          virtual ~SearchWorkerData()
          {}
 
@@ -76,6 +93,7 @@ namespace Logic
          /// <summary>Feedbacks the match.</summary>
          void  FeedbackMatch()
          {
+            ++Matches;
             SendFeedback(ProgressType::Info, 1, VString(L"%s (%d) : %s", Match.FullPath.FileName.c_str(), 
                                                                            Match.LineNumber, 
                                                                            Match.LineText.c_str()));
@@ -92,6 +110,7 @@ namespace Logic
          // -------------------- REPRESENTATION ---------------------
       public:
          MatchData      Match;
+         UINT           Matches;    // Number of matches fed back
          SearchTarget   Target;
          SearchCommand  Command;
          
@@ -102,10 +121,39 @@ namespace Logic
       };
 
       /// <summary>Worker thread for performing Find&Replace on script files that are not currently open as documents</summary>
+      /// <remarks>Files are read and searched concurrently on a worker pool, but are reported strictly in order</remarks>
       class LogicExport SearchWorker : public BackgroundWorker
       {
          // ------------------------ TYPES --------------------------
       private:
+         /// <summary>Location of a match within a file</summary>
+         class FileMatch
+         {
+         public:
+            FileMatch(const MatchData& m) : Start(m.Start), Length(m.Length), LineNumber(m.LineNumber), LineText(m.LineText)
+            {}
+
+            long     Start;        // Character index of match
+            UINT     Length,       // Length of match
+                     LineNumber;   // 1-based line number
+            wstring  LineText;     // Text of line containing match, after any replacement
+         };
+
+         /// <summary>Outcome of searching a file</summary>
+         class FileResult
+         {
+         public:
+            FileResult(const Path& p) : FullPath(p), Complete(false)
+            {}
+
+            Path               FullPath;   // Full path of file
+            vector<FileMatch>  Matches;    // Matches in order of position
+            wstring            Error;      // Error message, if file could not be read
+            bool               Complete;   // Whether file has been searched
+         };
+
+         /// <summary>Results in the order files are searched</summary>
+         typedef vector<FileResult>  FileResultArray;
 
          // --------------------- CONSTRUCTION ----------------------
       public:
@@ -116,10 +164,19 @@ namespace Logic
          DEFAULT_MOVE(SearchWorker);	// Default move semantics
 
          // ------------------------ STATIC -------------------------
+      public:
+         static bool  Search(SearchWorkerData* data, UINT threads = 0);
+
       protected:
          static void  BuildFileList(SearchWorkerData* data);
          static DWORD WINAPI ThreadMain(SearchWorkerData* data);
 
+      private:
+         static void  FindAll(SearchWorkerData* data, UINT threads);
+         static bool  FindNext(SearchWorkerData* data, UINT threads);
+         static void  ReportResult(SearchWorkerData* data, const FileResult& r);
+         static void  SearchFile(const MatchData& query, SearchCommand cmd, FileResult& r);
+
          // --------------------- PROPERTIES ------------------------
       
          // ---------------------- ACCESSORS ------------------------			
@@ -0,0 +1,113 @@
+#pragma once
+
+namespace Logic
+{
+   namespace Utils
+   {
+
+      /// <summary>High resolution timer for measuring elapsed time</summary>
+      class Stopwatch
+      {
+         // ------------------------ TYPES --------------------------
+      protected:
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         /// <summary>Creates a stopwatch, optionally starting it immediately</summary>
+         /// <param name="start">Whether to start timing immediately</param>
+         Stopwatch(bool start = true) : Elapsed(0), Running(false)
+         {
+            QueryPerformanceFrequency(&Frequency);
+            if (start)
+               Start();
+         }
+
+         DEFAULT_COPY(Stopwatch);	// Default copy semantics
+		   DEFAULT_MOVE(Stopwatch);	// Default move semantics
+
+         // ------------------------ STATIC -------------------------
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(double,ElapsedMilliseconds,GetElapsedMilliseconds);
+         PROPERTY_GET(double,ElapsedSeconds,GetElapsedSeconds);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         /// <summary>Gets the total elapsed time, in milliseconds</summary>
+         double GetElapsedMilliseconds() const
+         {
+            return GetElapsedSeconds() * 1000.0;
+         }
+
+         /// <summary>Gets the total elapsed time, in seconds</summary>
+         double GetElapsedSeconds() const
+         {
+            LONGLONG ticks = Elapsed;
+
+            // Include current interval if running
+            if (Running)
+            {
+               LARGE_INTEGER now;
+               QueryPerformanceCounter(&now);
+               ticks += now.QuadPart - Origin.QuadPart;
+            }
+
+            return (double)ticks / (double)Frequency.QuadPart;
+         }
+
+         /// <summary>Query whether stopwatch is running</summary>
+         bool IsRunning() const
+         {
+            return Running;
+         }
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         /// <summary>Resets the elapsed time and stops the stopwatch</summary>
+         void Reset()
+         {
+            Elapsed = 0;
+            Running = false;
+         }
+
+         /// <summary>Resets the elapsed time and starts the stopwatch</summary>
+         void Restart()
+         {
+            Reset();
+            Start();
+         }
+
+         /// <summary>Starts or resumes timing</summary>
+         void Start()
+         {
+            if (!Running)
+            {
+               QueryPerformanceCounter(&Origin);
+               Running = true;
+            }
+         }
+
+         /// <summary>Pauses timing, preserving the elapsed time</summary>
+         void Stop()
+         {
+            if (Running)
+            {
+               LARGE_INTEGER now;
+               QueryPerformanceCounter(&now);
+               Elapsed += now.QuadPart - Origin.QuadPart;
+               Running = false;
+            }
+         }
+
+         // -------------------- REPRESENTATION ---------------------
+      protected:
+         LARGE_INTEGER  Frequency,     // Counter frequency
+                        Origin;        // Counter value when last started
+         LONGLONG       Elapsed;       // Accumulated ticks
+         bool           Running;       // Whether currently timing
+      };
+
+   }
+}
+
+using namespace Logic::Utils;
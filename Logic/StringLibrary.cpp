@@ -1,8 +1,10 @@
 #include "stdafx.h"
 #include "StringLibrary.h"
 #include "LanguageFileReader.h"
+#include "LanguageStreamReader.h"
 #include "StringResolver.h"
 #include "PreferencesLibrary.h"
+#include "WorkerPool.h"
 
 namespace Logic
 {
@@ -29,10 +31,14 @@ namespace Logic
       /// <param name="vfs">The VFS to search</param>
       /// <param name="lang">The language of strings to search for</param>
       /// <param name="data">Background worker data</param>
+      /// <param name="threads">Maximum number of files to parse concurrently. Zero to use one per processor, one to parse serially</param>
       /// <returns>Number of files found</returns>
-      UINT  StringLibrary::Enumerate(XFileSystem& vfs, GameLanguage lang, WorkerData* data)
+      UINT  StringLibrary::Enumerate(XFileSystem& vfs, GameLanguage lang, WorkerData* data, UINT threads)
       {
-         list<XFileInfo> results;
+         typedef unique_ptr<LanguageFile>  LanguageFilePtr;
+
+         vector<XFileInfo> results;
+         WorkerPool        pool(threads);
 
          // Clear previous contents
          Clear();
@@ -41,7 +47,7 @@ namespace Logic
          data->SendFeedback(Cons::Heading, ProgressType::Operation, 1, VString(L"Enumerating %s language files", GetString(lang).c_str()));
 
          // Enumerate non-foreign language files
-         for (XFileInfo& f : vfs.Browse(XFolder::Language))
+         for (const XFileInfo& f : vfs.Browse(XFolder::Language))
          {
             LanguageFilenameReader fn(f.FullPath.FileName);
 
@@ -50,19 +56,40 @@ namespace Logic
                results.push_back(f);
          }
 
-         // Read/Store each file
-         for (XFileInfo& f : results)
+         // Parse each file concurrently  [Errors are reported in file order below]
+         vector<LanguageFilePtr> parsed(results.size());
+         vector<exception_ptr>   errors(results.size());
+         
+         for (UINT i = 0; i < results.size(); ++i)
+            pool.Add([&, i] 
+            {
+               try
+               {
+                  const XFileInfo& f = results[i];
+                  parsed[i].reset(new LanguageFile(LanguageStreamReader(f.OpenRead()).ReadFile(f.FullPath)));
+               }
+               catch (ExceptionBase&) {
+                  errors[i] = current_exception();
+               }
+            });
+         pool.Run();
+
+         // Store each file
+         for (UINT i = 0; i < results.size(); ++i)
          {
+            const XFileInfo& f = results[i];
             try
             {
                // Feedback
                data->SendFeedback(ProgressType::Info, 2, VString(L"Reading language file '%s'...", f.FullPath.c_str()));
                Console << L"Reading language file: " << f.FullPath << L"...";
 
-               // Parse language file
-               LanguageFile file = LanguageFileReader(f.OpenRead()).ReadFile(f.FullPath);
+               // Parse failed: Re-throw
+               if (errors[i])
+                  rethrow_exception(errors[i]);
 
                // check language tag matches filename
+               LanguageFile& file = *parsed[i];
                if (file.Language == lang)
                {
                   Files.insert(move(file));
@@ -83,12 +110,16 @@ namespace Logic
             }
          }
 
+         // Merge strings
+         UpdateLookup();
          return Files.size();
       }
 
       /// <summary>Clears the library of all files/strings</summary>
       void  StringLibrary::Clear()
       {
+         Resolved.clear();
+         Lookup.Clear();
          Files.clear();
       }
 
@@ -98,37 +129,29 @@ namespace Logic
       /// <returns></returns>
       bool  StringLibrary::Contains(UINT page, UINT id) const
       {
-         // Search files in descending file ID
-         for (const LanguageFile& f : Files)
-            if (f.Contains(page, id))
-               return true;
-
-         // Not found
-         return false;
+         return Lookup.Find(page, id) != nullptr;
       }
 
       /// <summary>Finds the specified string</summary>
       /// <param name="page">The page id</param>
       /// <param name="id">The string id</param>
       /// <returns></returns>
-      /// <exception cref="Logic::PageNotFoundException">Page does not exist</exception>
       /// <exception cref="Logic::StringNotFoundException">String does not exist</exception>
       const LanguageString&  StringLibrary::Find(UINT page, UINT id) const
       {
-         // Search files in descending file ID
-         for (const LanguageFile& f : Files)
-            if (f.Contains(page, id))
-               return f.Find(page, id);
+         const LanguageString* str = Lookup.Find(page, id);
 
          // Not found
-         throw StringNotFoundException(HERE, page, id);
+         if (!str)
+            throw StringNotFoundException(HERE, page, id);
+
+         return *str;
       }
 
       /// <summary>Finds a string, resolves the substrings and removes the comments</summary>
       /// <param name="page">The page id</param>
       /// <param name="id">The string id</param>
       /// <returns>Resolved text</returns>
-      /// <exception cref="Logic::PageNotFoundException">Page does not exist</exception>
       /// <exception cref="Logic::StringNotFoundException">String does not exist</exception>
       wstring  StringLibrary::Resolve(UINT page, UINT id) const
       {
@@ -142,23 +165,59 @@ namespace Logic
       /// <returns>true if found, false otherwise</returns>
       bool  StringLibrary::TryFind(UINT page, UINT id, const LanguageString* &str) const
       {
-         str = nullptr;
+         return (str = Lookup.Find(page, id)) != nullptr;
+      }
 
-         // Search files in descending file ID
+      /// <summary>Rebuilds the lookup table following changes to the files.</summary>
+      void  StringLibrary::UpdateLookup()
+      {
+         UINT count = 0;
+
+         // Size table for all strings
          for (const LanguageFile& f : Files)
-            if (f.Contains(page, id))
-            {
-               str = &f.Find(page, id);
-               return true;
-            }
+            for (const LanguagePage& p : f)
+               count += p.Strings.size();
 
-         // Not found
-         return false;
+         Resolved.clear();
+         Lookup.Clear();
+         Lookup.Reserve(count);
+
+         // Add strings in descending file ID  [First occurrence has highest precedence]
+         for (const LanguageFile& f : Files)
+            for (const LanguagePage& p : f)
+               for (const LanguageString& s : p)
+                  Lookup.Add(s);
       }
 
 		// ------------------------------ PROTECTED METHODS -----------------------------
 
 		// ------------------------------- PRIVATE METHODS ------------------------------
 
+      /// <summary>Finds the memoized resolved text of a library string</summary>
+      /// <param name="str">The library string</param>
+      /// <param name="txt">On return, the resolved text if found</param>
+      /// <returns>True if found, otherwise false</returns>
+      bool  StringLibrary::FindResolved(const LanguageString& str, wstring& txt) const
+      {
+         ResolvedLock.Enter();
+         auto pos = Resolved.find(&str);
+         bool found = pos != Resolved.end();
+         if (found)
+            txt = pos->second;
+         ResolvedLock.Leave();
+
+         return found;
+      }
+
+      /// <summary>Memoizes the resolved text of a library string</summary>
+      /// <param name="str">The library string</param>
+      /// <param name="txt">The resolved text</param>
+      void  StringLibrary::StoreResolved(const LanguageString& str, const wstring& txt) const
+      {
+         ResolvedLock.Enter();
+         Resolved[&str] = txt;
+         ResolvedLock.Leave();
+      }
+
    }
 }
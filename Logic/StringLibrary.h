@@ -1,9 +1,12 @@
 #pragma once
 
 #include "LanguageFile.h"
+#include "StringTable.h"
+#include "CriticalSection.h"
 #include "XFileSystem.h"
 #include "BackgroundWorker.h"
 #include <algorithm>
+#include <unordered_map>
 
 namespace Logic
 {
@@ -13,6 +16,8 @@ namespace Logic
       /// <summary></summary>
       class LogicExport StringLibrary
       {
+         friend class StringResolver;
+
       public:
          /// <summary>Collection of language files, sorted with highest priority first</summary>
          class FileCollection : public set<LanguageFile, greater<LanguageFile>>
@@ -39,17 +44,28 @@ namespace Logic
          wstring           Resolve(UINT page, UINT id) const;
          bool              TryFind(UINT page, UINT id, const LanguageString* &str) const;
 
+      private:
+         bool  FindResolved(const LanguageString& str, wstring& txt) const;
+         void  StoreResolved(const LanguageString& str, const wstring& txt) const;
+
 		   // ----------------------- MUTATORS ------------------------
 
       public:
          void  Clear();
-         UINT  Enumerate(XFileSystem& vfs, GameLanguage lang, WorkerData* data);
+         UINT  Enumerate(XFileSystem& vfs, GameLanguage lang, WorkerData* data, UINT threads = 0);
+         void  UpdateLookup();
 
 		   // -------------------- REPRESENTATION ---------------------
       public:
          static StringLibrary  Instance;
 
          FileCollection  Files;
+
+      private:
+         StringTable     Lookup;     // Highest precedence string of each page/ID
+
+         mutable CriticalSection                                 ResolvedLock;   // Guards resolved text
+         mutable unordered_map<const LanguageString*, wstring>  Resolved;       // Memoized resolved text of library strings
       };
 
       // The string library singleton
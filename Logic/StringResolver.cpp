@@ -2,42 +2,50 @@
 #include "StringResolver.h"
 #include "LanguagePage.h"
 #include "StringLibrary.h"
-#include <initializer_list>
 
 //#define PRINT_CONSOLE
 
-// Define reg.ex characters that are difficult to understand using C-style escape codes
-#define open_bracket   L"\\("
-#define close_bracket  L"\\)"
-#define backslash      L"\\\\"
-
 namespace Logic
 {
    namespace Language
    {
-      const wchar* expr = L"(?!" backslash L")" open_bracket 
-                          L"[^" open_bracket close_bracket backslash L"]+" 
-                          L"(?!" backslash close_bracket L")" close_bracket;
-
-      const wregex StringResolver::FullMarker(L"\\{(\\d+),(\\d+)\\}");
-      const wregex StringResolver::DefaultMarker(L"\\{(\\d+)\\}");
-      const wregex StringResolver::RemoveComment(expr);
-
       // -------------------------------- CONSTRUCTION --------------------------------
 
       /// <summary>Create a parser for a language string</summary>
       /// <param name="str">The string.</param>
-      StringResolver::StringResolver(const LanguageString& str) : Text(str.Text), Page(str.Page)
+      StringResolver::StringResolver(const LanguageString& str) : Text(str.Text), Page(str.Page), Cyclic(false)
       {
+         const LanguageString* lib;
+
 #ifdef PRINT_CONSOLE
          Console << "Parsing " << Cons::Yellow << str.Text << ENDL;
 #endif
+         // Library string: Use resolved text, if available
+         bool library = StringLib.TryFind(str.Page, str.ID, lib) && lib == &str;
+         if (library && StringLib.FindResolved(str, Text))
+            return;
 
          // Skip parsing if no brackets are present
          if (Text.find_first_of(L"{()}") != wstring::npos)
-            Parse();
+         {
+            ResolutionStack stack(1, &str);
+            Parse(stack);
+         }
+
+         // Library string: Store resolved text
+         if (library && !Cyclic)
+            StringLib.StoreResolved(str, Text);
       }
 
+      /// <summary>Create a parser for a library string referenced by another string</summary>
+      /// <param name="str">The string.</param>
+      /// <param name="stack">Strings being resolved, including this string.</param>
+      StringResolver::StringResolver(const LanguageString& str, ResolutionStack& stack) : Text(str.Text), Page(str.Page), Cyclic(false)
+      {
+         // Skip parsing if no brackets are present
+         if (Text.find_first_of(L"{()}") != wstring::npos)
+            Parse(stack);
+      }
 
       StringResolver::~StringResolver()
       {
@@ -45,80 +53,216 @@ namespace Logic
 
       // ------------------------------- STATIC METHODS -------------------------------
 
+      /// <summary>Matches a {aaa,bbb} or {aaa} marker</summary>
+      /// <param name="txt">The text.</param>
+      /// <param name="pos">Position of opening brace.</param>
+      /// <param name="full">True to match {aaa,bbb} markers, false to match {aaa} markers.</param>
+      /// <param name="page">On success, the page id.</param>
+      /// <param name="id">On success, the string id.</param>
+      /// <param name="end">On success, position following the closing brace.</param>
+      /// <returns>True if matched</returns>
+      bool  StringResolver::MatchMarker(const wstring& txt, UINT pos, bool full, UINT& page, UINT& id, UINT& end)
+      {
+         UINT digits = ++pos;
+
+         // Page (or ID)
+         while (pos < txt.length() && txt[pos] >= '0' && txt[pos] <= '9')
+            ++pos;
+         if (pos == digits)
+            return false;
+
+         // Full: Comma + ID
+         if (full)
+         {
+            if (pos >= txt.length() || txt[pos] != ',')
+               return false;
+            page = _wtoi(txt.substr(digits, pos - digits).c_str());
+
+            for (digits = ++pos; pos < txt.length() && txt[pos] >= '0' && txt[pos] <= '9'; )
+               ++pos;
+            if (pos == digits)
+               return false;
+         }
+
+         // Closing brace
+         if (pos >= txt.length() || txt[pos] != '}')
+            return false;
+
+         id = _wtoi(txt.substr(digits, pos - digits).c_str());
+         end = pos + 1;
+         return true;
+      }
+
       // ------------------------------- PUBLIC METHODS -------------------------------
 
       // ------------------------------ PROTECTED METHODS -----------------------------
       
-      /// <summary>Called for each occurrence of {aaa,bbb} markers</summary>
-      /// <param name="match">The match.</param>
+      /// <summary>Called for each occurrence of {aaa,bbb} and {aaa} markers</summary>
+      /// <param name="page">The page id.</param>
+      /// <param name="id">The string id.</param>
+      /// <param name="marker">The marker.</param>
+      /// <param name="stack">Strings being resolved.</param>
       /// <returns>Replacement text</returns>
-      wstring  StringResolver::OnFullMarker(wsmatch& match)
+      wstring  StringResolver::OnMarker(UINT page, UINT id, const wstring& marker, ResolutionStack& stack)
       {
-         UINT id   = _wtoi( match[2].str().c_str() ),
-              page = _wtoi( match[1].str().c_str() );
+         const LanguageString* str;
+         wstring               txt;
 
-         // Insert string if present, otherwise keep original marker
-         return StringLib.Contains(page, id) ? StringLib.Resolve(page, id) : match[0].str();
-      }
+         // Missing: Keep original marker
+         if (!StringLib.TryFind(page, id, str))
+            return marker;
 
-      /// <summary>Called for each occurrence of {aaa} markers</summary>
-      /// <param name="match">The match.</param>
-      /// <returns>Replacement text</returns>
-      wstring  StringResolver::OnDefaultMarker(wsmatch& match)
-      {
-         UINT id   = _wtoi( match[1].str().c_str() );
+         // Already being resolved: Keep original marker
+         if (find(stack.begin(), stack.end(), str) != stack.end())
+         {
+            Cyclic = true;
+            return marker;
+         }
 
-         // Insert string if present, otherwise keep original marker
-         return StringLib.Contains(Page, id) ? StringLib.Resolve(Page, id) : match[0].str();
+         // Previously resolved: Use memoized text
+         if (StringLib.FindResolved(*str, txt))
+            return txt;
+
+         // Resolve string
+         stack.push_back(str);
+         StringResolver r(*str, stack);
+         stack.pop_back();
+
+         // Memoize unless dependent upon the strings being resolved
+         if (r.Cyclic)
+            Cyclic = true;
+         else
+            StringLib.StoreResolved(*str, r.Text);
+
+         return r.Text;
       }
 
       // ------------------------------- PRIVATE METHODS ------------------------------
 
       /// <summary>Parses the instance text.</summary>
-      void  StringResolver::Parse()
+      /// <param name="stack">Strings being resolved.</param>
+      void  StringResolver::Parse(ResolutionStack& stack)
+      {
+         // Replace all {aaa,bbb} markers, then all {aaa} markers
+         ReplaceMarkers(true, stack);
+         ReplaceMarkers(false, stack);
+
+         // Remove all (aaa) comments, then de-escape brackets
+         RemoveComments();
+         RemoveEscapes();
+      }
+
+      /// <summary>Removes all (aaa) comments, including comments left enclosing a removed comment</summary>
+      /// <remarks>Comments cannot be empty or contain backslashes</remarks>
+      void  StringResolver::RemoveComments()
       {
-         wsmatch match;
-         wstring r;
-         
-         // Replace all {aaa,bbb} markers.  Manually track position for in-place replacement + avoid infinite loop
-         for (Position = 0; regex_search(Text.cbegin()+Position, Text.cend(), match, FullMarker); )
+         vector<UINT> open;      // Positions of unmatched opening brackets within output
+         wstring      output;
+
+         if (Text.find('(') == wstring::npos)
+            return;
+
+         output.reserve(Text.length());
+
+         for (WCHAR ch : Text)
          {
-            r = OnFullMarker(match);
+            switch (ch)
+            {
+            case '(':
+               open.push_back(output.length());
+               output += ch;
+               break;
 
-#ifdef PRINT_CONSOLE            
-            Console << "  Replace: " << Cons::Yellow << match[0].str() << Cons::White << " with " << Cons::Green << r << ENDL;
+            case ')':
+               // Remove non-empty comment without backslashes
+               if (!open.empty() && output.length() > open.back() + 1 && output.find('\\', open.back()) == wstring::npos)
+               {
+#ifdef PRINT_CONSOLE
+                  Console << "  Remove: " << Cons::Red << output.substr(open.back()) << ch << ENDL;
 #endif
-            // Advance position + perform replacement
-            Position = (match[0].first - Text.cbegin()) + r.length();
-            Text.replace(match[0].first, match[0].second, r);
+                  output.erase(open.back());
+                  open.pop_back();
+               }
+               else
+               {  // Unmatched: Enclosing brackets can no longer form comments
+                  open.clear();
+                  output += ch;
+               }
+               break;
+
+            default:
+               output += ch;
+               break;
+            }
          }
 
-         // Replace all {aaa} markers.  Manually track position for in-place replacement + avoid infinite loop
-         for (Position = 0; regex_search(Text.cbegin()+Position, Text.cend(), match, DefaultMarker); )
+         Text.swap(output);
+      }
+
+      /// <summary>Removes any backslashes preceeding brackets and braces</summary>
+      void  StringResolver::RemoveEscapes()
+      {
+         wstring output;
+         UINT    run = 0;      // Number of consecutive backslashes
+
+         if (Text.find('\\') == wstring::npos)
+            return;
+
+         output.reserve(Text.length());
+
+         for (WCHAR ch : Text)
          {
-            r = OnDefaultMarker(match);
+            switch (ch)
+            {
+            // Drop preceeding backslashes
+            case '(': case ')': case '{': case '}': case '[': case ']':
+               output.erase(output.length() - run);
+               break;
+            }
 
-#ifdef PRINT_CONSOLE
-            Console << "  Replace: " << Cons::Yellow << match[0].str() << Cons::White << " with " << Cons::Green << r << ENDL;
-#endif
-            // Advance position + perform replacement
-            Position = (match[0].first - Text.cbegin()) + r.length();
-            Text.replace(match[0].first, match[0].second, r);
+            run = (ch == '\\' ? run + 1 : 0);
+            output += ch;
          }
 
-         // Remove all (aaa) comments
-         while (regex_search(Text.cbegin(), Text.cend(), match, RemoveComment))
+         Text.swap(output);
+      }
+
+      /// <summary>Replaces all {aaa,bbb} or {aaa} markers with the text they reference</summary>
+      /// <param name="full">True to replace {aaa,bbb} markers, false to replace {aaa} markers.</param>
+      /// <param name="stack">Strings being resolved.</param>
+      /// <remarks>Replacement text is not searched for further markers</remarks>
+      void  StringResolver::ReplaceMarkers(bool full, ResolutionStack& stack)
+      {
+         UINT    page = Page, 
+                 id, 
+                 end,
+                 pos = Text.find('{');
+         wstring output;
+
+         if (pos == wstring::npos)
+            return;
+
+         output.reserve(Text.length());
+         output.append(Text, 0, pos);
+
+         // Copy text, replacing markers
+         while (pos < Text.length())
          {
+            if (Text[pos] == '{' && MatchMarker(Text, pos, full, page, id, end))
+            {
+               wstring marker = Text.substr(pos, end - pos),
+                       r = OnMarker(page, id, marker, stack);
 #ifdef PRINT_CONSOLE
-            Console << "  Remove: " << Cons::Red << match[0].str() << ENDL;
+               Console << "  Replace: " << Cons::Yellow << marker << Cons::White << " with " << Cons::Green << r << ENDL;
 #endif
-            Text.erase(match[0].first, match[0].second);
+               output += r;
+               pos = end;
+            }
+            else
+               output += Text[pos++];
          }
 
-         // De-escape brackets
-         for (auto chr : {L"\\(", L"\\)", L"\\{", L"\\}", L"\\[", L"\\]"})
-            for (int pos = Text.find(chr); pos != wstring::npos; pos = Text.find(chr))
-               Text.erase(pos, 1);
+         Text.swap(output);
       }
    }
 }
@@ -23,15 +23,23 @@ namespace Logic
       };
 
 
-      /// <summary></summary>
+      /// <summary>Resolves the markers, comments and escape sequences of a language string</summary>
+      /// <remarks>Referenced library strings are resolved once and memoized by the string library. Markers that refer to a 
+      /// string that is already being resolved are left unresolved, rather than recursing infinitely</remarks>
       class LogicExport StringResolver
       {
          // ------------------------ TYPES --------------------------
       private:
+         /// <summary>Strings currently being resolved, outermost first</summary>
+         typedef vector<const LanguageString*>  ResolutionStack;
+
          // --------------------- CONSTRUCTION ----------------------
 
       public:
          StringResolver(const LanguageString& str);
+      private:
+         StringResolver(const LanguageString& str, ResolutionStack& stack);
+      public:
          virtual ~StringResolver();
 
          DEFAULT_COPY(StringResolver);	// Default copy semantics
@@ -39,9 +47,7 @@ namespace Logic
 
          // ------------------------ STATIC -------------------------
       private:
-         static const wregex DefaultMarker;
-         static const wregex FullMarker;
-         static const wregex RemoveComment;
+         static bool  MatchMarker(const wstring& txt, UINT pos, bool full, UINT& page, UINT& id, UINT& end);
 
          // --------------------- PROPERTIES ------------------------
 
@@ -49,11 +55,13 @@ namespace Logic
 
          // ----------------------- MUTATORS ------------------------
       protected:
-         wstring  OnFullMarker(wsmatch& match);
-         wstring  OnDefaultMarker(wsmatch& match);
+         wstring  OnMarker(UINT page, UINT id, const wstring& marker, ResolutionStack& stack);
 
       private:
-         void  Parse();
+         void  Parse(ResolutionStack& stack);
+         void  RemoveComments();
+         void  RemoveEscapes();
+         void  ReplaceMarkers(bool full, ResolutionStack& stack);
 
          // -------------------- REPRESENTATION ---------------------
       public:
@@ -61,7 +69,7 @@ namespace Logic
          wstring     Text;
          
       private:
-         UINT  Position;
+         bool  Cyclic;     // Whether resolution depended upon a string already being resolved
       };
 
    }
@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include "StringTable.h"
+
+namespace Logic
+{
+   namespace Language
+   {
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      StringTable::StringTable() : Used(0)
+      {
+      }
+
+      StringTable::~StringTable()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Calculates the hash of a page and string ID</summary>
+      /// <param name="page">The page id</param>
+      /// <param name="id">The string id</param>
+      /// <returns></returns>
+      UINT  StringTable::GetHash(UINT page, UINT id)
+      {
+         // Fibonacci hashing of the combined key  [Upper bits are the most thoroughly mixed]
+         DWORD64 key = ((DWORD64)page << 32 | id) * 0x9E3779B97F4A7C15ULL;
+         return (UINT)(key >> 32);
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Adds a string, unless a string with the same page and ID is present</summary>
+      /// <param name="s">The string</param>
+      /// <returns>True if added, false if already present</returns>
+      bool  StringTable::Add(const LanguageString& s)
+      {
+         // Grow table beyond 50% load
+         if ((Used + 1) * 2 > Slots.size())
+            Rehash(max(1024U, Slots.size() * 2));
+
+         // Probe linearly until match or empty slot
+         UINT mask = Slots.size() - 1;
+         for (UINT index = GetHash(s.Page, s.ID) & mask; ; index = (index + 1) & mask)
+         {
+            Slot& slot = Slots[index];
+
+            // Exists: Retain existing
+            if (slot.String && slot.Page == s.Page && slot.ID == s.ID)
+               return false;
+
+            // Empty: Insert
+            if (!slot.String)
+            {
+               slot.Page = s.Page;
+               slot.ID = s.ID;
+               slot.String = &s;
+               ++Used;
+               return true;
+            }
+         }
+      }
+
+      /// <summary>Clears all strings</summary>
+      void  StringTable::Clear()
+      {
+         Slots.clear();
+         Used = 0;
+      }
+
+      /// <summary>Finds a string</summary>
+      /// <param name="page">The page id</param>
+      /// <param name="id">The string id</param>
+      /// <returns>String if present, otherwise nullptr</returns>
+      const LanguageString*  StringTable::Find(UINT page, UINT id) const
+      {
+         if (Slots.empty())
+            return nullptr;
+
+         // Probe linearly until match or empty slot
+         UINT mask = Slots.size() - 1;
+         for (UINT index = GetHash(page, id) & mask; Slots[index].String; index = (index + 1) & mask)
+         {
+            const Slot& slot = Slots[index];
+            if (slot.Page == page && slot.ID == id)
+               return slot.String;
+         }
+
+         return nullptr;
+      }
+
+      /// <summary>Ensures capacity for a number of strings without rehashing</summary>
+      /// <param name="count">The number of strings</param>
+      void  StringTable::Reserve(UINT count)
+      {
+         UINT capacity = 1024;
+
+         // Round up to power of two, at most 50% load
+         while (capacity < count * 2)
+            capacity *= 2;
+
+         if (capacity > Slots.size())
+            Rehash(capacity);
+      }
+
+		// ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Resizes the hash table and re-inserts every string</summary>
+      /// <param name="capacity">New capacity, must be a power of two</param>
+      void  StringTable::Rehash(UINT capacity)
+      {
+         SlotArray previous(capacity);
+         UINT      mask = capacity - 1;
+
+         Slots.swap(previous);
+
+         // Re-insert strings
+         for (const Slot& s : previous)
+            if (s.String)
+            {
+               UINT index = GetHash(s.Page, s.ID) & mask;
+               while (Slots[index].String)
+                  index = (index + 1) & mask;
+
+               Slots[index] = s;
+            }
+      }
+   }
+}
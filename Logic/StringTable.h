@@ -0,0 +1,70 @@
+#pragma once
+
+#include "LanguagePage.h"
+
+namespace Logic
+{
+   namespace Language
+   {
+      
+      /// <summary>Hash table of language strings keyed by page and ID</summary>
+      /// <remarks>Stores references to strings owned elsewhere. The first string added with each page and ID is retained, 
+      /// so strings should be added in order of precedence</remarks>
+      class LogicExport StringTable
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Hash table slot</summary>
+         class Slot
+         {
+         public:
+            Slot() : Page(0), ID(0), String(nullptr)
+            {}
+
+            UINT                   Page,      // Page ID
+                                   ID;        // String ID
+            const LanguageString*  String;    // String, or nullptr if empty
+         };
+
+         typedef vector<Slot>  SlotArray;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         StringTable();
+         virtual ~StringTable();
+
+         NO_COPY(StringTable);	// Uncopyable
+		   NO_MOVE(StringTable);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static UINT  GetHash(UINT page, UINT id);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         const LanguageString*  Find(UINT page, UINT id) const;
+         UINT                   GetCount() const   { return Used; }
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         bool  Add(const LanguageString& s);
+         void  Clear();
+         void  Reserve(UINT count);
+
+      private:
+         void  Rehash(UINT capacity);
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         SlotArray  Slots;     // Open-addressing hash table, size is a power of two
+         UINT       Used;      // Number of occupied slots
+      };
+
+   }
+}
+
+using namespace Logic::Language;
@@ -0,0 +1,234 @@
+#include "stdafx.h"
+#include "SyntaxAutomaton.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Create empty automaton</summary>
+      SyntaxAutomaton::SyntaxAutomaton()
+      {
+         Clear();
+      }
+
+      SyntaxAutomaton::~SyntaxAutomaton()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Calculates the FNV-1a hash of token text</summary>
+      /// <param name="txt">The text</param>
+      /// <returns></returns>
+      DWORD  SyntaxAutomaton::GetHash(const wstring& txt)
+      {
+         DWORD hash = 2166136261UL;
+
+         for (WCHAR ch : txt)
+            hash = (hash ^ ch) * 16777619UL;
+
+         return hash;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Clears all syntax, leaving only the root state</summary>
+      void  SyntaxAutomaton::Clear()
+      {
+         Edges.clear();
+         Nodes.assign(1, Node());
+         Slots.clear();
+         Terms.clear();
+         Transitions.assign(1, TransitionMap());
+         Compiled = true;
+      }
+
+      /// <summary>Flattens the transitions of every state into the sorted edge array</summary>
+      void  SyntaxAutomaton::Compile()
+      {
+         Edges.clear();
+
+         // Append the edges of each state contiguously  [Maps are ordered by token ID]
+         for (UINT index = 0; index < Nodes.size(); ++index)
+         {
+            Nodes[index].FirstEdge = Edges.size();
+            Nodes[index].EdgeCount = Transitions[index].size();
+
+            for (const auto& t : Transitions[index])
+               Edges.push_back(Edge(t.first, t.second));
+         }
+
+         Compiled = true;
+      }
+
+      /// <summary>Finds syntax by text</summary>
+      /// <param name="pos">First token</param>
+      /// <param name="end">End of tokens</param>
+      /// <param name="ver">Desired game version</param>
+      /// <param name="params">Parameter tokens</param>
+      /// <returns>Requested syntax if found/compatible, otherwise sentinel syntax</returns>
+      /// <exception cref="Logic::InvalidOperationException">Syntax inserted since automaton was compiled</exception>
+      CommandSyntaxRef  SyntaxAutomaton::Find(TokenIterator& pos, const TokenIterator& end, GameVersion ver, TokenList& params) const
+      {
+         if (!Compiled)
+            throw InvalidOperationException(HERE, L"Syntax automaton has not been compiled");
+
+         for (UINT state = 0; ; ++pos)
+         {
+            const Node& n = Nodes[state];
+
+            // EOF: Return syntax @ this state (if any)
+            if (pos >= end)
+               return n.Syntax && (n.Versions & (UINT)ver) ? *n.Syntax : CommandSyntax::Unrecognised;
+
+            // Variable Arguments: Terminate early to prevent analysing arguments
+            else if (n.VArgument)
+               return *n.Syntax;
+
+            UINT token = PARAMETER;
+
+            // PARAM: Store token
+            if (pos->IsParameter())
+               params.push_back(*pos);
+
+            // Lookup token ID. Unknown text cannot be followed
+            else if ((token = Lookup(pos->Text, GetHash(pos->Text))) == NONE)
+               return CommandSyntax::Unrecognised;
+
+            // Not found: Return sentinel
+            if ((state = Follow(n, token)) == NONE)
+               return CommandSyntax::Unrecognised;
+         }
+      }
+
+      /// <summary>Inserts new syntax into the automaton</summary>
+      /// <param name="s">The syntax, which must outlive the automaton</param>
+      /// <param name="pos">First token</param>
+      /// <param name="end">End of tokens</param>
+      /// <exception cref="Logic::AlgorithmException">Syntax conflicts with existing syntax</exception>
+      void  SyntaxAutomaton::Insert(CommandSyntaxRef s, TokenIterator pos, const TokenIterator& end)
+      {
+         UINT state = 0;
+
+         // (Insert/Lookup) state of each token
+         for (; pos < end; ++pos)
+         {
+            UINT token = pos->IsParameter() ? PARAMETER : Intern(pos->Text);
+            auto edge = Transitions[state].find(token);
+
+            // Follow existing transition
+            if (edge != Transitions[state].end())
+               state = edge->second;
+            else
+            {
+               // Create state
+               Transitions[state][token] = Nodes.size();
+               state = Nodes.size();
+               Nodes.push_back(Node());
+               Transitions.push_back(TransitionMap());
+            }
+         }
+
+         Node& n = Nodes[state];
+
+         // Ensure not duplicate
+         if (n.Syntax)
+            throw AlgorithmException(HERE, VString(L"The command syntax '%s' (id:%d) is already present", n.Syntax->Text.c_str(), n.Syntax->ID));
+
+         // EndOfInput: Accept syntax here
+         n.Syntax = &s;
+         n.Versions = s.Versions;
+         n.VArgument = s.IsVArgument();
+         Compiled = false;
+      }
+
+      // ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Finds the target of the outgoing edge of a state</summary>
+      /// <param name="n">The state</param>
+      /// <param name="token">The token ID</param>
+      /// <returns>Index of target state, or NONE if state has no such edge</returns>
+      UINT  SyntaxAutomaton::Follow(const Node& n, UINT token) const
+      {
+         auto first = Edges.begin() + n.FirstEdge,
+              last = first + n.EdgeCount;
+
+         // Binary search the edges of this state
+         auto edge = lower_bound(first, last, Edge(token, NONE));
+         return edge != last && edge->Token == token ? edge->Target : NONE;
+      }
+
+      /// <summary>Interns token text</summary>
+      /// <param name="txt">The text</param>
+      /// <returns>Token ID</returns>
+      UINT  SyntaxAutomaton::Intern(const wstring& txt)
+      {
+         DWORD hash = GetHash(txt);
+         UINT  token = Lookup(txt, hash);
+
+         // Exists: Return existing
+         if (token != NONE)
+            return token;
+
+         // Grow table beyond 75% load
+         if ((Terms.size() + 1) * 4 > Slots.size() * 3)
+            Rehash(max(256U, Slots.size() * 2));
+
+         // Insert into first empty slot
+         UINT mask = Slots.size() - 1,
+              slot = hash & mask;
+         while (Slots[slot] != NONE)
+            slot = (slot + 1) & mask;
+
+         Slots[slot] = Terms.size();
+         Terms.push_back(Term(txt, hash));
+         return Terms.size();
+      }
+
+      /// <summary>Finds the ID of token text</summary>
+      /// <param name="txt">The text</param>
+      /// <param name="hash">Hash of text</param>
+      /// <returns>Token ID, or NONE if not present</returns>
+      UINT  SyntaxAutomaton::Lookup(const wstring& txt, DWORD hash) const
+      {
+         if (Slots.empty())
+            return NONE;
+
+         // Probe linearly until match or empty slot
+         UINT mask = Slots.size() - 1;
+         for (UINT slot = hash & mask; Slots[slot] != NONE; slot = (slot + 1) & mask)
+         {
+            const Term& t = Terms[Slots[slot]];
+            if (t.Hash == hash && t.Text == txt)
+               return Slots[slot] + 1;
+         }
+
+         return NONE;
+      }
+
+      /// <summary>Resizes the hash table and re-inserts every term</summary>
+      /// <param name="capacity">New capacity, must be a power of two</param>
+      void  SyntaxAutomaton::Rehash(UINT capacity)
+      {
+         UINT mask = capacity - 1;
+
+         Slots.assign(capacity, (UINT)NONE);
+
+         // Re-insert terms
+         for (UINT index = 0; index < Terms.size(); ++index)
+         {
+            UINT slot = Terms[index].Hash & mask;
+            while (Slots[slot] != NONE)
+               slot = (slot + 1) & mask;
+
+            Slots[slot] = index;
+         }
+      }
+   }
+}
+
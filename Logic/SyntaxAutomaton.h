@@ -0,0 +1,115 @@
+#pragma once
+#include "ScriptToken.h"
+#include "CommandSyntax.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      /// <summary>Identifies command syntax from a sequence of tokens</summary>
+      /// <remarks>Token text is interned into integer IDs, and commands are inserted into a trie of token IDs.  Once compiled
+      /// the trie is flattened into contiguous node and edge arrays, with the edges of each node sorted by token ID, so identifying
+      /// a command performs one hash lookup and one binary search per token.  Stores references to syntax owned elsewhere</remarks>
+      class LogicExport SyntaxAutomaton
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Automaton state</summary>
+         class Node
+         {
+         public:
+            Node() : FirstEdge(0), EdgeCount(0), Versions(0), VArgument(false), Syntax(nullptr)
+            {}
+
+            UINT                  FirstEdge,     // Index of first outgoing edge
+                                  EdgeCount,     // Number of outgoing edges
+                                  Versions;      // Compatible game versions of syntax, if any
+            bool                  VArgument;     // Whether syntax has variable arguments
+            const CommandSyntax*  Syntax;        // Syntax accepted by this state, if any
+         };
+
+         /// <summary>Transition between states</summary>
+         class Edge
+         {
+         public:
+            Edge(UINT token, UINT target) : Token(token), Target(target)
+            {}
+
+            bool operator<(const Edge& r) const   { return Token < r.Token; }
+
+            UINT  Token,      // Token ID
+                  Target;     // Index of target state
+         };
+
+         /// <summary>Interned token text</summary>
+         class Term
+         {
+         public:
+            Term(const wstring& txt, DWORD hash) : Text(txt), Hash(hash)
+            {}
+
+            wstring  Text;    // Token text
+            DWORD    Hash;    // Hash of text
+         };
+
+         typedef vector<Node>          NodeArray;
+         typedef vector<Edge>          EdgeArray;
+         typedef vector<Term>          TermArray;
+         typedef vector<UINT>          SlotArray;
+         typedef map<UINT,UINT>        TransitionMap;
+         typedef vector<TransitionMap> TransitionArray;
+
+         static const UINT  NONE = (UINT)-1,
+                            PARAMETER = 0;      // Token ID of all parameters
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         SyntaxAutomaton();
+         virtual ~SyntaxAutomaton();
+
+         NO_COPY(SyntaxAutomaton);	// Uncopyable
+		   NO_MOVE(SyntaxAutomaton);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static DWORD  GetHash(const wstring& txt);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         CommandSyntaxRef  Find(TokenIterator& pos, const TokenIterator& end, GameVersion ver, TokenList& params) const;
+
+         /// <summary>Gets the number of states</summary>
+         UINT  GetCount() const   { return Nodes.size(); }
+
+      private:
+         UINT  Follow(const Node& n, UINT token) const;
+         UINT  Lookup(const wstring& txt, DWORD hash) const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         void  Clear();
+         void  Compile();
+         void  Insert(CommandSyntaxRef s, TokenIterator pos, const TokenIterator& end);
+
+      private:
+         UINT  Intern(const wstring& txt);
+         void  Rehash(UINT capacity);
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         bool             Compiled;      // Whether edges reflect every insertion
+         EdgeArray        Edges;         // Outgoing edges of each state, sorted by token ID
+         NodeArray        Nodes;         // States, the first of which is the root
+         SlotArray        Slots;         // Hash table of term indicies, NONE when empty
+         TermArray        Terms;         // Interned token text, term N has token ID N+1
+         TransitionArray  Transitions;   // Outgoing edges of each state, maintained during insertion
+      };
+
+   }
+}
+
+using namespace Logic::Scripts;
@@ -2,6 +2,7 @@
 #include "SyntaxHighlight.h"
 #include "ScriptFile.h"
 #include "ScriptToken.h"
+#include "TokenBuffer.h"
 #include "PreferencesLibrary.h"
 
 namespace Logic
@@ -84,18 +85,7 @@ namespace Logic
          {
          // Variable: Distinguish between arguments/constants/variables
          case TokenType::Variable:   
-            if (script.Variables.Contains(tok.ValueText))
-            {
-               auto& var = script.Variables[tok.ValueText];
-
-               // Argument
-               if (var.Type == VariableType::Argument)
-                  return Argument;
-               // Constant
-               else if (var.Constant)
-                  return Constant;
-            }
-            // Fall thru...
+            return GetVariableColour(script, tok.ValueText);
 
          // Default: Lookup colour
          case TokenType::Comment:      
@@ -120,8 +110,44 @@ namespace Logic
          throw ArgumentException(HERE, L"tok", VString(L"Unknown token type: %s", tok.Text.c_str()));
       }
 
+      /// <summary>Get the appropriate colour for a token lexed by a token buffer.</summary>
+      /// <param name="script">script.</param>
+      /// <param name="buf">buffer that lexed the token.</param>
+      /// <param name="tok">token.</param>
+      /// <returns></returns>
+      /// <exception cref="Logic::ArgumentException">Whitespace token or unknown token-type</exception>
+      COLORREF  SyntaxHighlight::GetColour(const ScriptFile& script, const TokenBuffer& buf, const LexToken& tok) const
+      {
+         // Variable: Distinguish between arguments/constants/variables  [Only variables require their text]
+         if (tok.Type == TokenType::Variable)
+            return GetVariableColour(script, buf.GetText(tok).substr(1));
+
+         return GetColour(tok.Type);
+      }
+
       // ------------------------------ PROTECTED METHODS -----------------------------
 
+      /// <summary>Get the appropriate colour for a variable.</summary>
+      /// <param name="script">script.</param>
+      /// <param name="name">variable name, without the dollar sign.</param>
+      /// <returns></returns>
+      COLORREF  SyntaxHighlight::GetVariableColour(const ScriptFile& script, const wstring& name) const
+      {
+         if (script.Variables.Contains(name))
+         {
+            auto& var = script.Variables[name];
+
+            // Argument
+            if (var.Type == VariableType::Argument)
+               return Argument;
+            // Constant
+            else if (var.Constant)
+               return Constant;
+         }
+
+         return Colours.at(TokenType::Variable);
+      }
+
       // ------------------------------- PRIVATE METHODS ------------------------------
    
    }
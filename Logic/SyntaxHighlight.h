@@ -7,7 +7,9 @@ namespace Logic
    {
       /// <summary>Forward declarations</summary>
       class ScriptFile;
+      FORWARD_DECLARATION(Compiler,class LexToken)
       FORWARD_DECLARATION(Compiler,class ScriptToken)
+      FORWARD_DECLARATION(Compiler,class TokenBuffer)
       FORWARD_DECLARATION(Compiler,enum class TokenType)
 
       /// <summary>Provides a lookup table for determining appropriate script token colours</summary>
@@ -35,6 +37,10 @@ namespace Logic
       public:
          COLORREF  GetColour(const Compiler::TokenType t) const;
          COLORREF  GetColour(const ScriptFile& script, const Compiler::ScriptToken& tok) const;
+         COLORREF  GetColour(const ScriptFile& script, const Compiler::TokenBuffer& buf, const Compiler::LexToken& tok) const;
+
+      protected:
+         COLORREF  GetVariableColour(const ScriptFile& script, const wstring& name) const;
 
          // ----------------------- MUTATORS ------------------------
 
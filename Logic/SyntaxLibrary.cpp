@@ -14,7 +14,7 @@ namespace Logic
 
       // -------------------------------- CONSTRUCTION --------------------------------
 
-      SyntaxLibrary::SyntaxLibrary()
+      SyntaxLibrary::SyntaxLibrary() : Generation(0)
       {
       }
 
@@ -33,6 +33,7 @@ namespace Logic
          Commands.clear();
          NameTree.Clear();
          Groups.clear();
+         InterlockedIncrement(&Generation);
       }
 
 
@@ -136,6 +137,14 @@ namespace Logic
          throw SyntaxNotFoundException(HERE, id, ver);
       }
 
+      /// <summary>Gets the number of times the library has been cleared or added to</summary>
+      /// <returns></returns>
+      /// <remarks>Caches of syntax references, such as parse sessions, must be discarded when this changes</remarks>
+      UINT  SyntaxLibrary::GetGeneration() const
+      {
+         return Generation;
+      }
+
       /// <summary>Get the collection of defined command groups</summary>
       /// <returns></returns>
       SyntaxLibrary::GroupCollection  SyntaxLibrary::GetGroups() const
@@ -198,6 +207,9 @@ namespace Logic
       /// <param name="f">The file</param>
       void  SyntaxLibrary::Add(SyntaxFile& f)
       { 
+         // Invalidate caches populated while loading
+         InterlockedIncrement(&Generation);
+
          // Merge commands with commands collection
          for (auto pair : f.Commands)
             Commands.Add(pair.second);
@@ -237,6 +249,9 @@ namespace Logic
             // Attempt Insert command [throws if duplicate]
             NameTree.Insert(syntax, tokens.begin(), tokens.end()); 
          }
+
+         // Flatten lookup for identification
+         NameTree.Compile();
       }
 
    }
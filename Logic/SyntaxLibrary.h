@@ -1,7 +1,7 @@
 #pragma once
 
 #include "SyntaxFile.h"
-#include "SyntaxTree.h"
+#include "SyntaxAutomaton.h"
 #include "BackgroundWorker.h"
 
 // Syntax library singleton
@@ -9,11 +9,18 @@
 
 namespace Logic
 {
+   namespace IO
+   {
+      class GameDataSnapshot;
+   }
+
    namespace Scripts
    {
       /// <summary></summary>
       class LogicExport SyntaxLibrary
       {
+         friend class IO::GameDataSnapshot;
+
          // ------------------------ TYPES --------------------------
       public:
          /// <summary>User customized Command group collection</summary>
@@ -44,10 +51,13 @@ namespace Logic
          static SyntaxLibrary  Instance;
 
          // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Generation,GetGeneration);
 			
 		   // ---------------------- ACCESSORS ------------------------			
 
       public:
+         UINT              GetGeneration() const;
          GroupCollection   GetGroups() const;
          CommandSyntaxRef  Find(UINT id, GameVersion ver) const;
          CommandSyntaxRef  Identify(TokenIterator& pos, const TokenIterator& end, GameVersion ver, TokenList& params) const;
@@ -67,7 +77,8 @@ namespace Logic
       private:
          CommandCollection  Commands;
          GroupCollection    Groups;
-         SyntaxTree         NameTree;
+         SyntaxAutomaton    NameTree;
+         volatile LONG      Generation;    // Incremented whenever commands are cleared or added, invalidating references to them
       };
 
    }
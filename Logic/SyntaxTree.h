@@ -6,8 +6,8 @@ namespace Logic
 {
    namespace Scripts
    {
-      /// <summary></summary>
-      class SyntaxTree
+      /// <summary>Identifies command syntax from a sequence of tokens, using a tree of token text</summary>
+      class LogicExport SyntaxTree
       {
          // ------------------------ TYPES --------------------------
       private:
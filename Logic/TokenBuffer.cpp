@@ -0,0 +1,586 @@
+#include "stdafx.h"
+#include "TokenBuffer.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         // -------------------------------- CONSTRUCTION --------------------------------
+
+         /// <summary>Creates an empty buffer</summary>
+         TokenBuffer::TokenBuffer() : LineStart(nullptr), LineEnd(nullptr), Position(nullptr), Significant(0)
+         {
+         }
+
+
+         TokenBuffer::~TokenBuffer()
+         {
+         }
+
+         // ------------------------------- STATIC METHODS -------------------------------
+
+         // ------------------------------- PUBLIC METHODS -------------------------------
+
+         /// <summary>Lexes a line of text, replacing the tokens of the previous line</summary>
+         /// <param name="line">line text, which must remain unchanged while the tokens are in use</param>
+         /// <param name="skipWhitespace">Whether to skip whitespace.</param>
+         /// <returns>Tokens</returns>
+         const LexTokenArray&  TokenBuffer::Lex(const wstring& line, bool skipWhitespace)
+         {
+            return Lex(line.c_str(), line.length(), skipWhitespace);
+         }
+
+         /// <summary>Lexes a line of text, replacing the tokens of the previous line</summary>
+         /// <param name="line">line text, which must remain unchanged while the tokens are in use</param>
+         /// <param name="length">length of text in characters</param>
+         /// <param name="skipWhitespace">Whether to skip whitespace.</param>
+         /// <returns>Tokens</returns>
+         const LexTokenArray&  TokenBuffer::Lex(const WCHAR* line, UINT length, bool skipWhitespace)
+         {
+            // Reset  [Preserve capacity]
+            LineStart = Position = line;
+            LineEnd = line + length;
+            Output.clear();
+            Significant = 0;
+
+            // Read until EOL
+            while (ValidPosition)
+            {
+               // Whitespace: Skip
+               if (skipWhitespace && MatchWhitespace()) 
+                  ReadWhitespace(Position);
+
+               // Whitespace: Read
+               else if (!skipWhitespace && MatchWhitespace())
+                  Push( ReadWhitespace(Position) );
+
+               // Comment: 
+               else if (Significant == 1 && MatchToken(0, L"*"))
+                  Push( ReadComment(Position) );
+
+               // Number:
+               else if (MatchNumber())
+                  Push( ReadNumber(Position) );      
+
+               // Remainder: 
+               else switch (*Position)
+               {
+               case L'$':   Push( ReadVariable(Position) );    break;
+               case L'{':   Push( ReadGameObject(Position) );  break;
+               case L'\'':  Push( ReadString(Position) );      break;
+
+               default: 
+                  Push( ReadAmbiguous(Position) );   
+                  break;
+               }
+            }
+
+            return Output;
+         }
+
+         // ------------------------------ PROTECTED METHODS -----------------------------
+
+         /// <summary>Creates a token from text between 'start' and current position</summary>
+         /// <param name="start">The start.</param>
+         /// <param name="t">Token type</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::MakeToken(CharIterator start, TokenType t) const
+         {
+            return LexToken(t, start-LineStart, Position-LineStart);
+         }
+
+         /// <summary>Check if current char matches a character</summary>
+         /// <param name="ch">The character to test</param>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchChar(WCHAR ch) const
+         {
+            return ValidPosition && *Position == ch;
+         }
+
+         /// <summary>Check if current position matches a string (CASE SENSITIVE)</summary>
+         /// <param name="str">The string to test</param>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchChars(const WCHAR* str) const
+         {
+            // Match each char
+            for (UINT i = 0; str[i]; ++i)
+               if (Position+i >= LineEnd || Position[i] != str[i])
+                  return false; // EOL/Mismatch
+
+            // Match
+            return true;
+         }
+
+         /// <summary>Check if current position matches a string (CASE SENSITIVE)</summary>
+         /// <param name="pos">The position to test</param>
+         /// <param name="str">The string to test</param>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchChars(CharIterator pos, const WCHAR* str) const
+         {
+            // Match each char
+            for (UINT i = 0; str[i]; ++i)
+               if (pos+i >= LineEnd || pos[i] != str[i])
+                  return false; // EOL/Mismatch
+
+            // Match
+            return true;
+         }
+
+         /// <summary>Check if current char is the opening bracket of a script object</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchConstant() const
+         {
+            // Match: '[', alpha
+            return ValidPosition && MatchChar(L'[') && Position+1 < LineEnd && iswalpha(Position[1]);
+         }
+
+         /// <summary>Check if current character is a digit</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchDigit() const
+         {
+            return ValidPosition && iswdigit(*Position);
+         }
+
+         /// <summary>Check if current character is a +ve/-ve number</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchNumber() const
+         {
+            return MatchDigit() 
+               || (MatchChar(L'-') && Position+1 < LineEnd && iswdigit(Position[1]));  // minus immediately preceeding digit
+         }
+
+         /// <summary>Check if current char is an operator</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchOperator() const
+         {
+            if (ValidPosition)
+               // Check first char of operator
+               switch (*Position)
+               {
+               // (for Expressions)
+               case L'=':
+               case L'<':
+               case L'>':
+               case L'!':
+               case L'~':
+               case L'-':
+               case L'+':
+               case L'*':
+               case L'/':
+               case L'&':
+               case L'^':
+               case L'|':
+               case L'(':
+               case L')':  
+               // (for Commands)
+               case L',':
+               case L':':
+               case L'[':
+               case L']':
+               // (Mine)
+               case L'%':
+               // (Invalid syntax)
+               case L'}':
+                  return true;
+
+               // and/or/mod
+               case L'A':  return MatchChars(L"AND");
+               case L'O':  return MatchChars(L"OR");
+               case L'M':  return MatchChars(L"MOD");
+               }
+
+            return false;
+         }
+
+         
+         /// <summary>Check if current char is text.</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchText() const
+         {
+            // Exclude whitespace and known operators, while allowing all other characters
+            if (ValidPosition)
+               switch (*Position)
+               {
+               // (for Expressions)
+               case L'=':
+               case L'<':
+               case L'>':
+               case L'!':
+               case L'~':
+               case L'-':
+               case L'+':
+               case L'*':
+               case L'/':
+               case L'&':
+               case L'^':
+               case L'|':
+               case L'(':
+               case L')':  
+               // (for Commands)
+               case L',':
+               case L':':
+               case L'[':
+               case L']':
+               case L'$':  // Variable
+               case L'{':  // Game object
+               case L'}':  // Game object
+               case L'\'': // String
+               // (mine)
+               case L'%':
+                  break;
+
+               // Allow multi-lingual alphanumeric.  Exclude whitespace 
+               default:
+                  return !MatchWhitespace();
+               }
+
+            // Failed
+            return false;
+         }
+         
+         /// <summary>Check if the text of a previously lexed token matches a string (CASE SENSITIVE)</summary>
+         /// <param name="index">Zero-based token index, including whitespace</param>
+         /// <param name="str">The string to test</param>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchToken(UINT index, const WCHAR* str) const
+         {
+            if (index >= Output.size())
+               return false;
+
+            const LexToken& t = Output[index];
+            return t.Length == wcslen(str) && MatchChars(LineStart+t.Start, str);
+         }
+
+         /// <summary>Check if current char is variable name</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchVariable() const
+         {
+            // Match alphanumeric/dot/underscore  (nb: not dollar)
+            return ValidPosition && (iswalnum(*Position) || MatchChar(L'.') || MatchChar(L'_'));
+         }
+
+         /// <summary>Check if current char is whitespace</summary>
+         /// <returns></returns>
+         bool  TokenBuffer::MatchWhitespace() const
+         {
+            // Match whitespace
+            return ValidPosition && iswspace(*Position);
+         }
+
+         /// <summary>Appends a token to the output</summary>
+         /// <param name="t">The token</param>
+         void  TokenBuffer::Push(const LexToken& t)
+         {
+            Output.push_back(t);
+
+            if (t.Type != TokenType::Whitespace)
+               ++Significant;
+         }
+
+         /// <summary>Consume character and move to the next, if available</summary>
+         /// <returns>True if found, false if end-of-line</returns>
+         bool  TokenBuffer::ReadChar()
+         {
+            return ValidPosition && ++Position < LineEnd;
+         }
+         
+         /// <summary>Reads a ScriptObject, Operator or Text, some of which share first letters</summary>
+         /// <param name="start">Current position (first character)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadAmbiguous(CharIterator start)
+         {
+            // Constant: Avoid interpreting '[' as an operator
+            if (MatchConstant())
+               return ReadConstant(start);
+
+            // Operator: 
+            if (MatchOperator())
+               return ReadOperator(start);
+
+            // Text: anything else 
+            return ReadText(start);
+         }
+
+         /// <summary>Reads a script object</summary>
+         /// <param name="start">Current position (opening bracket)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadConstant(CharIterator start)
+         {
+            // Consume all, excluding trailing bracket
+            while (ReadChar() && !MatchChar(L']'))
+            {}
+            
+            // Consume backet
+            if (MatchChar(L']'))
+               ReadChar();
+
+            // Return COMMENT
+            return MakeToken(start, TokenType::ScriptObject);
+         }
+
+         /// <summary>Reads a comment</summary>
+         /// <param name="start">Current position (opening bracket)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadComment(CharIterator start)
+         {
+            // Consume entire line
+            while (ReadChar())
+            {}
+            
+            // Return COMMENT
+            return MakeToken(start, TokenType::Comment);
+         }
+
+
+         /// <summary>Reads the game object.</summary>
+         /// <param name="start">Current position (opening bracket)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadGameObject(CharIterator start)
+         {
+            // Consume all, excluding trailing bracket
+            while (ReadChar() && !MatchChar(L'}'))
+            {}
+
+            // Consume backet
+            if (MatchChar(L'}'))
+               ReadChar();
+            
+            // Return GAME OBJECT
+            return MakeToken(start, TokenType::GameObject);
+         }
+         
+         /// <summary>Reads the string</summary>
+         /// <param name="start">Current position (leading apostrophe)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadString(CharIterator start)
+         {
+            bool escaped = false;
+            
+            // Read entire string (But enable escaped apostrophes)
+            while (ReadChar())
+            {
+               // Backslash: Escape next character
+               if (MatchChar(L'\\'))
+               {
+                  escaped = !escaped;
+                  continue;
+               }
+               // Unescaped apostrophe: Terminate
+               else if (MatchChar(L'\'') && !escaped)
+                  break;
+               
+               // Reset
+               escaped = false;
+            }
+
+            // Consume apostrophe
+            if (MatchChar(L'\''))
+               ReadChar();
+            
+            // Return STRING
+            return MakeToken(start, TokenType::String);
+         }
+
+         /// <summary>Reads the positive or negative number</summary>
+         /// <param name="start">Current position (leading digit or negative sign)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadNumber(CharIterator start)
+         {
+            // Consume first digit or negative operator
+            ReadChar();
+
+            // Consume digits
+            while (MatchDigit() && ReadChar())
+            {}
+            
+            // Return NUMBER
+            return MakeToken(start, TokenType::Number);
+         }
+
+         /// <summary>Reads an operator</summary>
+         /// <param name="start">Current position (first character)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadOperator(CharIterator start) 
+         {
+            // Read single char 
+            switch (*Position)
+            {
+            // BINARY
+            case L'+':
+            case L'*':
+            case L'/':
+            case L'^':
+            case L'%':
+               ReadChar();
+               return MakeToken(start, TokenType::BinaryOp);
+
+            // UNARY
+            case L'(':
+            case L')':  
+            case L'~': 
+            // Used by commands, class LogicExport as unary
+            case L',': 
+            case L':':
+            case L'[':
+            case L']':
+            // Invalid placement
+            case L'}':
+               ReadChar();
+               return MakeToken(start, TokenType::UnaryOp);
+
+            // BINARY: Read multi-char operators
+            default:
+               switch (*Position)
+               {
+               // CUSTOM AND/OR: Bitwise/Logical and/or
+               case L'&':
+               case L'|':
+                  ReadChar();
+                  // Read two characters if they're the same
+                  if (MatchChar(Position[-1]))
+                     ReadChar();
+                  return MakeToken(start, TokenType::BinaryOp);
+
+               // RefObj/Subtract/Minus
+               case L'-':  
+                  ReadChar();               
+                  // Dereference operator
+                  if (MatchChar('>'))              // NB: '-' is always returned as binary subtract  (unary minus is identified by parser)
+                     ReadChar();
+                  break;
+
+               // Comparisons
+               case L'<':  // < or <=
+               case L'>':  // > or >=
+               case L'!':  // ! or !=
+               case L'=':  // = or ==
+                  ReadChar();
+                  // Read comparison if present
+                  if (MatchChar('='))
+                     ReadChar();
+                  
+                  // Logical Not: Return as unary operator
+                  else if (Position[-1] == '!')
+                     return MakeToken(start, TokenType::UnaryOp);
+                  break;
+
+               // OR: Read double
+               case L'O':  
+                  Position += 2;
+                  break;
+
+               // AND/MOD: Read triple
+               case L'A':  
+               case L'M':  
+                  Position += 3; 
+                  break;
+
+               // Error: should never reach here
+               default:
+                  throw ArgumentException(HERE, L"Position", L"Unable to read previously matched operator");
+               }
+            }
+
+            // Return BINARY
+            return MakeToken(start, TokenType::BinaryOp);
+         }
+
+
+         
+         /// <summary>Reads a text/keyword/label/null token</summary>
+         /// <param name="start">Starting position (first character)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadText(CharIterator start)
+         {
+            bool Keyword = false;
+
+            // Read remaining text
+            while (MatchText() && ReadChar())
+            {}
+
+            // NULL: Can appear anywhere
+            if (MatchChars(start, L"null"))
+               return MakeToken(start, TokenType::Null);
+
+            // Identify keywords
+            switch (Significant)
+            {
+            case 0:
+               // LABEL: first text token followed by ':'
+               if (MatchChar(L':'))
+                  return MakeToken(start, TokenType::Label);
+
+               // Identify keywords
+               switch (Position - start)
+               {
+               case 2: Keyword = MatchChars(start, L"if") || MatchChars(start, L"do");                                           break;
+               case 3: Keyword = MatchChars(start, L"end") || MatchChars(start, L"for") || MatchChars(start, L"dim");            break;
+               case 4: Keyword = MatchChars(start, L"else") || MatchChars(start, L"skip") || MatchChars(start, L"goto");         break;
+               case 5: Keyword = MatchChars(start, L"while") || MatchChars(start, L"break") || MatchChars(start, L"gosub") || MatchChars(start, L"start");  break;
+               case 6: Keyword = MatchChars(start, L"return") || MatchChars(start, L"endsub");                                   break;
+               case 7: Keyword = MatchChars(start, L"foreach");                                                                  break;
+               case 8: Keyword = MatchChars(start, L"continue");                                                                 break;
+               }
+               break;
+
+            case 1:
+               // LABEL: second text token preceeded by goto/gosub
+               if (MatchToken(0, L"goto") || MatchToken(0, L"gosub"))
+                  return MakeToken(start, TokenType::Label);
+
+               // Identify keywords
+               switch (Position - start)
+               {
+               case 2: Keyword = MatchChars(start, L"if");            break;
+               case 3: Keyword = MatchChars(start, L"not");           break;
+               }
+               break;
+
+            case 2:
+               // Identify keywords
+               switch (Position - start)
+               {
+               case 3: Keyword = MatchChars(start, L"not");           break;
+               }
+               break;
+            }
+            
+            // Return KEYWORD/TEXT
+            return MakeToken(start, Keyword ? TokenType::Keyword : TokenType::Text);
+         }
+
+         /// <summary>Reads a variable</summary>
+         /// <param name="start">Current position (dollar sign)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadVariable(CharIterator start)
+         {
+            // Dollar sign
+            ReadChar();
+
+            // Consume name
+            while (MatchVariable() && ReadChar())
+            {}
+
+            // Return as OPERATOR if name is missing, otherwise VARIABLE
+            return MakeToken(start, Position-start > 0 ? TokenType::Variable : TokenType::UnaryOp);
+         }
+
+         /// <summary>Reads whitespace</summary>
+         /// <param name="start">Current position (first character)</param>
+         /// <returns></returns>
+         LexToken  TokenBuffer::ReadWhitespace(CharIterator start)
+         {
+            // Consume whitespace
+            while (MatchWhitespace() && ReadChar())
+            {}
+
+             // Return as WHITESPACE
+            return MakeToken(start, TokenType::Whitespace);
+         }
+
+         // ------------------------------- PRIVATE METHODS ------------------------------
+      }
+   }
+}
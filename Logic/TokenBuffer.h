@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ScriptToken.h"
+
+namespace Logic
+{
+   namespace Scripts
+   {
+      namespace Compiler
+      {
+         /// <summary>Lexes MSCI Script command text into a reusable array of tokens that reference the lexed text</summary>
+         /// <remarks>Tokens are character offsets into the caller's text, which is neither copied nor retained beyond the next call to Lex.
+         /// The token array retains its capacity between calls, so lexing successive lines performs no allocation once it has grown to
+         /// the longest line.  Buffers are not thread-safe, each thread should own its own buffer</remarks>
+         class LogicExport TokenBuffer
+         {
+            // ------------------------ TYPES --------------------------
+         protected:
+            typedef const WCHAR* CharIterator;
+
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            TokenBuffer();
+            virtual ~TokenBuffer();
+
+            NO_COPY(TokenBuffer);	// Uncopyable
+            NO_MOVE(TokenBuffer);	// Unmoveable
+
+            // ------------------------ STATIC -------------------------
+
+            // --------------------- PROPERTIES ------------------------
+         public:
+            PROPERTY_GET(const LexTokenArray&,Tokens,GetTokens);
+         protected:
+            PROPERTY_GET(bool,ValidPosition,IsValidPosition);
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            /// <summary>Get start token iterator</summary>
+            /// <returns></returns>
+            LexTokenArray::const_iterator begin() const
+            {
+               return Output.begin();
+            }
+
+            /// <summary>Get end token iterator</summary>
+            /// <returns></returns>
+            LexTokenArray::const_iterator end() const
+            {
+               return Output.end();
+            }
+
+            /// <summary>Gets the tokens of the most recently lexed text</summary>
+            /// <returns></returns>
+            const LexTokenArray&  GetTokens() const
+            {
+               return Output;
+            }
+
+            /// <summary>Gets the text of a token, which must belong to the most recently lexed text</summary>
+            /// <param name="t">The token</param>
+            /// <returns></returns>
+            wstring  GetText(const LexToken& t) const
+            {
+               return wstring(LineStart+t.Start, LineStart+t.End);
+            }
+
+         protected:
+            bool  IsValidPosition() const  { return Position < LineEnd; }
+
+            bool  MatchChar(WCHAR ch) const;
+            bool  MatchChars(const WCHAR* str) const;
+            bool  MatchChars(CharIterator pos, const WCHAR* str) const;
+
+            bool  MatchConstant() const;
+            bool  MatchDigit() const;
+            bool  MatchNumber() const;
+            bool  MatchOperator() const;
+            bool  MatchText() const;
+            bool  MatchToken(UINT index, const WCHAR* str) const;
+            bool  MatchVariable() const;
+            bool  MatchWhitespace() const;
+
+            LexToken  MakeToken(CharIterator start, TokenType t) const;
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            const LexTokenArray&  Lex(const wstring& line, bool skipWhitespace = true);
+            const LexTokenArray&  Lex(const WCHAR* line, UINT length, bool skipWhitespace = true);
+
+         protected:
+            void      Push(const LexToken& t);
+            bool      ReadChar();
+
+            LexToken  ReadAmbiguous(CharIterator start);
+            LexToken  ReadConstant(CharIterator start);
+            LexToken  ReadComment(CharIterator start);
+            LexToken  ReadGameObject(CharIterator start);
+            LexToken  ReadNumber(CharIterator start);
+            LexToken  ReadOperator(CharIterator start);
+            LexToken  ReadString(CharIterator start);
+            LexToken  ReadText(CharIterator start);
+            LexToken  ReadVariable(CharIterator start);
+            LexToken  ReadWhitespace(CharIterator start);
+
+            // -------------------- REPRESENTATION ---------------------
+         protected:
+            CharIterator   LineStart,         // Input start position
+                           LineEnd,           // Input end position
+                           Position;          // Position
+            LexTokenArray  Output;            // Tokens lexed so far
+            UINT           Significant;       // Number of non-whitespace tokens lexed so far
+         };
+      }
+   }
+}
+
+using namespace Logic::Scripts::Compiler;
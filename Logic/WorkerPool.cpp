@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "WorkerPool.h"
+
+namespace Logic
+{
+   namespace Threads
+   {
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      /// <summary>Creates an empty pool</summary>
+      /// <param name="threads">Maximum number of threads, including the calling thread. Zero to use one per processor</param>
+      WorkerPool::WorkerPool(UINT threads)
+         : MaxThreads(min(threads ? threads : GetProcessorCount(), (UINT)MAXIMUM_WAIT_OBJECTS)), Available(nullptr), Failed(false), Remaining(0)
+      {
+      }
+
+      WorkerPool::~WorkerPool()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Gets the number of logical processors.</summary>
+      /// <returns></returns>
+      UINT  WorkerPool::GetProcessorCount()
+      {
+         SYSTEM_INFO info;
+         GetSystemInfo(&info);
+         return max(1UL, info.dwNumberOfProcessors);
+      }
+
+      /// <summary>Worker thread entry point</summary>
+      /// <param name="pool">The pool.</param>
+      /// <returns></returns>
+      DWORD WINAPI  WorkerPool::ThreadMain(WorkerPool* pool)
+      {
+         pool->Execute();
+         return 0;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Adds an independent task to the batch</summary>
+      /// <param name="t">The task.</param>
+      /// <returns>Index of task, used to declare dependencies upon it</returns>
+      /// <exception cref="Logic::ArgumentNullException">Task is empty</exception>
+      UINT  WorkerPool::Add(Task t)
+      {
+         return Add(t, vector<UINT>());
+      }
+
+      /// <summary>Adds a task to the batch that is started once its prerequisites have completed</summary>
+      /// <param name="t">The task.</param>
+      /// <param name="prerequisites">Indicies of previously added tasks that must complete first.</param>
+      /// <returns>Index of task, used to declare dependencies upon it</returns>
+      /// <exception cref="Logic::ArgumentNullException">Task is empty</exception>
+      /// <exception cref="Logic::IndexOutOfRangeException">Prerequisite has not been added</exception>
+      UINT  WorkerPool::Add(Task t, const vector<UINT>& prerequisites)
+      {
+         if (!t)
+            throw ArgumentNullException(HERE, L"t");
+
+         UINT index = Tasks.size();
+
+         // Prerequisites must precede the task, which precludes cycles
+         for (UINT p : prerequisites)
+            if (p >= index)
+               throw IndexOutOfRangeException(HERE, p, index);
+
+         Tasks.push_back(TaskItem(t, prerequisites.size()));
+         for (UINT p : prerequisites)
+            Tasks[p].Dependents.push_back(index);
+
+         return index;
+      }
+
+      /// <summary>Executes all pending tasks and waits for them to complete.</summary>
+      /// <exception cref="Logic::Win32Exception">Unable to create semaphore</exception>
+      /// <exception cref="...">First exception thrown by a task</exception>
+      void  WorkerPool::Run()
+      {
+         vector<HANDLE> threads;
+
+         // Reset
+         Failed = false;
+         Error = nullptr;
+         Remaining = Tasks.size();
+         Ready.clear();
+
+         // Nothing to do
+         if (Tasks.empty())
+            return;
+
+         // Queue tasks without prerequisites
+         for (UINT i = 0; i < Tasks.size(); ++i)
+            if (Tasks[i].Pending == 0)
+               Ready.push_back(i);
+
+         // Signal once per ready task
+         if (!(Available = CreateSemaphore(nullptr, Ready.size(), LONG_MAX, nullptr)))
+            throw Win32Exception(HERE, L"Unable to create semaphore");
+
+         // Launch one fewer thread than required, the calling thread performs work too
+         for (UINT i = 1; i < min(MaxThreads, Tasks.size()); ++i)
+         {
+            HANDLE h = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)ThreadMain, (void*)this, NULL, NULL);
+
+            // Failed: Continue with the threads we have
+            if (!h)
+               break;
+            threads.push_back(h);
+         }
+
+         // Work until all tasks have completed
+         Execute();
+
+         // Wait for workers to finish
+         if (!threads.empty())
+         {
+            WaitForMultipleObjects(threads.size(), &threads[0], TRUE, INFINITE);
+            for (HANDLE h : threads)
+               CloseHandle(h);
+         }
+
+         // Cleanup
+         CloseHandle(Available);
+         Available = nullptr;
+         Tasks.clear();
+
+         // Re-throw first error, if any
+         if (Error)
+            rethrow_exception(Error);
+      }
+
+		// ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Executes tasks as they become ready, until all have completed or a task fails</summary>
+      void  WorkerPool::Execute()
+      {
+         while (WaitForSingleObject(Available, INFINITE) == WAIT_OBJECT_0)
+         {
+            // Claim next ready task.  None indicates completion or failure
+            Lock.Enter();
+            if (Ready.empty())
+            {
+               Lock.Leave();
+               return;
+            }
+            UINT index = Ready.front();
+            Ready.pop_front();
+            Lock.Leave();
+
+            exception_ptr error;
+            try
+            {
+               Tasks[index].Action();
+            }
+            catch (...)
+            {
+               error = current_exception();
+            }
+
+            Lock.Enter();
+            --Remaining;
+
+            // Failed: Preserve first error only, skip remaining tasks
+            if (error)
+            {
+               if (!Error)
+                  Error = error;
+               Failed = true;
+               Ready.clear();
+            }
+            // Success: Queue dependents whose prerequisites have all completed
+            else if (!Failed)
+               for (UINT d : Tasks[index].Dependents)
+                  if (--Tasks[d].Pending == 0)
+                  {
+                     Ready.push_back(d);
+                     ReleaseSemaphore(Available, 1, nullptr);
+                  }
+
+            // Finished: Release every thread
+            if (Failed || Remaining == 0)
+               ReleaseSemaphore(Available, MaxThreads, nullptr);
+            Lock.Leave();
+         }
+      }
+   }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "CriticalSection.h"
+#include <exception>
+
+namespace Logic
+{
+   namespace Threads
+   {
+
+      /// <summary>Executes a batch of tasks concurrently on a bounded number of threads</summary>
+      /// <remarks>Tasks may depend upon tasks added before them, and are only started once those have completed.  The calling
+      /// thread participates in the work and blocks until every task has completed.  If a task throws, the remaining tasks 
+      /// are skipped and the first exception is re-thrown on the calling thread</remarks>
+      class LogicExport WorkerPool
+      {
+         // ------------------------ TYPES --------------------------
+      public:
+         /// <summary>Unit of work</summary>
+         typedef function<void ()>  Task;
+
+      private:
+         /// <summary>Task and its position within the dependency graph</summary>
+         class TaskItem
+         {
+         public:
+            TaskItem(Task t, UINT prerequisites) : Action(t), Pending(prerequisites)
+            {}
+
+            Task          Action;        // Unit of work
+            UINT          Pending;       // Number of prerequisites yet to complete
+            vector<UINT>  Dependents;    // Indicies of tasks that depend upon this task
+         };
+
+         /// <summary>Tasks in order of submission</summary>
+         typedef vector<TaskItem>  TaskArray;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         WorkerPool(UINT threads = 0);
+         virtual ~WorkerPool();
+
+         NO_COPY(WorkerPool);	// Uncopyable
+		   NO_MOVE(WorkerPool);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static UINT  GetProcessorCount();
+
+      private:
+         static DWORD WINAPI  ThreadMain(WorkerPool* pool);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+         PROPERTY_GET(UINT,Threads,GetThreads);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         /// <summary>Gets the number of tasks pending</summary>
+         UINT  GetCount() const     { return Tasks.size(); }
+
+         /// <summary>Gets the maximum number of threads used, including the calling thread</summary>
+         UINT  GetThreads() const   { return MaxThreads; }
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         UINT  Add(Task t);
+         UINT  Add(Task t, const vector<UINT>& prerequisites);
+         void  Run();
+
+      private:
+         void  Execute();
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         CriticalSection     Lock;          // Guards all members below
+         exception_ptr       Error;         // First exception thrown by a task
+         HANDLE              Available;     // Semaphore counting ready tasks and exit requests
+         bool                Failed;        // Whether a task has thrown
+         const UINT          MaxThreads;    // Maximum number of threads
+         deque<UINT>         Ready;         // Indicies of tasks whose prerequisites have completed
+         UINT                Remaining;     // Number of tasks yet to complete
+         TaskArray           Tasks;         // Pending tasks
+      };
+
+   }
+}
+
+using namespace Logic::Threads;
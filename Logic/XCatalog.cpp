@@ -11,9 +11,24 @@ namespace Logic
       /// <summary>Initializes a new instance of the <see cref="XCatalog"/> class.</summary>
       /// <param name="vfs">File system</param>
       /// <param name="path">Full path of catalog file</param>
-      XCatalog::XCatalog(XFileSystem& vfs, Path path)
+      /// <param name="backend">Whether to map the data file into memory</param>
+      /// <exception cref="Logic::FileNotFoundException">Catalog not found</exception>
+      /// <exception cref="Logic::IOException">An I/O error occurred</exception>
+      XCatalog::XCatalog(XFileSystem& vfs, Path path, CatalogBackend backend)
          : FullPath(path), FileSystem(vfs), FileLock(new FileStream(FullPath, FileMode::OpenExisting, FileAccess::Read)) 
       { 
+         // Mapped: Map data file once for the lifetime of the catalog
+         if (backend == CatalogBackend::Mapped)
+         {
+            try
+            {
+               DataView = MappedFilePtr(new MappedFile(FullPath.RenameExtension(L".dat")));
+            }
+            catch (ExceptionBase& e) {
+               // Fallback to streamed access  (Address space may be exhausted on 32-bit)
+               Console << Cons::Warning << L"Unable to map data file for " << FullPath << L" : " << e.Message << ENDL;
+            }
+         }
       }
 
       /// <summary>Releases the lock on the catalog</summary>
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FileStream.h"
+#include "MappedFile.h"
 #include "CatalogReader.h"
 
 //using namespace Logic::FileSystem;
@@ -10,6 +11,13 @@ namespace Logic
    namespace FileSystem
    {
       class XFileSystem;
+
+      /// <summary>Defines how the contents of catalog data files are accessed</summary>
+      enum class CatalogBackend 
+      { 
+         Streamed,      // Each file opens its own stream on the data file
+         Mapped         // Data file is mapped into memory once and shared by all files
+      };
       
       /// <summary>Represents a catalog in the XFileSystem</summary>
       /// <remarks>The catalog file is locked for writing/deleting during the lifetime of this object</remarks>
@@ -21,7 +29,7 @@ namespace Logic
       public:
          // --------------------- CONSTRUCTION ----------------------
 
-         XCatalog(XFileSystem& vfs, Path path);
+         XCatalog(XFileSystem& vfs, Path path, CatalogBackend backend = CatalogBackend::Streamed);
          virtual ~XCatalog();
 
          // Move/copy assign not impl
@@ -35,6 +43,13 @@ namespace Logic
          CatalogReader  GetReader() const;
          Path           GetFullPath()  { return FullPath; }
 
+         /// <summary>Gets the mapped data file, if any</summary>
+         /// <returns>Mapped data file, or nullptr when using the streamed backend</returns>
+         MappedFilePtr  GetDataView() const   { return DataView; }
+
+         /// <summary>Query whether the data file has been mapped into memory</summary>
+         bool           IsMapped() const   { return DataView != nullptr; }
+
 #ifdef LOGIC_LIB_BUILD_FIX
          XCatalog& operator==(const XCatalog& r) const { THROW_LOGIC_LIB_BUILD_FIX; }
             
@@ -47,6 +62,7 @@ namespace Logic
 
       private:
          FileStreamPtr  FileLock;
+         MappedFilePtr  DataView;
          XFileSystem&   FileSystem;
 
       };
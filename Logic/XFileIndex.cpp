@@ -0,0 +1,216 @@
+#include "stdafx.h"
+#include "XFileIndex.h"
+#include <algorithm>
+
+namespace Logic
+{
+   namespace FileSystem
+   {
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      XFileIndex::XFileIndex()
+      {
+      }
+
+      XFileIndex::~XFileIndex()
+      {
+      }
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Case-folds a path</summary>
+      /// <param name="path">The path</param>
+      /// <returns>Lower-case copy of path</returns>
+      wstring  XFileIndex::Fold(const WCHAR* path)
+      {
+         wstring folded(path);
+
+         // Convert to lower-case in place
+         if (!folded.empty())
+            CharLowerBuff(&folded[0], folded.length());
+
+         return folded;
+      }
+
+      /// <summary>Calculates the FNV-1a hash of a case-folded path</summary>
+      /// <param name="folded">Case-folded path</param>
+      /// <returns></returns>
+      DWORD  XFileIndex::GetHash(const wstring& folded)
+      {
+         DWORD hash = 2166136261UL;
+
+         for (WCHAR ch : folded)
+            hash = (hash ^ ch) * 16777619UL;
+
+         return hash;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+      /// <summary>Attempts to add a file to the collection, overwriting any of lower precedence</summary>
+      /// <param name="f">The file to add</param>
+      /// <returns>True if added or overwritten, false if a file of equal or higher precedence is present</returns>
+      bool  XFileIndex::Add(const XFileInfo& f)
+      {
+         UINT key = Intern(Fold(f.Key.c_str()));
+
+         // Exists: Overwrite if higher precedence
+         if (Names[key].File != NONE)
+         {
+            FilePtr& existing = Files[Names[key].File];
+            if (f.Precedence <= existing->Precedence)
+               return false;
+
+            existing.reset(new XFileInfo(f));
+            return true;
+         }
+
+         // Add file
+         UINT index = Files.size();
+         Files.push_back(FilePtr(new XFileInfo(f)));
+         Keys.push_back(key);
+         Names[key].File = index;
+
+         // Add to folder  [Folder is key up to and including the last backslash]
+         const wstring& text = Names[key].Text;
+         UINT folder = Intern(text.substr(0, text.find_last_of(L'\\') + 1));
+         Names[folder].Children.push_back(index);
+         return true;
+      }
+
+      /// <summary>Gets all files within a folder</summary>
+      /// <param name="folder">Full path of folder</param>
+      /// <returns>View of files within the folder, empty if folder is not present</returns>
+      XFileView  XFileIndex::Browse(Path folder) const
+      {
+         wstring folded = Fold(folder.AppendBackslash().c_str());
+         UINT    name = Lookup(folded, GetHash(folded));
+
+         // Not found: Return empty view
+         if (name == NONE)
+            return XFileView();
+
+         // Reference each file of folder
+         vector<const XFileInfo*> files;
+         files.reserve(Names[name].Children.size());
+         for (UINT index : Names[name].Children)
+            files.push_back(Files[index].get());
+
+         return XFileView(std::move(files));
+      }
+
+      /// <summary>Clears all files and names</summary>
+      void  XFileIndex::Clear()
+      {
+         Files.clear();
+         Keys.clear();
+         Names.clear();
+         Slots.clear();
+      }
+
+      /// <summary>Queries whether the index contains a file</summary>
+      /// <param name="key">Full path EXCLUDING extension</param>
+      /// <returns></returns>
+      bool  XFileIndex::Contains(Path key) const
+      {
+         wstring folded = Fold(key.c_str());
+         UINT    name = Lookup(folded, GetHash(folded));
+
+         return name != NONE && Names[name].File != NONE;
+      }
+
+      /// <summary>Finds a file</summary>
+      /// <param name="key">Full path EXCLUDING extension</param>
+      /// <returns>File descriptor</returns>
+      /// <exception cref="Logic::FileNotFoundException">File not found</exception>
+      const XFileInfo&  XFileIndex::Find(Path key) const
+      {
+         wstring folded = Fold(key.c_str());
+         UINT    name = Lookup(folded, GetHash(folded));
+
+         // Error: file not found
+         if (name == NONE || Names[name].File == NONE)
+            throw FileNotFoundException(HERE, key);
+
+         return *Files[Names[name].File];
+      }
+
+      /// <summary>Sorts the files of each folder by key, so they are browsed in a consistent order</summary>
+      void  XFileIndex::Sort()
+      {
+         for (Name& n : Names)
+            sort(n.Children.begin(), n.Children.end(), [this](UINT a, UINT b) { return Names[Keys[a]].Text < Names[Keys[b]].Text; });
+      }
+
+		// ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+      /// <summary>Adds a case-folded path to the name table, if not already present</summary>
+      /// <param name="folded">Case-folded path</param>
+      /// <returns>Index of name</returns>
+      UINT  XFileIndex::Intern(wstring&& folded)
+      {
+         DWORD hash = GetHash(folded);
+         UINT  name = Lookup(folded, hash);
+
+         // Exists: Return existing
+         if (name != NONE)
+            return name;
+
+         // Grow table beyond 75% load
+         if ((Names.size() + 1) * 4 > Slots.size() * 3)
+            Rehash(max(64U, Slots.size() * 2));
+
+         // Insert into first empty slot
+         UINT mask = Slots.size() - 1,
+              slot = hash & mask;
+         while (Slots[slot] != NONE)
+            slot = (slot + 1) & mask;
+
+         Slots[slot] = Names.size();
+         Names.push_back(Name(std::move(folded), hash));
+         return Slots[slot];
+      }
+
+      /// <summary>Finds a case-folded path in the name table</summary>
+      /// <param name="folded">Case-folded path</param>
+      /// <param name="hash">Hash of path</param>
+      /// <returns>Index of name, or NONE if not present</returns>
+      UINT  XFileIndex::Lookup(const wstring& folded, DWORD hash) const
+      {
+         if (Slots.empty())
+            return NONE;
+
+         // Probe linearly until match or empty slot
+         UINT mask = Slots.size() - 1;
+         for (UINT slot = hash & mask; Slots[slot] != NONE; slot = (slot + 1) & mask)
+         {
+            const Name& n = Names[Slots[slot]];
+            if (n.Hash == hash && n.Text == folded)
+               return Slots[slot];
+         }
+
+         return NONE;
+      }
+
+      /// <summary>Resizes the hash table and re-inserts every name</summary>
+      /// <param name="capacity">New capacity, must be a power of two</param>
+      void  XFileIndex::Rehash(UINT capacity)
+      {
+         UINT mask = capacity - 1;
+
+         Slots.assign(capacity, (UINT)NONE);
+
+         // Re-insert names
+         for (UINT index = 0; index < Names.size(); ++index)
+         {
+            UINT slot = Names[index].Hash & mask;
+            while (Slots[slot] != NONE)
+               slot = (slot + 1) & mask;
+
+            Slots[slot] = index;
+         }
+      }
+   }
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "XFileInfo.h"
+
+namespace Logic
+{
+   namespace FileSystem
+   {
+
+      /// <summary>Read-only view of file descriptors owned by a file index</summary>
+      /// <remarks>Only valid while the index that produced it is unchanged</remarks>
+      class LogicExport XFileView
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         typedef vector<const XFileInfo*>  PointerArray;
+
+      public:
+         /// <summary>Forward-only iterator over the descriptors of a view</summary>
+         class const_iterator : public std::iterator<std::forward_iterator_tag, const XFileInfo>
+         {
+            // --------------------- CONSTRUCTION ----------------------
+         public:
+            const_iterator(PointerArray::const_iterator pos) : Position(pos)
+            {}
+
+            // ---------------------- ACCESSORS ------------------------
+         public:
+            const XFileInfo& operator*() const    { return **Position; }
+            const XFileInfo* operator->() const   { return *Position;  }
+
+            bool operator==(const const_iterator& r) const   { return Position == r.Position; }
+            bool operator!=(const const_iterator& r) const   { return Position != r.Position; }
+
+            // ----------------------- MUTATORS ------------------------
+         public:
+            const_iterator& operator++()          { ++Position; return *this; }
+            const_iterator  operator++(int)       { const_iterator tmp(*this); ++Position; return tmp; }
+
+            // -------------------- REPRESENTATION ---------------------
+         private:
+            PointerArray::const_iterator  Position;
+         };
+
+         typedef const_iterator  iterator;
+         typedef UINT            size_type;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         XFileView()
+         {}
+         XFileView(PointerArray&& files) : Files(std::move(files))
+         {}
+
+         DEFAULT_COPY(XFileView);	// Default copy semantics
+		   DEFAULT_MOVE(XFileView);	// Default move semantics
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(size_type,Count,size);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         const_iterator  begin() const   { return Files.begin();   }
+         const_iterator  end() const     { return Files.end();     }
+         bool            empty() const   { return Files.empty();   }
+         size_type       size() const    { return Files.size();    }
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         PointerArray  Files;
+      };
+
+
+      /// <summary>Collection of file descriptors, indexed by path and by folder</summary>
+      /// <remarks>Keys and folders are case-folded and interned once, lookups use an open-addressing hash table
+      /// and each folder records its own files so browsing does not visit the entire collection</remarks>
+      class LogicExport XFileIndex
+      {
+         // ------------------------ TYPES --------------------------
+      private:
+         /// <summary>Interned case-folded string, either a key or a folder</summary>
+         class Name
+         {
+         public:
+            Name(wstring&& txt, DWORD hash) : Text(std::move(txt)), Hash(hash), File(NONE)
+            {}
+
+            wstring       Text;       // Case-folded path
+            DWORD         Hash;       // Hash of text
+            UINT          File;       // Index of file with this key, or NONE
+            vector<UINT>  Children;   // Indicies of files within this folder
+         };
+
+         typedef unique_ptr<XFileInfo>  FilePtr;
+         typedef vector<FilePtr>        FileArray;
+         typedef vector<Name>           NameArray;
+         typedef vector<UINT>           SlotArray;
+
+         static const UINT  NONE = (UINT)-1;
+
+         // --------------------- CONSTRUCTION ----------------------
+      public:
+         XFileIndex();
+         virtual ~XFileIndex();
+
+         NO_COPY(XFileIndex);	// Uncopyable
+		   NO_MOVE(XFileIndex);	// Unmoveable
+
+         // ------------------------ STATIC -------------------------
+      private:
+         static wstring  Fold(const WCHAR* path);
+         static DWORD    GetHash(const wstring& folded);
+
+         // --------------------- PROPERTIES ------------------------
+      public:
+         PROPERTY_GET(UINT,Count,GetCount);
+
+         // ---------------------- ACCESSORS ------------------------
+      public:
+         XFileView         Browse(Path folder) const;
+         bool              Contains(Path key) const;
+         const XFileInfo&  Find(Path key) const;
+         UINT              GetCount() const    { return Files.size(); }
+
+      private:
+         UINT  Lookup(const wstring& folded, DWORD hash) const;
+
+         // ----------------------- MUTATORS ------------------------
+      public:
+         bool  Add(const XFileInfo& f);
+         void  Clear();
+         void  Sort();
+
+      private:
+         UINT  Intern(wstring&& folded);
+         void  Rehash(UINT capacity);
+
+         // -------------------- REPRESENTATION ---------------------
+      private:
+         FileArray  Files;      // File descriptors, in order of addition
+         SlotArray  Keys;       // Name index of the key of each file
+         NameArray  Names;      // Interned keys and folders
+         SlotArray  Slots;      // Hash table of name indicies, NONE when empty
+      };
+
+   }
+}
+
+using namespace Logic::FileSystem;
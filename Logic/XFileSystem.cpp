@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "XFileSystem.h"
 #include "FileSearch.h"
+#include "WorkerPool.h"
 #include <algorithm>
 #include <functional>
 
@@ -13,7 +14,9 @@ namespace Logic
       // -------------------------------- CONSTRUCTION --------------------------------
 
       /// <summary>Initializes a new instance of the <see cref="XFileSystem"/> class.</summary>
-      XFileSystem::XFileSystem() : Version(GameVersion::Threat)
+      /// <param name="backend">Whether catalog data files are streamed or mapped into memory</param>
+      /// <param name="threads">Maximum number of catalogs to read concurrently. Zero to use one per processor, one to read serially</param>
+      XFileSystem::XFileSystem(CatalogBackend backend, UINT threads) : Version(GameVersion::Threat), Backend(backend), Threads(threads)
       {
       }
 
@@ -21,7 +24,7 @@ namespace Logic
       XFileSystem::~XFileSystem()
       {
          Catalogs.clear();
-         Files.clear();
+         Files.Clear();
       }
       
       // ------------------------------- STATIC METHODS -------------------------------
@@ -51,34 +54,39 @@ namespace Logic
          throw ArgumentException(HERE, L"f", L"Unknown XFolder constant");
       }
 
+      /// <summary>Reads all file declarations from a catalog</summary>
+      /// <param name="cat">The catalog</param>
+      /// <param name="output">Declarations, in the order they were declared</param>
+      /// <exception cref="Logic::FileNotFoundException">Catalog not found</exception>
+      /// <exception cref="Logic::IOException">I/O error occurred</exception>
+      void  XFileSystem::ReadCatalog(const XCatalog& cat, DeclarationArray& output)
+      {
+         CatalogReader  reader(cat.GetReader());
+         wstring        path;
+         DWORD          size;
+
+         // Iterate thru declarations. Calculate running offset
+         for (DWORD offset = 0; reader.ReadDeclaration(path, size); offset += size)
+            output.push_back(Declaration(path, size, offset));
+      }
+
 		// ------------------------------- PUBLIC METHODS -------------------------------
       
       /// <summary>Searches for all files within a known folder</summary>
       /// <param name="folder">Known folder</param>
-      /// <returns>Results collection</returns>
-      /// <exception cref="Logic::IOException">I/O error occurred</exception>
-      XFileList  XFileSystem::Browse(XFolder folder) const
+      /// <returns>View of files within the folder, ordered by path</returns>
+      /// <exception cref="Logic::ArgumentException">Unrecognised folder constant</exception>
+      XFileView  XFileSystem::Browse(XFolder folder) const
       {
          return Browse(GetFolder(folder));
       }
 
       /// <summary>Searches for all files within a folder</summary>
       /// <param name="folder">Full path of folder</param>
-      /// <returns>Results collection</returns>
-      /// <exception cref="Logic::IOException">I/O error occurred</exception>
-      XFileList  XFileSystem::Browse(Path  folder) const
+      /// <returns>View of files within the folder, ordered by path</returns>
+      XFileView  XFileSystem::Browse(Path  folder) const
       {
-         XFileList results;
-
-         // Ensure trailing backslash
-         folder = folder.AppendBackslash();
-
-         // Copy all files with exactly the same folder
-         for (auto pair : Files)
-            if (folder == pair.first.Folder)
-               results.push_back(pair.second);
-
-         return results;
+         return Files.Browse(folder);
       }
 
       /// <summary>Queries whether file system contains a file</summary>
@@ -86,7 +94,7 @@ namespace Logic
       /// <returns></returns>
       bool  XFileSystem::Contains(Path  path) const
       {
-         return Files.find(path) != Files.end();
+         return Files.Contains(path);
       }
 
       /// <summary>Enumerates and locks the catalogs and their contents.  Any previous contents are cleared.</summary>
@@ -105,7 +113,7 @@ namespace Logic
 
          // Clear previous
          Catalogs.clear();
-         Files.clear();
+         Files.Clear();
 
          // Ensure trailing backslash
          Folder = folder.AppendBackslash();
@@ -128,23 +136,16 @@ namespace Logic
          EnumerateFiles(data);
 
          // Return count
-         return Files.size();
+         return Files.Count;
       }
 
       /// <summary>Queries whether file system contains a file</summary>
       /// <param name="path">Full path EXCLUDING extension</param>
       /// <returns>File descriptor</returns>
       /// <exception cref="Logic::FileNotFoundException">File not found</exception>
-      XFileInfo XFileSystem::Find(Path  path) const
+      const XFileInfo&  XFileSystem::Find(Path  path) const
       {
-         auto it = Files.find(path);
-
-         // Error: file not found
-         if (it == Files.end())
-            throw FileNotFoundException(HERE, path);
-
-         // Return result 
-         return it->second;
+         return Files.Find(path);
       }
 
       /// <summary>Gets the full path of a known subfolder</summary>
@@ -183,7 +184,7 @@ namespace Logic
                   break;
                
                // Add to FRONT of list  [Ensure highest priority at the front]
-               Catalogs.Add(XCatalog(*this, path.RenameExtension(L".cat")));
+               Catalogs.Add(XCatalog(*this, path.RenameExtension(L".cat"), Backend));
             }
 
             if (Version != GameVersion::AlbionPrelude)
@@ -200,37 +201,46 @@ namespace Logic
       /// <exception cref="Logic::IOException">I/O error occurred</exception>
       DWORD  XFileSystem::EnumerateFiles(const WorkerData* data)
       {
-         // Iterate thru catalogs (Highest priority -> Lowest)
-         for (const XCatalog& cat : Catalogs)
-         {
-            wstring  path;
-            DWORD    size;
+         vector<DeclarationArray> declarations(Catalogs.Count);
+         WorkerPool               pool(Threads);
+         UINT                     index = 0;
 
-            try
-            {
-               // Feedback
-               Console << Cons::White << L"Reading catalog " << cat.FullPath << "...";
-               data->SendFeedback(ProgressType::Info, 2, VString(L"Reading catalog '%s'", cat.FullPath.c_str()));
-
-               // Iterate thru declarations + insert. Calculate running offset.  (Duplicate files are automatically discarded)
-               CatalogReader  reader(cat.GetReader());
-               for (DWORD offset = 0; reader.ReadDeclaration(path, size); offset += size)
-                  Files.Add( XFileInfo(*this, cat, path, size, offset) );
+         // Feedback
+         Console << Cons::White << L"Reading " << Catalogs.Count << L" catalogs...";
+         data->SendFeedback(ProgressType::Info, 2, VString(L"Reading %d catalogs", Catalogs.Count));
 
-               // Feedback
-               Console << Cons::Success << ENDL;
-            }
-            catch (ExceptionBase& e) {
-               Console << Cons::Failure << e.Message << ENDL;
-               throw;
+         try
+         {
+            // Read declarations of each catalog concurrently
+            for (const XCatalog& cat : Catalogs)
+            {
+               DeclarationArray* output = &declarations[index++];
+               pool.Add([&cat, output] { ReadCatalog(cat, *output); });
             }
+            pool.Run();
+
+            // Feedback
+            Console << Cons::Success << ENDL;
+         }
+         catch (ExceptionBase& e) {
+            Console << Cons::Failure << e.Message << ENDL;
+            throw;
          }
 
+         // Merge catalogs (Highest priority -> Lowest).  (Duplicate files are automatically discarded)
+         index = 0;
+         for (const XCatalog& cat : Catalogs)
+            for (const Declaration& d : declarations[index++])
+               Files.Add( XFileInfo(*this, cat, d.SubPath, d.Size, d.Offset) );
+
          // Enumerate physical files
          EnumerateFolder(Folder);
 
+         // Order files within each folder
+         Files.Sort();
+
          // Return count
-         return Files.size();
+         return Files.Count;
       }
 
       /// <summary>Enumerates physical files within the folder</summary>
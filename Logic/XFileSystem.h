@@ -2,6 +2,7 @@
 
 #include "XCatalog.h"
 #include "XFileInfo.h"
+#include "XFileIndex.h"
 #include "BackgroundWorker.h"
 
 namespace Logic
@@ -33,35 +34,24 @@ namespace Logic
             void  Add(XCatalog&& c)  { push_front(std::move(c)); }
          };
 
-         /// <summary>Collection of file descriptors</summary>
-         class FileCollection : public map<Path, XFileInfo>
+         /// <summary>File declaration read from a catalog</summary>
+         class Declaration
          {
          public:
-            // ---------------------- PROPERTIES -----------------------
-         
-            PROPERTY_GET(size_type,Count,size);
+            Declaration(const wstring& path, DWORD size, DWORD offset) : SubPath(path), Size(size), Offset(offset)
+            {}
 
-            // ----------------------- MUTATORS ------------------------
-         
-            /// <summary>Attempts to add a file to the collection, overwriting any of lower precedence</summary>
-            /// <param name="f">The file to add</param>
-            void  Add(const XFileInfo& f)
-            {
-               _Pairib res = insert(value_type(f.Key, f));
-
-               // Exists: Overwrite if higher precendence
-               if (!res.second && f.Precedence > res.first->second.Precedence)
-               {
-                  //res.first->second = f;
-                  erase(res.first);
-                  insert(value_type(f.Key, f));
-               }
-            }
+            wstring  SubPath;    // Path relative to game folder
+            DWORD    Size,       // Size in bytes
+                     Offset;     // Offset within data file
          };
 
+         /// <summary>File declarations of a catalog, in the order they were declared</summary>
+         typedef vector<Declaration>  DeclarationArray;
+
       public:
          // --------------------- CONSTRUCTION ----------------------
-         XFileSystem();
+         XFileSystem(CatalogBackend backend = CatalogBackend::Streamed, UINT threads = 0);
          virtual ~XFileSystem();
 
          // Prevent moving/copying
@@ -72,16 +62,20 @@ namespace Logic
       public:
          static Path  GetPath(Path folder, GameVersion ver, XFolder f);
 
+      private:
+         static void  ReadCatalog(const XCatalog& cat, DeclarationArray& output);
+
          // --------------------- PROPERTIES ------------------------
 
          // ---------------------- ACCESSORS ------------------------
       public:
-         XFileList    Browse(XFolder folder) const;
-         XFileList    Browse(Path folder) const;
+         XFileView    Browse(XFolder folder) const;
+         XFileView    Browse(Path folder) const;
          bool         Contains(Path path) const;
-         XFileInfo    Find(Path path) const;
+         const XFileInfo&  Find(Path path) const;
          Path         GetFolder(XFolder f) const;
          Path         GetFolder() const            { return Folder;  }
+         CatalogBackend GetBackend() const         { return Backend; }
          GameVersion  GetVersion() const           { return Version; }
 
 			// ----------------------- MUTATORS ------------------------
@@ -95,8 +89,10 @@ namespace Logic
          
          // -------------------- REPRESENTATION ---------------------
       private:
+         CatalogBackend     Backend;
+         UINT               Threads;
          CatalogCollection  Catalogs;
-         FileCollection     Files;
+         XFileIndex         Files;
          Path               Folder;
          GameVersion        Version;
       };
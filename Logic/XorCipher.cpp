@@ -0,0 +1,189 @@
+#include "stdafx.h"
+#include "XorCipher.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace Logic
+{
+   namespace IO
+   {
+      // -------------------------------- STATIC DATA  --------------------------------
+
+      /// <summary>Widest instruction set supported by the processor</summary>
+      const XorCipher::InstructionSet  XorCipher::Available = XorCipher::Detect();
+
+      // -------------------------------- CONSTRUCTION --------------------------------
+
+      // ------------------------------- STATIC METHODS -------------------------------
+
+      /// <summary>Encodes a buffer by XORing every byte with the same key</summary>
+      /// <param name="buffer">Buffer to encode</param>
+      /// <param name="length">Length of buffer</param>
+      /// <param name="key">Encoding key</param>
+      /// <exception cref="Logic::ArgumentNullException">Buffer is null</exception>
+      void  XorCipher::Encode(byte* buffer, DWORD length, byte key)
+      {
+         Encode(buffer, length, key, Available);
+      }
+
+      /// <summary>Encodes a buffer by XORing every byte with the same key, using a specific instruction set</summary>
+      /// <param name="buffer">Buffer to encode</param>
+      /// <param name="length">Length of buffer</param>
+      /// <param name="key">Encoding key</param>
+      /// <param name="set">Instruction set, must be supported by the processor</param>
+      /// <exception cref="Logic::ArgumentNullException">Buffer is null</exception>
+      void  XorCipher::Encode(byte* buffer, DWORD length, byte key, InstructionSet set)
+      {
+         REQUIRED(buffer);
+         DWORD i = 0;
+
+         switch (set)
+         {
+         // AVX2: Encode 32 bytes per step
+         case InstructionSet::AVX2:
+            {
+               const __m256i keys = _mm256_set1_epi8((char)key);
+               for (; i + 32 <= length; i += 32)
+               {
+                  __m256i* p = reinterpret_cast<__m256i*>(buffer + i);
+                  _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), keys));
+               }
+               _mm256_zeroupper();
+            }
+            // Fall through to encode remaining bytes
+
+         // SSE2: Encode 16 bytes per step
+         case InstructionSet::SSE2:
+            {
+               const __m128i keys = _mm_set1_epi8((char)key);
+               for (; i + 16 <= length; i += 16)
+               {
+                  __m128i* p = reinterpret_cast<__m128i*>(buffer + i);
+                  _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), keys));
+               }
+            }
+            break;
+         }
+
+         // Scalar: Encode remaining bytes
+         for (; i < length; i++)
+            buffer[i] ^= key;
+      }
+
+      /// <summary>Encodes a buffer by XORing each byte with a key that is incremented after every byte</summary>
+      /// <param name="buffer">Buffer to encode</param>
+      /// <param name="length">Length of buffer</param>
+      /// <param name="key">Key of first byte</param>
+      /// <exception cref="Logic::ArgumentNullException">Buffer is null</exception>
+      void  XorCipher::EncodeRolling(byte* buffer, DWORD length, byte key)
+      {
+         EncodeRolling(buffer, length, key, Available);
+      }
+
+      /// <summary>Encodes a buffer by XORing each byte with a key that is incremented after every byte, using a specific instruction set</summary>
+      /// <param name="buffer">Buffer to encode</param>
+      /// <param name="length">Length of buffer</param>
+      /// <param name="key">Key of first byte</param>
+      /// <param name="set">Instruction set, must be supported by the processor</param>
+      /// <exception cref="Logic::ArgumentNullException">Buffer is null</exception>
+      void  XorCipher::EncodeRolling(byte* buffer, DWORD length, byte key, InstructionSet set)
+      {
+         REQUIRED(buffer);
+         DWORD i = 0;
+
+         switch (set)
+         {
+         // AVX2: Encode 32 bytes per step.  Keys wrap modulo 256 because additions are per-byte
+         case InstructionSet::AVX2:
+            {
+               __m256i keys = _mm256_add_epi8(_mm256_set1_epi8((char)key),
+                                              _mm256_setr_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15,
+                                                               16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31));
+               const __m256i step = _mm256_set1_epi8(32);
+
+               for (; i + 32 <= length; i += 32, key += 32)
+               {
+                  __m256i* p = reinterpret_cast<__m256i*>(buffer + i);
+                  _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), keys));
+                  keys = _mm256_add_epi8(keys, step);
+               }
+               _mm256_zeroupper();
+            }
+            // Fall through to encode remaining bytes
+
+         // SSE2: Encode 16 bytes per step
+         case InstructionSet::SSE2:
+            {
+               __m128i keys = _mm_add_epi8(_mm_set1_epi8((char)key),
+                                           _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+               const __m128i step = _mm_set1_epi8(16);
+
+               for (; i + 16 <= length; i += 16, key += 16)
+               {
+                  __m128i* p = reinterpret_cast<__m128i*>(buffer + i);
+                  _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), keys));
+                  keys = _mm_add_epi8(keys, step);
+               }
+            }
+            break;
+         }
+
+         // Scalar: Encode remaining bytes
+         for (; i < length; i++)
+            buffer[i] ^= key++;
+      }
+
+      /// <summary>Get instruction set name.</summary>
+      /// <param name="set">instruction set.</param>
+      /// <returns></returns>
+      /// <exception cref="Logic::ArgumentException">Unrecognised instruction set</exception>
+      wstring  XorCipher::GetString(InstructionSet set)
+      {
+         switch (set)
+         {
+         case InstructionSet::Scalar:  return L"Scalar";
+         case InstructionSet::SSE2:    return L"SSE2";
+         case InstructionSet::AVX2:    return L"AVX2";
+         }
+         throw ArgumentException(HERE, L"set", VString(L"Unrecognised instruction set: %d", set));
+      }
+
+      /// <summary>Detects the widest instruction set supported by the processor and operating system</summary>
+      /// <returns></returns>
+      XorCipher::InstructionSet  XorCipher::Detect()
+      {
+         int info[4] = {0};
+
+         // Query highest function + feature flags
+         __cpuid(info, 0);
+         if (info[0] < 1)
+            return InstructionSet::Scalar;
+
+         __cpuid(info, 1);
+         bool sse2 = (info[3] & (1 << 26)) != 0,
+              osxsave = (info[2] & (1 << 27)) != 0,
+              avx = (info[2] & (1 << 28)) != 0,
+              avx2 = false;
+
+         // AVX2: Requires OS support for saving YMM registers
+         if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+         {
+            __cpuid(info, 0);
+            if (info[0] >= 7)
+            {
+               __cpuidex(info, 7, 0);
+               avx2 = (info[1] & (1 << 5)) != 0;
+            }
+         }
+
+         return avx2 ? InstructionSet::AVX2 : sse2 ? InstructionSet::SSE2 : InstructionSet::Scalar;
+      }
+
+      // ------------------------------- PUBLIC METHODS -------------------------------
+
+		// ------------------------------ PROTECTED METHODS -----------------------------
+
+		// ------------------------------- PRIVATE METHODS ------------------------------
+
+   }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Logic
+{
+   namespace IO
+   {
+
+      /// <summary>Provides the XOR encoding kernels used by the catalog, data-file and encrypted file streams</summary>
+      /// <remarks>The widest instruction set supported by the processor is detected once at start-up, callers may
+      /// request a narrower one for testing purposes</remarks>
+      class LogicExport XorCipher
+      {
+         // ------------------------ TYPES --------------------------
+      public:
+         /// <summary>Defines the instruction sets available to the encoding kernels</summary>
+         enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+         // --------------------- CONSTRUCTION ----------------------
+      private:
+         XorCipher();
+
+         // ------------------------ STATIC -------------------------
+      public:
+         static const InstructionSet  Available;
+
+         static void  Encode(byte* buffer, DWORD length, byte key);
+         static void  Encode(byte* buffer, DWORD length, byte key, InstructionSet set);
+         static void  EncodeRolling(byte* buffer, DWORD length, byte key);
+         static void  EncodeRolling(byte* buffer, DWORD length, byte key, InstructionSet set);
+         static wstring  GetString(InstructionSet set);
+
+      private:
+         static InstructionSet  Detect();
+      };
+
+   }
+}
+
+using namespace Logic::IO;
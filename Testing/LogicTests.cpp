@@ -1,28 +1,51 @@
 ﻿#include "stdafx.h"
 #include "LogicTests.h"
 #include "../Logic/ScriptFile.h"
+#include "../Logic/BackupStore.h"
+#include "../Logic/BackupFileReader.h"
+#include "../Logic/BackupFileWriter.h"
+#include "../Logic/XFileInfo.h"
 #include "../Logic/ScriptParser.h"
+#include "../Logic/ParseSession.h"
 #include "../Logic/FileStream.h"
 #include "../Logic/CatalogStream.h"
 #include "../Logic/GZipStream.h"
 #include "../Logic/StringReader.h"
 #include "../Logic/LanguageFileReader.h"
+#include "../Logic/LanguageStreamReader.h"
 #include "../Logic/XFileSystem.h"
 #include "../Logic/LegacySyntaxFileReader.h"
 #include "../Logic/SyntaxLibrary.h"
+#include "../Logic/SyntaxTree.h"
 #include "../Logic/ScriptFileReader.h"
+#include "../Logic/ScriptCallCache.h"
+#include "../Logic/SearchIndex.h"
+#include "../Logic/SearchPattern.h"
+#include "../Logic/SearchWorker.h"
+#include "../Logic/FileSearch.h"
 #include "../Logic/StringLibrary.h"
 #include "../Logic/XmlWriter.h"
 #include "../Logic/SyntaxFileWriter.h"
 #include "../Logic/ExpressionParser.h"
+#include "../Logic/CommandIdentifier.h"
 #include "../Logic/CommandLexer.h"
+#include "../Logic/TokenBuffer.h"
 #include "../Logic/TWare.h"
 #include "../Logic/TLaser.h"
 #include "../Logic/TreeTraversal.h"
 #include "../Logic/StringResolver.h"
 #include "../Logic/RichStringParser.h"
 #include "../Logic/DescriptionFileReader.h"
+#include "../Logic/ScriptObjectLibrary.h"
+#include "../Logic/GameObjectLibrary.h"
+#include "../Logic/DescriptionLibrary.h"
+#include "../Logic/Stopwatch.h"
+#include "../Logic/XorCipher.h"
+#include "../Logic/XFileIndex.h"
+#include "../Logic/GameDataSnapshot.h"
+#include "../Logic/WorkerPool.h"
 #include "../DTL/dtl.hpp"
+#include <random>
 #include "ScriptValidator.h"
 
 namespace Testing
@@ -49,7 +72,9 @@ namespace Testing
 
       //Test_LanguageFileReader();
       //Test_LanguageEditRegEx();
+      //Test_LanguageStreamReader();
       //Test_CatalogReader();
+      //Test_CatalogEnumeration();
       //Test_GZip_Decompress();
       //Test_FileSystem();
       //Test_CommandSyntax();
@@ -61,6 +86,26 @@ namespace Testing
       //Text_RegEx();
       //Test_Iterator();
       //BatchTest_ScriptCompiler();
+      //Benchmark_BackupStore();
+      //Benchmark_FileIndex();
+      //Benchmark_GameDataLoad();
+      //Benchmark_GameDataSnapshot();
+      //Benchmark_IncrementalParse();
+      //Benchmark_LanguageFiles();
+      //Benchmark_Lexer();
+      //Benchmark_LineIdentification();
+      //Benchmark_NodeArena();
+      //Benchmark_ScriptCallCache();
+      //Benchmark_ScriptReader();
+      //Benchmark_ScriptTextReader();
+      //Benchmark_SearchIndex();
+      //Benchmark_SearchPattern();
+      //Benchmark_SearchWorker();
+      //Benchmark_StringLookup();
+      //Benchmark_StringResolver();
+      //Benchmark_SyntaxAutomaton();
+      //Benchmark_TreePasses();
+      //Benchmark_XorCipher();
       //Test_Lexer();
 
       //theApp.WriteString(L"example", L"writeString");
@@ -201,6 +246,1951 @@ namespace Testing
       Console << Cons::Yellow << "Validated " << count << " of " << total << " scripts..." << ENDL;
    }
 
+   void LogicTests::Benchmark_BackupStore()
+   {
+      const UINT  count = 500,      // Number of revisions
+                  sample = 10;      // Number of commits averaged
+      Path        store, legacy, migrated;
+
+      try
+      {
+         WCHAR temp[MAX_PATH];
+         GetTempPath(MAX_PATH, temp);
+         store = Path(temp) + L"XStudio2.BackupBenchmark.bak";
+         legacy = Path(temp) + L"XStudio2.BackupBenchmark.zip";
+         migrated = Path(temp) + L"XStudio2.BackupBenchmark.migrated.zip";
+         DeleteFile(store.c_str());
+         Console << Cons::Heading << L"Benchmarking backup store of " << count << L" revisions" << ENDL;
+
+         // Fixture: Script of 400 lines, a few of which are inserted, removed or modified by each revision
+         mt19937 rng(42);
+         vector<wstring> lines;
+         for (UINT i = 0; i < 400; ++i)
+            lines.push_back(VString(L"%03d: $ship = [THIS] -> get ship by index %d     * step %d", i, rng() % 1000, i));
+
+         vector<ScriptRevision> revisions;     // Oldest first
+         for (UINT rev = 0; rev < count; ++rev)
+         {
+            for (UINT edits = rng() % 5; edits > 0; --edits)
+            {
+               UINT at = rng() % lines.size();
+               switch (rng() % 3)
+               {
+               case 0: lines.insert(lines.begin() + at, VString(L"$count = $count + %d", rng() % 100)); break;
+               case 1: if (lines.size() > 1) lines.erase(lines.begin() + at); break;
+               case 2: lines[at] += L" modified"; break;
+               }
+            }
+
+            ScriptRevision r;
+            r.Title = VString(L"Revision %d", rev);
+            r.FullPath = L"benchmark.xml";
+            r.Date = COleDateTime::GetCurrentTime();
+            r.ScriptName = L"benchmark";
+            r.Game = GameVersion::TerranConflict;
+            r.CommandID = 0;
+            r.Version = rev;
+            for (UINT i = 0; i < lines.size(); ++i)
+               r.Content += (i > 0 ? L"\n" : L"") + lines[i];
+            revisions.push_back(r);
+         }
+
+         // Delta: Append every revision
+         BackupStore delta(store);
+         vector<double> latency;
+         for (auto& r : revisions)
+         {
+            Stopwatch sw;
+            delta.Commit(r);
+            latency.push_back(sw.ElapsedMilliseconds);
+         }
+
+         // Legacy: Write all but the final revisions, then time each remaining commit as load + insert + rewrite
+         auto writeLegacy = [&legacy](const BackupFile& b)
+         {
+            BackupFileWriter w(XFileInfo(legacy).OpenWrite(L"revisions.xml"));
+            w.WriteFile(b);
+            w.Close();
+         };
+
+         BackupFile initial(BackupType::MSCI);
+         for (UINT i = 0; i < count - sample; ++i)
+            initial.Revisions.Commit(revisions[i]);
+         writeLegacy(initial);
+
+         double legacyCommit = 0;
+         for (UINT i = count - sample; i < count; ++i)
+         {
+            Stopwatch sw;
+            auto b = BackupFileReader(XFileInfo(legacy).OpenRead()).ReadFile();
+            b.Revisions.Commit(revisions[i]);
+            writeLegacy(b);
+            legacyCommit += sw.ElapsedMilliseconds;
+         }
+
+         // Migrate: Convert a copy of the legacy file
+         if (!CopyFile(legacy.c_str(), migrated.c_str(), FALSE))
+            throw Win32Exception(HERE, L"Unable to copy legacy backup file");
+
+         Stopwatch sw;
+         BackupStore conversion(migrated);
+         conversion.Write(conversion.ReadFile());
+         double migrate = sw.ElapsedMilliseconds;
+
+         // Verify: Replay every revision of both stores
+         bool identical = delta.Count == count && conversion.Count == count;
+         for (auto backup : { delta.ReadFile(), conversion.ReadFile() })
+         {
+            UINT i = count;
+            for (auto& r : backup.Revisions)
+            {
+               auto& expected = revisions[--i];
+               identical &= (r.Title == expected.Title && r.Content == expected.Content && r.Version == expected.Version);
+            }
+         }
+
+         // Random access: Replay from nearest keyframe
+         UINT reads = 0;
+         sw.Restart();
+         for (UINT index = 0; index < count; index += 7, ++reads)
+            identical &= (delta.Read(index).Content == revisions[count - 1 - index].Content);
+         double access = sw.ElapsedMilliseconds / reads;
+
+         // Sizes
+         WIN32_FILE_ATTRIBUTE_DATA deltaAttr, legacyAttr;
+         GetFileAttributesEx(store.c_str(), GetFileExInfoStandard, &deltaAttr);
+         GetFileAttributesEx(legacy.c_str(), GetFileExInfoStandard, &legacyAttr);
+
+         // Interrupted commit: Append a record header whose payload never reached the disk
+         {
+            const DWORD header[2] = { 64, 0x12345678 };
+            const BYTE  payload[64] = { 0 };
+            FileStream fs(store, FileMode::OpenExisting, FileAccess::Write);
+            fs.Seek(0, SeekOrigin::End);
+            fs.Write(reinterpret_cast<const BYTE*>(header), sizeof(header));
+            fs.Write(payload, sizeof(payload));
+         }
+         identical &= (delta.Count == count);
+         delta.Commit(revisions.back());
+         identical &= (delta.Count == count + 1 && delta.Read(0).Content == revisions.back().Content);
+
+         UINT text = 0;
+         for (auto& r : revisions)
+            text += r.Content.length() * sizeof(WCHAR);
+
+         double first = 0, last = 0;
+         for (UINT i = 0; i < sample; ++i)
+         {
+            first += latency[i] / sample;
+            last += latency[count - sample + i] / sample;
+         }
+
+         Console << Cons::Yellow << VString(L"Delta commit:  first %d %.2fms  last %d %.2fms", sample, first, sample, last) << ENDL;
+         Console << Cons::Yellow << VString(L"Legacy commit: last %d %.2fms", sample, legacyCommit / sample) << ENDL;
+         Console << Cons::Yellow << VString(L"Size:          delta %d KB  legacy %d KB  text %d KB", deltaAttr.nFileSizeLow / 1024, legacyAttr.nFileSizeLow / 1024, text / 1024) << ENDL;
+         Console << Cons::Yellow << VString(L"Read:          %.2fms per revision", access) << ENDL;
+         Console << Cons::Yellow << VString(L"Migration:     %.0fms", migrate) << ENDL;
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark backup store");
+      }
+
+      // Cleanup
+      DeleteFile(store.c_str());
+      DeleteFile(legacy.c_str());
+      DeleteFile(migrated.c_str());
+   }
+
+   void LogicTests::Benchmark_FileIndex()
+   {
+      const UINT  folders = 50,
+                  files = 1000;     // 50k synthetic entries
+      vector<Path>           keys;
+      map<Path, XFileInfo>   baseline;
+      XFileIndex             index;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking file index using " << folders*files << L" synthetic entries" << ENDL;
+
+         // Generate paths.  Vary case of folders to exercise case-folding
+         for (UINT f = 0; f < folders; ++f)
+            for (UINT i = 0; i < files; ++i)
+               keys.push_back(VString(f % 2 ? L"C:\\X3\\Folder%02d\\File%05d" : L"C:\\X3\\FOLDER%02d\\file%05d", f, i));
+
+         // Populate both collections
+         Stopwatch sw;
+         for (const Path& k : keys)
+            baseline.insert(make_pair(k, XFileInfo(k + L".xml")));
+         double mapAdd = sw.ElapsedMilliseconds;
+
+         sw.Restart();
+         for (const Path& k : keys)
+            index.Add(XFileInfo(k + L".xml"));
+         index.Sort();
+         double indexAdd = sw.ElapsedMilliseconds;
+
+         // Find: every key, using opposite case
+         UINT found = 0;
+         sw.Restart();
+         for (const Path& k : keys)
+            found += baseline.find(GuiString(k.c_str()).ToUpper())->second.Length;
+         double mapFind = sw.ElapsedMilliseconds;
+
+         sw.Restart();
+         for (const Path& k : keys)
+            found += index.Find(GuiString(k.c_str()).ToUpper()).Length;
+         double indexFind = sw.ElapsedMilliseconds;
+
+         // Contains: every key plus an equal number of missing keys
+         UINT hits[2] = {0, 0};
+         sw.Restart();
+         for (const Path& k : keys)
+            hits[0] += (baseline.find(k) != baseline.end() ? 1 : 0) + (baseline.find(k + L"x") != baseline.end() ? 1 : 0);
+         double mapContains = sw.ElapsedMilliseconds;
+
+         sw.Restart();
+         for (const Path& k : keys)
+            hits[1] += (index.Contains(k) ? 1 : 0) + (index.Contains(k + L"x") ? 1 : 0);
+         double indexContains = sw.ElapsedMilliseconds;
+
+         // Browse: every folder.  Baseline scans the entire collection and copies each match, as XFileSystem did
+         UINT browsed[2] = {0, 0};
+         sw.Restart();
+         for (UINT f = 0; f < folders; ++f)
+         {
+            Path folder(VString(L"C:\\X3\\Folder%02d\\", f));
+            XFileList results;
+            for (auto pair : baseline)
+               if (folder == pair.first.Folder)
+                  results.push_back(pair.second);
+            browsed[0] += results.size();
+         }
+         double mapBrowse = sw.ElapsedMilliseconds;
+
+         sw.Restart();
+         for (UINT f = 0; f < folders; ++f)
+            browsed[1] += index.Browse(VString(L"C:\\X3\\Folder%02d\\", f)).size();
+         double indexBrowse = sw.ElapsedMilliseconds;
+
+         // Feedback
+         bool valid = index.Count == keys.size() && hits[0] == keys.size() && hits[1] == keys.size() 
+                   && browsed[0] == keys.size() && browsed[1] == keys.size();
+
+         Console << Cons::Yellow << L"Add:      " << Cons::White << VString(L"map %.1fms  index %.1fms", mapAdd, indexAdd) << ENDL;
+         Console << Cons::Yellow << L"Find:     " << Cons::White << VString(L"map %.1fms  index %.1fms", mapFind, indexFind) << ENDL;
+         Console << Cons::Yellow << L"Contains: " << Cons::White << VString(L"map %.1fms  index %.1fms", mapContains, indexContains) << ENDL;
+         Console << Cons::Yellow << L"Browse:   " << Cons::White << VString(L"map %.1fms  index %.1fms", mapBrowse, indexBrowse) << ENDL;
+         Console << L"Results identical: " << (valid ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark file index");
+      }
+   }
+
+   /// <summary>Game data used by a benchmark, which is unloaded when the fixture is destroyed</summary>
+   class GameDataFixture
+   {
+   public:
+      /// <summary>Creates an empty fixture</summary>
+      /// <param name="backend">Catalog backend.</param>
+      GameDataFixture(CatalogBackend backend = CatalogBackend::Streamed) : Data(Operation::NoFeedback), VFS(backend)
+      {}
+
+      /// <summary>Unloads game data</summary>
+      ~GameDataFixture()
+      {
+         Clear();
+      }
+
+      NO_COPY(GameDataFixture);	// No copy semantics
+      NO_MOVE(GameDataFixture);	// No move semantics
+
+      /// <summary>Unloads the libraries, and any script-calls resolved using them</summary>
+      void  Clear()
+      {
+         ScriptCallLib.Clear();
+         StringLib.Clear();
+         ScriptObjectLib.Clear();
+         GameObjectLib.Clear();
+         DescriptionLib.Clear();
+         SyntaxLib.Clear();
+      }
+
+      /// <summary>Builds the VFS and loads the libraries using the same stages as GameDataWorker::ThreadMain</summary>
+      /// <param name="descriptions">Whether to load command descriptions.</param>
+      void  Load(bool descriptions = false)
+      {
+         VFS.Enumerate(PrefsLib.GameDataFolder, PrefsLib.GameDataVersion, &Data);
+         StringLib.Enumerate(VFS, PrefsLib.GameDataLanguage, &Data);
+         ScriptObjectLib.Enumerate(&Data);
+         GameObjectLib.Enumerate(VFS, &Data);
+         if (descriptions)
+            DescriptionLib.Enumerate(&Data);
+         SyntaxLib.Enumerate(&Data);
+      }
+
+      WorkerData   Data;    // Worker data, without feedback
+      XFileSystem  VFS;     // Game data file system
+   };
+
+   /// <summary>Loads and unloads game data using the same stages as GameDataWorker::ThreadMain</summary>
+   /// <param name="backend">Catalog backend.</param>
+   /// <returns>Load time in milliseconds</returns>
+   double  LoadGameData(CatalogBackend backend)
+   {
+      Stopwatch sw;
+      {
+         GameDataFixture game(backend);
+         game.Load(true);
+      }
+      return sw.ElapsedMilliseconds;
+   }
+
+   void LogicTests::Benchmark_GameDataLoad()
+   {
+      const CatalogBackend backends[2] = { CatalogBackend::Streamed, CatalogBackend::Mapped };
+      const wchar*         names[2] = { L"Streamed", L"Mapped" };
+      
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking game data load from " << PrefsLib.GameDataFolder << ENDL;
+         Console << L"(Cold = first load using each backend, the OS file cache is not flushed)" << ENDL;
+
+         // Load game data using each backend: once cold, three times warm
+         for (int i = 0; i < 2; ++i)
+         {
+            double cold = LoadGameData(backends[i]), 
+                   warm = 0;
+
+            for (int pass = 0; pass < 3; ++pass)
+               warm += LoadGameData(backends[i]);
+
+            Console << Cons::Yellow << names[i] << Cons::White 
+                    << VString(L": cold %.0fms  warm %.0fms (avg of 3)", cold, warm / 3) << ENDL;
+         }
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark game data load");
+      }
+   }
+
+
+   void LogicTests::Benchmark_GameDataSnapshot()
+   {
+      WorkerData  data(Operation::NoFeedback);
+      XFileSystem vfs;
+      TempPath    tmp(L"gds");
+
+      try
+      {
+         GameDataSnapshot snapshot(tmp.RenameExtension(L".snapshot"));
+
+         Console << Cons::Heading << L"Benchmarking game data snapshot using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Build VFS + key  (Required with or without snapshot)
+         Stopwatch sw;
+         vfs.Enumerate(PrefsLib.GameDataFolder, PrefsLib.GameDataVersion, &data);
+         DWORD64 key = GameDataSnapshot::GetKey(vfs, PrefsLib.GameDataLanguage);
+         double common = sw.ElapsedMilliseconds;
+
+         // Without snapshot: Parse language/syntax files, generate script objects
+         sw.Restart();
+         StringLib.Enumerate(vfs, PrefsLib.GameDataLanguage, &data);
+         ScriptObjectLib.Enumerate(&data);
+         SyntaxLib.Enumerate(&data);
+         double parsed = sw.ElapsedMilliseconds;
+
+         UINT files = StringLib.Files.size(), 
+              objects = ScriptObjectLib.Count;
+         
+         // Generate snapshot
+         sw.Restart();
+         snapshot.Save(key, &data);
+         double saved = sw.ElapsedMilliseconds;
+
+         StringLib.Clear();
+         ScriptObjectLib.Clear();
+         SyntaxLib.Clear();
+
+         // With snapshot
+         sw.Restart();
+         bool loaded = snapshot.Load(key, &data);
+         double restored = sw.ElapsedMilliseconds;
+
+         // Stale key must be rejected
+         bool valid = loaded && files == StringLib.Files.size() && objects == ScriptObjectLib.Count;
+         StringLib.Clear();
+         ScriptObjectLib.Clear();
+         SyntaxLib.Clear();
+         valid &= !snapshot.Load(key+1, &data);
+
+         // Feedback
+         Console << Cons::Yellow << L"File system + key: " << Cons::White << VString(L"%.0fms", common) << ENDL;
+         Console << Cons::Yellow << L"Without snapshot:  " << Cons::White << VString(L"%.0fms", parsed) << ENDL;
+         Console << Cons::Yellow << L"Save snapshot:     " << Cons::White << VString(L"%.0fms", saved) << ENDL;
+         Console << Cons::Yellow << L"With snapshot:     " << Cons::White << VString(L"%.0fms", restored) << ENDL;
+         Console << L"Snapshot contents identical: " << (valid ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark game data snapshot");
+      }
+
+      // Cleanup
+      StringLib.Clear();
+      ScriptObjectLib.Clear();
+      SyntaxLib.Clear();
+      DeleteFile(tmp.c_str());
+      DeleteFile(tmp.RenameExtension(L".snapshot").c_str());
+   }
+
+   /// <summary>Writes a synthetic english language file</summary>
+   /// <param name="folder">Language folder.</param>
+   /// <param name="id">File ID.</param>
+   /// <param name="pages">Number of pages.</param>
+   /// <param name="strings">Number of strings per page.</param>
+   void  WriteTestLanguageFile(Path folder, UINT id, UINT pages, UINT strings)
+   {
+      wstring xml = L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n<language id=\"44\">\r\n";
+
+      // Generate pages: Each string references the previous
+      for (UINT p = 0; p < pages; ++p)
+      {
+         xml += GuiString::Format(L"<page id=\"35%04d\" title=\"Page %d\" descr=\"Synthetic page\">\r\n", id*10 + p, p);
+         for (UINT s = 1; s <= strings; ++s)
+            xml += GuiString::Format(L"<t id=\"%d\">String %d of page %d%s</t>\r\n", s, s, p, s > 1 ? GuiString::Format(L" {%d,%d}", id*10 + p, s-1).c_str() : L"");
+         xml += L"</page>\r\n";
+      }
+      xml += L"</language>";
+
+      // Write as UTF-8
+      string utf = GuiString::Convert(xml, CP_UTF8);
+      StreamPtr fs(new FileStream(folder + GuiString::Format(L"%04d-L044.xml", id), FileMode::CreateAlways, FileAccess::Write));
+      fs->Write((const BYTE*)utf.c_str(), utf.length());
+      fs->Close();
+   }
+
+   /// <summary>Summarises the nodes and errors of a parse, for comparison</summary>
+   /// <param name="p">The parser</param>
+   /// <returns>One entry per node and error</returns>
+   vector<wstring>  SummariseParse(const ScriptParser& p)
+   {
+      vector<wstring> summary;
+
+      for (const CommandNodePtr& n : p.ToList())
+         summary.push_back(VString(L"%d: id=%d params=%d depth=%d", n->LineNumber, n->Syntax.ID, n->Parameters.size(), n->Depth));
+
+      for (const ErrorToken& e : p.Errors)
+         summary.push_back(VString(L"%d: %s (%d,%d)", e.Line, e.Message.c_str(), e.Start, e.End));
+
+      return summary;
+   }
+
+   void LogicTests::Benchmark_IncrementalParse()
+   {
+      const UINT  blocks = 400,     // Size of synthetic script
+                  edits = 100;      // Number of single character edits
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking incremental line reading (structuring + verification remain whole-tree) using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Generate script
+         LineArray lines;
+         for (UINT i = 0; i < blocks; ++i)
+         {
+            lines.push_back(VString(L"$count%d = 0", i));
+            lines.push_back(VString(L"while $count%d < 100", i));
+            lines.push_back(VString(L"* Iteration %d", i));
+            lines.push_back(VString(L"$count%d = $count%d + 1", i, i));
+            lines.push_back(VString(L"if $count%d == 50", i));
+            lines.push_back(VString(L"$result%d = wait 100 ms", i));
+            lines.push_back(VString(L"write to log file 9000 append=[TRUE] value=$count%d", i));
+            lines.push_back(L"end");
+            lines.push_back(L"end");
+         }
+         lines.push_back(L"return null");
+
+         // Initial parse populates the session
+         ScriptFile   full(L""), incremental(L"");
+         ParseSession session;
+         Stopwatch sw;
+         session.Parse(incremental, lines, PrefsLib.GameDataVersion);
+         double initial = sw.ElapsedMilliseconds;
+
+         // Simulate typing: Insert one character at a time, re-parsing after each
+         double before = 0, after = 0;
+         UINT   reparsed = 0;
+         bool   identical = true;
+         mt19937 random(42);
+         for (UINT i = 0; i < edits; ++i)
+         {
+            wstring& line = lines[random() % (lines.size()-1)];
+            line.insert(random() % (line.size()+1), 1, L'x');
+
+            // Before: Parse every line
+            sw.Restart();
+            ScriptParser parser(full, lines, PrefsLib.GameDataVersion);
+            before += sw.ElapsedMilliseconds;
+
+            // After: Parse changed lines
+            sw.Restart();
+            ScriptParser& cached = session.Parse(incremental, lines, PrefsLib.GameDataVersion);
+            after += sw.ElapsedMilliseconds;
+            reparsed += session.Reparsed;
+
+            identical &= (SummariseParse(parser) == SummariseParse(cached));
+         }
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d edits to a %d line script, %.1f lines reparsed per edit", edits, lines.size(), reparsed / (double)edits) << ENDL;
+         Console << Cons::Yellow << L"Initial session parse: " << Cons::White << VString(L"%.0fms", initial) << ENDL;
+         Console << Cons::Yellow << L"Full parse:            " << Cons::White << VString(L"%.1fms per edit", before / edits) << ENDL;
+         Console << Cons::Yellow << L"Incremental parse:     " << Cons::White << VString(L"%.1fms per edit  speedup x%.1f", after / edits, before / max(after, 0.001)) << ENDL;
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark incremental parsing");
+      }
+   }
+
+   void LogicTests::Benchmark_LanguageFiles()
+   {
+      const UINT  count = 200;      // Number of synthetic files
+      WorkerData  data(Operation::NoFeedback);
+      TempPath    tmp(L"lng");
+      Path        folder = tmp.ToString() + L"-vfs\";
+      
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking language file parsing using " << folder << ENDL;
+
+         // Generate fixture: Game folder containing language files only
+         CreateDirectory(folder.c_str(), nullptr);
+         CreateDirectory((folder + L"t\").c_str(), nullptr);
+         for (UINT id = 1; id <= count; ++id)
+            WriteTestLanguageFile(folder + L"t\", id, 4, 250);
+
+         XFileSystem vfs;
+         vfs.Enumerate(folder, GameVersion::TerranConflict, &data);
+
+         // Parse serially for reference
+         Stopwatch sw;
+         UINT   files = StringLib.Enumerate(vfs, GameLanguage::English, &data, 1);
+         double serial = sw.ElapsedMilliseconds;
+         bool   valid = files == count;
+         
+         Console << Cons::Yellow << L"1 thread: " << Cons::White << VString(L"%.0fms", serial) << ENDL;
+
+         // Parse using increasing number of threads, up to one per core
+         for (UINT threads = 2, cores = WorkerPool::GetProcessorCount(); threads <= cores; threads = (threads < cores ? min(threads*2, cores) : threads+1))
+         {
+            sw.Restart();
+            valid &= StringLib.Enumerate(vfs, GameLanguage::English, &data, threads) == count;
+            double parallel = sw.ElapsedMilliseconds;
+
+            Console << Cons::Yellow << threads << L" threads: " << Cons::White 
+                    << VString(L"%.0fms  speedup x%.2f", parallel, serial / max(parallel, 1.0)) << ENDL;
+         }
+         
+         // Verify a string from the highest file ID
+         valid &= StringLib.Find(count*10 + 3, 7).Text == VString(L"String 7 of page 3 {%d,6}", count*10 + 3);
+         Console << L"Results identical: " << (valid ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark language file parsing");
+      }
+
+      // Cleanup
+      StringLib.Clear();
+      for (UINT id = 1; id <= count; ++id)
+         DeleteFile((folder + GuiString::Format(L"t\\%04d-L044.xml", id)).c_str());
+      RemoveDirectory((folder + L"t\\").c_str());
+      RemoveDirectory(folder.c_str());
+      DeleteFile(tmp.c_str());
+   }
+
+   /// <summary>Resolves a string using the previous regular expression based algorithm, without memoization</summary>
+   /// <param name="str">The string.</param>
+   /// <returns>Resolved text</returns>
+   wstring  RegexResolve(const LanguageString& str)
+   {
+      static const wregex FullMarker(L"\\{(\\d+),(\\d+)\\}"),
+                          DefaultMarker(L"\\{(\\d+)\\}"),
+                          RemoveComment(L"\\([^()\\\\]+\\)");
+      const LanguageString* ref;
+      wstring  txt = str.Text, r;
+      wsmatch  match;
+      UINT     pos;
+
+      if (txt.find_first_of(L"{()}") == wstring::npos)
+         return txt;
+
+      // Replace {aaa,bbb} then {aaa} markers
+      for (pos = 0; regex_search(txt.cbegin()+pos, txt.cend(), match, FullMarker); txt.replace(match[0].first, match[0].second, r))
+      {
+         r = StringLib.TryFind(_wtoi(match[1].str().c_str()), _wtoi(match[2].str().c_str()), ref) ? RegexResolve(*ref) : match[0].str();
+         pos = (match[0].first - txt.cbegin()) + r.length();
+      }
+      for (pos = 0; regex_search(txt.cbegin()+pos, txt.cend(), match, DefaultMarker); txt.replace(match[0].first, match[0].second, r))
+      {
+         r = StringLib.TryFind(str.Page, _wtoi(match[1].str().c_str()), ref) ? RegexResolve(*ref) : match[0].str();
+         pos = (match[0].first - txt.cbegin()) + r.length();
+      }
+
+      // Remove comments, de-escape brackets
+      while (regex_search(txt.cbegin(), txt.cend(), match, RemoveComment))
+         txt.erase(match[0].first, match[0].second);
+
+      for (auto chr : {L"\\(", L"\\)", L"\\{", L"\\}", L"\\[", L"\\]"})
+         for (auto p = txt.find(chr); p != wstring::npos; p = txt.find(chr))
+            txt.erase(p, 1);
+
+      return txt;
+   }
+
+   void LogicTests::Benchmark_Lexer()
+   {
+      const UINT  blocks = 5000,    // Size of synthetic corpus
+                  passes = 5;       // Number of times corpus is lexed
+      
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking command lexer using a synthetic corpus" << ENDL;
+
+         // Generate corpus  [Covers every token type]
+         LineArray lines;
+         for (UINT i = 0; i < blocks; ++i)
+         {
+            lines.push_back(VString(L"$ship%d = [THIS] -> get environment", i));
+            lines.push_back(VString(L"* Iteration %d: inspect the ship's sector", i));
+            lines.push_back(VString(L"if not $ship%d -> exists AND $count%d != -%d", i, i, i));
+            lines.push_back(VString(L"$name%d = 'Ship \\'%d\\'' + {SS_WARE_ENERGY}", i, i));
+            lines.push_back(VString(L"skip if $ship%d == null OR ($count%d MOD 3) >= 2", i, i));
+            lines.push_back(VString(L"gosub Label%d:", i));
+            lines.push_back(VString(L"$result%d = [PLAYERSHIP] -> call script 'lib.test' : value=$count%d flag=[TRUE]", i, i));
+            lines.push_back(L"end");
+         }
+
+         // Before: Allocate text for each token
+         Stopwatch sw;
+         UINT   before = 0, shared = 0, after = 0;
+         for (UINT p = 0; p < passes; ++p)
+            for (const wstring& line : lines)
+            {
+               CommandLexer lex(line, false);
+               before += lex.Tokens.size();
+            }
+         double lexer = sw.ElapsedMilliseconds;
+
+         // Shared: Allocate text for each token, lexing every line with one buffer  [As the script parser does]
+         TokenBuffer buffer;
+         sw.Restart();
+         for (UINT p = 0; p < passes; ++p)
+            for (const wstring& line : lines)
+            {
+               CommandLexer lex(line, buffer, false);
+               shared += lex.Tokens.size();
+            }
+         double sharedLexer = sw.ElapsedMilliseconds;
+
+         // After: Reuse a token buffer
+         sw.Restart();
+         for (UINT p = 0; p < passes; ++p)
+            for (const wstring& line : lines)
+               after += buffer.Lex(line, false).size();
+         double reused = sw.ElapsedMilliseconds;
+
+         // Verify tokens
+         bool identical = (before == shared && before == after);
+         for (auto line = lines.begin(); identical && line != lines.end(); ++line)
+         {
+            CommandLexer lex(*line, false);
+            auto& tokens = buffer.Lex(*line, false);
+
+            identical = tokens.size() == lex.Tokens.size() && equal(tokens.begin(), tokens.end(), lex.Tokens.begin(), [&buffer](const LexToken& a, const ScriptToken& b) {
+               return a.Type == b.Type && a.Start == b.Start && a.End == b.End && buffer.GetText(a) == b.Text;
+            });
+         }
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d tokens from %d lines, lexed %d times", before / passes, lines.size(), passes) << ENDL;
+         Console << Cons::Yellow << L"Command lexer: " << Cons::White << VString(L"%.0fms  %.1fM tokens/sec", lexer, before / max(lexer, 0.001) / 1000) << ENDL;
+         Console << Cons::Yellow << L"Shared buffer: " << Cons::White << VString(L"%.0fms  %.1fM tokens/sec  speedup x%.1f", sharedLexer, shared / max(sharedLexer, 0.001) / 1000, lexer / max(sharedLexer, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Token buffer:  " << Cons::White << VString(L"%.0fms  %.1fM tokens/sec  speedup x%.1f", reused, after / max(reused, 0.001) / 1000, lexer / max(reused, 0.001)) << ENDL;
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark command lexer");
+      }
+   }
+
+   void LogicTests::Benchmark_LineIdentification()
+   {
+      const UINT  blocks = 400,     // Size of synthetic script
+                  queries = 4;      // Identifications per keystroke  (goto label, lookup online, open script, view string)
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking single line identification using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Generate script
+         LineArray lines;
+         for (UINT i = 0; i < blocks; ++i)
+         {
+            lines.push_back(VString(L"$count%d = 0", i));
+            lines.push_back(VString(L"while $count%d < 100", i));
+            lines.push_back(VString(L"$count%d = $count%d + 1", i, i));
+            lines.push_back(VString(L"$result%d = wait 100 ms", i));
+            lines.push_back(VString(L"write to log file 9000 append=[TRUE] value=$count%d", i));
+            lines.push_back(L"end");
+         }
+         lines.push_back(L"return null");
+
+         // Parse script to populate symbols
+         ScriptFile script(L"");
+         script.Game = PrefsLib.GameDataVersion;
+         ScriptParser parsed(script, lines, script.Game);
+
+         // Simulate typing a command, identifying the line after each keystroke
+         const wstring command = L"$result = [THIS] -> call script 'plugin.test' : argument1=$count0 argument2=null";
+         CommandIdentifier identifier;
+         double before = 0, after = 0;
+         bool   identical = true;
+         for (UINT keys = 1; keys <= command.length(); ++keys)
+         {
+            wstring line = command.substr(0, keys);
+            CommandSyntaxPtr copied = nullptr, 
+                             reused = nullptr;
+
+            // Before: Copy script and parse + verify line
+            Stopwatch sw;
+            for (UINT q = 0; q < queries; ++q)
+            {
+               ScriptFile copy(script);
+               ScriptParser parser(copy, {line}, copy.Game);
+               copied = &parser.FirstCommand->Syntax;
+            }
+            before += sw.ElapsedMilliseconds;
+
+            // After: Identify line against the script
+            sw.Restart();
+            for (UINT q = 0; q < queries; ++q)
+               reused = identifier.Identify(script, line).Syntax;
+            after += sw.ElapsedMilliseconds;
+
+            identical &= (copied == reused);
+         }
+
+         // Feedback
+         UINT keys = command.length();
+         Console << Cons::Yellow << VString(L"%d keystrokes, %d identifications per keystroke, %d line script", keys, queries, lines.size()) << ENDL;
+         Console << Cons::Yellow << L"Copy + parse: " << Cons::White << VString(L"%.3fms per keystroke", before / keys) << ENDL;
+         Console << Cons::Yellow << L"Identifier:   " << Cons::White << VString(L"%.3fms per keystroke  speedup x%.1f", after / keys, before / max(after, 0.001)) << ENDL;
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark single line identification");
+      }
+   }
+
+   void LogicTests::Benchmark_StringResolver()
+   {
+      const UINT  pages = 40,       // Size of synthetic corpus
+                  strings = 2500;
+      
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking string resolution" << ENDL;
+
+         // Generate corpus: Strings reference strings with higher IDs, on the same page and others
+         LanguageFile file;
+         mt19937      random(42);
+         file.ID = 1;
+
+         for (UINT p = 1; p <= pages; ++p)
+         {
+            LanguagePage page(p, L"", L"", false);
+            for (UINT id = 1; id <= strings; ++id)
+            {
+               wstring txt = VString(L"String %d of page %d", id, p);
+               
+               switch (random() % 6)
+               {
+               case 0:  txt += VString(L" {%d,%d}", 1 + random() % pages, id + 1 + random() % 50);                  break;
+               case 1:  txt += VString(L" {%d} and {%d}", id + 1 + random() % 20, id + 1 + random() % 20);           break;
+               case 2:  txt += VString(L" (comment) \\(escaped\\) {%d,%d}", p, id + 1);                           break;
+               case 3:  txt += L" \\[b\\]bold\\[/b\\] (hidden (nested))";                                          break;
+               }
+
+               LanguageString str(id, p, txt, GameVersion::TerranConflict);
+               page.Add(str);
+            }
+            file.Pages.Add(page);
+         }
+
+         StringLib.Clear();
+         StringLib.Files.insert(move(file));
+         StringLib.UpdateLookup();
+
+         // Before: Regular expressions, without memoization
+         vector<wstring> before, cold, warm;
+         Stopwatch sw;
+         for (auto& page : *StringLib.begin())
+            for (auto& str : page)
+               before.push_back(RegexResolve(str));
+         double regex = sw.ElapsedMilliseconds;
+
+         // After: First pass resolves + memoizes, second pass uses memoized text
+         sw.Restart();
+         for (auto& page : *StringLib.begin())
+            for (auto& str : page)
+               cold.push_back(str.ResolvedText);
+         double first = sw.ElapsedMilliseconds;
+
+         sw.Restart();
+         for (auto& page : *StringLib.begin())
+            for (auto& str : page)
+               warm.push_back(str.ResolvedText);
+         double second = sw.ElapsedMilliseconds;
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d strings", before.size()) << ENDL;
+         Console << Cons::Yellow << L"Regex resolver:       " << Cons::White << VString(L"%.0fms", regex) << ENDL;
+         Console << Cons::Yellow << L"Single-pass (cold):   " << Cons::White << VString(L"%.0fms  speedup x%.1f", first, regex / max(first, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Single-pass (memo):   " << Cons::White << VString(L"%.0fms  speedup x%.1f", second, regex / max(second, 0.001)) << ENDL;
+         Console << L"Results identical: " << (before == cold && cold == warm ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark string resolution");
+      }
+
+      // Cleanup
+      StringLib.Clear();
+   }
+
+   void LogicTests::Benchmark_NodeArena()
+   {
+      const UINT  blocks = 2000,    // Size of synthetic script
+                  repeats = 20;     // Number of copies of the tree
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking command node arena using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Generate script
+         LineArray lines;
+         for (UINT i = 0; i < blocks; ++i)
+         {
+            lines.push_back(VString(L"$count%d = 0", i));
+            lines.push_back(VString(L"while $count%d < 100", i));
+            lines.push_back(VString(L"* Iteration %d", i));
+            lines.push_back(VString(L"$count%d = $count%d + 1", i, i));
+            lines.push_back(VString(L"if $count%d == 50", i));
+            lines.push_back(VString(L"$result%d = wait 100 ms", i));
+            lines.push_back(VString(L"write to log file 9000 append=[TRUE] value=$count%d", i));
+            lines.push_back(L"end");
+            lines.push_back(L"end");
+         }
+         lines.push_back(L"return null");
+
+         // Parse script  [Nodes allocated from the arena of the tree]
+         ScriptFile script(L"");
+         Stopwatch sw;
+         ScriptParser parser(script, lines, PrefsLib.GameDataVersion);
+         double parse = sw.ElapsedMilliseconds;
+         CommandNodeList nodes = parser.ToList();
+
+         // Before: Allocate each node, its reference count, its entry in the child list and its parameters from the heap
+         double heapCreate = 0, heapDestroy = 0;
+         UINT   heapAllocations = 0;
+         for (const CommandNodePtr& n : nodes)
+            heapAllocations += 3 + (n->Parameters.empty() ? 0 : 1) + (n->Postfix.empty() ? 0 : 1);
+
+         for (UINT r = 0; r < repeats; ++r)
+         {
+            CommandNodePtr root = CommandNode::Create(nullptr);
+            sw.Restart();
+            for (const CommandNodePtr& n : nodes)
+               *root += CommandNode::Create(nullptr, *n, n->LineNumber);
+            heapCreate += sw.ElapsedMilliseconds;
+
+            sw.Restart();
+            root.reset();
+            heapDestroy += sw.ElapsedMilliseconds;
+         }
+
+         // After: Allocate nodes, reference counts, child lists and parameters together from an arena
+         double arenaCreate = 0, arenaDestroy = 0;
+         UINT   allocated = 0, allocations = 0, reserved = 0;
+         bool   identical = true;
+         for (UINT r = 0; r < repeats; ++r)
+         {
+            NodeArenaPtr   arena(new NodeArena());
+            CommandNodePtr root = CommandNode::Create(arena.get());
+            sw.Restart();
+            for (const CommandNodePtr& n : nodes)
+               *root += CommandNode::Create(arena.get(), *n, n->LineNumber);
+            arenaCreate += sw.ElapsedMilliseconds;
+
+            // Verify copies, and that their storage is in the arena
+            allocated = arena->Allocated;
+            allocations = arena->Count;
+            reserved = arena->Reserved;
+            identical &= equal(nodes.begin(), nodes.end(), root->Children.begin(), [&arena](const CommandNodePtr& a, const CommandNodePtr& b) { 
+               return a->LineNumber == b->LineNumber && a->Syntax.ID == b->Syntax.ID && a->Parameters.size() == b->Parameters.size() 
+                   && b->GetArena() == arena.get() && b->Parameters.get_allocator() == b->Children.get_allocator(); 
+            });
+
+            sw.Restart();
+            root.reset();
+            arena.reset();
+            arenaDestroy += sw.ElapsedMilliseconds;
+         }
+
+         // Feedback  [Both exclude the text of parameters]
+         Console << Cons::Yellow << VString(L"%d line script parsed in %.0fms, %d nodes of %d bytes, copied %d times", lines.size(), parse, nodes.size(), sizeof(CommandNode), repeats) << ENDL;
+         Console << Cons::Yellow << L"Heap:  " << Cons::White << VString(L"%.1fms create, %.1fms destroy, %d allocations per tree", heapCreate, heapDestroy, heapAllocations) << ENDL;
+         Console << Cons::Yellow << L"Arena: " << Cons::White << VString(L"%.1fms create, %.1fms destroy, %d bump allocations per tree, %dKB used of %dKB reserved  speedup x%.1f", arenaCreate, arenaDestroy, allocations, allocated/1024, reserved/1024, (heapCreate+heapDestroy) / max(arenaCreate+arenaDestroy, 0.001)) << ENDL;
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark command node arena");
+      }
+   }
+
+   void LogicTests::Benchmark_ScriptCallCache()
+   {
+      const UINT  limit = 250;      // Maximum number of scripts
+      GameDataFixture game;
+      bool        concurrent = PrefsLib.ResolveScriptCallsConcurrently;
+
+      try
+      {
+         Path folder = PrefsLib.GameDataFolder + L"scripts";
+         Console << Cons::Heading << L"Benchmarking script-call resolution using " << folder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Fixture: Loose scripts of the game folder, which call a common set of library scripts
+         list<Path> scripts;
+         for (FileSearch fs(folder + L"*.*"); fs.HasResult() && scripts.size() < limit; fs.Next())
+            if (!fs.IsDirectory() && (fs.FullPath.HasExtension(L".pck") || fs.FullPath.HasExtension(L".xml")))
+               scripts.push_back(fs.FullPath);
+
+         // Reads every script, returning the translated text of all commands
+         auto readAll = [&scripts](bool perScript, UINT& calls) -> vector<wstring>
+         {
+            vector<wstring> text;
+            calls = 0;
+            for (const Path& p : scripts)
+            {
+               if (perScript)
+                  ScriptCallLib.Clear();
+               try
+               {
+                  auto script = ScriptFileReader(XFileInfo(p).OpenRead()).ReadFile(p, false);
+                  for (auto& cmd : script.Commands.Input)
+                     text.push_back(cmd.Text);
+                  calls += (UINT)count_if(script.Commands.Input.begin(), script.Commands.Input.end(), [](const ScriptCommand& c) { return c.Syntax.IsScriptCall(); });
+               }
+               catch (ExceptionBase&) {
+                  text.push_back(L"Failed: " + p.ToString());
+               }
+            }
+            return text;
+         };
+
+         // Before: Re-read the callees of each script
+         UINT calls = 0;
+         PrefsLib.ResolveScriptCallsConcurrently = false;
+         ScriptCallLib.ResetCounters();
+         Stopwatch sw;
+         auto uncached = readAll(true, calls);
+         double before = sw.ElapsedMilliseconds;
+         double beforeRate = ScriptCallLib.HitRate;
+
+         // After: Share callees between scripts, reading them one at a time
+         ScriptCallLib.Clear();
+         ScriptCallLib.ResetCounters();
+         sw.Restart();
+         auto serial = readAll(false, calls);
+         double after = sw.ElapsedMilliseconds;
+         double afterRate = ScriptCallLib.HitRate;
+
+         // After: Share callees between scripts, reading them concurrently
+         ScriptCallLib.Clear();
+         ScriptCallLib.ResetCounters();
+         PrefsLib.ResolveScriptCallsConcurrently = true;
+         sw.Restart();
+         auto parallel = readAll(false, calls);
+         double parallelTime = sw.ElapsedMilliseconds;
+         double parallelRate = ScriptCallLib.HitRate;
+         UINT   cached = ScriptCallLib.Count;
+
+         // Warm: Callees are already cached
+         ScriptCallLib.ResetCounters();
+         sw.Restart();
+         auto warm = readAll(false, calls);
+         double warmTime = sw.ElapsedMilliseconds;
+         double warmRate = ScriptCallLib.HitRate;
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d scripts read, %d script-calls to %d distinct scripts", scripts.size(), calls, cached) << ENDL;
+         Console << Cons::Yellow << L"Per-script callees: " << Cons::White << VString(L"%.0fms  hit rate %.0f%%", before, beforeRate * 100) << ENDL;
+         Console << Cons::Yellow << L"Shared, serial:     " << Cons::White << VString(L"%.0fms  hit rate %.0f%%  speedup x%.1f", after, afterRate * 100, before / max(after, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Shared, concurrent: " << Cons::White << VString(L"%.0fms  hit rate %.0f%%  speedup x%.1f", parallelTime, parallelRate * 100, before / max(parallelTime, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Shared, warm:       " << Cons::White << VString(L"%.0fms  hit rate %.0f%%  speedup x%.1f", warmTime, warmRate * 100, before / max(warmTime, 0.001)) << ENDL;
+         Console << L"Results identical: " << (uncached == serial && serial == parallel && parallel == warm ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark script-call resolution");
+      }
+
+      // Cleanup
+      PrefsLib.ResolveScriptCallsConcurrently = concurrent;
+      ScriptCallLib.ResetCounters();
+   }
+
+   void LogicTests::Benchmark_ScriptReader()
+   {
+      const UINT  limit = 500;      // Maximum number of scripts
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking script reading using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Read scripts
+         list<ScriptFile> files;
+         vector<pair<ScriptFile*,ScriptCommand>> commands;
+         Stopwatch sw;
+         UINT   scripts = 0, failed = 0;
+         double reading = 0;
+         for (auto& f : game.VFS.Browse(XFolder::Scripts))
+         {
+            if (scripts + failed == limit)
+               break;
+            else if (!f.FullPath.HasExtension(L".pck") && !f.FullPath.HasExtension(L".xml"))
+               continue;
+
+            try
+            {
+               sw.Restart();
+               files.push_back(ScriptFileReader(f.OpenRead()).ReadFile(f.FullPath, false));
+               reading += sw.ElapsedMilliseconds;
+               ++scripts;
+
+               // Preserve commands whose syntax markers are all present, and whose text is generated entirely from their syntax  [Expressions/vargs append further text]
+               for (auto& cmd : files.back().Commands.Input)
+                  if (!cmd.Is(CMD_EXPRESSION) && !cmd.Syntax.IsVArgument() 
+                   && all_of(cmd.Syntax.Template.begin(), cmd.Syntax.Template.end(), [&cmd](const CommandSyntax::Segment& seg) { 
+                     return !seg.IsParameter() || (UINT)seg.Parameter < cmd.Parameters.size(); 
+                  }))
+                     commands.push_back(make_pair(&files.back(), cmd));
+            }
+            catch (ExceptionBase&) {
+               ++failed;
+            }
+         }
+
+         // Before: Previous implementation of ScriptCommand::Translate, which lexed the syntax replacing '$n' markers with parameter text
+         vector<wstring> lexed, spliced;
+         sw.Restart();
+         for (auto& c : commands)
+         {
+            ScriptCommand cmd(c.second);
+            for (ScriptParameter& p : cmd.Parameters)
+               p.Translate(*c.first);
+
+            CommandLexer lex(cmd.Syntax.Text, false);
+            GuiString text;
+            for (const ScriptToken& tok : lex.Tokens)
+               if (tok.Type == TokenType::Variable || tok.Type == TokenType::Comment)
+                  text.append(cmd.Parameters[tok.Text[1]-48].Text);
+               else
+                  text.append(tok.Text);
+
+            text = text.TrimLeft(L" ");
+            if (cmd.Syntax.Execution == ExecutionType::Concurrent)
+               text.insert(0, L"start ");
+            if (cmd.Commented)
+               text.insert(0, L"* ");
+            lexed.push_back(text);
+         }
+         double before = sw.ElapsedMilliseconds;
+
+         // After: ScriptCommand::Translate, which splices precompiled syntax templates
+         sw.Restart();
+         for (auto& c : commands)
+         {
+            ScriptCommand cmd(c.second);
+            cmd.Text.clear();
+            cmd.Translate(*c.first);
+            spliced.push_back(cmd.Text);
+         }
+         double after = sw.ElapsedMilliseconds;
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d scripts read (%d failed), %d commands", scripts, failed, commands.size()) << ENDL;
+         Console << Cons::Yellow << L"ScriptFileReader: " << Cons::White << VString(L"%.0fms  %.1f scripts/sec", reading, scripts * 1000 / max(reading, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Lexed syntax:     " << Cons::White << VString(L"%.1fms", before) << ENDL;
+         Console << Cons::Yellow << L"Syntax template:  " << Cons::White << VString(L"%.1fms  speedup x%.1f", after, before / max(after, 0.001)) << ENDL;
+         Console << L"Results identical: " << (lexed == spliced ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark script reading");
+      }
+   }
+
+   void LogicTests::Benchmark_ScriptTextReader()
+   {
+      const UINT  limit = 500;      // Maximum number of scripts
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking text-only script reading using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Read each script using both readers, alternately, so neither benefits from a warmer file cache
+         Stopwatch sw;
+         UINT     scripts = 0, failed = 0, different = 0;
+         DWORD64  bytes = 0;
+         double   full = 0, text = 0;
+         for (auto& f : game.VFS.Browse(XFolder::Scripts))
+         {
+            if (scripts + failed == limit)
+               break;
+            else if (!f.FullPath.HasExtension(L".pck") && !f.FullPath.HasExtension(L".xml"))
+               continue;
+
+            try
+            {
+               // Before: Full reader
+               auto stream = f.OpenRead();
+               bytes += stream->GetLength();
+               sw.Restart();
+               auto before = ScriptFileReader(stream).ReadFile(f.FullPath, false);
+               full += sw.ElapsedMilliseconds;
+
+               // After: Text-only reader
+               sw.Restart();
+               auto after = ScriptFileReader(f.OpenRead()).ReadText(f.FullPath, true);
+               text += sw.ElapsedMilliseconds;
+               ++scripts;
+
+               // Compare text
+               auto a = before.Commands.Input.begin();
+               auto b = after.Commands.Input.begin();
+               if (before.Commands.Input.size() != after.Commands.Input.size())
+                  ++different;
+               else for (; a != before.Commands.Input.end(); ++a, ++b)
+                  if (a->Text != b->Text)
+                  {
+                     Console << Cons::Red << f.FullPath.FileName << L": " << Cons::White << a->Text << L" : " << b->Text << ENDL;
+                     ++different;
+                     break;
+                  }
+            }
+            catch (ExceptionBase&) {
+               ++failed;
+            }
+         }
+
+         // Feedback
+         double megabytes = bytes / (1024.0 * 1024.0);
+         Console << Cons::Yellow << VString(L"%d scripts read (%d failed), %.1fMB", scripts, failed, megabytes) << ENDL;
+         Console << Cons::Yellow << L"Full reader:      " << Cons::White << VString(L"%.0fms  %.1f scripts/sec  %.2fMB/sec", full, scripts * 1000 / max(full, 0.001), megabytes * 1000 / max(full, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Text-only reader: " << Cons::White << VString(L"%.0fms  %.1f scripts/sec  %.2fMB/sec  speedup x%.1f", text, scripts * 1000 / max(text, 0.001), megabytes * 1000 / max(text, 0.001), full / max(text, 0.001)) << ENDL;
+         Console << L"Results identical: " << (!different ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark text-only script reading");
+      }
+   }
+
+   void LogicTests::Benchmark_SearchIndex()
+   {
+      const UINT  count = 2000;     // Number of synthetic scripts
+      GameDataFixture game;
+      Path        folder, index;
+
+      try
+      {
+         Path source = PrefsLib.GameDataFolder + L"scripts";
+         WCHAR temp[MAX_PATH];
+         GetTempPath(MAX_PATH, temp);
+         folder = Path(temp) + L"XStudio2.IndexBenchmark";
+         index = Path(temp) + L"XStudio2.IndexBenchmark.dat";
+         Console << Cons::Heading << L"Benchmarking search index of " << count << L" scripts copied from " << source << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Fixture: Loose scripts of the game folder, copied repeatedly into a temporary folder
+         list<Path> originals, scripts;
+         for (FileSearch fs(source + L"*.*"); fs.HasResult(); fs.Next())
+            if (!fs.IsDirectory() && (fs.FullPath.HasExtension(L".pck") || fs.FullPath.HasExtension(L".xml")))
+               originals.push_back(fs.FullPath);
+
+         if (originals.empty())
+            throw FileNotFoundException(HERE, source);
+
+         CreateDirectory(folder.c_str(), nullptr);
+         for (auto src = originals.begin(); scripts.size() < count; ++src)
+         {
+            if (src == originals.end())
+               src = originals.begin();
+
+            Path copy = folder + VString(L"index.%04d%s", scripts.size(), src->Extension.c_str());
+            if (!CopyFile(src->c_str(), copy.c_str(), FALSE))
+               throw Win32Exception(HERE, VString(L"Unable to copy '%s'", src->c_str()));
+            scripts.push_back(copy);
+         }
+
+         // Build: Index every script
+         SearchIndexLib.Clear();
+         Stopwatch sw;
+         UINT indexed = SearchIndexLib.Update(scripts);
+         double build = sw.ElapsedMilliseconds;
+
+         // Persist: Save + reload
+         SearchIndexLib.Save(index);
+         WIN32_FILE_ATTRIBUTE_DATA attr;
+         GetFileAttributesEx(index.c_str(), GetFileExInfoStandard, &attr);
+
+         sw.Restart();
+         bool loaded = SearchIndexLib.Load(index);
+         double load = sw.ElapsedMilliseconds;
+
+         // Incremental: Nothing has changed
+         sw.Restart();
+         UINT reindexed = SearchIndexLib.Update(scripts);
+         double incremental = sw.ElapsedMilliseconds;
+
+         Console << Cons::Yellow << VString(L"Build:       %d scripts  %.0fms", indexed, build) << ENDL;
+         Console << Cons::Yellow << VString(L"Size:        %d trigrams  %d KB on disk", SearchIndexLib.Trigrams, attr.nFileSizeLow / 1024) << ENDL;
+         Console << Cons::Yellow << VString(L"Load:        %.1fms", load) << ENDL;
+         Console << Cons::Yellow << VString(L"Incremental: %d scripts  %.0fms", reindexed, incremental) << ENDL;
+
+         // Searches the fixture, with or without the index, returning the number of matches found and the time taken
+         auto findAll = [&scripts](const wstring& term, bool regEx, bool filter, double& ms, UINT& skipped) -> UINT
+         {
+            SearchWorkerData search(Operation::NoFeedback, scripts, MatchData(SearchTarget::ScriptFolder, term, L"", false, false, regEx));
+            ScriptCallLib.Clear();
+
+            Stopwatch sw;
+            skipped = filter ? SearchIndexLib.Filter(search.Files, search.Match) : 0;
+            search.Command = SearchCommand::FindAll;
+            SearchWorker::Search(&search);
+            ms = sw.ElapsedMilliseconds;
+            return search.Matches;
+         };
+
+         // Compare each query with and without the index
+         bool identical = loaded && reindexed == 0;
+         for (auto& q : vector<pair<wstring,bool>>{ {L"get", false}, {L"[THIS] -> get", false}, {L"wait randomly", false},
+                                                     {L"\\[THIS\\] -> \\w+", true}, {L"set global variable", false}, {L"zzqxj", false} })
+         {
+            double   before, after, query;
+            UINT     unused, skipped;
+            list<Path> files(scripts);
+
+            // Filter latency alone
+            sw.Restart();
+            SearchIndexLib.Filter(files, MatchData(SearchTarget::ScriptFolder, q.first, L"", false, false, q.second));
+            query = sw.ElapsedMilliseconds;
+
+            UINT matchesBefore = findAll(q.first, q.second, false, before, unused),
+                 matchesAfter = findAll(q.first, q.second, true, after, skipped);
+            identical &= (matchesBefore == matchesAfter);
+
+            Console << Cons::Yellow << VString(L"%-22s ", q.first.c_str()) << Cons::White 
+                    << VString(L"%d matches  query %.2fms  skipped %d files  unindexed %.0fms  indexed %.0fms  speedup x%.1f", matchesAfter, query, skipped, before, after, before / max(after, 0.001)) << ENDL;
+         }
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark search index");
+      }
+
+      // Cleanup
+      if (!folder.Empty())
+      {
+         for (FileSearch fs(folder + L"*.*"); fs.HasResult(); fs.Next())
+            if (!fs.IsDirectory())
+               DeleteFile(fs.FullPath.c_str());
+         RemoveDirectory(folder.c_str());
+         DeleteFile(index.c_str());
+      }
+      SearchIndexLib.Clear();
+   }
+
+   void LogicTests::Benchmark_SearchPattern()
+   {
+      const UINT  count = 500;     // Number of scripts
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking search patterns against std::wregex using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Read translated text of scripts
+         vector<wstring> texts;
+         size_t chars = 0;
+         for (auto& f : game.VFS.Browse(XFolder::Scripts))
+            if (texts.size() < count && (f.FullPath.HasExtension(L".pck") || f.FullPath.HasExtension(L".xml")))
+               try
+               {
+                  texts.push_back(ScriptFileReader(f.OpenRead()).ReadText(f.FullPath, true).GetAllText());
+                  chars += texts.back().length();
+               }
+               catch (ExceptionBase&) {
+               }
+
+         // Counts whole-word matches in every script using std::wregex, returning the time taken
+         auto findLibrary = [&texts](const wregex& regEx, bool matchWord, double& ms) -> UINT
+         {
+            Stopwatch sw;
+            UINT matches = 0;
+            for (auto& txt : texts)
+            {
+               wsmatch m;
+               for (UINT from = 0; from <= txt.length() && regex_search(txt.cbegin()+from, txt.cend(), m, regEx, from ? regex_constants::match_prev_avail : regex_constants::match_default); )
+               {
+                  UINT pos = m[0].first - txt.cbegin(), len = m[0].length();
+                  bool whole = (pos == 0 || !SearchPattern::IsWordChar(txt[pos-1])) && (pos+len >= txt.length() || !SearchPattern::IsWordChar(txt[pos+len]));
+
+                  // Skip partial words, and beyond empty matches
+                  matches += (!matchWord || whole) ? 1 : 0;
+                  from = (!matchWord || whole) && len ? pos+len : pos+1;
+               }
+            }
+            ms = sw.ElapsedMilliseconds;
+            return matches;
+         };
+
+         // Counts matches in every script using a compiled pattern, returning the time taken
+         auto findPattern = [&texts](const SearchPattern& p, double& ms) -> UINT
+         {
+            Stopwatch sw;
+            UINT matches = 0, pos, len;
+            for (auto& txt : texts)
+               for (UINT from = 0; p.Find(txt, from, pos, len); from = (len ? pos+len : pos+1))
+                  ++matches;
+            ms = sw.ElapsedMilliseconds;
+            return matches;
+         };
+
+         // Queries: Term, regEx, matchCase, matchWord  [Anchors are omitted, std::wregex anchors to the search position]
+         struct Query { const WCHAR* Term; bool RegEx, MatchCase, MatchWord; };
+         const Query queries[] = 
+         {
+            { L"get",                             false, false, false },
+            { L"[THIS] -> ",                      false, false, false },
+            { L"get",                             true,  true,  true  },
+            { L"\\[THIS\\] -> \\w+",              true,  false, false },
+            { L"\\$\\w+ = \\$\\w+ \\+ 1",         true,  true,  false },
+            { L"(wait|get|set) \\w+",             true,  false, false },
+            { L"\\d+",                            true,  true,  false },
+            { L"\\$(\\w+) = \\$\\1",              true,  true,  false },
+         };
+         const WCHAR* engines[] = { L"Literal", L"Automaton", L"Library" };
+         bool identical = true;
+
+         Console << Cons::Yellow << VString(L"%d scripts, %d characters", texts.size(), chars) << ENDL;
+         for (auto& q : queries)
+         {
+            double        before, after;
+            SearchPattern pattern(q.Term, q.RegEx, q.MatchCase, q.MatchWord);
+            wregex        regEx(q.RegEx ? wstring(q.Term) : regex_replace(wstring(q.Term), wregex(L"[.^$|()\\[\\]{}*+?\\\\]"), wstring(L"\\$&")),
+                                q.MatchCase ? regex_constants::ECMAScript : regex_constants::ECMAScript | regex_constants::icase);
+
+            UINT matchesBefore = findLibrary(regEx, q.MatchWord, before),
+                 matchesAfter = findPattern(pattern, after);
+            identical &= (matchesBefore == matchesAfter);
+
+            Console << Cons::Yellow << VString(L"%-24s %-9s ", q.Term, engines[(UINT)pattern.Engine]) << Cons::White 
+                    << VString(L"%d matches  std::wregex %.0fms  pattern %.0fms  speedup x%.1f", matchesAfter, before, after, before / max(after, 0.001)) << ENDL;
+         }
+
+         // Finds the leftmost match using std::wregex alone, by matching at each position in turn against the remainder of its line
+         auto findReference = [](const wregex& regEx, bool matchWord, const wstring& txt, UINT from, UINT& pos, UINT& len) -> bool
+         {
+            wsmatch m;
+            for (pos = from; pos <= txt.length(); ++pos)
+            {
+               bool   lineStart = (pos == 0 || txt[pos-1] == '\r' || txt[pos-1] == '\n');
+               size_t end = txt.find_first_of(L"\r\n", pos);
+               auto   flags = regex_constants::match_continuous | (lineStart ? regex_constants::match_default : regex_constants::match_prev_avail | regex_constants::match_not_bol);
+
+               // Skip positions within a word
+               if (matchWord && pos > 0 && SearchPattern::IsWordChar(txt[pos-1]))
+                  continue;
+
+               if (regex_search(txt.cbegin()+pos, (end == wstring::npos ? txt.cend() : txt.cbegin()+end), m, regEx, flags))
+               {
+                  len = m[0].length();
+                  return true;
+               }
+            }
+            return false;
+         };
+
+         // Corpus: Compare the position and length of every match against std::wregex  [Expressions do not span lines]
+         const WCHAR* corpus[] = 
+         {
+            L"a|ab", L"(?=a)(a|ab)", L"get|getitem", L"(ab|a)(?!c)", L"(a|ab)(c|bcd)?",                   // Alternation
+            L"\\w+?", L"\\$\\w+?\\b", L"<.*?>", L"<.*>", L"\\d{2,3}?", L"a*?b|a", L"^\\w+?",           // Lazy quantifiers
+            L"^\\$\\w+", L"\\w+$", L"^$", L"^[ \\t]*\\*", L"^a|b$", L"[a-c]+?$",                       // Anchors
+            L"\\bset\\b", L"\\Bet\\b", L"\\w*", L"x*",                                                 // Word boundaries, empty matches
+            L"THIS", L"\\$count", L"(\\w)\\1", L"\\w+(?=[ \\t]*=)", L"^(?=[ \\t]*\\$)[^ \\t\\r\\n]+"    // Literal and library
+         };
+         const wstring samples[] = 
+         {
+            L"$count = $count + 1\r\n* comment\r\n\r\nstart [THIS] -> call script 'plugin.getitem' : a ab abc=aab\r\n$x = [THIS] -> get sector\r\n  set ab <a>text</a> 1234 55\r\nend",
+            L"ab\nab a\n\nGet get_x GET getitem\n",
+            L"a",
+            L"",
+         };
+         UINT checked = 0, failed = 0;
+
+         for (auto expr : corpus)
+            for (UINT options = 0; options < 4; ++options)
+            {
+               bool          matchCase = (options & 1) != 0, 
+                             matchWord = (options & 2) != 0;
+               SearchPattern pattern(expr, true, matchCase, matchWord);
+               wregex        regEx(matchWord ? L"(?:" + wstring(expr) + L")(?!\\w)" : wstring(expr), 
+                                   matchCase ? regex_constants::ECMAScript : regex_constants::ECMAScript | regex_constants::icase);
+
+               for (auto& txt : samples)
+               {
+                  vector<pair<UINT,UINT>> expected, actual;
+                  UINT pos, len;
+
+                  for (UINT from = 0; findReference(regEx, matchWord, txt, from, pos, len); from = (len ? pos+len : pos+1))
+                     expected.push_back(make_pair(pos, len));
+                  for (UINT from = 0; pattern.Find(txt, from, pos, len); from = (len ? pos+len : pos+1))
+                     actual.push_back(make_pair(pos, len));
+
+                  ++checked;
+                  if (expected != actual)
+                  {
+                     Console << Cons::Yellow << VString(L"%-24s %-9s matchCase=%d matchWord=%d ", expr, engines[(UINT)pattern.Engine], matchCase, matchWord) 
+                             << Cons::Red << VString(L"%d matches, expected %d", actual.size(), expected.size()) << ENDL;
+                     ++failed;
+                  }
+               }
+            }
+
+         identical &= (failed == 0);
+         Console << Cons::Yellow << VString(L"%d of %d corpus searches match std::wregex", checked - failed, checked) << ENDL;
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark search patterns");
+      }
+   }
+
+   void LogicTests::Benchmark_SearchWorker()
+   {
+      const UINT  count = 2000;     // Number of synthetic scripts
+      GameDataFixture game;
+      Path        folder;
+
+      try
+      {
+         Path source = PrefsLib.GameDataFolder + L"scripts";
+         WCHAR temp[MAX_PATH];
+         GetTempPath(MAX_PATH, temp);
+         folder = Path(temp) + L"XStudio2.SearchBenchmark";
+         Console << Cons::Heading << L"Benchmarking search of " << count << L" scripts copied from " << source << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Fixture: Loose scripts of the game folder, copied repeatedly into a temporary folder
+         list<Path> originals, scripts;
+         for (FileSearch fs(source + L"*.*"); fs.HasResult(); fs.Next())
+            if (!fs.IsDirectory() && (fs.FullPath.HasExtension(L".pck") || fs.FullPath.HasExtension(L".xml")))
+               originals.push_back(fs.FullPath);
+
+         if (originals.empty())
+            throw FileNotFoundException(HERE, source);
+
+         CreateDirectory(folder.c_str(), nullptr);
+         for (auto src = originals.begin(); scripts.size() < count; ++src)
+         {
+            if (src == originals.end())
+               src = originals.begin();
+
+            Path copy = folder + VString(L"search.%04d%s", scripts.size(), src->Extension.c_str());
+            if (!CopyFile(src->c_str(), copy.c_str(), FALSE))
+               throw Win32Exception(HERE, VString(L"Unable to copy '%s'", src->c_str()));
+            scripts.push_back(copy);
+         }
+
+         // Searches the fixture, returning the number of matches found and the time taken
+         auto findAll = [&scripts](const wstring& term, bool regEx, UINT threads, double& ms) -> UINT
+         {
+            SearchWorkerData search(Operation::NoFeedback, scripts, MatchData(SearchTarget::ScriptFolder, term, L"", false, false, regEx));
+            ScriptCallLib.Clear();
+            
+            Stopwatch sw;
+            search.Command = SearchCommand::FindAll;
+            SearchWorker::Search(&search, threads);
+            ms = sw.ElapsedMilliseconds;
+            return search.Matches;
+         };
+
+         // Finds each matching file in turn, returning the files found and the time taken
+         auto findNext = [&scripts](const wstring& term, UINT threads, double& ms) -> list<Path>
+         {
+            SearchWorkerData search(Operation::NoFeedback, scripts, MatchData(SearchTarget::ScriptFolder, term, L"", false, false, false));
+            list<Path> found;
+            ScriptCallLib.Clear();
+
+            Stopwatch sw;
+            while (SearchWorker::Search(&search, threads))
+               found.push_back(search.Match.FullPath);
+            ms = sw.ElapsedMilliseconds;
+            return found;
+         };
+
+         // Before: One file at a time.  After: One file per processor
+         double serialText, parallelText, serialRegEx, parallelRegEx, serialNext, parallelNext;
+         UINT textBefore  = findAll(L"get", false, 1, serialText),
+              textAfter   = findAll(L"get", false, 0, parallelText),
+              regExBefore = findAll(L"\\[THIS\\] -> \\w+", true, 1, serialRegEx),
+              regExAfter  = findAll(L"\\[THIS\\] -> \\w+", true, 0, parallelRegEx);
+         auto nextBefore  = findNext(L"wait", 1, serialNext),
+              nextAfter   = findNext(L"wait", 0, parallelNext);
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d scripts, %d processors", scripts.size(), WorkerPool::GetProcessorCount()) << ENDL;
+         Console << Cons::Yellow << L"FindAll text:  " << Cons::White << VString(L"%d matches  serial %.0fms  concurrent %.0fms  speedup x%.1f", textAfter, serialText, parallelText, serialText / max(parallelText, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"FindAll regEx: " << Cons::White << VString(L"%d matches  serial %.0fms  concurrent %.0fms  speedup x%.1f", regExAfter, serialRegEx, parallelRegEx, serialRegEx / max(parallelRegEx, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Find next:     " << Cons::White << VString(L"%d files  serial %.0fms  concurrent %.0fms  speedup x%.1f", nextAfter.size(), serialNext, parallelNext, serialNext / max(parallelNext, 0.001)) << ENDL;
+         Console << L"Results identical: " << (textBefore == textAfter && regExBefore == regExAfter && nextBefore == nextAfter ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark search");
+      }
+
+      // Cleanup
+      if (!folder.Empty())
+      {
+         for (FileSearch fs(folder + L"*.*"); fs.HasResult(); fs.Next())
+            if (!fs.IsDirectory())
+               DeleteFile(fs.FullPath.c_str());
+         RemoveDirectory(folder.c_str());
+      }
+   }
+
+   void LogicTests::Benchmark_StringLookup()
+   {
+      const UINT  count = 1000000;     // Number of lookups
+      WorkerData  data(Operation::NoFeedback);
+      XFileSystem vfs;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking string library lookups using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load language files
+         vfs.Enumerate(PrefsLib.GameDataFolder, PrefsLib.GameDataVersion, &data);
+         StringLib.Enumerate(vfs, PrefsLib.GameDataLanguage, &data);
+
+         // Gather keys of every string
+         vector<pair<UINT,UINT>> keys, lookups;
+         for (const LanguageFile& f : StringLib.Files)
+            for (const LanguagePage& p : f)
+               for (const LanguageString& s : p)
+                  keys.push_back(make_pair(s.Page, s.ID));
+
+         if (keys.empty())
+            throw InvalidOperationException(HERE, L"No language strings found");
+
+         // Generate random lookups: One in ten is missing
+         mt19937 random(42);
+         lookups.reserve(count);
+         for (UINT i = 0; i < count; ++i)
+         {
+            auto key = keys[random() % keys.size()];
+            lookups.push_back(i % 10 ? key : make_pair(key.first, key.second + 100000));
+         }
+
+         // Before: Search each file in descending file ID
+         vector<const LanguageString*> scanned(count), hashed(count);
+         Stopwatch sw;
+         for (UINT i = 0; i < count; ++i)
+            for (const LanguageFile& f : StringLib.Files)
+               if (f.Contains(lookups[i].first, lookups[i].second))
+               {
+                  scanned[i] = &f.Find(lookups[i].first, lookups[i].second);
+                  break;
+               }
+         double scan = sw.ElapsedMilliseconds;
+
+         // After: Lookup table
+         sw.Restart();
+         for (UINT i = 0; i < count; ++i)
+            StringLib.TryFind(lookups[i].first, lookups[i].second, hashed[i]);
+         double table = sw.ElapsedMilliseconds;
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d lookups over %d strings in %d files", count, keys.size(), StringLib.Files.size()) << ENDL;
+         Console << Cons::Yellow << L"File scan:    " << Cons::White << VString(L"%.1fms", scan) << ENDL;
+         Console << Cons::Yellow << L"Lookup table: " << Cons::White << VString(L"%.1fms  speedup x%.1f", table, scan / max(table, 0.001)) << ENDL;
+         Console << L"Results identical: " << (scanned == hashed ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark string lookups");
+      }
+
+      // Cleanup
+      StringLib.Clear();
+   }
+
+   void LogicTests::Benchmark_SyntaxAutomaton()
+   {
+      typedef tuple<UINT,UINT,UINT,UINT> Result;    // ID, Versions, tokens consumed, parameters
+
+      const UINT        count = 500000;    // Number of synthetic lines
+      const GameVersion versions[4] = { GameVersion::Threat, GameVersion::Reunion, GameVersion::TerranConflict, GameVersion::AlbionPrelude };
+      WorkerData        data(Operation::NoFeedback);
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking command identification" << ENDL;
+
+         // Load command syntax
+         SyntaxLib.Enumerate(&data);
+
+         // Gather every visible command
+         set<const CommandSyntax*> commands;
+         for (GameVersion v : versions)
+            for (const CommandSyntax* s : SyntaxLib.Query(L"", v))
+               if (s->ID != CMD_NOP && s->ID != CMD_COMMENT && s->ID != CMD_COMMAND_COMMENT && s->ID != CMD_EXPRESSION)
+                  commands.insert(s);
+
+         // Lex each command WITHOUT RefObj & RetVar, as the library does
+         vector<pair<const CommandSyntax*,TokenArray>> syntax;
+         for (const CommandSyntax* s : commands)
+         {
+            CommandLexer lex(s->Text);
+            TokenArray   tokens;
+
+            for (const ScriptToken& t : lex.Tokens)
+               if (t.Type != TokenType::Variable || (!s->Parameters[t.Text[1]-48].IsRefObj() && !s->Parameters[t.Text[1]-48].IsRetVar()))
+                  tokens.push_back(t);
+
+            syntax.push_back(make_pair(s, tokens));
+         }
+
+         // Build both structures
+         SyntaxTree      tree;
+         SyntaxAutomaton automaton;
+         for (auto& s : syntax)
+         {
+            tree.Insert(*s.first, s.second.begin(), s.second.end());
+            automaton.Insert(*s.first, s.second.begin(), s.second.end());
+         }
+         automaton.Compile();
+
+         // Generate corpus: Random commands with concrete arguments. One in ten has an unrecognised keyword
+         const ScriptToken    args[3] = { ScriptToken(TokenType::Variable, 0, 0, L"$ship"), 
+                                          ScriptToken(TokenType::Number, 0, 0, L"42"), 
+                                          ScriptToken(TokenType::String, 0, 0, L"'text'") };
+         vector<TokenArray>   lines(count);
+         vector<GameVersion>  lineVersions(count);
+         mt19937 random(42);
+         for (UINT i = 0; i < count; ++i)
+         {
+            const TokenArray& tokens = syntax[random() % syntax.size()].second;
+            for (const ScriptToken& t : tokens)
+               if (t.IsParameter())
+                  lines[i].push_back(args[random() % 3]);
+               else
+                  lines[i].push_back(i % 10 || &t != &tokens.back() ? t : ScriptToken(TokenType::Text, 0, 0, L"unrecognised"));
+            lineVersions[i] = versions[random() % 4];
+         }
+
+         // Identify every line using the specified structure
+         auto identify = [&](function<CommandSyntaxRef (TokenIterator&, const TokenIterator&, GameVersion, TokenList&)> find, vector<Result>& results) -> double
+         {
+            Stopwatch sw;
+            for (UINT i = 0; i < count; ++i)
+            {
+               TokenIterator pos = lines[i].begin();
+               TokenList params;
+               CommandSyntaxRef s = find(pos, lines[i].end(), lineVersions[i], params);
+               results.push_back(Result(s.ID, s.Versions, pos - lines[i].begin(), params.size()));
+            }
+            return sw.ElapsedMilliseconds;
+         };
+
+         // Before: Tree of token text.  After: Token ID automaton
+         vector<Result> before, after;
+         before.reserve(count);
+         after.reserve(count);
+         double treeTime = identify([&](TokenIterator& pos, const TokenIterator& end, GameVersion v, TokenList& p) -> CommandSyntaxRef { return tree.Find(pos, end, v, p); }, before);
+         double automatonTime = identify([&](TokenIterator& pos, const TokenIterator& end, GameVersion v, TokenList& p) -> CommandSyntaxRef { return automaton.Find(pos, end, v, p); }, after);
+
+         // Feedback
+         UINT recognised = count_if(after.begin(), after.end(), [](const Result& r) { return get<0>(r) != CommandSyntax::Unrecognised.ID; });
+         Console << Cons::Yellow << VString(L"%d lines using %d commands, %d recognised. Automaton has %d states", count, syntax.size(), recognised, automaton.Count) << ENDL;
+         Console << Cons::Yellow << L"Syntax tree: " << Cons::White << VString(L"%.0fms", treeTime) << ENDL;
+         Console << Cons::Yellow << L"Automaton:   " << Cons::White << VString(L"%.0fms  speedup x%.1f", automatonTime, treeTime / max(automatonTime, 0.001)) << ENDL;
+         Console << L"Results identical: " << (before == after ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark command identification");
+      }
+
+      // Cleanup
+      SyntaxLib.Clear();
+   }
+
+   void LogicTests::Benchmark_TreePasses()
+   {
+      const UINT  scripts = 50,     // Number of synthetic scripts
+                  repeats = 10;     // Number of verifications of each script
+      GameDataFixture game;
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking fused command tree passes using " << PrefsLib.GameDataFolder << ENDL;
+
+         // Load game data
+         game.Load();
+
+         // Summarise compiled output, for comparison
+         auto summarise = [](const ScriptParser& p) -> vector<wstring>
+         {
+            auto summary = SummariseParse(p);
+            for (const CommandNodePtr& n : p.ToList())
+               summary.push_back(VString(L"%d: index=%d", n->LineNumber, n->Index));
+            summary.push_back(VString(L"std=%d aux=%d", p.Script.Commands.StdOutput.size(), p.Script.Commands.AuxOutput.size()));
+            return summary;
+         };
+
+         PassManager::TimingArray verifyPasses, compilePasses;
+         double verifyBefore = 0, verifyAfter = 0,
+                compileBefore = 0, compileAfter = 0;
+         UINT   lineCount = 0;
+         bool   identical = true;
+         Stopwatch sw;
+
+         // Batch of scripts of increasing size
+         for (UINT s = 0; s < scripts; ++s)
+         {
+            LineArray lines;
+            for (UINT i = 0; i < 10 + 5*s; ++i)
+            {
+               lines.push_back(VString(L"$count%d = 0", i));
+               lines.push_back(VString(L"while $count%d < 100", i));
+               lines.push_back(VString(L"$count%d = $count%d + 1", i, i));
+               lines.push_back(VString(L"if $count%d == 50", i));
+               lines.push_back(L"break");
+               lines.push_back(VString(L"else if $count%d == 25", i));
+               lines.push_back(L"continue");
+               lines.push_back(L"end");
+               lines.push_back(VString(L"write to log file 9000 append=[TRUE] value=$count%d", i));
+               lines.push_back(L"end");
+            }
+            lines.push_back(L"return null");
+            lineCount += lines.size();
+
+            // Parse script twice
+            ScriptFile   fileBefore(L""), fileAfter(L"");
+            ScriptParser before(fileBefore, lines, PrefsLib.GameDataVersion),
+                         after(fileAfter, lines, PrefsLib.GameDataVersion);
+
+            // Verify repeatedly
+            for (UINT r = 0; r < repeats; ++r)
+            {
+               // Before: Separate depth-first traversal per visitor
+               fileBefore.Clear();
+               before.Errors.clear();
+               sw.Restart();
+               {
+                  CommandGenerator    commands(fileBefore, before.Errors);
+                  ConstantIdentifier  constants(fileBefore, before.Errors);
+                  LogicVerifier       logic(before.Errors);
+                  TerminationVerifier termination(before.Errors);
+                  VariableIdentifier  variables(fileBefore, before.Errors);
+
+                  before.Tree.Transform(variables);
+                  before.Tree.Transform(constants);
+                  before.Tree.Transform(commands);
+                  before.Tree.Transform(logic);
+                  if (any_of(before.Tree.begin(), before.Tree.end(), CommandNode::isStandardCommand) && before.Errors.empty())
+                     before.Tree.Transform(termination);
+               }
+               verifyBefore += sw.ElapsedMilliseconds;
+
+               // After: Fused traversals of pre-order array
+               fileAfter.Clear();
+               after.Errors.clear();
+               sw.Restart();
+               after.Tree.Verify(fileAfter, after.Errors);
+               verifyAfter += sw.ElapsedMilliseconds;
+            }
+
+            // Measure each pass separately
+            fileAfter.Clear();
+            after.Errors.clear();
+            after.Tree.Verify(fileAfter, after.Errors, nullptr, &verifyPasses);
+
+            // Compile once, before: Separate depth-first traversal per visitor  [Linking inserts nodes]
+            sw.Restart();
+            {
+               UINT i = 0;
+               CommandGenerator   generator(fileBefore, before.Errors);
+               LinkageFinalizer   finalizer(before.Errors);
+               MacroExpander      macros(fileBefore, before.Errors);
+               NodeIndexer        indexer(i);
+               NodeLinker         linker(before.Errors);
+
+               // Macros: Expansion traversal  [Script contains none]
+               if (PrefsLib.UseMacroCommands)
+                  before.Tree.Transform(macros);
+
+               before.Tree.Transform(linker);
+               before.Tree.Transform(indexer);
+               before.Tree.Transform(finalizer);
+               before.Tree.Transform(generator);
+            }
+            compileBefore += sw.ElapsedMilliseconds;
+
+            // After: Fused traversals of pre-order array
+            sw.Restart();
+            after.Tree.Compile(fileAfter, after.Errors, &compilePasses);
+            compileAfter += sw.ElapsedMilliseconds;
+
+            identical &= (summarise(before) == summarise(after));
+         }
+
+         // Feedback
+         Console << Cons::Yellow << VString(L"%d scripts, %d lines, each verified %d times and compiled once", scripts, lineCount, repeats) << ENDL;
+         Console << Cons::Yellow << L"Separate verification: " << Cons::White << VString(L"%.1fms", verifyBefore) << ENDL;
+         Console << Cons::Yellow << L"Fused verification:    " << Cons::White << VString(L"%.1fms  speedup x%.1f", verifyAfter, verifyBefore / max(verifyAfter, 0.001)) << ENDL;
+         Console << Cons::Yellow << L"Separate compilation:  " << Cons::White << VString(L"%.1fms", compileBefore) << ENDL;
+         Console << Cons::Yellow << L"Fused compilation:     " << Cons::White << VString(L"%.1fms  speedup x%.1f", compileAfter, compileBefore / max(compileAfter, 0.001)) << ENDL;
+
+         // Per-pass timings  [Verification measured once per script]
+         Console << Cons::Heading << L"Verification passes" << ENDL;
+         for (const auto& t : verifyPasses)
+            Console << Cons::Yellow << VString(L"%-12s", t.Name.c_str()) << Cons::White << VString(L"%.2fms", t.Milliseconds) << ENDL;
+
+         Console << Cons::Heading << L"Compilation passes" << ENDL;
+         for (const auto& t : compilePasses)
+            Console << Cons::Yellow << VString(L"%-12s", t.Name.c_str()) << Cons::White << VString(L"%.2fms", t.Milliseconds) << ENDL;
+
+         Console << L"Results identical: " << (identical ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark command tree passes");
+      }
+   }
+
+   void LogicTests::Benchmark_XorCipher()
+   {
+      typedef XorCipher::InstructionSet InstructionSet;
+
+      const DWORD    length = 64*1024*1024,     // 64MB synthetic buffer
+                     passes = 8;
+      InstructionSet sets[3] = { InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2 };
+      ByteArrayPtr   buffer(new BYTE[length]), 
+                     expected(new BYTE[length]);
+
+      try
+      {
+         Console << Cons::Heading << L"Benchmarking XOR decode kernels using " << (length/(1024*1024)) << L"MB buffers. "
+                 << L"Processor supports " << XorCipher::GetString(XorCipher::Available) << ENDL;
+
+         // Generate synthetic data
+         for (DWORD i = 0; i < length; ++i)
+            buffer.get()[i] = (BYTE)(i * 7 + (i >> 8));
+
+         // Catalog:  Rolling key.  (Offset by 3 to ensure kernels handle unaligned buffers)
+         // DataFile: Constant key
+         // X3 file:  Constant key derived from first byte
+         for (int stream = 0; stream < 3; ++stream)
+         {
+            const wchar* names[3] = { L"CatalogStream", L"DataStream", L"EncryptedX3Stream" };
+            const byte   keys[3] = { 0xDB, 0x33, 0xC8 ^ 0x1f };
+
+            // Generate expected output with scalar kernel
+            memcpy(expected.get(), buffer.get(), length);
+            if (stream == 0)
+               XorCipher::EncodeRolling(expected.get()+3, length-3, keys[stream], InstructionSet::Scalar);
+            else
+               XorCipher::Encode(expected.get()+3, length-3, keys[stream], InstructionSet::Scalar);
+            
+            // Measure each supported kernel
+            for (auto set : sets)
+            {
+               if (set > XorCipher::Available)
+                  continue;
+
+               Stopwatch sw;
+               for (DWORD pass = 0; pass < passes; ++pass)
+                  if (stream == 0)
+                     XorCipher::EncodeRolling(buffer.get()+3, length-3, keys[stream], set);
+                  else
+                     XorCipher::Encode(buffer.get()+3, length-3, keys[stream], set);
+               sw.Stop();
+
+               // Verify: An even number of passes restores the original buffer, so apply one more and compare
+               if (stream == 0)
+                  XorCipher::EncodeRolling(buffer.get()+3, length-3, keys[stream], set);
+               else
+                  XorCipher::Encode(buffer.get()+3, length-3, keys[stream], set);
+               bool valid = memcmp(buffer.get(), expected.get(), length) == 0;
+
+               // Restore original
+               if (stream == 0)
+                  XorCipher::EncodeRolling(buffer.get()+3, length-3, keys[stream], InstructionSet::Scalar);
+               else
+                  XorCipher::Encode(buffer.get()+3, length-3, keys[stream], InstructionSet::Scalar);
+               
+               // Feedback
+               double gbps = ((double)length * passes / (1024.0*1024.0*1024.0)) / sw.ElapsedSeconds;
+               Console << Cons::Yellow << names[stream] << Cons::White << L" " << XorCipher::GetString(set) 
+                       << VString(L": %.2f GB/s ", gbps) << (valid ? Cons::Success : Cons::Failure) << ENDL;
+            }
+         }
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to benchmark XOR kernels");
+      }
+   }
 
    void LogicTests::Test_CommandSyntax()
    {
@@ -249,6 +2239,119 @@ namespace Testing
    }
 
 
+   /// <summary>Writes a synthetic catalog and data file</summary>
+   /// <param name="folder">Game folder.</param>
+   /// <param name="index">Catalog number.</param>
+   /// <param name="files">Sub-path and size of each file</param>
+   void  WriteTestCatalog(Path folder, int index, const vector<pair<wstring,DWORD>>& files)
+   {
+      Path        cat = folder + GuiString::Format(L"%02i.cat", index);
+      GuiString   text(GuiString::Format(L"%02i.dat\n", index));
+      DWORD       total = 0;
+
+      // Declarations: Use forward slashes like the game catalogs
+      for (auto& f : files)
+      {
+         text += GuiString::Format(L"%s %d\n", f.first.c_str(), f.second);
+         total += f.second;
+      }
+      replace(text.begin(), text.end(), L'\\', L'/');
+      
+      // Write catalog
+      string ansi(text.begin(), text.end());
+      StreamPtr cs(new CatalogStream(cat, FileMode::CreateAlways, FileAccess::Write));
+      cs->Write((const BYTE*)ansi.c_str(), ansi.length());
+      cs->Close();
+
+      // Write data file: Each file contains the catalog number repeated
+      ByteArrayPtr data(new BYTE[total+1]);
+      memset(data.get(), '0' + index, total);
+      XorCipher::Encode(data.get(), total, 0x33);
+
+      StreamPtr ds(new FileStream(cat.RenameExtension(L".dat"), FileMode::CreateAlways, FileAccess::Write));
+      ds->Write(data.get(), total);
+      ds->Close();
+   }
+
+   void  LogicTests::Test_CatalogEnumeration()
+   {
+      TempPath  tmp(L"cat");
+      Path      folder = tmp.ToString() + L"-vfs\\";
+
+      try
+      {
+         Console << Cons::Heading << L"Testing concurrent catalog enumeration using " << folder << ENDL;
+
+         // Generate fixture: Three catalogs with overlapping files of differing precedence
+         CreateDirectory(folder.c_str(), nullptr);
+         WriteTestCatalog(folder, 1, { {L"types\\TShips.txt", 10}, {L"t\\0001-L044.xml", 20}, {L"scripts\\a.xml", 5}, {L"scripts\\d.xml", 9} });
+         WriteTestCatalog(folder, 2, { {L"types\\TShips.pck", 8}, {L"scripts\\b.pck", 7}, {L"scripts\\d.xml", 6} });
+         WriteTestCatalog(folder, 3, { {L"t\\0001-L044.xml", 30}, {L"scripts\\a.pck", 4}, {L"scripts\\c.txt", 3} });
+
+         // Enumerate serially, concurrently and concurrently using mapped catalogs
+         XFileSystem serial(CatalogBackend::Streamed, 1), 
+                     parallel(CatalogBackend::Streamed, 0), 
+                     mapped(CatalogBackend::Mapped, 0);
+         serial.Enumerate(folder, GameVersion::TerranConflict);
+         parallel.Enumerate(folder, GameVersion::TerranConflict);
+         mapped.Enumerate(folder, GameVersion::TerranConflict);
+
+         // Compare results
+         bool equal = true;
+         for (const wchar* sub : { L"types\\", L"t\\", L"scripts\\" })
+         {
+            auto a = serial.Browse(folder + sub), 
+                 b = parallel.Browse(folder + sub), 
+                 c = mapped.Browse(folder + sub);
+
+            if (a.size() != b.size() || a.size() != c.size())
+               equal = false;
+            else 
+               for (auto x = a.begin(), y = b.begin(), z = c.begin(); x != a.end(); ++x, ++y, ++z)
+               {
+                  if (x->FullPath != y->FullPath || x->Offset != y->Offset || x->Length != y->Length || x->Catalog->FullPath != y->Catalog->FullPath
+                   || x->FullPath != z->FullPath || x->Offset != z->Offset || x->Length != z->Length || x->Catalog->FullPath != z->Catalog->FullPath)
+                     equal = false;
+               }
+         }
+         Console << L"Serial and concurrent results identical: " << (equal ? Cons::Success : Cons::Failure) << ENDL;
+
+         // Verify precedence: [Key, Expected catalog]
+         const pair<const wchar*, int> expected[] = 
+         {
+            { L"types\\TShips",   2 },   // .pck beats .txt in lower catalog
+            { L"t\\0001-L044",    3 },   // Highest catalog wins
+            { L"scripts\\a",      3 },   // .pck in highest catalog
+            { L"scripts\\d",      2 },   // Equal precedence: Highest catalog wins
+         };
+
+         for (auto& e : expected)
+         {
+            XFileInfo f = parallel.Find(folder + e.first);
+            bool      catalog = f.Catalog->FullPath.FileName == GuiString::Format(L"%02i.cat", e.second);
+            
+            // Verify contents decoded from the expected data file
+            auto buf = mapped.Find(folder + e.first).OpenRead()->ReadAllBytes();
+            bool content = f.Length > 0 && buf.get()[0] == '0' + e.second && buf.get()[f.Length-1] == '0' + e.second;
+
+            Console << L"Resolved " << e.first << L" from " << f.Catalog->FullPath.FileName << L": " 
+                    << (catalog && content ? Cons::Success : Cons::Failure) << ENDL;
+         }
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to test catalog enumeration");
+      }
+
+      // Cleanup
+      for (int i = 1; i <= 3; ++i)
+      {
+         DeleteFile((folder + GuiString::Format(L"%02i.cat", i)).c_str());
+         DeleteFile((folder + GuiString::Format(L"%02i.dat", i)).c_str());
+      }
+      RemoveDirectory(folder.c_str());
+      DeleteFile(tmp.c_str());
+   }
+
    void  LogicTests::Test_DescriptionReader()
    {
       const AppPath path = L"Data\\Descriptions.xml";
@@ -588,6 +2691,117 @@ namespace Testing
       }
    }
 
+   /// <summary>Compares the pages and strings of two language files</summary>
+   /// <param name="a">First file.</param>
+   /// <param name="b">Second file.</param>
+   /// <returns>True if identical</returns>
+   bool  CompareLanguageFiles(const LanguageFile& a, const LanguageFile& b)
+   {
+      if (a.ID != b.ID || a.Language != b.Language || a.Pages.size() != b.Pages.size())
+         return false;
+
+      // Compare pages
+      for (auto x = a.Pages.begin(), y = b.Pages.begin(); x != a.Pages.end(); ++x, ++y)
+      {
+         const LanguagePage &p = x->second, 
+                            &q = y->second;
+
+         if (p.ID != q.ID || p.Title != q.Title || p.Description != q.Description || p.Voiced != q.Voiced || p.Strings.size() != q.Strings.size())
+            return false;
+
+         // Compare strings
+         for (auto s = p.Strings.begin(), t = q.Strings.begin(); s != p.Strings.end(); ++s, ++t)
+            if (s->second.ID != t->second.ID || s->second.Text != t->second.Text || s->second.Version != t->second.Version)
+               return false;
+      }
+
+      return true;
+   }
+
+   void  LogicTests::Test_LanguageStreamReader()
+   {
+      const BYTE  bom[3] = { 0xEF, 0xBB, 0xBF };
+      WorkerData  data(Operation::NoFeedback);
+      TempPath    tmp(L"lng");
+      Path        sample = tmp.RenameExtension(L".xml");
+
+      try
+      {
+         Console << Cons::Heading << L"Testing streaming language file reader against the DOM reader" << ENDL;
+
+         // Generate sample: Entities, character references, CDATA, comments, whitespace and multiple versions
+         string xml = GuiString::Convert(
+            L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+            L"<!-- Sample language file -->\r\n"
+            L"<language id=\"44\">\r\n"
+            L"  <page id=\"350017\" title=\"Boarding &amp; Marines\" descr=\"Line one\r\nline two\" voice=\"yes\">\r\n"
+            L"    <t id=\"1\">  Leading and trailing whitespace  </t>\r\n"
+            L"    <t id=\"2\">&lt;tag&gt; &quot;quoted&quot; &apos;single&apos; &#65;&#x42; \\053 Über</t>\r\n"
+            L"    <t id=\"3\"><![CDATA[<raw> & unescaped]]> after</t>\r\n"
+            L"    <t id=\"4\">Multiple\r\nlines <!-- comment --> here</t>\r\n"
+            L"    <t id=\"5\"/>\r\n"
+            L"    <t id=\"6\">{17,1} (hidden) [red]colour[/red]</t>\r\n"
+            L"  </page>\r\n"
+            L"  <page id=\"300017\" title=\"Older\">\r\n"
+            L"    <t id=\"1\">Reunion version</t>\r\n"
+            L"    <t id=\"7\">Reunion only</t>\r\n"
+            L"  </page>\r\n"
+            L"  <page id=\"380018\"/>\r\n"
+            L"</language>", CP_UTF8);
+
+         StreamPtr fs(new FileStream(sample, FileMode::CreateAlways, FileAccess::Write));
+         fs->Write(bom, 3);
+         fs->Write((const BYTE*)xml.c_str(), xml.length());
+         fs->Close();
+
+         // Compare sample
+         LanguageFile dom = LanguageFileReader(StreamPtr(new FileStream(sample, FileMode::OpenExisting, FileAccess::Read))).ReadFile(sample),
+                      stream = LanguageStreamReader(StreamPtr(new FileStream(sample, FileMode::OpenExisting, FileAccess::Read))).ReadFile(sample);
+         
+         Console << L"Sample file identical: " << (CompareLanguageFiles(dom, stream) ? Cons::Success : Cons::Failure) << ENDL;
+
+         // Compare each language file of the game data
+         XFileSystem vfs;
+         vfs.Enumerate(PrefsLib.GameDataFolder, PrefsLib.GameDataVersion, &data);
+
+         double domTime = 0, streamTime = 0;
+         UINT   files = 0, failures = 0;
+
+         for (const XFileInfo& f : vfs.Browse(XFolder::Language))
+         {
+            if (!LanguageFilenameReader(f.FullPath.FileName).Valid)
+               continue;
+
+            Stopwatch sw;
+            LanguageFile a = LanguageFileReader(f.OpenRead()).ReadFile(f.FullPath);
+            domTime += sw.ElapsedMilliseconds;
+
+            sw.Restart();
+            LanguageFile b = LanguageStreamReader(f.OpenRead()).ReadFile(f.FullPath);
+            streamTime += sw.ElapsedMilliseconds;
+
+            // Feedback
+            ++files;
+            if (!CompareLanguageFiles(a, b))
+            {
+               Console << Cons::Failure << L"Differs: " << f.FullPath << ENDL;
+               ++failures;
+            }
+         }
+
+         Console << Cons::Yellow << files << L" game files: " << Cons::White 
+                 << VString(L"DOM %.0fms  streaming %.0fms", domTime, streamTime) << ENDL;
+         Console << L"Game files identical: " << (failures == 0 ? Cons::Success : Cons::Failure) << ENDL;
+      }
+      catch (ExceptionBase&  e) {
+         Console.Log(HERE, e, L"Unable to test streaming language file reader");
+      }
+
+      // Cleanup
+      DeleteFile(sample.c_str());
+      DeleteFile(tmp.c_str());
+   }
+
    void  LogicTests::Test_LanguageEditRegEx()
    {
       try
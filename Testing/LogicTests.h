@@ -17,11 +17,33 @@ namespace Testing
 
    public:
       static void  BatchTest_ScriptCompiler();
+      static void  Benchmark_BackupStore();
+      static void  Benchmark_FileIndex();
+      static void  Benchmark_GameDataLoad();
+      static void  Benchmark_GameDataSnapshot();
+      static void  Benchmark_IncrementalParse();
+      static void  Benchmark_LanguageFiles();
+      static void  Benchmark_Lexer();
+      static void  Benchmark_LineIdentification();
+      static void  Benchmark_NodeArena();
+      static void  Benchmark_ScriptCallCache();
+      static void  Benchmark_ScriptReader();
+      static void  Benchmark_ScriptTextReader();
+      static void  Benchmark_SearchIndex();
+      static void  Benchmark_SearchPattern();
+      static void  Benchmark_SearchWorker();
+      static void  Benchmark_StringLookup();
+      static void  Benchmark_StringResolver();
+      static void  Benchmark_SyntaxAutomaton();
+      static void  Benchmark_TreePasses();
+      static void  Benchmark_XorCipher();
       static void  Test_CommandSyntax();
       static void  Test_LanguageFileReader();
       static void  Test_LanguageEditRegEx();
+      static void  Test_LanguageStreamReader();
       static void  Test_TFileReader();
       static void  Test_CatalogReader();
+      static void  Test_CatalogEnumeration();
       static void  Test_CommandTreeIterator();
       static void  Test_ExpressionParser();
       static void  Test_DescriptionReader();